@@ -2,12 +2,14 @@
    #import "TargetConditionals.h"
 #endif
 
-// Use single precision floats on the iPhone.
-#ifdef TARGET_OS_IPHONE
-	#define CP_USE_DOUBLES 0
-#else
-	// use doubles by default for higher precision
-	#define CP_USE_DOUBLES 1
+// Use single precision floats on the iPhone, or when built with -DCP_USE_DOUBLES=0.
+#ifndef CP_USE_DOUBLES
+	#ifdef TARGET_OS_IPHONE
+		#define CP_USE_DOUBLES 0
+	#else
+		// use doubles by default for higher precision
+		#define CP_USE_DOUBLES 1
+	#endif
 #endif
 
 #if CP_USE_DOUBLES
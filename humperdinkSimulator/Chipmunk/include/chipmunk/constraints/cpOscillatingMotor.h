@@ -30,6 +30,11 @@ typedef struct cpOscillatingMotor {
 	cpFloat iSum;
 		
 	cpFloat jAcc, jMax;
+	
+	// Energy the motor has put into (or taken out of) its bodies, summed once per step as
+	// |accumulated impulse * relative angular velocity at the end of the step|, so it doesn't
+	// depend on the number of solver passes. A step is counted when the next one starts.
+	cpFloat work;
 } cpOscillatingMotor;
 
 cpOscillatingMotor *cpOscillatingMotorAlloc(void);
@@ -39,3 +44,4 @@ cpConstraint *cpOscillatingMotorNew(cpBody *a, cpBody *b, cpFloat frequency, cpF
 CP_DefineConstraintProperty(cpOscillatingMotor, cpFloat, frequency, Frequency);
 CP_DefineConstraintProperty(cpOscillatingMotor, cpFloat, amplitude, Amplitude);
 CP_DefineConstraintProperty(cpOscillatingMotor, cpFloat, phaseShift, PhaseShift);
+CP_DefineConstraintProperty(cpOscillatingMotor, cpFloat, work, Work);
@@ -101,7 +101,8 @@ void cpArbiterUpdate(cpArbiter *arb, cpContact *contacts, int numContacts, struc
 void cpArbiterPreStep(cpArbiter *arb, cpFloat dt_inv);
 void cpArbiterApplyCachedImpulse(cpArbiter *arb);
 // Run an iteration of the solver on the arbiter.
-void cpArbiterApplyImpulse(cpArbiter *arb, cpFloat eCoef);
+// Returns the largest change made to a contact's accumulated normal or friction impulse.
+cpFloat cpArbiterApplyImpulse(cpArbiter *arb, cpFloat eCoef);
 
 // Arbiter Helper Functions
 cpVect cpArbiterTotalImpulse(cpArbiter *arb);
@@ -72,6 +72,11 @@ typedef struct cpBody{
 	cpVect v_bias;
 	cpFloat w_bias;
 	
+	// Index of the body in its space's body list, valid while island_stamp matches the space's stamp.
+	// Used by the island solver to partition the space.
+	int island_index;
+	int island_stamp;
+	
 //	int active;
 } cpBody;
 
@@ -132,10 +137,21 @@ cpBodyWorld2Local(cpBody *body, cpVect v)
 	return cpvunrotate(cpvsub(v, body->p), body->rot);
 }
 
+// Bodies of infinite mass and moment (like the static body) are left untouched by impulses.
+// Scaling by a zero m_inv and i_inv would leave them as they were anyway, but for a NaN impulse,
+// and the island solver's threads all share the static body so the writes would race.
+static inline int
+cpBodyIsImmovable(cpBody *body)
+{
+	return (body->m_inv == 0.0f && body->i_inv == 0.0f);
+}
+
 // Apply an impulse (in world coordinates) to the body at a point relative to the center of gravity (also in world coordinates).
 static inline void
 cpBodyApplyImpulse(cpBody *body, cpVect j, cpVect r)
 {
+	if(cpBodyIsImmovable(body)) return;
+	
 	body->v = cpvadd(body->v, cpvmult(j, body->m_inv));
 	body->w += body->i_inv*cpvcross(r, j);
 }
@@ -144,6 +160,8 @@ cpBodyApplyImpulse(cpBody *body, cpVect j, cpVect r)
 static inline void
 cpBodyApplyBiasImpulse(cpBody *body, cpVect j, cpVect r)
 {
+	if(cpBodyIsImmovable(body)) return;
+	
 	body->v_bias = cpvadd(body->v_bias, cpvmult(j, body->m_inv));
 	body->w_bias += body->i_inv*cpvcross(r, j);
 }
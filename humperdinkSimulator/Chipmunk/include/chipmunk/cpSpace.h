@@ -42,6 +42,16 @@ typedef struct cpCollisionHandler {
 	void *data;
 } cpCollisionHandler;
 
+// Statistics of the impulse solver for the last call to cpSpaceStep().
+typedef struct cpSpaceStepStats {
+	// Number of passes the impulse solver ran. (the most run by any island when threaded)
+	int iterations;
+	// Largest change in accumulated impulse during the last pass. (only measured with an iterationTolerance)
+	cpFloat residual;
+	// Deepest overlap between two colliding shapes found at the start of the step.
+	cpFloat penetration;
+} cpSpaceStepStats;
+
 typedef struct cpSpace{
 	// *** User definable fields
 	
@@ -51,16 +61,38 @@ typedef struct cpSpace{
 	// Number of iterations to use in the impulse solver to solve elastic collisions.
 	int elasticIterations;
 	
+	// Stop the impulse solver early once no arbiter or constraint changed its accumulated impulse
+	// by more than iterationTolerance during a pass. At least minIterations and at most iterations passes are run.
+	// A tolerance of 0 always runs every iteration.
+	cpFloat iterationTolerance;
+	int minIterations;
+	
 	// Default gravity to supply when integrating rigid body motions.
 	cpVect gravity;
 	
 	// Default damping to supply when integrating rigid body motions.
 	cpFloat damping;
 	
+	// Number of threads to use in the impulse solver.
+	// Groups of bodies that are not connected by constraints or contacts (islands) are solved concurrently.
+	// The result is identical to the serial solver. Values less than 2 disable threading.
+	int threads;
+	
+	// Solve with graph coloring instead of islands, for large groups of connected bodies that form a single island.
+	// Arbiters and constraints are split into colors that share no bodies and each color is spread over the threads.
+	// The solver order differs from the serial solver, but the result doesn't depend on the number of threads.
+	int graphColoring;
+	
 	// *** Internally Used Fields
 	
 	// Time stamp. Is incremented on every call to cpSpaceStep().
 	int stamp;
+	
+	// Solver statistics of the last step. (read only)
+	cpSpaceStepStats stepStats;
+	
+	// Timestep of the last step, cached contact impulses are rescaled when it changes.
+	cpFloat prevDt;
 
 	// The static and active shape spatial hashes.
 	cpSpaceHash *staticShapes;
@@ -82,6 +114,9 @@ typedef struct cpSpace{
 	cpCollisionHandler defaultHandler;
 	
 	cpHashSet *postStepCallbacks;
+	
+	// Scratch data and worker threads for the island solver. (created on demand)
+	struct cpIslandSolver *islandSolver;
 } cpSpace;
 
 // Basic allocation/destruction functions.
@@ -156,5 +191,10 @@ void cpSpaceResizeStaticHash(cpSpace *space, cpFloat dim, int count);
 void cpSpaceResizeActiveHash(cpSpace *space, cpFloat dim, int count);
 void cpSpaceRehashStatic(cpSpace *space);
 
+// Forget all persistent contacts (and their cached impulses) and the step history,
+// as if the bodies had just been added. Use after moving bodies to a new pose to reuse a space.
+// Separate callbacks are not called.
+void cpSpaceResetContacts(cpSpace *space);
+
 // Update the space.
 void cpSpaceStep(cpSpace *space, cpFloat dt);
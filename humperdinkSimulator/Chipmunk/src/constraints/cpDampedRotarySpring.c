@@ -43,8 +43,8 @@ preStep(cpDampedRotarySpring *spring, cpFloat dt, cpFloat dt_inv)
 
 	// apply spring torque
 	cpFloat j_spring = spring->springTorqueFunc((cpConstraint *)spring, a->a - b->a)*dt;
-	a->w -= j_spring*a->i_inv;
-	b->w += j_spring*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j_spring*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += j_spring*b->i_inv;
 }
 
 static void
@@ -63,8 +63,8 @@ applyImpulse(cpDampedRotarySpring *spring)
 	
 	//apply_impulses(a, b, spring->r1, spring->r2, cpvmult(spring->n, v_damp*spring->nMass));
 	cpFloat j_damp = w_damp*spring->iSum;
-	a->w -= j_damp*a->i_inv;
-	b->w += j_damp*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j_damp*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += j_damp*b->i_inv;
 }
 
 static cpFloat
@@ -42,8 +42,8 @@ preStep(cpGearJoint *joint, cpFloat dt, cpFloat dt_inv)
 
 	// apply joint torque
 	cpFloat j = joint->jAcc;
-	a->w -= j*a->i_inv*joint->ratio_inv;
-	b->w += j*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j*a->i_inv*joint->ratio_inv;
+	if(b->i_inv != 0.0f) b->w += j*b->i_inv;
 }
 
 static void
@@ -62,8 +62,8 @@ applyImpulse(cpGearJoint *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv*joint->ratio_inv;
-	b->w += j*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j*a->i_inv*joint->ratio_inv;
+	if(b->i_inv != 0.0f) b->w += j*b->i_inv;
 }
 
 static cpFloat
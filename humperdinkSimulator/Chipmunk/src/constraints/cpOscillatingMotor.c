@@ -38,9 +38,13 @@ preStep(cpOscillatingMotor *joint, cpFloat dt, cpFloat dt_inv)
 	// compute max impulse
 	joint->jMax = J_MAX(joint, dt);
 
+	// work done over the last step, once from its final impulse (the passes' corrections
+	// cancel out in it) and the relative angular velocity it left the bodies with
+	joint->work += cpfabs(joint->jAcc*(b->w - a->w));
+	
 	// apply joint torque
-	a->w -= joint->jAcc*a->i_inv;
-	b->w += joint->jAcc*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= joint->jAcc*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += joint->jAcc*b->i_inv;
 	
 	// accumulate time
 	joint->t += dt;
@@ -49,7 +53,7 @@ preStep(cpOscillatingMotor *joint, cpFloat dt, cpFloat dt_inv)
 	if (joint->frequency == 0.0f) {
 		joint->t = 0.0f;
 	} else {
-		cpFloat tLimit = (2.0*M_PI)/joint->frequency;
+		cpFloat tLimit = (cpFloat)(2.0*M_PI)/joint->frequency;
 		if (joint->t > tLimit) joint->t -= tLimit;
 	}
 }
@@ -65,7 +69,7 @@ applyImpulse(cpOscillatingMotor *joint)
 		rate = 0.0f;
 	} else {
 		// compute rate according to time-step
-		rate = joint->frequency * joint->amplitude * cos(joint->frequency * joint->t + joint->phaseShift);
+		rate = joint->frequency * joint->amplitude * cpfcos(joint->frequency * joint->t + joint->phaseShift);
 	}
 	
 	
@@ -79,8 +83,8 @@ applyImpulse(cpOscillatingMotor *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += j*b->i_inv;
 }
 
 static cpFloat
@@ -112,6 +116,7 @@ cpOscillatingMotorInit(cpOscillatingMotor *joint, cpBody *a, cpBody *b, cpFloat
 	joint->phaseShift = phaseShift;
 	joint->t = 0.0f;
 	joint->jAcc = 0.0f;
+	joint->work = 0.0f;
 	
 	return joint;
 }
@@ -61,8 +61,8 @@ preStep(cpRatchetJoint *joint, cpFloat dt, cpFloat dt_inv)
 		joint->jAcc = 0.0f;
 
 	// apply joint torque
-	a->w -= joint->jAcc*a->i_inv;
-	b->w += joint->jAcc*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= joint->jAcc*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += joint->jAcc*b->i_inv;
 }
 
 static void
@@ -84,8 +84,8 @@ applyImpulse(cpRatchetJoint *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += j*b->i_inv;
 }
 
 static cpFloat
@@ -37,8 +37,8 @@ preStep(cpSimpleMotor *joint, cpFloat dt, cpFloat dt_inv)
 	joint->jMax = J_MAX(joint, dt);
 
 	// apply joint torque
-	a->w -= joint->jAcc*a->i_inv;
-	b->w += joint->jAcc*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= joint->jAcc*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += joint->jAcc*b->i_inv;
 }
 
 static void
@@ -57,8 +57,8 @@ applyImpulse(cpSimpleMotor *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	if(a->i_inv != 0.0f) a->w -= j*a->i_inv;
+	if(b->i_inv != 0.0f) b->w += j*b->i_inv;
 }
 
 static cpFloat
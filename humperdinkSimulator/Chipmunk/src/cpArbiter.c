@@ -222,11 +222,12 @@ cpArbiterApplyCachedImpulse(cpArbiter *arb)
 	}
 }
 
-void
+cpFloat
 cpArbiterApplyImpulse(cpArbiter *arb, cpFloat eCoef)
 {
 	cpBody *a = arb->a->body;
 	cpBody *b = arb->b->body;
+	cpFloat change = 0.0f;
 
 	for(int i=0; i<arb->numContacts; i++){
 		cpContact *con = &arb->contacts[i];
@@ -270,5 +271,9 @@ cpArbiterApplyImpulse(cpArbiter *arb, cpFloat eCoef)
 		
 		// Apply the final impulse.
 		apply_impulses(a, b, r1, r2, cpvrotate(n, cpv(jn, jt)));
+		
+		change = cpfmax(change, cpfmax(cpfabs(jn), cpfabs(jt)));
 	}
+	
+	return change;
 }
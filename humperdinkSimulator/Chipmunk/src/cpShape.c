@@ -46,8 +46,8 @@ cpShapeInit(cpShape *shape, const cpShapeClass *klass, cpBody *body)
 {
 	shape->klass = klass;
 	
-	shape->hashid = SHAPE_ID_COUNTER;
-	SHAPE_ID_COUNTER++;
+	// atomically, as spaces may be filled on several threads at once
+	shape->hashid = __atomic_fetch_add(&SHAPE_ID_COUNTER, 1, __ATOMIC_RELAXED);
 	
 	shape->body = body;
 	shape->sensor = 0;
@@ -109,7 +109,7 @@ void
 cpSegmentQueryInfoPrint(cpSegmentQueryInfo *info)
 {
 	printf("Segment Query:\n");
-	printf("\tt: %f\n", info->t);
+	printf("\tt: %f\n", (double)info->t);
 //	printf("\tdist: %f\n", info->dist);
 //	printf("\tpoint: %s\n", cpvstr(info->point));
 	printf("\tn: %s\n", cpvstr(info->n));
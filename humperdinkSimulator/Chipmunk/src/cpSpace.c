@@ -26,6 +26,7 @@
 #include <assert.h>
 
 #include "chipmunk.h"
+#include "cpSpaceIsland.h"
 
 int cp_contact_persistence = 3;
 
@@ -130,7 +131,18 @@ cpSpaceInit(cpSpace *space)
 	space->gravity = cpvzero;
 	space->damping = 1.0f;
 	
+	space->iterationTolerance = 0.0f;
+	space->minIterations = 1;
+	
+	space->threads = 1;
+	space->graphColoring = 0;
+	space->islandSolver = NULL;
+	
 	space->stamp = 0;
+	space->stepStats.iterations = 0;
+	space->stepStats.residual = 0.0f;
+	space->stepStats.penetration = 0.0f;
+	space->prevDt = 0.0f;
 
 	space->staticShapes = cpSpaceHashNew(DEFAULT_DIM_SIZE, DEFAULT_COUNT, (cpSpaceHashBBFunc)shapeBBFunc);
 	space->activeShapes = cpSpaceHashNew(DEFAULT_DIM_SIZE, DEFAULT_COUNT, (cpSpaceHashBBFunc)shapeBBFunc);
@@ -179,6 +191,8 @@ cpSpaceDestroy(cpSpace *space)
 	if(space->collFuncSet)
 		cpHashSetEach(space->collFuncSet, &freeWrap, NULL);
 	cpHashSetFree(space->collFuncSet);
+	
+	cpIslandSolverFree(space->islandSolver);
 }
 
 void
@@ -556,6 +570,26 @@ cpSpaceRehashStatic(cpSpace *space)
 	cpSpaceHashRehash(space->staticShapes);
 }
 
+static int
+arbiterForgetFilter(cpArbiter *arb, void *unused)
+{
+	cpArbiterFree(arb);
+	return 0;
+}
+
+void
+cpSpaceResetContacts(cpSpace *space)
+{
+	cpHashSetFilter(space->contactSet, (cpHashSetFilterFunc)arbiterForgetFilter, NULL);
+	space->arbiters->num = 0;
+	
+	space->stamp = 0;
+	space->stepStats.iterations = 0;
+	space->stepStats.residual = 0.0f;
+	space->stepStats.penetration = 0.0f;
+	space->prevDt = 0.0f;
+}
+
 #pragma mark Collision Detection Functions
 
 static inline int
@@ -702,21 +736,43 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 	cpArray *arbiters = space->arbiters;
 	for(int i=0; i<arbiters->num; i++)
 		cpArbiterPreStep((cpArbiter *)arbiters->arr[i], dt_inv);
+	
+	// Find the deepest overlap, and scale the cached contact impulses if the timestep changed,
+	// they were accumulated over the last step. (constraints keep theirs, the solver absorbs the difference)
+	cpFloat dt_coef = (space->prevDt ? dt/space->prevDt : 1.0f);
+	cpFloat penetration = 0.0f;
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		for(int j=0; j<arb->numContacts; j++){
+			cpContact *con = &arb->contacts[j];
+			penetration = cpfmax(penetration, -con->dist);
+			
+			if(dt_coef != 1.0f){
+				con->jnAcc *= dt_coef;
+				con->jtAcc *= dt_coef;
+			}
+		}
+	}
+	space->stepStats.penetration = penetration;
+	space->prevDt = dt;
 
 	// Prestep the constraints.
 	for(int i=0; i<constraints->num; i++){
 		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
 		constraint->klass->preStep(constraint, dt, dt_inv);
 	}
+	
+	// Split the solver work into islands or colors when running multithreaded.
+	cpIslandSolver *islands = cpSpaceGetIslandSolver(space);
+	if(islands && !cpIslandSolverPrepare(islands, space)) islands = NULL;
 
-	for(int i=0; i<space->elasticIterations; i++){
-		for(int j=0; j<arbiters->num; j++)
-			cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j], 1.0f);
-			
-		for(int j=0; j<constraints->num; j++){
-			cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
-			constraint->klass->applyImpulse(constraint);
-		}
+	// The elastic passes always run in full.
+	cpFloat residual;
+	if(islands){
+		if(space->elasticIterations) cpIslandSolverRun(islands, space->elasticIterations, 1.0f, 0, 0.0f, 0, &residual);
+	} else {
+		cpSolveImpulses((cpArbiter **)arbiters->arr, arbiters->num, (cpConstraint **)constraints->arr, constraints->num,
+			space->elasticIterations, 1.0f, 0.0f, 0, &residual);
 	}
 
 	// Integrate velocities.
@@ -726,21 +782,21 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 		body->velocity_func(body, space->gravity, damping, dt);
 	}
 
-	for(int i=0; i<arbiters->num; i++)
-		cpArbiterApplyCachedImpulse((cpArbiter *)arbiters->arr[i]);
-	
 	// run the old-style elastic solver if elastic iterations are disabled
 	cpFloat elasticCoef = (space->elasticIterations ? 0.0f : 1.0f);
 	
-	// Run the impulse solver.
-	for(int i=0; i<space->iterations; i++){
-		for(int j=0; j<arbiters->num; j++)
-			cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j], elasticCoef);
-			
-		for(int j=0; j<constraints->num; j++){
-			cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
-			constraint->klass->applyImpulse(constraint);
-		}
+	cpSpaceStepStats *stats = &space->stepStats;
+	if(islands){
+		// Apply cached impulses and run the impulse solver on each island or color.
+		stats->iterations = cpIslandSolverRun(islands, space->iterations, elasticCoef, 1,
+			space->iterationTolerance, space->minIterations, &stats->residual);
+	} else {
+		for(int i=0; i<arbiters->num; i++)
+			cpArbiterApplyCachedImpulse((cpArbiter *)arbiters->arr[i]);
+		
+		// Run the impulse solver.
+		stats->iterations = cpSolveImpulses((cpArbiter **)arbiters->arr, arbiters->num, (cpConstraint **)constraints->arr, constraints->num,
+			space->iterations, elasticCoef, space->iterationTolerance, space->minIterations, &stats->residual);
 	}
 	
 	// run the post solve callbacks
@@ -22,6 +22,8 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include "chipmunk.h"
@@ -236,11 +238,30 @@ hash_func(cpHashValue x, cpHashValue y, cpHashValue n)
 	return (x*1640531513ul ^ y*2654435789ul) % n;
 }
 
+// Cell coordinates are clamped to this, so a body that has blown up to
+// coordinates beyond an int (or NaN) can't make the cell loops run forever
+#define CELL_LIMIT (1 << 29)
+
+// NaN by the bits: -ffast-math lets the compiler assume there are none,
+// and fold away comparisons that would have caught them
+static inline int
+is_nan(cpFloat f)
+{
+	double d = f;
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+	return (bits & 0x7ff0000000000000ull) == 0x7ff0000000000000ull && (bits & 0x000fffffffffffffull) != 0;
+}
+
 // Much faster than (int)floor(f)
 // Profiling showed floor() to be a sizable performance hog
 static inline int
 floor_int(cpFloat f)
 {
+	if(is_nan(f)) return -CELL_LIMIT;
+	if(f >= CELL_LIMIT) return CELL_LIMIT;
+	if(f <= -CELL_LIMIT) return -CELL_LIMIT;
+	
 	int i = (int)f;
 	return (f < 0.0f && f != i ? i - 1 : i);
 }
@@ -0,0 +1,507 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ 
+ 
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "chipmunk.h"
+#include "cpThreadPool.h"
+#include "cpSpaceIsland.h"
+
+#pragma mark Memory Management Functions
+
+cpIslandSolver *
+cpIslandSolverNew(int threads)
+{
+	cpIslandSolver *solver = (cpIslandSolver *)cpcalloc(1, sizeof(cpIslandSolver));
+	solver->threads = threads;
+	solver->pool = cpThreadPoolNew(threads);
+	
+	solver->threadIterations = (int *)cpcalloc(threads, sizeof(int));
+	solver->threadResiduals = (cpFloat *)cpcalloc(2*threads, sizeof(cpFloat));
+	
+	return solver;
+}
+
+void
+cpIslandSolverFree(cpIslandSolver *solver)
+{
+	if(solver){
+		cpThreadPoolFree(solver->pool);
+		
+		cpfree(solver->parent);
+		cpfree(solver->islandOf);
+		cpfree(solver->bodyColors);
+		cpfree(solver->arbiterGroup);
+		cpfree(solver->constraintGroup);
+		cpfree(solver->arbiters);
+		cpfree(solver->constraints);
+		cpfree(solver->arbiterStart);
+		cpfree(solver->constraintStart);
+		cpfree(solver->threadIterations);
+		cpfree(solver->threadResiduals);
+		
+		cpfree(solver);
+	}
+}
+
+cpIslandSolver *
+cpSpaceGetIslandSolver(cpSpace *space)
+{
+	cpIslandSolver *solver = space->islandSolver;
+	int threads = (space->threads > 1 ? space->threads : 1);
+	
+	if(threads == 1 && !space->graphColoring){
+		return NULL;
+	} else if(solver && solver->threads == threads){
+		return solver;
+	} else {
+		cpIslandSolverFree(solver);
+		return (space->islandSolver = cpIslandSolverNew(threads));
+	}
+}
+
+// Grow an int or pointer scratch buffer, the buffers only ever grow so steady state stepping doesn't allocate.
+static void *
+growBuffer(void *buffer, int *max, int count, size_t size)
+{
+	if(count <= *max) return buffer;
+	
+	while(*max < count) *max = (*max ? *max*2 : 16);
+	return cprealloc(buffer, (*max)*size);
+}
+
+#pragma mark Grouping Helpers
+
+// Index of a body in the space or -1 for bodies that can't carry impulses between groups.
+// Bodies of infinite mass (like the static ground body) are shared by every group touching them,
+// impulses skip them (see cpBodyIsImmovable) so the groups stay independent.
+static inline int
+bodyIndex(cpBody *body, int stamp)
+{
+	if(body->island_stamp != stamp || (body->m_inv == 0.0f && body->i_inv == 0.0f)) return -1;
+	return body->island_index;
+}
+
+// Number the bodies of the space so they can be looked up with bodyIndex().
+static void
+indexBodies(cpIslandSolver *solver, cpSpace *space)
+{
+	cpArray *bodies = space->bodies;
+	
+	int bodiesMax = solver->bodiesMax;
+	solver->parent = (int *)growBuffer(solver->parent, &bodiesMax, bodies->num, sizeof(int));
+	bodiesMax = solver->bodiesMax;
+	solver->islandOf = (int *)growBuffer(solver->islandOf, &bodiesMax, bodies->num, sizeof(int));
+	solver->bodyColors = (unsigned long long *)growBuffer(solver->bodyColors, &solver->bodiesMax, bodies->num, sizeof(unsigned long long));
+	
+	for(int i=0; i<bodies->num; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		body->island_index = i;
+		body->island_stamp = space->stamp;
+	}
+}
+
+// Stable counting sort of the items by group.
+static void
+sortByGroup(void **items, int num, int *groups, void **sorted, int *start, int numGroups)
+{
+	for(int i=0; i<=numGroups; i++) start[i] = 0;
+	for(int i=0; i<num; i++) start[groups[i] + 1]++;
+	for(int i=0; i<numGroups; i++) start[i + 1] += start[i];
+	
+	// Use start[group] as the insertion cursor then shift it back.
+	for(int i=0; i<num; i++) sorted[start[groups[i]]++] = items[i];
+	for(int i=numGroups; i>0; i--) start[i] = start[i - 1];
+	start[0] = 0;
+}
+
+static void
+sortGroups(cpIslandSolver *solver, cpSpace *space)
+{
+	cpArray *arbiters = space->arbiters;
+	cpArray *constraints = space->constraints;
+	
+	int groupsMax = solver->groupsMax;
+	solver->arbiterStart = (int *)growBuffer(solver->arbiterStart, &groupsMax, solver->numGroups + 1, sizeof(int));
+	solver->constraintStart = (int *)growBuffer(solver->constraintStart, &solver->groupsMax, solver->numGroups + 1, sizeof(int));
+	
+	sortByGroup(arbiters->arr, arbiters->num, solver->arbiterGroup, solver->arbiters, solver->arbiterStart, solver->numGroups);
+	sortByGroup(constraints->arr, constraints->num, solver->constraintGroup, solver->constraints, solver->constraintStart, solver->numGroups);
+}
+
+#pragma mark Island Partitioning
+
+static inline int
+findRoot(int *parent, int i)
+{
+	while(parent[i] != i){
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	
+	return i;
+}
+
+static void
+join(int *parent, cpBody *a, cpBody *b, int stamp)
+{
+	int ia = bodyIndex(a, stamp);
+	int ib = bodyIndex(b, stamp);
+	if(ia < 0 || ib < 0) return;
+	
+	int ra = findRoot(parent, ia);
+	int rb = findRoot(parent, ib);
+	
+	// Always keep the lowest index as the root so the result doesn't depend on the join order.
+	if(ra < rb){
+		parent[rb] = ra;
+	} else {
+		parent[ra] = rb;
+	}
+}
+
+// Islands are numbered in the order they are first referenced by an arbiter or constraint.
+static int
+islandFor(cpIslandSolver *solver, cpBody *a, cpBody *b, int stamp, int *staticIsland)
+{
+	int i = bodyIndex(a, stamp);
+	if(i < 0) i = bodyIndex(b, stamp);
+	
+	int *island;
+	if(i < 0){
+		// Both bodies are static, there is nothing to solve against but keep it in its own island.
+		island = staticIsland;
+	} else {
+		island = &solver->islandOf[findRoot(solver->parent, i)];
+	}
+	
+	if(*island < 0) *island = solver->numGroups++;
+	return *island;
+}
+
+static void
+buildIslands(cpIslandSolver *solver, cpSpace *space)
+{
+	cpArray *bodies = space->bodies;
+	cpArray *arbiters = space->arbiters;
+	cpArray *constraints = space->constraints;
+	int stamp = space->stamp;
+	
+	for(int i=0; i<bodies->num; i++){
+		solver->parent[i] = i;
+		solver->islandOf[i] = -1;
+	}
+	
+	// Join the bodies connected by contacts and constraints.
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		join(solver->parent, arb->a->body, arb->b->body, stamp);
+	}
+	
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		join(solver->parent, constraint->a, constraint->b, stamp);
+	}
+	
+	// Label the island of every arbiter and constraint.
+	int staticIsland = -1;
+	
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		solver->arbiterGroup[i] = islandFor(solver, arb->a->body, arb->b->body, stamp, &staticIsland);
+	}
+	
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		solver->constraintGroup[i] = islandFor(solver, constraint->a, constraint->b, stamp, &staticIsland);
+	}
+}
+
+#pragma mark Graph Coloring
+
+// Greedy coloring, the lowest color that neither body has used yet.
+static int
+colorFor(cpIslandSolver *solver, cpBody *a, cpBody *b, int stamp)
+{
+	int ia = bodyIndex(a, stamp);
+	int ib = bodyIndex(b, stamp);
+	
+	unsigned long long used = 0;
+	if(ia >= 0) used |= solver->bodyColors[ia];
+	if(ib >= 0) used |= solver->bodyColors[ib];
+	
+	if(used == ~0ull){
+		solver->serialGroup = CP_MAX_COLORS;
+		return CP_MAX_COLORS;
+	}
+	
+	int color = __builtin_ctzll(~used);
+	unsigned long long bit = 1ull<<color;
+	if(ia >= 0) solver->bodyColors[ia] |= bit;
+	if(ib >= 0) solver->bodyColors[ib] |= bit;
+	
+	if(color >= solver->numGroups) solver->numGroups = color + 1;
+	return color;
+}
+
+static void
+buildColors(cpIslandSolver *solver, cpSpace *space)
+{
+	cpArray *arbiters = space->arbiters;
+	cpArray *constraints = space->constraints;
+	int stamp = space->stamp;
+	
+	memset(solver->bodyColors, 0, space->bodies->num*sizeof(unsigned long long));
+	
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		solver->arbiterGroup[i] = colorFor(solver, arb->a->body, arb->b->body, stamp);
+	}
+	
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		solver->constraintGroup[i] = colorFor(solver, constraint->a, constraint->b, stamp);
+	}
+	
+	if(solver->serialGroup >= 0) solver->numGroups = solver->serialGroup + 1;
+}
+
+int
+cpIslandSolverPrepare(cpIslandSolver *solver, cpSpace *space)
+{
+	cpArray *arbiters = space->arbiters;
+	cpArray *constraints = space->constraints;
+	
+	indexBodies(solver, space);
+	
+	int arbitersMax = solver->arbitersMax;
+	solver->arbiterGroup = (int *)growBuffer(solver->arbiterGroup, &arbitersMax, arbiters->num, sizeof(int));
+	solver->arbiters = (void **)growBuffer(solver->arbiters, &solver->arbitersMax, arbiters->num, sizeof(void *));
+	
+	int constraintsMax = solver->constraintsMax;
+	solver->constraintGroup = (int *)growBuffer(solver->constraintGroup, &constraintsMax, constraints->num, sizeof(int));
+	solver->constraints = (void **)growBuffer(solver->constraints, &solver->constraintsMax, constraints->num, sizeof(void *));
+	
+	solver->numGroups = 0;
+	solver->serialGroup = -1;
+	solver->colored = space->graphColoring;
+	
+	if(solver->colored){
+		buildColors(solver, space);
+	} else {
+		buildIslands(solver, space);
+	}
+	
+	sortGroups(solver, space);
+	
+	// Islands need at least two to share, colors are split up between the threads.
+	return (solver->colored ? arbiters->num + constraints->num > 0 : solver->numGroups > 1);
+}
+
+#pragma mark Impulse Passes
+
+// One pass over the arbiters and constraints, returning the largest change in accumulated impulse.
+// Constraints only report the magnitude of their accumulated impulse, so that is what gets compared.
+static inline cpFloat
+measuredPass(cpArbiter **arbiters, int numArbiters, cpConstraint **constraints, int numConstraints, cpFloat eCoef)
+{
+	cpFloat change = 0.0f;
+	
+	for(int j=0; j<numArbiters; j++)
+		change = cpfmax(change, cpArbiterApplyImpulse(arbiters[j], eCoef));
+	
+	for(int j=0; j<numConstraints; j++){
+		cpConstraint *constraint = constraints[j];
+		cpFloat jOld = constraint->klass->getImpulse(constraint);
+		constraint->klass->applyImpulse(constraint);
+		change = cpfmax(change, cpfabs(constraint->klass->getImpulse(constraint) - jOld));
+	}
+	
+	return change;
+}
+
+int
+cpSolveImpulses(cpArbiter **arbiters, int numArbiters, cpConstraint **constraints, int numConstraints,
+	int iterations, cpFloat eCoef, cpFloat tolerance, int minIterations, cpFloat *residual)
+{
+	*residual = 0.0f;
+	
+	for(int i=0; i<iterations; i++){
+		if(tolerance > 0.0f){
+			*residual = measuredPass(arbiters, numArbiters, constraints, numConstraints, eCoef);
+			if(i + 1 >= minIterations && *residual <= tolerance) return i + 1;
+		} else {
+			for(int j=0; j<numArbiters; j++)
+				cpArbiterApplyImpulse(arbiters[j], eCoef);
+			
+			for(int j=0; j<numConstraints; j++){
+				cpConstraint *constraint = constraints[j];
+				constraint->klass->applyImpulse(constraint);
+			}
+		}
+	}
+	
+	return iterations;
+}
+
+#pragma mark Parallel Solving
+
+// Islands are handed out round robin so each island is always solved by the same thread.
+// Within an island the arbiters and constraints are solved in the same order as the serial solver.
+// With a tolerance each island stops on its own.
+static void
+solveIslands(cpIslandSolver *solver, int thread)
+{
+	int maxIterations = 0;
+	cpFloat maxResidual = 0.0f;
+	
+	for(int island=thread; island<solver->numGroups; island+=solver->pool->numThreads){
+		cpArbiter **arbiters = (cpArbiter **)solver->arbiters + solver->arbiterStart[island];
+		int numArbiters = solver->arbiterStart[island + 1] - solver->arbiterStart[island];
+		
+		cpConstraint **constraints = (cpConstraint **)solver->constraints + solver->constraintStart[island];
+		int numConstraints = solver->constraintStart[island + 1] - solver->constraintStart[island];
+		
+		if(solver->applyCached){
+			for(int j=0; j<numArbiters; j++)
+				cpArbiterApplyCachedImpulse(arbiters[j]);
+		}
+		
+		cpFloat residual;
+		int iterations = cpSolveImpulses(arbiters, numArbiters, constraints, numConstraints,
+			solver->iterations, solver->eCoef, solver->tolerance, solver->minIterations, &residual);
+		
+		maxIterations = (iterations > maxIterations ? iterations : maxIterations);
+		maxResidual = cpfmax(maxResidual, residual);
+	}
+	
+	solver->threadIterations[thread] = maxIterations;
+	solver->threadResiduals[thread] = maxResidual;
+}
+
+// Slice [start, end) of a group's range that belongs to a thread.
+static inline void
+threadSlice(int *start, int *end, int thread, int numThreads)
+{
+	int count = *end - *start;
+	*end = *start + (count*(thread + 1))/numThreads;
+	*start = *start + (count*thread)/numThreads;
+}
+
+// Every color is split into contiguous slices, one per thread, followed by a barrier.
+// Nothing in a color shares a dynamic body, so the result doesn't depend on the number of threads.
+// With a tolerance every thread posts its largest change before the last barrier of a pass,
+// then all of them make the same decision to stop from the posted values.
+static void
+solveColors(cpIslandSolver *solver, int thread)
+{
+	cpThreadPool *pool = solver->pool;
+	int numThreads = pool->numThreads;
+	cpArbiter **arbiters = (cpArbiter **)solver->arbiters;
+	cpConstraint **constraints = (cpConstraint **)solver->constraints;
+	int measure = (solver->tolerance > 0.0f);
+	
+	int iterations = solver->iterations;
+	cpFloat residual = 0.0f;
+	
+	// Pass -1 applies the cached impulses.
+	for(int pass=(solver->applyCached ? -1 : 0); pass<solver->iterations; pass++){
+		// Alternate between two sets of slots, a thread can't get two passes ahead of the others.
+		cpFloat *residuals = solver->threadResiduals + (pass&1)*numThreads;
+		cpFloat change = 0.0f;
+		
+		for(int color=0; color<solver->numGroups; color++){
+			int arbStart = solver->arbiterStart[color], arbEnd = solver->arbiterStart[color + 1];
+			int conStart = solver->constraintStart[color], conEnd = solver->constraintStart[color + 1];
+			
+			if(color == solver->serialGroup){
+				// Ran out of colors, thread 0 solves these alone.
+				if(thread != 0) arbEnd = arbStart, conEnd = conStart;
+			} else {
+				threadSlice(&arbStart, &arbEnd, thread, numThreads);
+				threadSlice(&conStart, &conEnd, thread, numThreads);
+			}
+			
+			if(pass < 0){
+				for(int j=arbStart; j<arbEnd; j++)
+					cpArbiterApplyCachedImpulse(arbiters[j]);
+			} else if(measure){
+				change = cpfmax(change, measuredPass(arbiters + arbStart, arbEnd - arbStart, constraints + conStart, conEnd - conStart, solver->eCoef));
+				residuals[thread] = change;
+			} else {
+				for(int j=arbStart; j<arbEnd; j++)
+					cpArbiterApplyImpulse(arbiters[j], solver->eCoef);
+				
+				for(int j=conStart; j<conEnd; j++){
+					cpConstraint *constraint = constraints[j];
+					constraint->klass->applyImpulse(constraint);
+				}
+			}
+			
+			cpThreadPoolBarrier(pool);
+		}
+		
+		if(measure && pass >= 0){
+			residual = 0.0f;
+			for(int i=0; i<numThreads; i++) residual = cpfmax(residual, residuals[i]);
+			
+			if(pass + 1 >= solver->minIterations && residual <= solver->tolerance){
+				iterations = pass + 1;
+				break;
+			}
+		}
+	}
+	
+	// Every thread ran the same passes.
+	solver->threadIterations[thread] = iterations;
+	if(thread == 0) solver->colorResidual = residual;
+}
+
+int
+cpIslandSolverRun(cpIslandSolver *solver, int iterations, cpFloat eCoef, int applyCached, cpFloat tolerance, int minIterations, cpFloat *residual)
+{
+	solver->iterations = iterations;
+	solver->eCoef = eCoef;
+	solver->applyCached = applyCached;
+	solver->tolerance = tolerance;
+	solver->minIterations = minIterations;
+	
+	cpThreadPoolFunc func = (cpThreadPoolFunc)(solver->colored ? solveColors : solveIslands);
+	cpThreadPoolRun(solver->pool, func, solver);
+	
+	if(solver->colored){
+		*residual = solver->colorResidual;
+		return solver->threadIterations[0];
+	}
+	
+	int passes = 0;
+	*residual = 0.0f;
+	
+	for(int i=0; i<solver->pool->numThreads; i++){
+		passes = (solver->threadIterations[i] > passes ? solver->threadIterations[i] : passes);
+		*residual = cpfmax(*residual, solver->threadResiduals[i]);
+	}
+	
+	return passes;
+}
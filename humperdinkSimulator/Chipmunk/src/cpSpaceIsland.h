@@ -0,0 +1,99 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ 
+ 
+// Private to the solver. Runs the impulse solver of a space on several threads.
+//
+// The arbiters and constraints are split into groups that can be solved concurrently:
+//  - islands: sets of bodies not connected to each other by any arbiter or constraint.
+//    Each island is solved by one thread in the serial order, so the result is identical to the serial solver.
+//  - colors: (space->graphColoring) no two arbiters or constraints in a color share a dynamic body.
+//    Each color is split between all threads and the colors are solved one after another.
+//    Works for a single big island, but the solver order and so the result differs from the serial solver.
+
+struct cpThreadPool;
+
+// Arbiters and constraints that can't be colored with the first CP_MAX_COLORS colors are solved serially.
+#define CP_MAX_COLORS 64
+
+typedef struct cpIslandSolver {
+	// Number of threads requested, the pool may have started fewer.
+	int threads;
+	struct cpThreadPool *pool;
+	
+	// Union-find forest over the indexes of space->bodies and the island of each root.
+	int *parent, *islandOf;
+	// Colors used by the arbiters and constraints touching each body, one bit per color.
+	unsigned long long *bodyColors;
+	int bodiesMax;
+	
+	// Group (island or color) of every arbiter and constraint, in space order.
+	int *arbiterGroup, *constraintGroup;
+	
+	// Arbiters and constraints sorted by group, keeping their relative space order.
+	// Group i owns the ranges [arbiterStart[i], arbiterStart[i+1]) and [constraintStart[i], constraintStart[i+1]).
+	void **arbiters, **constraints;
+	int arbitersMax, constraintsMax;
+	
+	int *arbiterStart, *constraintStart;
+	int groupsMax;
+	
+	int numGroups;
+	// Set if the groups are colors rather than islands.
+	int colored;
+	// Color holding the arbiters and constraints that ran out of colors, or -1.
+	int serialGroup;
+	
+	// Parameters of the pass being run.
+	int iterations;
+	cpFloat eCoef;
+	int applyCached;
+	cpFloat tolerance;
+	int minIterations;
+	
+	// Passes run and last residual of each thread's islands.
+	// Colors keep the residual of every thread for the last two passes instead, and the overall one in colorResidual.
+	int *threadIterations;
+	cpFloat *threadResiduals;
+	cpFloat colorResidual;
+} cpIslandSolver;
+
+cpIslandSolver *cpIslandSolverNew(int threads);
+void cpIslandSolverFree(cpIslandSolver *solver);
+
+// Returns the island solver for the space, or NULL if the space uses the serial solver.
+cpIslandSolver *cpSpaceGetIslandSolver(cpSpace *space);
+
+// Group the current arbiters and constraints of the space into islands, or colors if space->graphColoring is set.
+// Returns false if the space can't be split up and should be solved serially.
+int cpIslandSolverPrepare(cpIslandSolver *solver, cpSpace *space);
+
+// Run up to 'iterations' passes of the impulse solver over every group, see cpSolveImpulses() for the tolerance.
+// Cached arbiter impulses are applied first if applyCached is set.
+// Returns the number of passes run (the most run by any island) and the largest change in the last pass in 'residual'.
+int cpIslandSolverRun(cpIslandSolver *solver, int iterations, cpFloat eCoef, int applyCached, cpFloat tolerance, int minIterations, cpFloat *residual);
+
+// Run up to 'iterations' passes of the impulse solver over a list of arbiters and constraints.
+// With a non-zero tolerance, stops once no arbiter or constraint changed its accumulated impulse
+// by more than the tolerance during a pass, after at least minIterations passes.
+// Returns the number of passes run and the largest change in the last pass in 'residual'. (0 if not measured)
+int cpSolveImpulses(cpArbiter **arbiters, int numArbiters, cpConstraint **constraints, int numConstraints,
+	int iterations, cpFloat eCoef, cpFloat tolerance, int minIterations, cpFloat *residual);
@@ -0,0 +1,157 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ 
+ 
+#include <stdlib.h>
+#include <sched.h>
+
+#include "chipmunk.h"
+#include "cpThreadPool.h"
+
+typedef struct workerContext {
+	cpThreadPool *pool;
+	int thread;
+} workerContext;
+
+static void *
+workerLoop(workerContext *context)
+{
+	cpThreadPool *pool = context->pool;
+	int thread = context->thread;
+	cpfree(context);
+	
+	unsigned int seen = 0;
+	
+	pthread_mutex_lock(&pool->lock);
+	for(;;){
+		while(pool->generation == seen && !pool->quit)
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		
+		if(pool->quit) break;
+		seen = pool->generation;
+		
+		pthread_mutex_unlock(&pool->lock);
+		pool->func(pool->data, thread);
+		pthread_mutex_lock(&pool->lock);
+		
+		if(--pool->pending == 0)
+			pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	
+	return NULL;
+}
+
+cpThreadPool *
+cpThreadPoolNew(int numThreads)
+{
+	cpThreadPool *pool = (cpThreadPool *)cpcalloc(1, sizeof(cpThreadPool));
+	pool->numThreads = (numThreads > 1 ? numThreads : 1);
+	
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	
+	pool->workers = (pthread_t *)cpcalloc(pool->numThreads, sizeof(pthread_t));
+	
+	// Thread 0 is the caller of cpThreadPoolRun().
+	for(int i=1; i<pool->numThreads; i++){
+		workerContext *context = (workerContext *)cpmalloc(sizeof(workerContext));
+		context->pool = pool;
+		context->thread = i;
+		
+		if(pthread_create(&pool->workers[i], NULL, (void *(*)(void *))workerLoop, context)){
+			// Couldn't start any more workers, make do with what we have.
+			cpfree(context);
+			pool->numThreads = i;
+			break;
+		}
+	}
+	
+	return pool;
+}
+
+void
+cpThreadPoolFree(cpThreadPool *pool)
+{
+	if(!pool) return;
+	
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	
+	for(int i=1; i<pool->numThreads; i++)
+		pthread_join(pool->workers[i], NULL);
+	
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	
+	cpfree(pool->workers);
+	cpfree(pool);
+}
+
+void
+cpThreadPoolRun(cpThreadPool *pool, cpThreadPoolFunc func, void *data)
+{
+	if(pool->numThreads == 1){
+		func(data, 0);
+		return;
+	}
+	
+	pthread_mutex_lock(&pool->lock);
+	pool->func = func;
+	pool->data = data;
+	pool->pending = pool->numThreads - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	
+	func(data, 0);
+	
+	pthread_mutex_lock(&pool->lock);
+	while(pool->pending)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+// Number of times to poll the barrier before yielding the CPU.
+#define BARRIER_SPINS 1000
+
+void
+cpThreadPoolBarrier(cpThreadPool *pool)
+{
+	if(pool->numThreads == 1) return;
+	
+	unsigned int generation = __atomic_load_n(&pool->barrierGeneration, __ATOMIC_ACQUIRE);
+	
+	if(__atomic_add_fetch(&pool->barrierCount, 1, __ATOMIC_ACQ_REL) == (unsigned int)pool->numThreads){
+		// Last one in, reset the count before releasing the others.
+		__atomic_store_n(&pool->barrierCount, 0, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&pool->barrierGeneration, 1, __ATOMIC_RELEASE);
+	} else {
+		// Barriers are hit many times per step, spin briefly instead of going to sleep.
+		for(int spins=0; __atomic_load_n(&pool->barrierGeneration, __ATOMIC_ACQUIRE) == generation; spins++){
+			if(spins >= BARRIER_SPINS) sched_yield();
+		}
+	}
+}
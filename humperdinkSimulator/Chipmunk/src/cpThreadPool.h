@@ -0,0 +1,63 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ 
+ 
+// Private to the solver. A small persistent pool of worker threads used by
+// cpSpaceStep() to solve independent groups of constraints concurrently.
+
+#include <pthread.h>
+
+struct cpThreadPool;
+
+// Job run on every thread of the pool. 'thread' is in [0, numThreads).
+typedef void (*cpThreadPoolFunc)(void *data, int thread);
+
+typedef struct cpThreadPool {
+	// Number of threads including the calling thread.
+	int numThreads;
+	
+	pthread_t *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t wake, done;
+	
+	// Current job.
+	cpThreadPoolFunc func;
+	void *data;
+	
+	// Incremented for every job so sleeping workers can tell a new job from a spurious wakeup.
+	unsigned int generation;
+	int pending;
+	int quit;
+	
+	// Spinning barrier used inside a job.
+	unsigned int barrierCount;
+	unsigned int barrierGeneration;
+} cpThreadPool;
+
+cpThreadPool *cpThreadPoolNew(int numThreads);
+void cpThreadPoolFree(cpThreadPool *pool);
+
+// Run func(data, thread) once on every thread of the pool and wait for all of them to finish.
+// The calling thread always runs thread 0, so the mapping of work to threads is fixed.
+void cpThreadPoolRun(cpThreadPool *pool, cpThreadPoolFunc func, void *data);
+
+// Wait until every thread of the pool has reached the barrier. Only valid from inside a job.
+void cpThreadPoolBarrier(cpThreadPool *pool);
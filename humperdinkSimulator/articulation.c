@@ -0,0 +1,998 @@
+#include "articulation.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+// physics simulation
+#include "chipmunk.h"
+#include "constraints/util.h"
+
+// the furthest (in radians) any limb may turn in one pass of the articulated-body
+// algorithm: its velocity product terms are integrated explicitly, and add energy once
+// limbs turn much further in a step, so longer steps are split into several passes
+#define MAX_PASS_TURN 0.25f
+// the most passes a step is split into
+#define MAX_PASSES 32
+
+
+/*
+ * Planar spatial algebra
+ *  motion vectors (angular velocity, linear velocity) and
+ *  force vectors (moment, force) are both expressed at a reference point
+ *  (the root's position at the start of the step), in world axes
+ */
+typedef struct {
+	cpFloat w;
+	cpVect v;
+} spatial_t;
+
+// symmetric 3x3 spatial inertia
+typedef struct {
+	cpFloat ww, wx, wy;
+	cpFloat xx, xy, yy;
+} inertia_t;
+
+/*
+ * Link data for a single limb of the tree
+ *  - the proxy body and where its joint sits on the parent
+ *  - joint state and motor parameters
+ *  - scratch values for the articulated-body passes
+ */
+typedef struct link {
+	Articulation articulation;
+	int parent;
+	cpBody *body;
+
+	// joint position in the parent's body coordinates
+	cpVect pivot;
+
+	// joint angle, rate and position correction rate (unused for the root)
+	cpFloat q;
+	cpFloat qd;
+	cpFloat qdBias;
+
+	// oscillating motor
+	cpFloat frequency, amplitude, phase;
+	cpFloat t;
+	cpFloat maxForce;
+
+	// set when the motor can't hold its target rate, the joint then moves
+	// freely under 'tau' (also set for joints without a motor)
+	int free;
+	cpFloat tau;
+
+	// energy used by the motor, |tau * qd| * dt summed over the steps
+	cpFloat work;
+
+	// position relative to the reference point, joint axis and rigid inertia
+	cpVect r;
+	spatial_t S;
+	inertia_t I;
+
+	// articulated inertia, IA*S, S.IA.S and the articulated bias force
+	inertia_t IA;
+	spatial_t U;
+	cpFloat D;
+	spatial_t pA;
+	cpFloat u;
+
+	// velocity product acceleration, acceleration (or velocity change) and joint acceleration
+	spatial_t c;
+	spatial_t a;
+	cpFloat qdd;
+
+	// spatial velocity and position correction velocity
+	spatial_t V;
+	spatial_t VBias;
+
+	// impulse to propagate through the tree
+	spatial_t f;
+
+	// proxy velocities as last written, anything else was applied by the space
+	cpVect v, vBias;
+	cpFloat w, wBias;
+} link_t;
+
+/*
+ * Articulation ADT data
+ *  - the links, parents first
+ *  - contacts claimed from the space for this step
+ */
+struct articulation {
+	cpSpace *space;
+
+	link_t *links;
+	int numLinks;
+
+	cpArray *arbiters;
+
+	// reference point for the spatial vectors
+	cpVect origin;
+
+	// of all the links
+	cpFloat mass;
+};
+
+/*
+ * Constraint wrapper that plugs the articulation into the space's solver.
+ * The root's constraint (the driver) does all the work, the others only
+ * join the limbs into one island for the threaded solver.
+ */
+typedef struct articulationJoint {
+	cpConstraint constraint;
+	Articulation articulation;
+	int driver;
+} articulationJoint;
+
+/*
+ * Private helper function prototypes
+ */
+static void proxyVelocityFunc( cpBody *body, cpVect gravity, cpFloat damping, cpFloat dt );
+static void proxyPositionFunc( cpBody *body, cpFloat dt );
+static void rootPositionFunc( cpBody *body, cpFloat dt );
+static void preStep( articulationJoint *joint, cpFloat dt, cpFloat dt_inv );
+static void applyImpulse( articulationJoint *joint );
+static cpFloat getImpulse( articulationJoint *joint );
+
+static void placeLink( Articulation art, link_t *link );
+static cpVect massCentre( Articulation art );
+static cpVect massVelocity( Articulation art );
+static void treeMomentum( Articulation art, cpVect centre, cpVect *linear, cpFloat *angular );
+static void setTreeMomentum( Articulation art, cpVect centre, cpVect linear, cpFloat angular );
+static void treeVelocities( Articulation art );
+static void updateKinematics( Articulation art );
+static int countPasses( Articulation art, cpFloat dt );
+static void forwardDynamics( Articulation art, cpVect gravity, cpFloat dt );
+static void splitDynamics( Articulation art, cpVect gravity, cpFloat dt, int passes );
+static void articulatedInertias( Articulation art );
+static void propagateImpulses( Articulation art );
+static void writeProxies( Articulation art, int bias );
+static int syncProxies( Articulation art, int bias );
+static void claimContacts( Articulation art );
+static int compareArbiters( const void *a, const void *b );
+static void solveContact( Articulation art, cpArbiter *arb, int contact );
+
+static const cpConstraintClass articulationJointClass = {
+	(cpConstraintPreStepFunction)preStep,
+	(cpConstraintApplyImpulseFunction)applyImpulse,
+	(cpConstraintGetImpulseFunction)getImpulse,
+};
+
+
+/*
+ * Spatial algebra helpers
+ */
+static inline spatial_t spatial( cpFloat w, cpVect v ) {
+	spatial_t s = { w, v };
+	return s;
+}
+
+static const spatial_t spatialZero = { 0.0f, { 0.0f, 0.0f } };
+
+static inline spatial_t sadd( spatial_t a, spatial_t b ) {
+	return spatial( a.w + b.w, cpvadd( a.v, b.v ) );
+}
+
+static inline spatial_t ssub( spatial_t a, spatial_t b ) {
+	return spatial( a.w - b.w, cpvsub( a.v, b.v ) );
+}
+
+static inline spatial_t smult( spatial_t a, cpFloat s ) {
+	return spatial( a.w * s, cpvmult( a.v, s ) );
+}
+
+// motion . force
+static inline cpFloat sdot( spatial_t m, spatial_t f ) {
+	return m.w * f.w + cpvdot( m.v, f.v );
+}
+
+// motion cross product, a x b
+static inline spatial_t crossMotion( spatial_t a, spatial_t b ) {
+	return spatial( 0.0f, cpv( b.w * a.v.y - a.w * b.v.y, a.w * b.v.x - b.w * a.v.x ) );
+}
+
+// force cross product, a x* f
+static inline spatial_t crossForce( spatial_t a, spatial_t f ) {
+	return spatial( cpvcross( a.v, f.v ), cpvmult( cpvperp( f.v ), a.w ) );
+}
+
+// velocity of the point at 'r' (relative to the reference point) of a body moving with V
+static inline cpVect pointVelocity( spatial_t V, cpVect r ) {
+	return cpvadd( V.v, cpvmult( cpvperp( r ), V.w ) );
+}
+
+// spatial velocity of a body from its velocity (and angular velocity) at 'r'
+static inline spatial_t bodyVelocity( cpVect v, cpFloat w, cpVect r ) {
+	return spatial( w, cpvsub( v, cpvmult( cpvperp( r ), w ) ) );
+}
+
+// spatial impulse of an impulse j applied at 'r' with an extra moment 'moment'
+static inline spatial_t pointImpulse( cpVect j, cpFloat moment, cpVect r ) {
+	return spatial( moment + cpvcross( r, j ), j );
+}
+
+// inertia of mass m, with moment i about its center of gravity at 'r'
+static inline inertia_t bodyInertia( cpFloat m, cpFloat i, cpVect r ) {
+	inertia_t I = { i + m * cpvdot( r, r ), -m * r.y, m * r.x, m, 0.0f, m };
+	return I;
+}
+
+static inline spatial_t imult( inertia_t I, spatial_t v ) {
+	return spatial(
+		I.ww * v.w + I.wx * v.v.x + I.wy * v.v.y,
+		cpv( I.wx * v.w + I.xx * v.v.x + I.xy * v.v.y, I.wy * v.w + I.xy * v.v.x + I.yy * v.v.y )
+	);
+}
+
+static inline inertia_t iadd( inertia_t a, inertia_t b ) {
+	inertia_t I = { a.ww + b.ww, a.wx + b.wx, a.wy + b.wy, a.xx + b.xx, a.xy + b.xy, a.yy + b.yy };
+	return I;
+}
+
+// I - U U^T / D
+static inline inertia_t ireduce( inertia_t I, spatial_t U, cpFloat D ) {
+	cpFloat d = 1.0f / D;
+	inertia_t R = {
+		I.ww - U.w * U.w * d, I.wx - U.w * U.v.x * d, I.wy - U.w * U.v.y * d,
+		I.xx - U.v.x * U.v.x * d, I.xy - U.v.x * U.v.y * d, I.yy - U.v.y * U.v.y * d
+	};
+	return R;
+}
+
+// I^-1 f
+static inline spatial_t isolve( inertia_t I, spatial_t f ) {
+	cpFloat A = I.xx * I.yy - I.xy * I.xy;
+	cpFloat B = I.wy * I.xy - I.wx * I.yy;
+	cpFloat C = I.wx * I.xy - I.wy * I.xx;
+	cpFloat E = I.ww * I.yy - I.wy * I.wy;
+	cpFloat F = I.wx * I.wy - I.ww * I.xy;
+	cpFloat G = I.ww * I.xx - I.wx * I.wx;
+
+	cpFloat det = I.ww * A + I.wx * B + I.wy * C;
+	assert( det != 0.0f );
+	cpFloat d = 1.0f / det;
+
+	return spatial(
+		( A * f.w + B * f.v.x + C * f.v.y ) * d,
+		cpv( ( B * f.w + E * f.v.x + F * f.v.y ) * d, ( C * f.w + F * f.v.x + G * f.v.y ) * d )
+	);
+}
+
+
+/*
+ * ADT implementation
+ */
+
+Articulation createArticulation( cpSpace *space, cpBody **bodies, int *parents, int numLinks ) {
+	assert( numLinks > 0 && parents[0] == -1 );
+
+	Articulation art = malloc( sizeof( struct articulation ) );
+	assert( art != NULL );
+
+	art->space = space;
+	art->numLinks = numLinks;
+	art->arbiters = cpArrayNew( 0 );
+	art->origin = bodies[0]->p;
+	art->mass = 0.0f;
+
+	art->links = calloc( numLinks, sizeof( link_t ) );
+	assert( art->links != NULL );
+
+	for ( int i = 0; i < numLinks; ++i ) {
+		link_t *link = &art->links[i];
+		assert( i == 0 || ( parents[i] >= 0 && parents[i] < i ) );
+
+		link->articulation = art;
+		link->parent = parents[i];
+		link->body = bodies[i];
+		link->free = 1;
+		art->mass += bodies[i]->m;
+
+		if ( i > 0 ) {
+			link->pivot = cpBodyWorld2Local( bodies[parents[i]], bodies[i]->p );
+		}
+
+		// the proxies are integrated by the articulation, not the space
+		cpBody *body = link->body;
+		body->data = link;
+		body->velocity_func = proxyVelocityFunc;
+		body->position_func = ( i == 0 ) ? rootPositionFunc : proxyPositionFunc;
+
+		// start at rest in the construction pose
+		body->v = cpvzero;
+		body->w = 0.0f;
+		body->v_bias = cpvzero;
+		body->w_bias = 0.0f;
+
+		articulationJoint *joint = cpmalloc( sizeof( articulationJoint ) );
+		assert( joint != NULL );
+		cpConstraintInit( (cpConstraint *)joint, &articulationJointClass, body, ( i == 0 ) ? body : bodies[parents[i]] );
+		joint->articulation = art;
+		joint->driver = ( i == 0 );
+
+		cpSpaceAddConstraint( space, (cpConstraint *)joint );
+	}
+
+	return art;
+}
+
+void destroyArticulation( Articulation art ) {
+	cpArrayFree( art->arbiters );
+	free( art->links );
+	free( art );
+}
+
+void setArticulationMotor( Articulation art, int link, cpFloat frequency, cpFloat amplitude, cpFloat phase, cpFloat maxForce ) {
+	assert( link > 0 && link < art->numLinks );
+
+	art->links[link].frequency = frequency;
+	art->links[link].amplitude = amplitude;
+	art->links[link].phase = phase;
+	art->links[link].maxForce = maxForce;
+}
+
+int getArticulationNumLinks( Articulation art ) {
+	return art->numLinks;
+}
+
+cpFloat getArticulationJointAngle( Articulation art, int link ) {
+	return art->links[link].q;
+}
+
+cpFloat getArticulationMotorWork( Articulation art, int link ) {
+	return art->links[link].work;
+}
+
+int getArticulationNumContacts( Articulation art ) {
+	return art->arbiters->num;
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+// velocities are integrated by the driver's pre-step
+static void proxyVelocityFunc( cpBody *body, cpVect gravity, cpFloat damping, cpFloat dt ) {
+}
+
+// positions are integrated by the root
+static void proxyPositionFunc( cpBody *body, cpFloat dt ) {
+}
+
+static inline int isProxyOf( cpBody *body, Articulation art ) {
+	return body->velocity_func == proxyVelocityFunc && ( (link_t *)body->data )->articulation == art;
+}
+
+static inline int isStatic( cpBody *body ) {
+	return body->m_inv == 0.0f && body->i_inv == 0.0f;
+}
+
+/*
+ * Integrate the root like a free body, the joints in joint space,
+ * then place the limbs (forward kinematics). The limbs move along arcs
+ * this way, which puts the centre of mass somewhere its velocity
+ * doesn't take it, and the same root velocity and joint rates give the
+ * new pose other momenta (enough to fly on at long steps). So the tree
+ * is then moved to where its centre of mass goes, and the root's
+ * velocity changed to keep its momenta.
+ */
+static void rootPositionFunc( cpBody *body, cpFloat dt ) {
+	Articulation art = ( (link_t *)body->data )->articulation;
+	cpVect centre = massCentre( art );
+
+	cpVect linear;
+	cpFloat angular;
+	treeMomentum( art, centre, &linear, &angular );
+	centre = cpvadd( centre, cpvmult( massVelocity( art ), dt ) );
+
+	cpBodyUpdatePosition( body, dt );
+
+	for ( int i = 1; i < art->numLinks; ++i ) {
+		link_t *link = &art->links[i];
+
+		link->q += ( link->qd + link->qdBias ) * dt;
+		link->qdBias = 0.0f;
+		placeLink( art, link );
+
+		link->body->v_bias = cpvzero;
+		link->body->w_bias = 0.0f;
+	}
+
+	cpVect shift = cpvsub( centre, massCentre( art ) );
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		cpBody *linkBody = art->links[i].body;
+		linkBody->p = cpvadd( linkBody->p, shift );
+	}
+
+	setTreeMomentum( art, centre, linear, angular );
+}
+
+static cpVect massCentre( Articulation art ) {
+	cpVect sum = cpvzero;
+
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		cpBody *body = art->links[i].body;
+		sum = cpvadd( sum, cpvmult( body->p, body->m ) );
+	}
+
+	return cpvmult( sum, 1.0f / art->mass );
+}
+
+/*
+ * Linear momentum of the tree, and its angular momentum about 'centre',
+ * from the root's velocity and the joint rates in the current pose
+ */
+static void treeMomentum( Articulation art, cpVect centre, cpVect *linear, cpFloat *angular ) {
+	int numLinks = art->numLinks;
+	cpVect v[numLinks];
+	cpFloat w[numLinks];
+
+	*linear = cpvzero;
+	*angular = 0.0f;
+
+	for ( int i = 0; i < numLinks; ++i ) {
+		link_t *link = &art->links[i];
+		cpBody *body = link->body;
+
+		if ( i == 0 ) {
+			v[i] = body->v;
+			w[i] = body->w;
+		} else {
+			cpBody *parent = art->links[link->parent].body;
+			v[i] = cpvadd( v[link->parent], cpvmult( cpvperp( cpvsub( body->p, parent->p ) ), w[link->parent] ) );
+			w[i] = w[link->parent] + link->qd;
+		}
+
+		*linear = cpvadd( *linear, cpvmult( v[i], body->m ) );
+		*angular += body->m * cpvcross( cpvsub( body->p, centre ), v[i] ) + body->i * w[i];
+	}
+}
+
+/*
+ * Changes the root's velocity (spinning and moving the whole tree) so the
+ * tree has these momenta, angular about 'centre', its centre of mass
+ */
+static void setTreeMomentum( Articulation art, cpVect centre, cpVect linear, cpFloat angular ) {
+	cpBody *root = art->links[0].body;
+
+	cpFloat inertia = 0.0f;
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		cpBody *body = art->links[i].body;
+		inertia += body->i + body->m * cpvlengthsq( cpvsub( body->p, centre ) );
+	}
+
+	cpVect currentLinear;
+	cpFloat currentAngular;
+	treeMomentum( art, centre, &currentLinear, &currentAngular );
+
+	cpFloat dw = ( angular - currentAngular ) / inertia;
+	cpVect dv = cpvmult( cpvsub( linear, currentLinear ), 1.0f / art->mass );
+
+	// spinning about the root moves the centre of mass as well
+	root->w += dw;
+	root->v = cpvadd( root->v, cpvsub( dv, cpvmult( cpvperp( cpvsub( centre, root->p ) ), dw ) ) );
+}
+
+// the links' spatial velocities from the root's velocity and the joint rates
+static void treeVelocities( Articulation art ) {
+	link_t *links = art->links;
+	cpBody *root = links[0].body;
+
+	links[0].V = bodyVelocity( root->v, root->w, links[0].r );
+	for ( int i = 1; i < art->numLinks; ++i ) {
+		links[i].V = sadd( links[links[i].parent].V, smult( links[i].S, links[i].qd ) );
+	}
+}
+
+// including the position correction velocities, as the positions are integrated
+static cpVect massVelocity( Articulation art ) {
+	cpVect sum = cpvzero;
+
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		cpBody *body = art->links[i].body;
+		sum = cpvadd( sum, cpvmult( cpvadd( body->v, body->v_bias ), body->m ) );
+	}
+
+	return cpvmult( sum, 1.0f / art->mass );
+}
+
+// puts a (non-root) link's proxy where its joint angle and its parent's proxy say
+static void placeLink( Articulation art, link_t *link ) {
+	cpBody *parent = art->links[link->parent].body;
+
+	cpBodySetAngle( link->body, parent->a + link->q );
+	link->body->p = cpBodyLocal2World( parent, link->pivot );
+}
+
+/*
+ * Reference point, joint axes and rigid body inertias for the current pose
+ */
+static void updateKinematics( Articulation art ) {
+	art->origin = art->links[0].body->p;
+
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		link_t *link = &art->links[i];
+		cpBody *body = link->body;
+
+		link->r = cpvsub( body->p, art->origin );
+		// revolute joint at the body's position
+		link->S = spatial( 1.0f, cpv( link->r.y, -link->r.x ) );
+		link->I = bodyInertia( body->m, body->i, link->r );
+	}
+}
+
+/*
+ * Number of passes of forwardDynamics a step needs to keep every limb
+ * (and every joint, or the rate its motor will drive it at) within
+ * MAX_PASS_TURN a pass
+ */
+static int countPasses( Articulation art, cpFloat dt ) {
+	cpFloat maxRate = 0.0f;
+
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		link_t *link = &art->links[i];
+		maxRate = cpfmax( maxRate, cpfabs( link->body->w ) );
+		maxRate = cpfmax( maxRate, cpfabs( link->qd ) );
+		maxRate = cpfmax( maxRate, cpfabs( link->frequency * link->amplitude ) );
+	}
+
+	int passes = (int)cpfceil( maxRate * dt / MAX_PASS_TURN );
+	return ( passes < 1 ) ? 1 : ( passes > MAX_PASSES ) ? MAX_PASSES : passes;
+}
+
+/*
+ * Articulated-body algorithm (Featherstone): one step of free motion under
+ * gravity and the motors. Motor joints are treated as prescribed motion
+ * (reaching their target rate this step) unless that needs more than
+ * maxForce torque, in which case they are solved again as free joints
+ * pushed with maxForce.
+ * Leaves the articulated inertias in the links for propagating impulses.
+ */
+static void forwardDynamics( Articulation art, cpVect gravity, cpFloat dt ) {
+	link_t *links = art->links;
+	int numLinks = art->numLinks;
+
+	// velocities, velocity product terms and motor targets
+	links[0].V = bodyVelocity( links[0].body->v, links[0].body->w, links[0].r );
+
+	for ( int i = 0; i < numLinks; ++i ) {
+		link_t *link = &links[i];
+
+		if ( i > 0 ) {
+			spatial_t Vparent = links[link->parent].V;
+			spatial_t Vjoint = smult( link->S, link->qd );
+
+			link->V = sadd( Vparent, Vjoint );
+			link->c = crossMotion( Vparent, Vjoint );
+
+			// motor target, as cpOscillatingMotor
+			link->free = ( link->maxForce == 0.0f );
+			link->tau = 0.0f;
+			link->t += dt;
+
+			cpFloat rate = 0.0f;
+			if ( link->frequency == 0.0f ) {
+				link->t = 0.0f;
+			} else {
+				cpFloat tLimit = (cpFloat)( 2.0 * M_PI ) / link->frequency;
+				if ( link->t > tLimit ) link->t -= tLimit;
+				rate = link->frequency * link->amplitude * cpfcos( link->frequency * link->t + link->phase );
+			}
+			link->qdd = ( rate - link->qd ) / dt;
+		}
+
+		link->VBias = spatialZero;
+		link->qdBias = 0.0f;
+	}
+
+	// saturating a motor changes the articulated inertias, so repeat until no more saturate
+	for ( int pass = 0; pass < numLinks; ++pass ) {
+		for ( int i = 0; i < numLinks; ++i ) {
+			link_t *link = &links[i];
+			cpFloat m = link->body->m;
+
+			spatial_t gravityForce = pointImpulse( cpvmult( gravity, m ), 0.0f, link->r );
+			link->IA = link->I;
+			link->pA = ssub( crossForce( link->V, imult( link->I, link->V ) ), gravityForce );
+		}
+
+		// leaves to root
+		for ( int i = numLinks - 1; i > 0; --i ) {
+			link_t *link = &links[i];
+			link_t *parent = &links[link->parent];
+
+			link->U = imult( link->IA, link->S );
+			link->D = sdot( link->S, link->U );
+
+			inertia_t Ia;
+			spatial_t pa;
+
+			if ( link->free ) {
+				link->u = link->tau - sdot( link->S, link->pA );
+				Ia = ireduce( link->IA, link->U, link->D );
+				pa = sadd( sadd( link->pA, imult( Ia, link->c ) ), smult( link->U, link->u / link->D ) );
+			} else {
+				Ia = link->IA;
+				pa = sadd( link->pA, imult( link->IA, sadd( link->c, smult( link->S, link->qdd ) ) ) );
+			}
+
+			parent->IA = iadd( parent->IA, Ia );
+			parent->pA = sadd( parent->pA, pa );
+		}
+
+		// root to leaves
+		links[0].a = smult( isolve( links[0].IA, links[0].pA ), -1.0f );
+
+		int saturated = 0;
+		for ( int i = 1; i < numLinks; ++i ) {
+			link_t *link = &links[i];
+			spatial_t a = sadd( links[link->parent].a, link->c );
+
+			if ( link->free ) {
+				link->qdd = ( link->u - sdot( a, link->U ) ) / link->D;
+				link->a = sadd( a, smult( link->S, link->qdd ) );
+			} else {
+				link->a = sadd( a, smult( link->S, link->qdd ) );
+				link->tau = sdot( link->S, sadd( imult( link->IA, link->a ), link->pA ) );
+
+				if ( cpfabs( link->tau ) > link->maxForce ) {
+					link->free = 1;
+					link->tau = ( link->tau > 0.0f ) ? link->maxForce : -link->maxForce;
+					saturated = 1;
+				}
+			}
+		}
+
+		if ( !saturated ) break;
+	}
+
+	// integrate velocities, the root's as a classical acceleration
+	// (the spatial one also carries the change of the point the root's velocity is measured at)
+	cpBody *root = links[0].body;
+	cpVect rootAcceleration = cpvadd( links[0].a.v, cpvmult( cpvperp( root->v ), root->w ) );
+	links[0].V = spatial( root->w + links[0].a.w * dt, cpvadd( root->v, cpvmult( rootAcceleration, dt ) ) );
+	for ( int i = 1; i < numLinks; ++i ) {
+		link_t *link = &links[i];
+		link->qd += link->qdd * dt;
+		link->V = sadd( links[link->parent].V, smult( link->S, link->qd ) );
+		link->work += cpfabs( link->tau * link->qd ) * dt;
+	}
+}
+
+/*
+ * forwardDynamics over 'passes' equal parts of the step, moving the tree
+ * along its velocities between them. The tree is then put back where it
+ * started (the space moves it along its final velocities, as any body),
+ * with the articulated inertias for that pose.
+ */
+static void splitDynamics( Articulation art, cpVect gravity, cpFloat dt, int passes ) {
+	link_t *links = art->links;
+	int numLinks = art->numLinks;
+	cpBody *root = links[0].body;
+
+	cpVect startPosition = root->p;
+	cpFloat startAngle = root->a;
+	cpFloat startQ[numLinks];
+	for ( int i = 1; i < numLinks; ++i ) {
+		startQ[i] = links[i].q;
+	}
+
+	cpFloat h = dt / passes;
+	for ( int pass = 0; pass < passes; ++pass ) {
+		if ( pass > 0 ) {
+			root->p = cpvadd( root->p, cpvmult( root->v, h ) );
+			cpBodySetAngle( root, root->a + root->w * h );
+			for ( int i = 1; i < numLinks; ++i ) {
+				links[i].q += links[i].qd * h;
+				placeLink( art, &links[i] );
+			}
+			updateKinematics( art );
+		}
+
+		forwardDynamics( art, gravity, h );
+
+		// the root's velocity, for the next pass
+		root->v = pointVelocity( links[0].V, links[0].r );
+		root->w = links[0].V.w;
+	}
+
+	root->p = startPosition;
+	cpBodySetAngle( root, startAngle );
+	for ( int i = 1; i < numLinks; ++i ) {
+		links[i].q = startQ[i];
+		placeLink( art, &links[i] );
+	}
+	updateKinematics( art );
+	articulatedInertias( art );
+}
+
+/*
+ * The articulated inertias (and IA*S, S.IA.S) of the links in the current
+ * pose, with the joints left free by the last forwardDynamics
+ */
+static void articulatedInertias( Articulation art ) {
+	link_t *links = art->links;
+
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		links[i].IA = links[i].I;
+	}
+
+	for ( int i = art->numLinks - 1; i > 0; --i ) {
+		link_t *link = &links[i];
+		link_t *parent = &links[link->parent];
+
+		link->U = imult( link->IA, link->S );
+		link->D = sdot( link->S, link->U );
+		parent->IA = iadd( parent->IA, link->free ? ireduce( link->IA, link->U, link->D ) : link->IA );
+	}
+}
+
+/*
+ * Velocity change of every link from the impulses in link->f,
+ * using the articulated inertias of the last forwardDynamics().
+ * Motor joints that are holding their rate absorb any impulse.
+ * Results are left in link->a (spatial) and link->qdd (joint), f is cleared.
+ */
+static void propagateImpulses( Articulation art ) {
+	link_t *links = art->links;
+	int numLinks = art->numLinks;
+
+	for ( int i = 0; i < numLinks; ++i ) {
+		links[i].pA = smult( links[i].f, -1.0f );
+		links[i].f = spatialZero;
+	}
+
+	for ( int i = numLinks - 1; i > 0; --i ) {
+		link_t *link = &links[i];
+		spatial_t pa = link->pA;
+
+		if ( link->free ) {
+			link->u = -sdot( link->S, link->pA );
+			pa = sadd( pa, smult( link->U, link->u / link->D ) );
+		}
+
+		links[link->parent].pA = sadd( links[link->parent].pA, pa );
+	}
+
+	links[0].a = smult( isolve( links[0].IA, links[0].pA ), -1.0f );
+
+	for ( int i = 1; i < numLinks; ++i ) {
+		link_t *link = &links[i];
+		spatial_t a = links[link->parent].a;
+
+		link->qdd = link->free ? ( link->u - sdot( a, link->U ) ) / link->D : 0.0f;
+		link->a = sadd( a, smult( link->S, link->qdd ) );
+	}
+}
+
+/*
+ * Copy the tree's velocities (or position correction velocities) onto the proxies
+ */
+static void writeProxies( Articulation art, int bias ) {
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		link_t *link = &art->links[i];
+		cpBody *body = link->body;
+
+		if ( bias ) {
+			body->v_bias = link->vBias = pointVelocity( link->VBias, link->r );
+			body->w_bias = link->wBias = link->VBias.w;
+		} else {
+			body->v = link->v = pointVelocity( link->V, link->r );
+			body->w = link->w = link->V.w;
+		}
+	}
+}
+
+/*
+ * Pick up impulses applied to the proxies since they were last written
+ * and apply them to the tree instead. Returns true if there were any.
+ */
+static int syncProxies( Articulation art, int bias ) {
+	int changed = 0;
+
+	for ( int i = 0; i < art->numLinks; ++i ) {
+		link_t *link = &art->links[i];
+		cpBody *body = link->body;
+
+		cpVect dv = bias ? cpvsub( body->v_bias, link->vBias ) : cpvsub( body->v, link->v );
+		cpFloat dw = bias ? body->w_bias - link->wBias : body->w - link->w;
+
+		if ( dv.x != 0.0f || dv.y != 0.0f || dw != 0.0f ) {
+			link->f = pointImpulse( cpvmult( dv, body->m ), dw * body->i, link->r );
+			changed = 1;
+		}
+	}
+
+	if ( changed ) {
+		propagateImpulses( art );
+
+		for ( int i = 0; i < art->numLinks; ++i ) {
+			link_t *link = &art->links[i];
+
+			if ( bias ) {
+				link->VBias = sadd( link->VBias, link->a );
+				link->qdBias += link->qdd;
+			} else {
+				link->V = sadd( link->V, link->a );
+				link->qd += link->qdd;
+			}
+		}
+
+		writeProxies( art, bias );
+	}
+
+	return changed;
+}
+
+// inverse of the articulated mass felt by a contact along 'dir'
+static cpFloat contactInverseMass( Articulation art, cpBody *a, cpBody *b, cpVect point, cpVect dir ) {
+	cpVect r = cpvsub( point, art->origin );
+
+	// equal and opposite unit impulses, as apply_impulses()
+	if ( isProxyOf( a, art ) ) {
+		link_t *link = a->data;
+		link->f = sadd( link->f, pointImpulse( cpvneg( dir ), 0.0f, r ) );
+	}
+	if ( isProxyOf( b, art ) ) {
+		link_t *link = b->data;
+		link->f = sadd( link->f, pointImpulse( dir, 0.0f, r ) );
+	}
+
+	propagateImpulses( art );
+
+	cpVect va = isProxyOf( a, art ) ? pointVelocity( ( (link_t *)a->data )->a, r ) : cpvzero;
+	cpVect vb = isProxyOf( b, art ) ? pointVelocity( ( (link_t *)b->data )->a, r ) : cpvzero;
+
+	return cpvdot( cpvsub( vb, va ), dir );
+}
+
+/*
+ * Take the contacts between the limbs and the static ground (or each other)
+ * out of the space's solver, so they can be solved one contact at a time
+ * with the tree's response. Contacts with other dynamic bodies are left
+ * to the space, their impulses are picked up by syncProxies().
+ */
+static void claimContacts( Articulation art ) {
+	cpArray *arbiters = art->space->arbiters;
+	art->arbiters->num = 0;
+
+	int kept = 0;
+	for ( int i = 0; i < arbiters->num; ++i ) {
+		cpArbiter *arb = arbiters->arr[i];
+		cpBody *a = arb->a->body;
+		cpBody *b = arb->b->body;
+
+		int claim = ( isProxyOf( a, art ) && ( isProxyOf( b, art ) || isStatic( b ) ) )
+		         || ( isProxyOf( b, art ) && isStatic( a ) );
+
+		if ( !claim ) {
+			arbiters->arr[kept++] = arb;
+			continue;
+		}
+
+		cpArrayPush( art->arbiters, arb );
+		// the space won't get to post-solve it
+		arb->state = cpArbiterStateNormal;
+
+		for ( int j = 0; j < arb->numContacts; ++j ) {
+			cpContact *con = &arb->contacts[j];
+			con->nMass = 1.0f / contactInverseMass( art, a, b, con->p, con->n );
+			con->tMass = 1.0f / contactInverseMass( art, a, b, con->p, cpvperp( con->n ) );
+		}
+
+		cpArbiterApplyCachedImpulse( arb );
+	}
+	arbiters->num = kept;
+
+	qsort( art->arbiters->arr, art->arbiters->num, sizeof( cpArbiter * ), compareArbiters );
+
+	syncProxies( art, 0 );
+}
+
+/*
+ * Order of the claimed contacts, which are solved one after another: by
+ * their shapes' ids, which are only in the same order from one simulation
+ * to the next (unlike the order the space finds the contacts in, which
+ * follows the ids' hashes)
+ */
+static int compareArbiters( const void *a, const void *b ) {
+	const cpArbiter *arbA = *(cpArbiter * const *)a;
+	const cpArbiter *arbB = *(cpArbiter * const *)b;
+
+	cpHashValue lowA = arbA->a->hashid < arbA->b->hashid ? arbA->a->hashid : arbA->b->hashid;
+	cpHashValue highA = arbA->a->hashid < arbA->b->hashid ? arbA->b->hashid : arbA->a->hashid;
+	cpHashValue lowB = arbB->a->hashid < arbB->b->hashid ? arbB->a->hashid : arbB->b->hashid;
+	cpHashValue highB = arbB->a->hashid < arbB->b->hashid ? arbB->b->hashid : arbB->a->hashid;
+
+	if ( lowA != lowB ) return ( lowA < lowB ) ? -1 : 1;
+	if ( highA != highB ) return ( highA < highB ) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Run the normal arbiter solver on a single contact,
+ * then push the result through the tree before the next one
+ */
+static void solveContact( Articulation art, cpArbiter *arb, int contact ) {
+	int numContacts = arb->numContacts;
+	cpContact *contacts = arb->contacts;
+
+	arb->numContacts = 1;
+	arb->contacts = &contacts[contact];
+	cpArbiterApplyImpulse( arb, 1.0f );
+	arb->numContacts = numContacts;
+	arb->contacts = contacts;
+
+	syncProxies( art, 1 );
+	syncProxies( art, 0 );
+}
+
+static void preStep( articulationJoint *joint, cpFloat dt, cpFloat dt_inv ) {
+	if ( !joint->driver ) return;
+
+	Articulation art = joint->articulation;
+
+	updateKinematics( art );
+
+	cpVect centre = massCentre( art );
+	cpVect linear;
+	cpFloat angular;
+	treeMomentum( art, centre, &linear, &angular );
+
+	int passes = countPasses( art, dt );
+	if ( passes > 1 ) {
+		splitDynamics( art, art->space->gravity, dt, passes );
+	} else {
+		forwardDynamics( art, art->space->gravity, dt );
+	}
+
+	// the algorithm keeps the momenta only as well as it integrates the velocity product
+	// terms, but nothing inside the tree can change them: only gravity does
+	cpBody *root = art->links[0].body;
+	root->v = pointVelocity( art->links[0].V, art->links[0].r );
+	root->w = art->links[0].V.w;
+	setTreeMomentum( art, centre, cpvadd( linear, cpvmult( art->space->gravity, art->mass * dt ) ), angular );
+	treeVelocities( art );
+
+	writeProxies( art, 0 );
+	writeProxies( art, 1 );
+
+	claimContacts( art );
+}
+
+static void applyImpulse( articulationJoint *joint ) {
+	if ( !joint->driver ) return;
+
+	Articulation art = joint->articulation;
+
+	// impulses from the space's own arbiters and constraints
+	syncProxies( art, 1 );
+	syncProxies( art, 0 );
+
+	for ( int i = 0; i < art->arbiters->num; ++i ) {
+		cpArbiter *arb = art->arbiters->arr[i];
+
+		for ( int j = 0; j < arb->numContacts; ++j ) {
+			solveContact( art, arb, j );
+		}
+	}
+}
+
+// total impulse of the claimed contacts, so the space can tell when they have converged
+static cpFloat getImpulse( articulationJoint *joint ) {
+	if ( !joint->driver ) return 0.0f;
+
+	Articulation art = joint->articulation;
+	cpFloat impulse = 0.0f;
+
+	for ( int i = 0; i < art->arbiters->num; ++i ) {
+		cpArbiter *arb = art->arbiters->arr[i];
+
+		for ( int j = 0; j < arb->numContacts; ++j ) {
+			impulse += arb->contacts[j].jnAcc + cpfabs( arb->contacts[j].jtAcc );
+		}
+	}
+
+	return impulse;
+}
@@ -0,0 +1,59 @@
+/*
+ * Articulation ADT:
+ *  Reduced-coordinate (Featherstone articulated-body) dynamics
+ *  for a tree of rigid limbs connected by motor-driven revolute joints
+ *
+ * The limbs are simulated in joint coordinates: a floating root body
+ * plus one joint angle per limb, so joints can never separate.
+ * Each limb keeps a normal chipmunk body and shape as a proxy, which
+ * is used for collision detection and is kept in sync with the tree.
+ * Contacts on the proxies are found and pre-stepped by the space as usual,
+ * then solved by the articulation with their articulated effective mass,
+ * their impulses being propagated through the tree in O(n).
+ *
+ * Limitations:
+ *  - the space's graph coloring solver must not be used (islands are fine)
+ *  - postSolve collision callbacks are not called for contacts between a
+ *    limb and the static ground (or another limb of the same articulation)
+ *  - space damping and body velocity limits are ignored for the limbs
+ *  - the space's elasticIterations should be left at 0
+ */
+
+#include "chipmunk.h"
+
+typedef struct articulation *Articulation;
+
+/*
+ * Constructor: Takes over the simulation of a tree of bodies.
+ *  Bodies must already be in the space, in their construction pose,
+ *  and ordered so that parents come before their children
+ *  (parents[0] == -1 for the root, which floats freely).
+ *  Each body's joint is placed at its position (its center of gravity).
+ * Deconstructor: Removes memory allocated for the articulation.
+ *  Its constraints are left in the space and freed with it.
+ */
+Articulation createArticulation( cpSpace *space, cpBody **bodies, int *parents, int numLinks );
+void destroyArticulation( Articulation articulation );
+
+/*
+ * Drives the joint of a (non-root) link like a cpOscillatingMotor:
+ *  relative angular velocity = frequency * amplitude * cos( frequency * t + phase )
+ *  using at most maxForce torque
+ */
+void setArticulationMotor( Articulation articulation, int link, cpFloat frequency, cpFloat amplitude, cpFloat phase, cpFloat maxForce );
+
+int getArticulationNumLinks( Articulation articulation );
+cpFloat getArticulationJointAngle( Articulation articulation, int link );
+
+/*
+ * Energy a link's motor has used so far: its torque times the joint's
+ * rate, integrated over the steps (0 for the root)
+ */
+cpFloat getArticulationMotorWork( Articulation articulation, int link );
+
+/*
+ * Number of the limbs' contacts with the ground (or each other) the
+ * articulation solved in the last step (they are taken out of the
+ * space's arbiters)
+ */
+int getArticulationNumContacts( Articulation articulation );
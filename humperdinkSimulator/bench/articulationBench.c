@@ -0,0 +1,204 @@
+/*
+ * Articulated solver benchmark:
+ *  simulates a set of random creatures (plus any .hdk files given with -f)
+ *  with pivot joints and with the articulated solver (-a), over a range of
+ *  timesteps and solver passes, and reports for each how far the joints
+ *  came apart, how deep limbs went into the ground, how far each
+ *  creature's fitness (distance travelled) ends up from the same solver at
+ *  1/60 s and 10 passes, and how many creatures became unstable (blew up,
+ *  or ended up in the ground). Fails (exit status 1) if the articulated
+ *  solver leaves any creature unstable that pivot joints don't.
+ *
+ * usage: articulationBench [-n creatures] [-l limbs] [-s seconds] [-f file.hdk ...]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "../finite.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+// a creature with a limb moving faster than this, or ending up further than this below the ground
+// (further than limbs sink into it for a step, even at 1/10 s) is unstable
+#define MAX_SPEED 10000.0
+#define MAX_DEPTH 100.0
+
+typedef struct {
+	double fitness;
+	double meanSeparation;
+	double maxSeparation;
+	double maxDepth;
+	int unstable;
+} result_t;
+
+static result_t runCreature( json_t *genome, int articulated, double timestep, int iterations, double duration );
+
+
+int main( int argc, char *argv[] ) {
+	int numRandom = 20;
+	int limbs = 6;
+	double duration = 10.0;
+
+	int numFiles = 0;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numRandom = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-f", 2 ) == 0 && i+1 < argc ) {
+			numFiles++;
+		}
+	}
+
+	json_t **genomes = malloc( sizeof( json_t * ) * ( numFiles + numRandom ) );
+	assert( genomes != NULL );
+	int numGenomes = 0;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-f", 2 ) == 0 && i+1 < argc ) {
+			json_error_t error;
+			json_t *json = json_load_file( argv[i+1], &error );
+
+			if ( !json ) {
+				fprintf( stderr, "Error parsing humperdink on line %d:\n", error.line );
+				fprintf( stderr, "\t%s\n\n", error.text );
+				exit( 1 );
+			}
+			genomes[numGenomes++] = json;
+		}
+	}
+	for ( int i = 0; i < numRandom; ++i ) {
+		genomes[numGenomes++] = createRandomGenome( limbs, i + 1 );
+	}
+	assert( numGenomes > 0 );
+
+	cpInitChipmunk( );
+
+	const double timesteps[] = { 1.0/60.0, 1.0/30.0, 1.0/20.0, 1.0/10.0 };
+	const char *timestepNames[] = { "1/60", "1/30", "1/20", "1/10" };
+	const int iterationCounts[] = { 5, 10, 20 };
+	int numTimesteps = sizeof( timesteps ) / sizeof( timesteps[0] );
+	int numIterations = sizeof( iterationCounts ) / sizeof( iterationCounts[0] );
+
+	printf( "%d creatures, %.1f simulated seconds each\n\n", numGenomes, duration );
+	printf( "%-12s %-9s %7s %16s %16s %10s %12s %9s\n",
+		"solver", "timestep", "passes", "mean separation", "max separation", "max depth", "mean error", "unstable" );
+
+	// each solver's results at the simulator's defaults
+	result_t baselines[2][numGenomes];
+	for ( int articulated = 0; articulated <= 1; ++articulated ) {
+		for ( int i = 0; i < numGenomes; ++i ) {
+			baselines[articulated][i] = runCreature( genomes[i], articulated, 1.0/60.0, 10, duration );
+		}
+	}
+
+	int failed = 0;
+
+	for ( int t = 0; t < numTimesteps; ++t ) {
+		for ( int n = 0; n < numIterations; ++n ) {
+			int pivotUnstable[numGenomes];
+
+			for ( int articulated = 0; articulated <= 1; ++articulated ) {
+				double meanSeparation = 0.0;
+				double maxSeparation = 0.0;
+				double maxDepth = 0.0;
+				double meanError = 0.0;
+				int stable = 0;
+				int unstable = 0;
+
+				for ( int i = 0; i < numGenomes; ++i ) {
+					result_t *baseline = &baselines[articulated][i];
+					result_t result = runCreature( genomes[i], articulated, timesteps[t], iterationCounts[n], duration );
+
+					if ( !articulated ) {
+						pivotUnstable[i] = result.unstable;
+					} else if ( result.unstable && !pivotUnstable[i] ) {
+						failed = 1;
+					}
+
+					if ( result.unstable ) {
+						unstable++;
+						continue;
+					}
+
+					meanSeparation += result.meanSeparation;
+					maxSeparation = fmax( maxSeparation, result.maxSeparation );
+					maxDepth = fmax( maxDepth, result.maxDepth );
+					if ( !baseline->unstable ) {
+						meanError += fabs( result.fitness - baseline->fitness );
+						stable++;
+					}
+				}
+
+				printf( "%-12s %-9s %7d %16.4f %16.4f %10.2f %12.3f %9d\n",
+					articulated ? "articulated" : "pivot", timestepNames[t], iterationCounts[n],
+					( unstable < numGenomes ) ? meanSeparation / ( numGenomes - unstable ) : 0.0,
+					maxSeparation,
+					maxDepth,
+					( stable > 0 ) ? meanError / stable : 0.0,
+					unstable
+				);
+			}
+		}
+	}
+
+	printf( "\n(separations are between each limb's start and its parent's end, depths are below the ground's\n" );
+	printf( " surface, errors are in distance travelled, relative to the same solver at 1/60 s and 10 passes,\n" );
+	printf( " all over stable creatures)\n" );
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_decref( genomes[i] );
+	}
+	free( genomes );
+
+	return failed;
+}
+
+static result_t runCreature( json_t *genome, int articulated, double timestep, int iterations, double duration ) {
+	Environment env = createEnvironment( 800, 600 );
+	setEnvironmentTimestep( env, timestep );
+	setEnvironmentIterations( env, iterations );
+
+	Creature creature;
+	if ( articulated ) {
+		creature = createArticulatedCreature( genome, getEnvironmentSpace( env ) );
+	} else {
+		creature = createCreature( genome, getEnvironmentSpace( env ) );
+	}
+	double startX = getCreatureX( creature );
+
+	result_t result;
+	result.meanSeparation = 0.0;
+	result.maxSeparation = 0.0;
+	result.maxDepth = 0.0;
+	result.unstable = 0;
+
+	creatureState_t state;
+	int updates = (int)( duration / timestep + 0.5 );
+	for ( int i = 0; i < updates && !result.unstable; ++i ) {
+		updateEnvironment( env );
+
+		getCreatureState( creature, &state );
+		result.unstable = state.blownUp || state.maxSpeed > MAX_SPEED;
+
+		result.meanSeparation += state.maxSeparation / updates;
+		result.maxSeparation = fmax( result.maxSeparation, state.maxSeparation );
+		result.maxDepth = fmax( result.maxDepth, getEnvironmentGroundY( env ) - state.lowestY );
+	}
+	result.fitness = getCreatureX( creature ) - startX;
+	result.unstable = result.unstable || !isFiniteValue( result.fitness )
+		|| state.lowestY < getEnvironmentGroundY( env ) - MAX_DEPTH;
+
+	destroyCreature( creature );
+	destroyEnvironment( env );
+
+	return result;
+}
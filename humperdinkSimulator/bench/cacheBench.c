@@ -0,0 +1,138 @@
+/*
+ * Fitness cache benchmark:
+ *  runs a small elitist GA (the fittest quarter of each generation survives
+ *  unchanged, the rest are offspring of it: new parameters on the same
+ *  limbs, or exact copies), evaluating every genome once without and once
+ *  with a fitness cache, and reports the time each took, the cache's hits,
+ *  and whether the cached results are the same.
+ *  With -f the cache is also kept in a file: run twice to see a restart
+ *  served from the file.
+ *
+ * usage: cacheBench [-n population] [-g generations] [-l limbs] [-s seconds] [-c capacity] [-f cachefile]
+ */
+
+#include "../evaluation.h"
+#include "../fitnessCache.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+// an offspring is an exact copy of its parent this often
+#define COPY_CHANCE 0.3
+
+typedef struct {
+	json_t *genome;
+	double fitness;
+} individual_t;
+
+static int compareFitness( const void *a, const void *b );
+
+
+int main( int argc, char *argv[] ) {
+	int populationSize = 40;
+	int generations = 10;
+	int limbs = 6;
+	double duration = 5.0;
+	int capacity = 1000;
+	char *filename = NULL;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			populationSize = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-g", 2 ) == 0 && i+1 < argc ) {
+			generations = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-c", 2 ) == 0 && i+1 < argc ) {
+			capacity = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-f", 2 ) == 0 && i+1 < argc ) {
+			filename = argv[i+1];
+		}
+	}
+	assert( populationSize >= 4 && generations > 0 );
+
+	cpInitChipmunk( );
+
+	FitnessCache cache = createFitnessCache( capacity, filename );
+	if ( cache == NULL ) {
+		fprintf( stderr, "Can't use %s as a fitness cache\n", filename );
+		exit( 1 );
+	}
+
+	evaluationSettings_t settings = defaultEvaluationSettings( (int)( duration * UPDATES_PER_SECOND + 0.5 ) );
+	int survivors = populationSize / 4;
+	unsigned int seed = 1;
+
+	individual_t population[populationSize];
+	for ( int i = 0; i < populationSize; ++i ) {
+		population[i].genome = createRandomGenome( limbs, seed++ );
+	}
+
+	double uncachedSeconds = 0.0;
+	double cachedSeconds = 0.0;
+	int evaluations = 0;
+	int different = 0;
+
+	for ( int g = 0; g < generations; ++g ) {
+		for ( int i = 0; i < populationSize; ++i ) {
+			metrics_t uncached;
+			metrics_t cached;
+
+			double start = benchTime( );
+			evaluateGenome( population[i].genome, &settings, &uncached );
+			uncachedSeconds += benchTime( ) - start;
+
+			start = benchTime( );
+			evaluateGenomeCached( cache, population[i].genome, &settings, &cached );
+			cachedSeconds += benchTime( ) - start;
+
+			different += ( memcmp( &uncached, &cached, sizeof( metrics_t ) ) != 0 );
+			population[i].fitness = cached.distance;
+			evaluations++;
+		}
+
+		// the survivors stay, the rest are replaced by their offspring
+		qsort( population, populationSize, sizeof( individual_t ), compareFitness );
+		for ( int i = survivors; i < populationSize; ++i ) {
+			json_t *parent = population[rand_r( &seed ) % survivors].genome;
+			json_decref( population[i].genome );
+
+			if ( rand_r( &seed ) < COPY_CHANCE * RAND_MAX ) {
+				population[i].genome = json_deep_copy( parent );
+			} else {
+				population[i].genome = createRandomGenomeLike( parent, seed++ );
+			}
+		}
+	}
+
+	long hits = getFitnessCacheHits( cache );
+
+	printf( "%d generations of %d genomes with %d limbs, %.1f simulated seconds each\n\n", generations, populationSize, limbs, duration );
+	printf( "%-10s %10s %14s\n", "cache", "seconds", "evaluations/s" );
+	printf( "%-10s %10.3f %14.1f\n", "none", uncachedSeconds, evaluations / uncachedSeconds );
+	printf( "%-10s %10.3f %14.1f\n", "cached", cachedSeconds, evaluations / cachedSeconds );
+	printf( "speedup %.2f\n\n", uncachedSeconds / cachedSeconds );
+	printf( "cache hits: %ld of %d (%.0f%%)\n", hits, evaluations, 100.0 * hits / evaluations );
+	printf( "results different from a new evaluation: %d\n", different );
+
+	for ( int i = 0; i < populationSize; ++i ) {
+		json_decref( population[i].genome );
+	}
+	destroyFitnessCache( cache );
+
+	return 0;
+}
+
+// fittest first
+static int compareFitness( const void *a, const void *b ) {
+	double x = ( (const individual_t *)a )->fitness;
+	double y = ( (const individual_t *)b )->fitness;
+	return ( x < y ) - ( x > y );
+}
@@ -0,0 +1,152 @@
+/*
+ * Evolution benchmark:
+ *  runs the same GA (evolution.h) from random genomes with 1, 2, 4, ...
+ *  threads, reports the time each run took and its evaluations per second,
+ *  and checks every run wrote the same final generation. Then, as an
+ *  external script driving the simulator would, writes each genome of the
+ *  final generation to its own file and runs the simulator on it (with -g,
+ *  its output thrown away), and reports the evaluations per second of that.
+ *
+ * usage: evolutionBench [-n population] [-g generations] [-s seconds] [-t max threads] [-p simulator]
+ */
+
+#include "../evolution.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+#define GENOME_FILE "evolutionBench.hdk"
+
+static char *runEvolution( evolutionSettings_t *settings, evaluationSettings_t *evaluation, double *seconds, long *evaluations );
+static double runSimulator( const char *simulator, const char *generation, int updates, int *runs );
+
+
+int main( int argc, char *argv[] ) {
+	evolutionSettings_t settings = defaultEvolutionSettings( );
+	settings.populationSize = 40;
+	settings.generations = 10;
+	double duration = 10.0;
+	int maxThreads = 8;
+	char *simulator = "./simulator";
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			settings.populationSize = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-g", 2 ) == 0 && i+1 < argc ) {
+			settings.generations = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[++i] );
+		} else if ( strncmp( argv[i], "-t", 2 ) == 0 && i+1 < argc ) {
+			maxThreads = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-p", 2 ) == 0 && i+1 < argc ) {
+			simulator = argv[++i];
+		}
+	}
+	assert( settings.populationSize > 0 && settings.generations > 0 && maxThreads > 0 );
+
+	cpInitChipmunk( );
+
+	int updates = (int)( duration * UPDATES_PER_SECOND + 0.5 );
+	evaluationSettings_t evaluation = defaultEvaluationSettings( updates );
+
+	printf( "%d generations of %d, %.1f simulated seconds each\n\n", settings.generations, settings.populationSize, duration );
+	printf( "%-20s %10s %12s %14s\n", "evaluator", "seconds", "evaluations", "evaluations/s" );
+
+	char *expected = NULL;
+	int different = 0;
+	for ( int threads = 1; threads <= maxThreads; threads *= 2 ) {
+		double seconds;
+		long evaluations;
+		settings.threads = threads;
+		char *generation = runEvolution( &settings, &evaluation, &seconds, &evaluations );
+
+		char name[32];
+		snprintf( name, sizeof( name ), "in-process, %d thread%s", threads, ( threads > 1 ) ? "s" : "" );
+		printf( "%-20s %10.3f %12ld %14.1f\n", name, seconds, evaluations, evaluations / seconds );
+
+		if ( expected == NULL ) {
+			expected = generation;
+		} else {
+			different += ( strcmp( expected, generation ) != 0 );
+			free( generation );
+		}
+	}
+
+	if ( access( simulator, X_OK ) == 0 ) {
+		int runs;
+		double seconds = runSimulator( simulator, expected, updates, &runs );
+		printf( "%-20s %10.3f %12d %14.1f\n", "process per genome", seconds, runs, runs / seconds );
+	} else {
+		printf( "(no %s to compare with, see -p)\n", simulator );
+	}
+
+	printf( "\nruns with a different final generation: %d\n", different );
+
+	free( expected );
+	return different ? 1 : 0;
+}
+
+// runs a GA to the end, and returns its final generation as written by writeEvolution
+static char *runEvolution( evolutionSettings_t *settings, evaluationSettings_t *evaluation, double *seconds, long *evaluations ) {
+	double start = benchTime( );
+
+	Evolution evolution = createEvolution( settings, evaluation, NULL, 0 );
+	for ( int g = 0; g < settings->generations; ++g ) {
+		if ( g > 0 ) {
+			nextGeneration( evolution );
+		}
+		evaluateGeneration( evolution );
+	}
+
+	*seconds = benchTime( ) - start;
+	*evaluations = getEvolutionEvaluations( evolution );
+
+	char *text;
+	size_t length;
+	FILE *output = open_memstream( &text, &length );
+	assert( output != NULL );
+	if ( !writeEvolution( evolution, output ) ) {
+		fprintf( stderr, "writeEvolution failed\n" );
+		exit( 1 );
+	}
+	fclose( output );
+
+	destroyEvolution( evolution );
+	return text;
+}
+
+// a file and a run of the simulator for each line of a generation
+static double runSimulator( const char *simulator, const char *generation, int updates, int *runs ) {
+	char command[1024];
+	snprintf( command, sizeof( command ), "%s -g -i %d -f %s > /dev/null 2>&1", simulator, updates, GENOME_FILE );
+
+	double start = benchTime( );
+
+	*runs = 0;
+	for ( const char *line = generation; *line != '\0'; ) {
+		const char *end = strchr( line, '\n' );
+		assert( end != NULL );
+
+		FILE *file = fopen( GENOME_FILE, "w" );
+		assert( file != NULL );
+		fwrite( line, 1, end - line + 1, file );
+		fclose( file );
+
+		if ( system( command ) != 0 ) {
+			fprintf( stderr, "%s failed\n", command );
+			exit( 1 );
+		}
+		( *runs )++;
+		line = end + 1;
+	}
+
+	double seconds = benchTime( ) - start;
+	remove( GENOME_FILE );
+	return seconds;
+}
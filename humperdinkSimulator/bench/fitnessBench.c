@@ -0,0 +1,89 @@
+/*
+ * Fitness benchmark:
+ *  simulates a set of random creatures (plus any .hdk files given with -f)
+ *  and prints each creature's fitness (distance travelled) and the time
+ *  it took, one creature per line.
+ *  Built twice, as fitnessBench and fitnessBench_float (-DCP_USE_DOUBLES=0),
+ *  so bench/precisionBench can compare the two precisions.
+ *
+ * usage: fitnessBench [-n creatures] [-l limbs] [-s seconds] [-f file.hdk ...]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+
+int main( int argc, char *argv[] ) {
+	int numRandom = 20;
+	int limbs = 6;
+	double duration = 30.0;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numRandom = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		}
+	}
+
+	cpInitChipmunk( );
+
+	// lines starting with '#' are for people, not for precisionBench
+	printf( "# cpFloat: %s, cpBody: %d bytes, cpContact: %d bytes\n",
+		( sizeof( cpFloat ) == sizeof( float ) ) ? "float" : "double",
+		(int)sizeof( cpBody ), (int)sizeof( cpContact ) );
+	printf( "# creature fitness seconds\n" );
+
+	int updates = (int)( duration * UPDATES_PER_SECOND + 0.5 );
+	int creature = 0;
+
+	for ( int i = 0; i < argc + numRandom; ++i ) {
+		json_t *genome;
+
+		// the .hdk files first, then the random creatures
+		if ( i < argc ) {
+			if ( strncmp( argv[i], "-f", 2 ) != 0 || i+1 >= argc ) {
+				continue;
+			}
+
+			json_error_t error;
+			genome = json_load_file( argv[i+1], &error );
+
+			if ( !genome ) {
+				fprintf( stderr, "Error parsing humperdink on line %d:\n", error.line );
+				fprintf( stderr, "\t%s\n\n", error.text );
+				exit( 1 );
+			}
+		} else {
+			genome = createRandomGenome( limbs, i - argc + 1 );
+		}
+
+		Environment env = createEnvironment( 800, 600 );
+		Creature simulated = createCreature( genome, getEnvironmentSpace( env ) );
+		double startX = getCreatureX( simulated );
+
+		double start = benchTime( );
+		for ( int j = 0; j < updates; ++j ) {
+			updateEnvironment( env );
+		}
+		double seconds = benchTime( ) - start;
+
+		printf( "%d %.9g %.6f\n", creature++, getCreatureX( simulated ) - startX, seconds );
+
+		destroyCreature( simulated );
+		destroyEnvironment( env );
+		json_decref( genome );
+	}
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Number formatting benchmark:
+ *  simulates a set of random creatures and records their trajectories,
+ *  then writes every position as a line of output (into memory) the way
+ *  the simulator used to, with snprintf's "%lf", with "%.17g" (the
+ *  shortest printf format that always reads back the same), and with
+ *  json_real_str, and reports the time each took. Every number written by
+ *  json_real_str is read back with strtod to check it's the same double.
+ *
+ * usage: formatBench [-n creatures] [-l limbs] [-i iterations] [-r rounds]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define NUM_FORMATS 3
+
+static const char *formatNames[NUM_FORMATS] = { "%lf", "%.17g", "json_real_str" };
+
+static size_t writeLines( int format, double *xs, double *ys, long numPositions, char *output );
+
+
+int main( int argc, char *argv[] ) {
+	int numCreatures = 10;
+	int limbs = 8;
+	int iterations = 3000;
+	int rounds = 5;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numCreatures = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-i", 2 ) == 0 && i+1 < argc ) {
+			iterations = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-r", 2 ) == 0 && i+1 < argc ) {
+			rounds = atoi( argv[++i] );
+		}
+	}
+	assert( numCreatures > 0 && iterations > 0 && rounds > 0 );
+
+	// the trajectories, as the simulator would print them
+	long numPositions = (long)numCreatures * iterations;
+	double *xs = malloc( sizeof( double ) * numPositions );
+	double *ys = malloc( sizeof( double ) * numPositions );
+	assert( xs != NULL && ys != NULL );
+
+	cpInitChipmunk( );
+	long position = 0;
+	for ( int c = 0; c < numCreatures; ++c ) {
+		json_t *genome = createRandomGenome( limbs, c + 1 );
+		Environment env = createEnvironment( 800, 600 );
+		Creature creature = createCreature( genome, getEnvironmentSpace( env ) );
+
+		for ( int i = 0; i < iterations; ++i ) {
+			updateEnvironment( env );
+			xs[position] = getCreatureX( creature );
+			ys[position] = getCreatureY( creature );
+			position++;
+		}
+
+		destroyCreature( creature );
+		destroyEnvironment( env );
+		json_decref( genome );
+	}
+
+	// room for the longest lines
+	char *output = malloc( numPositions * ( 2 * JSON_REAL_STR_LENGTH + 8 ) );
+	assert( output != NULL );
+
+	double seconds[NUM_FORMATS] = { 0.0 };
+	size_t lengths[NUM_FORMATS] = { 0 };
+	for ( int r = 0; r < rounds; ++r ) {
+		for ( int f = 0; f < NUM_FORMATS; ++f ) {
+			double start = benchTime( );
+			lengths[f] = writeLines( f, xs, ys, numPositions, output );
+			seconds[f] += benchTime( ) - start;
+		}
+	}
+
+	// every number reads back as the same double
+	long different = 0;
+	char *text = output;
+	char *end = output + writeLines( NUM_FORMATS - 1, xs, ys, numPositions, output );
+	for ( long i = 0; i < numPositions && text < end; ++i ) {
+		double x = strtod( text + 1, &text );
+		double y = strtod( text + 1, &text );
+		text += 2;
+		if ( x != xs[i] || y != ys[i] ) {
+			different++;
+		}
+	}
+
+	printf( "%d creatures with %d limbs, %d iterations (%ld lines), %d rounds\n\n", numCreatures, limbs, iterations, numPositions, rounds );
+	printf( "%-14s %10s %10s %12s %12s %8s\n", "format", "seconds", "MB/s", "lines/s", "bytes/line", "speedup" );
+	for ( int f = 0; f < NUM_FORMATS; ++f ) {
+		printf( "%-14s %10.3f %10.1f %12.0f %12.1f %8.2f\n", formatNames[f], seconds[f],
+			rounds * lengths[f] / 1e6 / seconds[f], rounds * numPositions / seconds[f],
+			(double)lengths[f] / numPositions, seconds[0] / seconds[f]
+		);
+	}
+	printf( "\nnumbers that didn't read back the same: %ld\n", different );
+
+	free( output );
+	free( xs );
+	free( ys );
+
+	return 0;
+}
+
+// writes every position as "(x, y)\n" in the format, returns the length
+static size_t writeLines( int format, double *xs, double *ys, long numPositions, char *output ) {
+	char *end = output;
+
+	for ( long i = 0; i < numPositions; ++i ) {
+		if ( format == 0 ) {
+			end += sprintf( end, "(%lf, %lf)\n", xs[i], ys[i] );
+		} else if ( format == 1 ) {
+			end += sprintf( end, "(%.17g, %.17g)\n", xs[i], ys[i] );
+		} else {
+			*end++ = '(';
+			end += json_real_str( xs[i], end );
+			*end++ = ',';
+			*end++ = ' ';
+			end += json_real_str( ys[i], end );
+			*end++ = ')';
+			*end++ = '\n';
+		}
+	}
+
+	return end - output;
+}
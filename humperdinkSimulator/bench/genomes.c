@@ -0,0 +1,98 @@
+#include "genomes.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+static json_t *createLimb( double angle, double length, double frequency, double amplitude, double phase );
+static double randomRange( unsigned int *seed, double min, double max );
+static void randomizeLimbs( json_t *limb, unsigned int *seed );
+
+
+json_t *createCentipedeGenome( int segments ) {
+	json_t *root = NULL;
+	json_t *parentConnections = NULL;
+	
+	for ( int i = 0; i < segments; ++i ) {
+		// the root points along the ground, the rest of the spine continues straight on
+		json_t *spine = createLimb( ( i == 0 ) ? -M_PI/2.0 : 0.0, 20.0, 2.0, 0.3, i * 0.5 );
+		json_t *connections = json_object_get( spine, "connections" );
+		
+		json_array_append_new( connections, createLimb(  M_PI/2.0, 15.0, 6.0, 0.8, i * 0.5 ) );
+		json_array_append_new( connections, createLimb( -M_PI/2.0, 15.0, 6.0, 0.8, i * 0.5 + M_PI ) );
+		
+		if ( root == NULL ) {
+			root = spine;
+		} else {
+			json_array_insert_new( parentConnections, 0, spine );
+		}
+		parentConnections = connections;
+	}
+	
+	return root;
+}
+
+json_t *createRandomGenome( int numLimbs, unsigned int seed ) {
+	json_t *limbs[numLimbs];
+	
+	for ( int i = 0; i < numLimbs; ++i ) {
+		limbs[i] = createLimb(
+			randomRange( &seed, -M_PI, M_PI ),
+			randomRange( &seed, 10.0, 40.0 ),
+			randomRange( &seed, 0.0, 8.0 ),
+			randomRange( &seed, 0.0, M_PI ),
+			randomRange( &seed, 0.0, 2.0*M_PI )
+		);
+		
+		// attach to a random earlier limb
+		if ( i > 0 ) {
+			json_t *parent = limbs[rand_r( &seed ) % i];
+			json_array_append_new( json_object_get( parent, "connections" ), limbs[i] );
+		}
+	}
+	
+	return limbs[0];
+}
+
+json_t *createRandomGenomeLike( json_t *genome, unsigned int seed ) {
+	json_t *copy = json_deep_copy( genome );
+	randomizeLimbs( copy, &seed );
+	return copy;
+}
+
+double benchTime( void ) {
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+static json_t *createLimb( double angle, double length, double frequency, double amplitude, double phase ) {
+	json_t *limb = json_object( );
+	
+	json_object_set_new( limb, "angle", json_real( angle ) );
+	json_object_set_new( limb, "length", json_real( length ) );
+	json_object_set_new( limb, "frequency", json_real( frequency ) );
+	json_object_set_new( limb, "amplitude", json_real( amplitude ) );
+	json_object_set_new( limb, "phase", json_real( phase ) );
+	json_object_set_new( limb, "connections", json_array( ) );
+	
+	return limb;
+}
+
+static double randomRange( unsigned int *seed, double min, double max ) {
+	return min + ( max - min ) * ( rand_r( seed ) / (double)RAND_MAX );
+}
+
+static void randomizeLimbs( json_t *limb, unsigned int *seed ) {
+	json_object_set_new( limb, "angle", json_real( randomRange( seed, -M_PI, M_PI ) ) );
+	json_object_set_new( limb, "length", json_real( randomRange( seed, 10.0, 40.0 ) ) );
+	json_object_set_new( limb, "frequency", json_real( randomRange( seed, 0.0, 8.0 ) ) );
+	json_object_set_new( limb, "amplitude", json_real( randomRange( seed, 0.0, M_PI ) ) );
+	json_object_set_new( limb, "phase", json_real( randomRange( seed, 0.0, 2.0*M_PI ) ) );
+	
+	json_t *connections = json_object_get( limb, "connections" );
+	for ( int i = 0; i < json_array_size( connections ); ++i ) {
+		randomizeLimbs( json_array_get( connections, i ), seed );
+	}
+}
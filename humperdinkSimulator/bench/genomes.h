@@ -0,0 +1,30 @@
+/*
+ * Synthetic genomes for the benchmarks:
+ *  creatures of an arbitrary size, built as jansson trees
+ *  in the same schema as the .hdk files (see readme.txt)
+ */
+
+#include <jansson.h>
+
+/*
+ * A centipede: a straight spine of 'segments' limbs, each with a pair
+ * of oscillating legs (3 * segments limbs in total)
+ */
+json_t *createCentipedeGenome( int segments );
+
+/*
+ * A random tree of 'numLimbs' limbs with random parameters,
+ * the same seed always gives the same genome
+ */
+json_t *createRandomGenome( int numLimbs, unsigned int seed );
+
+/*
+ * A genome with the same tree of limbs as 'genome' (a mutation-only
+ * offspring), but new random parameters
+ */
+json_t *createRandomGenomeLike( json_t *genome, unsigned int seed );
+
+/*
+ * Seconds on a monotonic clock, for timing
+ */
+double benchTime( void );
@@ -0,0 +1,155 @@
+/*
+ * Library benchmark:
+ *  evaluates a batch of random genomes through libhumperdink (humperdink.h,
+ *  linked statically), submitted once as JSON text and once as binary
+ *  genomes, reports the time taken to submit the batch and to run it, and
+ *  checks every genome got the same results as evaluateLimbs gives it
+ *  directly with the same settings.
+ *
+ * usage: libraryBench [-n genomes] [-l limbs] [-s seconds] [-t threads]
+ */
+
+#include "../humperdink.h"
+#include "../evaluation.h"
+#include "../binaryGenome.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+static void runBatch( const char *name, Humperdink humperdink, int numGenomes, char **texts, char **data, size_t *sizes,
+	metrics_t *expected, int *different );
+static int sameResult( double a, double b );
+
+
+int main( int argc, char *argv[] ) {
+	int numGenomes = 100;
+	int limbs = 8;
+	double duration = 10.0;
+	int threads = 1;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numGenomes = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[++i] );
+		} else if ( strncmp( argv[i], "-t", 2 ) == 0 && i+1 < argc ) {
+			threads = atoi( argv[++i] );
+		}
+	}
+	assert( numGenomes > 0 && limbs > 0 && threads > 0 );
+
+	Humperdink humperdink = createHumperdink( );
+	if ( getHumperdinkVersion( ) != HUMPERDINK_VERSION ) {
+		fprintf( stderr, "built with version %d, linked with %d\n", HUMPERDINK_VERSION, getHumperdinkVersion( ) );
+		return 1;
+	}
+
+	int updates = (int)( duration * UPDATES_PER_SECOND + 0.5 );
+	char settings[64];
+	snprintf( settings, sizeof( settings ), "updates=%d,threads=%d", updates, threads );
+	if ( !setHumperdinkSettings( humperdink, settings ) ) {
+		fprintf( stderr, "%s\n", getHumperdinkError( humperdink ) );
+		return 1;
+	}
+
+	// each genome as text and as a binary genome, and its results from evaluateLimbs
+	char *texts[numGenomes];
+	char *data[numGenomes];
+	size_t sizes[numGenomes];
+	metrics_t expected[numGenomes];
+	evaluationSettings_t evaluation = defaultEvaluationSettings( updates );
+	double seconds = 0.0;
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_t *json = createRandomGenome( limbs, i + 1 );
+		texts[i] = json_dumps( json, 0 );
+		assert( texts[i] != NULL );
+
+		int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+		parameters_t parameters[numLimbs];
+		int parents[numLimbs];
+		getGenomeLimbs( json, parameters, parents, numLimbs );
+
+		FILE *output = open_memstream( &data[i], &sizes[i] );
+		assert( output != NULL );
+		if ( !writeBinaryGenome( output, parameters, numLimbs ) ) {
+			fprintf( stderr, "writeBinaryGenome failed\n" );
+			exit( 1 );
+		}
+		fclose( output );
+
+		double start = benchTime( );
+		evaluateLimbs( parameters, numLimbs, &evaluation, &expected[i] );
+		seconds += benchTime( ) - start;
+		json_decref( json );
+	}
+
+	printf( "%d genomes with %d limbs, %.1f simulated seconds each, on %d thread%s\n\n", numGenomes, limbs, duration,
+		threads, ( threads > 1 ) ? "s" : "" );
+	printf( "%-16s %10s %10s %12s\n", "batch", "submit s", "run s", "genomes/s" );
+	printf( "%-16s %10s %10.3f %12.1f\n", "evaluateLimbs", "", seconds, numGenomes / seconds );
+
+	int different = 0;
+	runBatch( "JSON text", humperdink, numGenomes, texts, NULL, NULL, expected, &different );
+	runBatch( "binary genomes", humperdink, numGenomes, NULL, data, sizes, expected, &different );
+
+	printf( "\ngenomes with results different from evaluateLimbs': %d\n", different );
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		free( texts[i] );
+		free( data[i] );
+	}
+	destroyHumperdink( humperdink );
+
+	return different ? 1 : 0;
+}
+
+// submits the batch from 'texts', or else 'data', runs it, and compares its results
+static void runBatch( const char *name, Humperdink humperdink, int numGenomes, char **texts, char **data, size_t *sizes,
+	metrics_t *expected, int *different ) {
+	clearHumperdinkBatch( humperdink );
+
+	double start = benchTime( );
+	for ( int i = 0; i < numGenomes; ++i ) {
+		int added = ( texts != NULL ) ? addHumperdinkGenome( humperdink, texts[i] )
+		                              : addHumperdinkBinaryGenome( humperdink, data[i], sizes[i] );
+		if ( !added ) {
+			fprintf( stderr, "%s\n", getHumperdinkError( humperdink ) );
+			exit( 1 );
+		}
+	}
+	double submitted = benchTime( );
+
+	if ( !runHumperdink( humperdink ) ) {
+		fprintf( stderr, "%s\n", getHumperdinkError( humperdink ) );
+		exit( 1 );
+	}
+	double finished = benchTime( );
+
+	double distances[numGenomes];
+	double energies[numGenomes];
+	if ( !getHumperdinkResults( humperdink, "distance", distances, numGenomes )
+		|| !getHumperdinkResults( humperdink, "energy", energies, numGenomes ) ) {
+		fprintf( stderr, "%s\n", getHumperdinkError( humperdink ) );
+		exit( 1 );
+	}
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		if ( !sameResult( distances[i], expected[i].distance ) || !sameResult( energies[i], expected[i].energy ) ) {
+			( *different )++;
+		}
+	}
+
+	printf( "%-16s %10.3f %10.3f %12.1f\n", name, submitted - start, finished - submitted, numGenomes / ( finished - start ) );
+}
+
+// the same bits (so NaN is NaN, which -ffast-math's comparisons can't tell)
+static int sameResult( double a, double b ) {
+	return memcmp( &a, &b, sizeof( double ) ) == 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * Genome loader benchmark:
+ *  loads the same genomes (random trees, written out indented) with
+ *  json_loads and getGenomeLimbs (with the tree on the heap, and in a
+ *  jansson arena cleared after each genome), and with the streaming
+ *  genome loader,
+ *  and reports the time each took and whether they read the same limbs.
+ *  The genomes are also written as binary genome files (in a temporary
+ *  directory), and opened and checked with openBinaryGenome.
+ *  Every prefix of one of the genomes, and some copies with a byte changed,
+ *  are loaded both ways too, to check the errors (text and line) match.
+ *  Any files given are checked the same way, e.g. jansson's test suites:
+ *    bench/loaderBench `find jansson-1.2/test/suites -name input`
+ *
+ * usage: loaderBench [-n genomes] [-l limbs] [-r rounds] [file ...]
+ */
+
+#include "../creature.h"
+#include "../genomeLoader.h"
+#include "../binaryGenome.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <assert.h>
+
+// byte changes tried on the mangled copies
+#define NUM_MANGLED 2000
+
+static const char mangleBytes[] = "{}[]:,\"\\ \n0.e-+tuxz\x01\x80\xc3\xff";
+
+static int checkText( const char *text, size_t length, const char *name );
+static int sameLimbs( json_t *json, genome_t *genome );
+
+
+int main( int argc, char *argv[] ) {
+	int numGenomes = 1000;
+	int limbs = 12;
+	int rounds = 5;
+	char *files[argc];
+	int numFiles = 0;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numGenomes = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-r", 2 ) == 0 && i+1 < argc ) {
+			rounds = atoi( argv[++i] );
+		} else {
+			files[numFiles++] = argv[i];
+		}
+	}
+	assert( numGenomes > 0 && rounds > 0 );
+
+	char *texts[numGenomes];
+	size_t lengths[numGenomes];
+	size_t totalLength = 0;
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_t *genome = createRandomGenome( limbs, i + 1 );
+		texts[i] = json_dumps( genome, JSON_INDENT( 2 ) );
+		lengths[i] = strlen( texts[i] );
+		totalLength += lengths[i];
+		json_decref( genome );
+	}
+
+	// the same limbs both ways
+	int different = 0;
+	genome_t genome;
+	initGenome( &genome );
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_error_t error;
+		json_t *json = json_loads( texts[i], &error );
+		if ( !loadGenomeText( texts[i], lengths[i], &genome, &error ) || !sameLimbs( json, &genome ) ) {
+			different++;
+		}
+		json_decref( json );
+	}
+
+	// the same genomes as binary files
+	char directory[] = "/tmp/loaderBenchXXXXXX";
+	if ( mkdtemp( directory ) == NULL ) {
+		fprintf( stderr, "Can't make a directory for the binary genomes\n" );
+		exit( 1 );
+	}
+	char paths[numGenomes][sizeof( directory ) + 16];
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_t *json = json_loads( texts[i], NULL );
+		snprintf( paths[i], sizeof( paths[i] ), "%s/%d.hdkb", directory, i );
+		FILE *file = fopen( paths[i], "wb" );
+		if ( file == NULL || !writeBinaryGenomeFromJSON( file, json ) ) {
+			fprintf( stderr, "Can't write %s\n", paths[i] );
+			exit( 1 );
+		}
+		fclose( file );
+
+		BinaryGenome binary = openBinaryGenome( paths[i], NULL );
+		genome_t copy = { getBinaryGenomeLimbs( binary ), NULL, getBinaryGenomeNumLimbs( binary ), 0 };
+		loadGenomeText( texts[i], lengths[i], &genome, NULL );
+		copy.parents = genome.parents;
+		if ( !sameLimbs( json, &copy ) ) {
+			different++;
+		}
+		closeBinaryGenome( binary );
+		json_decref( json );
+	}
+
+	double domSeconds = 0.0;
+	double arenaSeconds = 0.0;
+	double streamSeconds = 0.0;
+	json_arena_t *arena = json_arena_new( );
+	double binarySeconds = 0.0;
+	for ( int r = 0; r < rounds; ++r ) {
+		double start = benchTime( );
+		for ( int i = 0; i < numGenomes; ++i ) {
+			json_error_t error;
+			json_t *json = json_loads( texts[i], &error );
+			int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+			parameters_t parameters[numLimbs];
+			int parents[numLimbs];
+			getGenomeLimbs( json, parameters, parents, numLimbs );
+			json_decref( json );
+		}
+		domSeconds += benchTime( ) - start;
+
+		start = benchTime( );
+		for ( int i = 0; i < numGenomes; ++i ) {
+			json_error_t error;
+			json_t *json = json_arena_loadb( arena, texts[i], lengths[i], &error );
+			int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+			parameters_t parameters[numLimbs];
+			int parents[numLimbs];
+			getGenomeLimbs( json, parameters, parents, numLimbs );
+			json_arena_clear( arena );
+		}
+		arenaSeconds += benchTime( ) - start;
+
+		start = benchTime( );
+		for ( int i = 0; i < numGenomes; ++i ) {
+			json_error_t error;
+			loadGenomeText( texts[i], lengths[i], &genome, &error );
+		}
+		streamSeconds += benchTime( ) - start;
+
+		start = benchTime( );
+		for ( int i = 0; i < numGenomes; ++i ) {
+			BinaryGenome binary = openBinaryGenome( paths[i], NULL );
+			closeBinaryGenome( binary );
+		}
+		binarySeconds += benchTime( ) - start;
+	}
+	freeGenome( &genome );
+	json_arena_free( arena );
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		remove( paths[i] );
+	}
+	rmdir( directory );
+
+	double megabytes = rounds * totalLength / 1e6;
+	printf( "%d genomes with %d limbs, %.0f bytes each, %d rounds\n\n", numGenomes, limbs, (double)totalLength / numGenomes, rounds );
+	printf( "%-10s %10s %10s %12s\n", "loader", "seconds", "MB/s", "genomes/s" );
+	printf( "%-10s %10.3f %10.1f %12.0f\n", "json_t", domSeconds, megabytes / domSeconds, rounds * numGenomes / domSeconds );
+	printf( "%-10s %10.3f %10.1f %12.0f\n", "arena", arenaSeconds, megabytes / arenaSeconds, rounds * numGenomes / arenaSeconds );
+	printf( "%-10s %10.3f %10.1f %12.0f\n", "streaming", streamSeconds, megabytes / streamSeconds, rounds * numGenomes / streamSeconds );
+	printf( "%-10s %10.3f %10s %12.0f\n", "binary", binarySeconds, "-", rounds * numGenomes / binarySeconds );
+	printf( "speedup %.2f (streaming), %.2f (binary, from files)\n\n", domSeconds / streamSeconds, domSeconds / binarySeconds );
+	printf( "genomes read differently: %d\n", different );
+
+	// errors: every prefix, and single byte changes
+	int checked = 0;
+	int mismatched = 0;
+	for ( size_t length = 0; length < lengths[0]; ++length ) {
+		mismatched += !checkText( texts[0], length, "prefix" );
+		checked++;
+	}
+
+	unsigned int seed = 1;
+	char copy[lengths[0] + 1];
+	for ( int i = 0; i < NUM_MANGLED; ++i ) {
+		memcpy( copy, texts[0], lengths[0] + 1 );
+		copy[rand_r( &seed ) % lengths[0]] = mangleBytes[rand_r( &seed ) % ( sizeof( mangleBytes ) - 1 )];
+		mismatched += !checkText( copy, lengths[0], "mangled copy" );
+		checked++;
+	}
+
+	for ( int i = 0; i < numFiles; ++i ) {
+		FILE *file = fopen( files[i], "rb" );
+		if ( file == NULL ) {
+			fprintf( stderr, "Can't open %s\n", files[i] );
+			continue;
+		}
+		char text[65536];
+		size_t length = fread( text, 1, sizeof( text ), file );
+		fclose( file );
+
+		mismatched += !checkText( text, length, files[i] );
+		checked++;
+	}
+	printf( "inputs with different results or errors: %d of %d\n", mismatched, checked );
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		free( texts[i] );
+	}
+
+	return 0;
+}
+
+// loads the text both ways (as json_loadf would read it from a file), true if they agree
+static int checkText( const char *text, size_t length, const char *name ) {
+	json_error_t domError;
+	json_error_t streamError;
+	genome_t genome;
+	initGenome( &genome );
+
+	FILE *file = ( length > 0 ) ? fmemopen( (void *)text, length, "r" ) : fopen( "/dev/null", "r" );
+	assert( file != NULL );
+	// jansson reads errno without clearing it
+	errno = 0;
+	json_t *json = json_loadf( file, &domError );
+	fclose( file );
+
+	int loaded = loadGenomeText( text, length, &genome, &streamError );
+
+	int same;
+	if ( json != NULL ) {
+		same = loaded && sameLimbs( json, &genome );
+	} else {
+		same = !loaded && domError.line == streamError.line && strcmp( domError.text, streamError.text ) == 0;
+	}
+	if ( !same ) {
+		printf( "%s: json_loadf (line %d) %s, streaming (line %d) %s\n", name,
+			domError.line, ( json != NULL ) ? "loaded" : domError.text,
+			streamError.line, loaded ? "loaded" : streamError.text
+		);
+	}
+
+	json_decref( json );
+	freeGenome( &genome );
+	return same;
+}
+
+static int sameLimbs( json_t *json, genome_t *genome ) {
+	int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+	if ( numLimbs != genome->numLimbs ) {
+		return 0;
+	}
+
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( json, parameters, parents, numLimbs );
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		parameters_t *a = &parameters[i];
+		parameters_t *b = &genome->parameters[i];
+		if ( parents[i] != genome->parents[i] || a->numConnections != b->numConnections
+		  || a->angle != b->angle || a->length != b->length || a->frequency != b->frequency
+		  || a->amplitude != b->amplitude || a->phase != b->phase ) {
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,170 @@
+/*
+ * Lockstep benchmark:
+ *  simulates a batch of creatures that share a topology (random parameters
+ *  on one random tree of limbs, or on the tree of a .hdk file given with -f)
+ *  one at a time with chipmunk and LOCKSTEP_LANES at a time with the
+ *  lockstep engine, and reports the throughput of each and how far
+ *  apart their fitnesses (distance travelled) end up.
+ *
+ * usage: lockstepBench [-n creatures] [-l limbs] [-s seconds] [-r seed] [-f file.hdk]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "../lockstep.h"
+#include "../finite.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+// a creature that ends up further than this has blown up
+#define MAX_DISTANCE 100000.0
+
+static int compareDoubles( const void *a, const void *b );
+
+
+int main( int argc, char *argv[] ) {
+	int numCreatures = 64;
+	int limbs = 6;
+	double duration = 30.0;
+	unsigned int seed = 1;
+	char *filename = NULL;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numCreatures = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-r", 2 ) == 0 && i+1 < argc ) {
+			seed = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-f", 2 ) == 0 && i+1 < argc ) {
+			filename = argv[i+1];
+		}
+	}
+	assert( numCreatures > 0 );
+
+	json_t *topology;
+	if ( filename != NULL ) {
+		json_error_t error;
+		topology = json_load_file( filename, &error );
+
+		if ( !topology ) {
+			fprintf( stderr, "Error parsing humperdink on line %d:\n", error.line );
+			fprintf( stderr, "\t%s\n\n", error.text );
+			exit( 1 );
+		}
+	} else {
+		topology = createRandomGenome( limbs, seed );
+	}
+
+	json_t *genomes[numCreatures];
+	for ( int i = 0; i < numCreatures; ++i ) {
+		genomes[i] = createRandomGenomeLike( topology, seed * 1000 + i );
+	}
+
+	cpInitChipmunk( );
+
+	int updates = (int)( duration * UPDATES_PER_SECOND + 0.5 );
+	double chipmunkFitness[numCreatures];
+	double lockstepFitness[numCreatures];
+
+	double start = benchTime( );
+	for ( int i = 0; i < numCreatures; ++i ) {
+		Environment env = createEnvironment( 800, 600 );
+		Creature creature = createCreature( genomes[i], getEnvironmentSpace( env ) );
+		double startX = getCreatureX( creature );
+
+		for ( int j = 0; j < updates; ++j ) {
+			updateEnvironment( env );
+		}
+		chipmunkFitness[i] = getCreatureX( creature ) - startX;
+
+		destroyCreature( creature );
+		destroyEnvironment( env );
+	}
+	double chipmunkSeconds = benchTime( ) - start;
+
+	start = benchTime( );
+	for ( int i = 0; i < numCreatures; i += LOCKSTEP_LANES ) {
+		int batch = ( numCreatures - i < LOCKSTEP_LANES ) ? numCreatures - i : LOCKSTEP_LANES;
+		Lockstep lockstep = createLockstep( &genomes[i], batch );
+
+		double startX[LOCKSTEP_LANES];
+		for ( int l = 0; l < batch; ++l ) {
+			startX[l] = getLockstepX( lockstep, l );
+		}
+
+		for ( int j = 0; j < updates; ++j ) {
+			updateLockstep( lockstep );
+		}
+
+		for ( int l = 0; l < batch; ++l ) {
+			lockstepFitness[i + l] = getLockstepX( lockstep, l ) - startX[l];
+		}
+
+		destroyLockstep( lockstep );
+	}
+	double lockstepSeconds = benchTime( ) - start;
+
+	double errors[numCreatures];
+	int numErrors = 0;
+	int blownUp = 0;
+	double meanError = 0.0;
+	double meanFitness = 0.0;
+
+	for ( int i = 0; i < numCreatures; ++i ) {
+		double a = chipmunkFitness[i];
+		double b = lockstepFitness[i];
+
+		if ( !isFiniteValue( a ) || !isFiniteValue( b ) || fabs( a ) > MAX_DISTANCE || fabs( b ) > MAX_DISTANCE ) {
+			blownUp++;
+			continue;
+		}
+
+		errors[numErrors++] = fabs( a - b );
+		meanError += fabs( a - b );
+		meanFitness += fabs( a );
+	}
+
+	printf( "%d creatures with %d limbs, %.1f simulated seconds each, %d lanes\n\n",
+		numCreatures, getGenomeLimbs( topology, NULL, NULL, 0 ), duration, LOCKSTEP_LANES );
+	printf( "%-10s %10s %14s\n", "engine", "seconds", "creatures/s" );
+	printf( "%-10s %10.3f %14.1f\n", "chipmunk", chipmunkSeconds, numCreatures / chipmunkSeconds );
+	printf( "%-10s %10.3f %14.1f\n", "lockstep", lockstepSeconds, numCreatures / lockstepSeconds );
+	printf( "speedup %.2f\n\n", chipmunkSeconds / lockstepSeconds );
+
+	if ( numErrors > 0 ) {
+		qsort( errors, numErrors, sizeof( double ), compareDoubles );
+		meanError /= numErrors;
+		meanFitness /= numErrors;
+
+		printf( "fitness difference (distance travelled):\n" );
+		printf( "%12s %12s %12s %12s %12s\n", "median", "90%", "max", "mean", "rel. mean" );
+		printf( "%12.3f %12.3f %12.3f %12.3f %12.3f\n",
+			errors[numErrors/2], errors[( numErrors * 9 ) / 10], errors[numErrors-1],
+			meanError, ( meanFitness > 0.0 ) ? meanError / meanFitness : 0.0
+		);
+	}
+	printf( "blown up: %d\n", blownUp );
+
+	for ( int i = 0; i < numCreatures; ++i ) {
+		json_decref( genomes[i] );
+	}
+	json_decref( topology );
+
+	return 0;
+}
+
+static int compareDoubles( const void *a, const void *b ) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return ( x > y ) - ( x < y );
+}
@@ -0,0 +1,203 @@
+/*
+ * Population loader benchmark:
+ *  writes a population of random genomes as JSON lines (with some blank
+ *  lines, and some lines cut short so they fail to load), then loads it
+ *  line by line with json_loads and getGenomeLimbs, and with
+ *  loadPopulationText using 1, 2, 4, ... threads, and reports the time
+ *  each took. Every population is checked against loading its lines one
+ *  at a time with loadGenomeText: the same limbs in the same order, and
+ *  the same errors on the same lines.
+ *
+ * usage: populationBench [-n genomes] [-l limbs] [-r rounds] [-t max threads]
+ */
+
+#include "../creature.h"
+#include "../genomeLoader.h"
+#include "../population.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// every BLANK_EVERY'th line is blank, every BROKEN_EVERY'th genome is cut short
+#define BLANK_EVERY 50
+#define BROKEN_EVERY 97
+
+static int checkPopulation( Population population, const char *text, size_t length );
+static int sameGenome( genome_t *a, genome_t *b );
+
+
+int main( int argc, char *argv[] ) {
+	int numGenomes = 10000;
+	int limbs = 12;
+	int rounds = 5;
+	int maxThreads = 8;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numGenomes = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-r", 2 ) == 0 && i+1 < argc ) {
+			rounds = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-t", 2 ) == 0 && i+1 < argc ) {
+			maxThreads = atoi( argv[++i] );
+		}
+	}
+	assert( numGenomes > 0 && rounds > 0 && maxThreads > 0 );
+
+	// the population, one genome per line
+	size_t length = 0;
+	size_t capacity = 65536;
+	char *text = malloc( capacity );
+	assert( text != NULL );
+	int numLines = 0;
+	int numBroken = 0;
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_t *genome = createRandomGenome( limbs, i + 1 );
+		char *line = json_dumps( genome, JSON_COMPACT );
+		size_t lineLength = strlen( line );
+		json_decref( genome );
+
+		if ( i % BROKEN_EVERY == BROKEN_EVERY - 1 ) {
+			lineLength /= 2;
+			numBroken++;
+		}
+
+		if ( length + lineLength + 2 > capacity ) {
+			capacity = 2 * ( length + lineLength + 2 );
+			text = realloc( text, capacity );
+			assert( text != NULL );
+		}
+		if ( numLines % BLANK_EVERY == BLANK_EVERY - 1 ) {
+			text[length++] = '\n';
+			numLines++;
+		}
+		memcpy( text + length, line, lineLength );
+		length += lineLength;
+		text[length++] = '\n';
+		numLines++;
+		free( line );
+	}
+
+	printf( "%d genomes with %d limbs (%d cut short) on %d lines, %.0f bytes each, %d rounds\n\n",
+		numGenomes, limbs, numBroken, numLines, (double)length / numGenomes, rounds
+	);
+
+	// line by line through jansson, as a population used to be read
+	double domSeconds = 0.0;
+	for ( int r = 0; r < rounds; ++r ) {
+		double start = benchTime( );
+		for ( char *line = text; line < text + length; ) {
+			char *newline = memchr( line, '\n', text + length - line );
+			*newline = '\0';
+			json_error_t error;
+			json_t *json = json_loads( line, &error );
+			if ( json != NULL ) {
+				int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+				parameters_t parameters[numLimbs];
+				int parents[numLimbs];
+				getGenomeLimbs( json, parameters, parents, numLimbs );
+				json_decref( json );
+			}
+			*newline = '\n';
+			line = newline + 1;
+		}
+		domSeconds += benchTime( ) - start;
+	}
+
+	double megabytes = rounds * length / 1e6;
+	printf( "%-12s %10s %10s %12s %8s\n", "loader", "seconds", "MB/s", "genomes/s", "speedup" );
+	printf( "%-12s %10.3f %10.1f %12.0f %8s\n", "json_loads", domSeconds, megabytes / domSeconds, rounds * numGenomes / domSeconds, "-" );
+
+	int mismatched = 0;
+	for ( int threads = 1; threads <= maxThreads; threads *= 2 ) {
+		double seconds = 0.0;
+		for ( int r = 0; r < rounds; ++r ) {
+			double start = benchTime( );
+			Population population = loadPopulationText( text, length, threads );
+			seconds += benchTime( ) - start;
+
+			if ( r == 0 ) {
+				mismatched += !checkPopulation( population, text, length );
+				if ( getPopulationSize( population ) != numGenomes || getPopulationErrors( population ) != numBroken ) {
+					printf( "%d threads: %d genomes, %d errors\n", threads, getPopulationSize( population ), getPopulationErrors( population ) );
+					mismatched++;
+				}
+			}
+			destroyPopulation( population );
+		}
+
+		char name[32];
+		snprintf( name, sizeof( name ), "%d thread%s", threads, ( threads == 1 ) ? "" : "s" );
+		printf( "%-12s %10.3f %10.1f %12.0f %8.2f\n", name, seconds, megabytes / seconds, rounds * numGenomes / seconds, domSeconds / seconds );
+	}
+
+	printf( "\npopulations read differently: %d\n", mismatched );
+
+	free( text );
+	return 0;
+}
+
+// every member as loadGenomeText reads its line, in order, true if they all match
+static int checkPopulation( Population population, const char *text, size_t length ) {
+	genome_t genome;
+	initGenome( &genome );
+
+	int index = 0;
+	int lineNumber = 0;
+	int same = 1;
+	for ( const char *line = text; line < text + length && same; ) {
+		const char *newline = memchr( line, '\n', text + length - line );
+		size_t lineLength = newline - line;
+		lineNumber++;
+
+		if ( lineLength > 0 ) {
+			json_error_t error;
+			int loaded = loadGenomeText( line, lineLength, &genome, &error );
+
+			if ( index >= getPopulationSize( population ) ) {
+				same = 0;
+			} else {
+				populationMember_t *member = getPopulationMember( population, index );
+				if ( member->line != lineNumber || member->loaded != loaded ) {
+					same = 0;
+				} else if ( loaded ) {
+					same = sameGenome( &member->genome, &genome );
+				} else {
+					same = ( member->error.line == lineNumber && strcmp( member->error.text, error.text ) == 0 );
+				}
+				if ( !same ) {
+					printf( "line %d: member %d (line %d) %s, loadGenomeText %s\n", lineNumber, index,
+						member->line, member->loaded ? "loaded" : member->error.text, loaded ? "loaded" : error.text
+					);
+				}
+			}
+			index++;
+		}
+
+		line = newline + 1;
+	}
+
+	freeGenome( &genome );
+	return same && index == getPopulationSize( population );
+}
+
+static int sameGenome( genome_t *a, genome_t *b ) {
+	if ( a->numLimbs != b->numLimbs ) {
+		return 0;
+	}
+
+	for ( int i = 0; i < a->numLimbs; ++i ) {
+		parameters_t *p = &a->parameters[i];
+		parameters_t *q = &b->parameters[i];
+		if ( a->parents[i] != b->parents[i] || p->numConnections != q->numConnections
+		  || p->angle != q->angle || p->length != q->length || p->frequency != q->frequency
+		  || p->amplitude != q->amplitude || p->phase != q->phase ) {
+			return 0;
+		}
+	}
+	return 1;
+}
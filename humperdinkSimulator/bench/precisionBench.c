@@ -0,0 +1,152 @@
+/*
+ * Precision validation:
+ *  runs bench/fitnessBench (double precision) and bench/fitnessBench_float
+ *  (single precision) on the same creatures, and reports how far apart
+ *  their fitnesses end up and how much faster the float build is.
+ *  Both must be built first ("make bench").
+ *
+ * usage: precisionBench [-n creatures] [-l limbs] [-s seconds] [-f file.hdk ...]
+ *  (the arguments are passed on to both builds)
+ */
+
+#include "../finite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+// a creature that ends up further than this has blown up
+#define MAX_DISTANCE 100000.0
+
+#define MAX_COMMAND 4096
+
+typedef struct {
+	double *fitness;
+	double seconds;
+	int numCreatures;
+} run_t;
+
+static run_t runBuild( const char *directory, const char *build, int argc, char *argv[] );
+static int compareDoubles( const void *a, const void *b );
+
+
+int main( int argc, char *argv[] ) {
+	// the fitness benchmarks live next to this one
+	char directory[MAX_COMMAND] = ".";
+	char *slash = strrchr( argv[0], '/' );
+	if ( slash != NULL ) {
+		snprintf( directory, sizeof( directory ), "%.*s", (int)( slash - argv[0] ), argv[0] );
+	}
+
+	run_t doubles = runBuild( directory, "fitnessBench", argc, argv );
+	run_t floats = runBuild( directory, "fitnessBench_float", argc, argv );
+
+	if ( doubles.numCreatures != floats.numCreatures || doubles.numCreatures == 0 ) {
+		fprintf( stderr, "The two builds simulated different creatures (%d and %d)\n", doubles.numCreatures, floats.numCreatures );
+		exit( 1 );
+	}
+
+	int numCreatures = doubles.numCreatures;
+	double errors[numCreatures];
+	int numErrors = 0;
+	int blownUp = 0;
+	double meanError = 0.0;
+	double meanFitness = 0.0;
+
+	for ( int i = 0; i < numCreatures; ++i ) {
+		double a = doubles.fitness[i];
+		double b = floats.fitness[i];
+
+		if ( !isFiniteValue( a ) || !isFiniteValue( b ) || fabs( a ) > MAX_DISTANCE || fabs( b ) > MAX_DISTANCE ) {
+			blownUp++;
+			continue;
+		}
+
+		errors[numErrors++] = fabs( a - b );
+		meanError += fabs( a - b );
+		meanFitness += fabs( a );
+	}
+
+	printf( "%d creatures\n\n", numCreatures );
+	printf( "%-10s %10s\n", "build", "seconds" );
+	printf( "%-10s %10.3f\n", "double", doubles.seconds );
+	printf( "%-10s %10.3f\n", "float", floats.seconds );
+	printf( "speedup %.2f\n\n", doubles.seconds / floats.seconds );
+
+	if ( numErrors > 0 ) {
+		qsort( errors, numErrors, sizeof( double ), compareDoubles );
+		meanError /= numErrors;
+		meanFitness /= numErrors;
+
+		printf( "fitness difference (distance travelled):\n" );
+		printf( "%12s %12s %12s %12s %12s %12s\n", "min", "median", "90%", "max", "mean", "rel. mean" );
+		printf( "%12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+			errors[0], errors[numErrors/2], errors[( numErrors * 9 ) / 10], errors[numErrors-1],
+			meanError, ( meanFitness > 0.0 ) ? meanError / meanFitness : 0.0
+		);
+	}
+	printf( "blown up: %d\n", blownUp );
+
+	printf( "\n(see bench/timestepBench for how far the fitness drifts from changes as small as halving the timestep)\n" );
+
+	free( doubles.fitness );
+	free( floats.fitness );
+
+	return 0;
+}
+
+static run_t runBuild( const char *directory, const char *build, int argc, char *argv[] ) {
+	char command[MAX_COMMAND];
+	int length = snprintf( command, sizeof( command ), "'%s/%s'", directory, build );
+	for ( int i = 1; i < argc && length < sizeof( command ); ++i ) {
+		length += snprintf( command + length, sizeof( command ) - length, " '%s'", argv[i] );
+	}
+	assert( length < sizeof( command ) );
+
+	FILE *output = popen( command, "r" );
+	if ( output == NULL ) {
+		fprintf( stderr, "Could not run %s\n", command );
+		exit( 1 );
+	}
+
+	run_t run;
+	int capacity = 16;
+	run.fitness = malloc( sizeof( double ) * capacity );
+	assert( run.fitness != NULL );
+	run.seconds = 0.0;
+	run.numCreatures = 0;
+
+	char line[256];
+	while ( fgets( line, sizeof( line ), output ) != NULL ) {
+		int creature;
+		double fitness;
+		double seconds;
+
+		if ( line[0] == '#' || sscanf( line, "%d %lf %lf", &creature, &fitness, &seconds ) != 3 ) {
+			continue;
+		}
+
+		if ( run.numCreatures == capacity ) {
+			capacity *= 2;
+			run.fitness = realloc( run.fitness, sizeof( double ) * capacity );
+			assert( run.fitness != NULL );
+		}
+		run.fitness[run.numCreatures++] = fitness;
+		run.seconds += seconds;
+	}
+
+	if ( pclose( output ) != 0 ) {
+		fprintf( stderr, "%s failed (has it been built? try \"make bench\")\n", command );
+		exit( 1 );
+	}
+
+	return run;
+}
+
+static int compareDoubles( const void *a, const void *b ) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return ( x > y ) - ( x < y );
+}
@@ -0,0 +1,115 @@
+/*
+ * Screening benchmark:
+ *  evaluates a batch of random genomes in full, and with a screening tier
+ *  of each kind in turn (fewer updates, fewer solver passes, a larger
+ *  timestep, and all three) in an audit, and reports each tier's cost
+ *  against the full tier's, the rank correlation of its distances with the
+ *  full ones, how many of the full tier's best it would have kept, and the
+ *  time a screening with it would have taken: the tier for every genome,
+ *  and the full tier for those it kept.
+ *
+ * usage: screeningBench [-n genomes] [-l limbs] [-s seconds] [-k keep] [-t threads]
+ */
+
+#include "../screening.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+#define NUM_TIERS 4
+
+
+int main( int argc, char *argv[] ) {
+	int numGenomes = 200;
+	int limbs = 8;
+	double duration = 20.0;
+	double keep = 0.25;
+	int threads = 1;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numGenomes = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[++i] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[++i] );
+		} else if ( strncmp( argv[i], "-k", 2 ) == 0 && i+1 < argc ) {
+			keep = atof( argv[++i] );
+		} else if ( strncmp( argv[i], "-t", 2 ) == 0 && i+1 < argc ) {
+			threads = atoi( argv[++i] );
+		}
+	}
+	assert( numGenomes >= 3 && limbs > 0 && keep > 0.0 && keep <= 1.0 );
+
+	cpInitChipmunk( );
+
+	genome_t genomes[numGenomes];
+	genome_t *batch[numGenomes];
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_t *json = createRandomGenome( limbs, i + 1 );
+		genome_t *genome = &genomes[i];
+		genome->numLimbs = genome->capacity = getGenomeLimbs( json, NULL, NULL, 0 );
+		genome->parameters = malloc( sizeof( parameters_t ) * genome->capacity );
+		genome->parents = malloc( sizeof( int ) * genome->capacity );
+		assert( genome->parameters != NULL && genome->parents != NULL );
+		getGenomeLimbs( json, genome->parameters, genome->parents, genome->numLimbs );
+		json_decref( json );
+		batch[i] = genome;
+	}
+
+	evaluationSettings_t full = defaultEvaluationSettings( (int)( duration * UPDATES_PER_SECOND + 0.5 ) );
+
+	// a quarter of the updates, 4 solver passes, 1/30 s steps (as many seconds), and all three
+	const char *names[NUM_TIERS] = { "updates/4", "passes=4", "timestep*2", "all three" };
+	evaluationSettings_t tiers[NUM_TIERS];
+	for ( int i = 0; i < NUM_TIERS; ++i ) {
+		tiers[i] = full;
+	}
+	tiers[0].updates = full.updates / 4;
+	tiers[1].iterations = 4;
+	tiers[2].timestep = 1.0/30.0;
+	tiers[2].updates = full.updates / 2;
+	tiers[3].updates = full.updates / 8;
+	tiers[3].iterations = 4;
+	tiers[3].timestep = 1.0/30.0;
+
+	printf( "%d genomes with %d limbs, %.1f simulated seconds each in full, keeping %.0f%%\n\n", numGenomes, limbs, duration, keep * 100.0 );
+	printf( "%-12s %10s %8s %12s %8s %12s %8s\n", "tier", "seconds", "cost", "correlation", "recall", "screening s", "saving" );
+
+	metrics_t results[numGenomes];
+	double fullSeconds = 0.0;
+	for ( int i = 0; i < NUM_TIERS; ++i ) {
+		Screening screening = createScreening( &full, threads );
+		addScreeningTier( screening, &tiers[i], keep );
+		setScreeningAudit( screening, 1 );
+		screenGenomes( screening, batch, numGenomes, results, NULL );
+
+		screeningReport_t tier;
+		screeningReport_t report;
+		getScreeningReport( screening, 0, &tier );
+		getScreeningReport( screening, 1, &report );
+		if ( i == 0 ) {
+			fullSeconds = report.seconds;
+			printf( "%-12s %10.3f %8.2f %12s %8s %12s %8s\n", "full", fullSeconds, 1.0, "", "", "", "" );
+		}
+
+		// the tier for all of them, then the full tier for the ones it keeps
+		int kept = (int)( keep * numGenomes + 0.999999 );
+		double screeningSeconds = tier.seconds + fullSeconds * kept / numGenomes;
+		printf( "%-12s %10.3f %8.2f %12.3f %8.2f %12.3f %7.1fx\n", names[i], tier.seconds, tier.seconds / fullSeconds,
+			tier.correlation, tier.recall, screeningSeconds, fullSeconds / screeningSeconds );
+
+		destroyScreening( screening );
+	}
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		freeGenome( &genomes[i] );
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Solver benchmark:
+ *  times a large creature (default 170 segment centipede, 510 limbs)
+ *  with the serial solver and with the graph coloring solver on
+ *  1..N threads, compares how well each converges, and how many
+ *  passes the early exit (iteration tolerance) saves.
+ *
+ * usage: solverBench [-n segments] [-i steps] [-t maxThreads]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	double seconds;
+	double jointError;
+	double passes;
+	cpVect position;
+} result_t;
+
+static result_t runSolver( json_t *genome, int steps, int iterations, int threads, int graphColoring, double tolerance );
+static double pivotJointError( cpSpace *space );
+
+
+int main( int argc, char *argv[] ) {
+	int segments = 170;
+	int steps = 600;
+	int maxThreads = 8;
+	
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			segments = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-i", 2 ) == 0 && i+1 < argc ) {
+			steps = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-t", 2 ) == 0 && i+1 < argc ) {
+			maxThreads = atoi( argv[i+1] );
+		}
+	}
+	
+	cpInitChipmunk( );
+	json_t *genome = createCentipedeGenome( segments );
+	
+	printf( "Centipede with %d limbs, %d steps\n\n", segments * 3, steps );
+	
+	printf( "Speedup (10 iterations):\n" );
+	printf( "%-10s %8s %10s %9s %12s\n", "solver", "threads", "seconds", "speedup", "joint error" );
+	
+	result_t serial = runSolver( genome, steps, 10, 1, 0, 0.0 );
+	printf( "%-10s %8d %10.3f %9.2f %12.5f\n", "serial", 1, serial.seconds, 1.0, serial.jointError );
+	
+	for ( int threads = 1; threads <= maxThreads; threads *= 2 ) {
+		result_t colored = runSolver( genome, steps, 10, threads, 1, 0.0 );
+		printf( "%-10s %8d %10.3f %9.2f %12.5f\n", "colored", threads, colored.seconds, serial.seconds / colored.seconds, colored.jointError );
+	}
+	
+	// the colored solver visits constraints in a different order to Gauss-Seidel,
+	// compare the joint drift and where the creature ends up for a range of iteration counts
+	printf( "\nConvergence (mean pivot joint separation, final position):\n" );
+	printf( "%-10s %12s %12s %22s\n", "iterations", "serial", "colored", "final position delta" );
+	
+	int iterationCounts[] = { 2, 5, 10, 20, 40 };
+	for ( int i = 0; i < sizeof( iterationCounts ) / sizeof( iterationCounts[0] ); ++i ) {
+		result_t a = runSolver( genome, steps, iterationCounts[i], 1, 0, 0.0 );
+		result_t b = runSolver( genome, steps, iterationCounts[i], 1, 1, 0.0 );
+		printf( "%-10d %12.5f %12.5f %22.3f\n", iterationCounts[i], a.jointError, b.jointError, (double)cpvdist( a.position, b.position ) );
+	}
+	
+	// early exit: up to 40 passes, stopping once the impulses settle
+	printf( "\nEarly exit (serial solver, at most 40 iterations):\n" );
+	printf( "%-10s %12s %10s %12s %22s\n", "tolerance", "passes/step", "seconds", "joint error", "final position delta" );
+	
+	result_t full = runSolver( genome, steps, 40, 1, 0, 0.0 );
+	printf( "%-10s %12.2f %10.3f %12.5f %22.3f\n", "off", full.passes, full.seconds, full.jointError, 0.0 );
+	
+	double tolerances[] = { 0.1, 1.0, 10.0, 100.0 };
+	for ( int i = 0; i < sizeof( tolerances ) / sizeof( tolerances[0] ); ++i ) {
+		result_t adaptive = runSolver( genome, steps, 40, 1, 0, tolerances[i] );
+		printf( "%-10g %12.2f %10.3f %12.5f %22.3f\n", tolerances[i], adaptive.passes, adaptive.seconds, adaptive.jointError, (double)cpvdist( full.position, adaptive.position ) );
+	}
+	
+	json_decref( genome );
+	
+	return 0;
+}
+
+static result_t runSolver( json_t *genome, int steps, int iterations, int threads, int graphColoring, double tolerance ) {
+	Environment env = createEnvironment( 800, 600 );
+	cpSpace *space = getEnvironmentSpace( env );
+	space->iterations = iterations;
+	setEnvironmentThreads( env, threads );
+	setEnvironmentGraphColoring( env, graphColoring );
+	setEnvironmentIterationTolerance( env, tolerance, 2 );
+	
+	Creature creature = createCreature( genome, space );
+	
+	result_t result;
+	result.jointError = 0.0;
+	result.passes = 0.0;
+	
+	double start = benchTime( );
+	for ( int i = 0; i < steps; ++i ) {
+		updateEnvironment( env );
+		result.jointError += pivotJointError( space );
+		result.passes += getEnvironmentStepIterations( env );
+	}
+	// the joint error pass is timed too, but it is the same for every solver
+	result.seconds = benchTime( ) - start;
+	result.jointError /= steps;
+	result.passes /= steps;
+	result.position = getCreaturePosition( creature );
+	
+	destroyCreature( creature );
+	destroyEnvironment( env );
+	
+	return result;
+}
+
+static double pivotJointError( cpSpace *space ) {
+	double total = 0.0;
+	int count = 0;
+	
+	for ( int i = 0; i < space->constraints->num; ++i ) {
+		cpConstraint *constraint = space->constraints->arr[i];
+		if ( constraint->klass != cpPivotJointGetClass( ) ) continue;
+		
+		cpPivotJoint *joint = (cpPivotJoint *)constraint;
+		cpVect p1 = cpBodyLocal2World( constraint->a, joint->anchr1 );
+		cpVect p2 = cpBodyLocal2World( constraint->b, joint->anchr2 );
+		
+		total += (double)cpvdist( p1, p2 );
+		count++;
+	}
+	
+	return ( count > 0 ) ? total / count : 0.0;
+}
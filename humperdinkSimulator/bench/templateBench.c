@@ -0,0 +1,150 @@
+/*
+ * Creature template benchmark:
+ *  evaluates a population of genomes drawn from a few topologies
+ *  (mutation-only offspring), once building a new environment and creature
+ *  for every genome, and once reusing one creature per topology with
+ *  setCreatureGenome and resetEnvironment. Reports the time spent setting
+ *  up creatures each way, and checks the fitnesses come out the same.
+ *
+ * usage: templateBench [-n genomes] [-k topologies] [-l limbs] [-s seconds]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+typedef struct {
+	unsigned int key;
+	json_t *genome;
+	Environment env;
+	Creature creature;
+} template_t;
+
+
+int main( int argc, char *argv[] ) {
+	int numGenomes = 200;
+	int numTopologies = 4;
+	int limbs = 6;
+	double duration = 5.0;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numGenomes = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-k", 2 ) == 0 && i+1 < argc ) {
+			numTopologies = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		}
+	}
+	assert( numGenomes > 0 && numTopologies > 0 );
+
+	json_t *topologies[numTopologies];
+	for ( int k = 0; k < numTopologies; ++k ) {
+		topologies[k] = createRandomGenome( limbs, k + 1 );
+	}
+
+	json_t *genomes[numGenomes];
+	for ( int i = 0; i < numGenomes; ++i ) {
+		genomes[i] = createRandomGenomeLike( topologies[i % numTopologies], i + 1 );
+	}
+
+	cpInitChipmunk( );
+
+	int updates = (int)( duration * UPDATES_PER_SECOND + 0.5 );
+	double builtFitness[numGenomes];
+	double reusedFitness[numGenomes];
+
+	// a new environment and creature for every genome
+	double setupSeconds = 0.0;
+	double start = benchTime( );
+	for ( int i = 0; i < numGenomes; ++i ) {
+		double setupStart = benchTime( );
+		Environment env = createEnvironment( 800, 600 );
+		Creature creature = createCreature( genomes[i], getEnvironmentSpace( env ) );
+		setupSeconds += benchTime( ) - setupStart;
+
+		double startX = getCreatureX( creature );
+		for ( int j = 0; j < updates; ++j ) {
+			updateEnvironment( env );
+		}
+		builtFitness[i] = getCreatureX( creature ) - startX;
+
+		setupStart = benchTime( );
+		destroyCreature( creature );
+		destroyEnvironment( env );
+		setupSeconds += benchTime( ) - setupStart;
+	}
+	double builtSeconds = benchTime( ) - start;
+
+	// one creature per topology, found by its key
+	template_t templates[numTopologies];
+	int numTemplates = 0;
+
+	double reuseSeconds = 0.0;
+	start = benchTime( );
+	for ( int i = 0; i < numGenomes; ++i ) {
+		double setupStart = benchTime( );
+		unsigned int key = getGenomeTopologyKey( genomes[i] );
+
+		template_t *template = NULL;
+		for ( int t = 0; t < numTemplates && template == NULL; ++t ) {
+			if ( templates[t].key == key && sameGenomeTopology( templates[t].genome, genomes[i] ) ) {
+				template = &templates[t];
+			}
+		}
+
+		if ( template == NULL ) {
+			assert( numTemplates < numTopologies );
+			template = &templates[numTemplates++];
+			template->key = key;
+			template->genome = genomes[i];
+			template->env = createEnvironment( 800, 600 );
+			template->creature = createCreature( genomes[i], getEnvironmentSpace( template->env ) );
+		} else {
+			resetEnvironment( template->env );
+			setCreatureGenome( template->creature, genomes[i] );
+		}
+		reuseSeconds += benchTime( ) - setupStart;
+
+		double startX = getCreatureX( template->creature );
+		for ( int j = 0; j < updates; ++j ) {
+			updateEnvironment( template->env );
+		}
+		reusedFitness[i] = getCreatureX( template->creature ) - startX;
+	}
+	double reusedSeconds = benchTime( ) - start;
+
+	int same = 0;
+	for ( int i = 0; i < numGenomes; ++i ) {
+		same += ( builtFitness[i] == reusedFitness[i] );
+	}
+
+	printf( "%d genomes of %d topologies, %d limbs, %.1f simulated seconds each\n\n", numGenomes, numTopologies, limbs, duration );
+	printf( "%-10s %14s %14s\n", "creatures", "setup seconds", "total seconds" );
+	printf( "%-10s %14.4f %14.3f\n", "built", setupSeconds, builtSeconds );
+	printf( "%-10s %14.4f %14.3f\n", "reused", reuseSeconds, reusedSeconds );
+	printf( "setup speedup %.1f\n\n", setupSeconds / reuseSeconds );
+	printf( "same fitness: %d of %d\n", same, numGenomes );
+
+	for ( int t = 0; t < numTemplates; ++t ) {
+		destroyCreature( templates[t].creature );
+		destroyEnvironment( templates[t].env );
+	}
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_decref( genomes[i] );
+	}
+	for ( int k = 0; k < numTopologies; ++k ) {
+		json_decref( topologies[k] );
+	}
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Early termination benchmark:
+ *  simulates random creatures for the full time, then again stopping each
+ *  one as soon as a termination rule fires (see termination.h), and
+ *  reports the simulation time saved, why creatures were stopped, and how
+ *  many of the fittest creatures (by the full simulation) are still among
+ *  the fittest when each is judged by where it was stopped. Fails (exit
+ *  status 1) if the fittest aren't ranked the same both ways.
+ *
+ * usage: terminationBench [-n creatures] [-l limbs] [-s seconds] [-x rules]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "../termination.h"
+#include "../finite.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <assert.h>
+
+#define UPDATES_PER_SECOND 60
+
+// the share of creatures counted as the fittest
+#define TOP_FRACTION 0.1
+
+static int compareDoubles( const void *a, const void *b );
+static void rankFittest( double *fitness, int numCreatures, int *fittest, int numTop );
+
+
+int main( int argc, char *argv[] ) {
+	int numCreatures = 100;
+	int limbs = 6;
+	double duration = 30.0;
+	terminationRules_t rules = defaultTerminationRules( );
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numCreatures = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-x", 2 ) == 0 && i+1 < argc ) {
+			if ( !parseTerminationRules( argv[i+1], &rules ) ) {
+				fprintf( stderr, "Can't read the termination rules \"%s\"\n", argv[i+1] );
+				exit( 1 );
+			}
+		}
+	}
+	assert( numCreatures > 0 );
+
+	cpInitChipmunk( );
+
+	int updates = (int)( duration * UPDATES_PER_SECOND + 0.5 );
+	double fullFitness[numCreatures];
+	double stoppedFitness[numCreatures];
+	terminationReason_t reasons[numCreatures];
+	long simulated = 0;
+
+	// only the updates are timed, building the creatures costs the same both ways
+	double fullSeconds = 0.0;
+	for ( int i = 0; i < numCreatures; ++i ) {
+		json_t *genome = createRandomGenome( limbs, i + 1 );
+		Environment env = createEnvironment( 800, 600 );
+		Creature creature = createCreature( genome, getEnvironmentSpace( env ) );
+		double startX = getCreatureX( creature );
+
+		double start = benchTime( );
+		for ( int j = 0; j < updates; ++j ) {
+			updateEnvironment( env );
+		}
+		fullSeconds += benchTime( ) - start;
+		fullFitness[i] = getCreatureX( creature ) - startX;
+
+		destroyCreature( creature );
+		destroyEnvironment( env );
+		json_decref( genome );
+	}
+
+	double stoppedSeconds = 0.0;
+	for ( int i = 0; i < numCreatures; ++i ) {
+		json_t *genome = createRandomGenome( limbs, i + 1 );
+		Environment env = createEnvironment( 800, 600 );
+		Creature creature = createCreature( genome, getEnvironmentSpace( env ) );
+		Termination termination = createTermination( creature, env, rules );
+		double startX = getCreatureX( creature );
+
+		double start = benchTime( );
+		for ( int j = 0; j < updates; ++j ) {
+			updateEnvironment( env );
+			if ( checkTermination( termination ) != TERMINATION_NONE ) {
+				break;
+			}
+		}
+		stoppedSeconds += benchTime( ) - start;
+		stoppedFitness[i] = getCreatureX( creature ) - startX;
+		reasons[i] = getTerminationReason( termination );
+		simulated += getTerminationUpdates( termination );
+
+		destroyTermination( termination );
+		destroyCreature( creature );
+		destroyEnvironment( env );
+		json_decref( genome );
+	}
+
+	// blown up creatures rank last
+	for ( int i = 0; i < numCreatures; ++i ) {
+		if ( !isFiniteValue( stoppedFitness[i] ) ) {
+			stoppedFitness[i] = -DBL_MAX;
+		}
+		if ( !isFiniteValue( fullFitness[i] ) ) {
+			fullFitness[i] = -DBL_MAX;
+		}
+	}
+
+	// the fittest creatures by distance travelled, in each simulation
+	int numTop = (int)( numCreatures * TOP_FRACTION );
+	if ( numTop < 1 ) {
+		numTop = 1;
+	}
+
+	double sorted[numCreatures];
+	memcpy( sorted, fullFitness, sizeof( sorted ) );
+	qsort( sorted, numCreatures, sizeof( double ), compareDoubles );
+	double topFull = sorted[numCreatures - numTop];
+
+	memcpy( sorted, stoppedFitness, sizeof( sorted ) );
+	qsort( sorted, numCreatures, sizeof( double ), compareDoubles );
+	double topStopped = sorted[numCreatures - numTop];
+
+	int stopped[TERMINATION_UNDERGROUND + 1] = { 0 };
+	int topKept = 0;
+	int topCut = 0;
+	for ( int i = 0; i < numCreatures; ++i ) {
+		stopped[reasons[i]]++;
+		if ( fullFitness[i] >= topFull ) {
+			topKept += ( stoppedFitness[i] >= topStopped );
+			topCut += ( reasons[i] != TERMINATION_NONE );
+		}
+	}
+
+	printf( "%d creatures with %d limbs, %.1f simulated seconds each\n\n", numCreatures, limbs, duration );
+	printf( "%-12s %10s %10s\n", "simulation", "seconds", "updates" );
+	printf( "%-12s %10.3f %10ld\n", "full", fullSeconds, (long)updates * numCreatures );
+	printf( "%-12s %10.3f %10ld\n", "terminated", stoppedSeconds, simulated );
+	printf( "speedup %.2f\n\n", fullSeconds / stoppedSeconds );
+
+	printf( "stopped:\n" );
+	for ( int r = TERMINATION_NONE + 1; r <= TERMINATION_UNDERGROUND; ++r ) {
+		printf( "  %-12s %d\n", terminationReasonName( r ), stopped[r] );
+	}
+	printf( "  %-12s %d\n\n", "ran to end", stopped[TERMINATION_NONE] );
+
+	printf( "of the fittest %d in the full simulation:\n", numTop );
+	printf( "  stopped early            %d\n", topCut );
+	printf( "  still among the fittest  %d\n", topKept );
+
+	int fullRanking[numTop];
+	int stoppedRanking[numTop];
+	rankFittest( fullFitness, numCreatures, fullRanking, numTop );
+	rankFittest( stoppedFitness, numCreatures, stoppedRanking, numTop );
+	int sameRanking = ( memcmp( fullRanking, stoppedRanking, sizeof( fullRanking ) ) == 0 );
+	printf( "  ranked the same          %s\n", sameRanking ? "yes" : "no" );
+
+	return sameRanking ? 0 : 1;
+}
+
+static int compareDoubles( const void *a, const void *b ) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return ( x > y ) - ( x < y );
+}
+
+// the indices of the 'numTop' fittest creatures, fittest first (the first of equals first)
+static void rankFittest( double *fitness, int numCreatures, int *fittest, int numTop ) {
+	for ( int r = 0; r < numTop; ++r ) {
+		int best = -1;
+		for ( int i = 0; i < numCreatures; ++i ) {
+			int ranked = 0;
+			for ( int j = 0; j < r; ++j ) {
+				ranked |= ( fittest[j] == i );
+			}
+			if ( !ranked && ( best < 0 || fitness[i] > fitness[best] ) ) {
+				best = i;
+			}
+		}
+		fittest[r] = best;
+	}
+}
@@ -0,0 +1,183 @@
+/*
+ * Timestep validation:
+ *  simulates a set of random creatures (plus any .hdk files given with -f)
+ *  for the same length of time with longer fixed steps and with adaptive
+ *  stepping, and reports how far each creature's fitness (distance
+ *  travelled) ends up from the default 1/60 s steps.
+ *
+ * usage: timestepBench [-n creatures] [-l limbs] [-s seconds] [-f file.hdk ...]
+ */
+
+#include "../environment.h"
+#include "../creature.h"
+#include "../finite.h"
+#include "genomes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+// a creature that ends up further than this has blown up
+#define MAX_DISTANCE 100000.0
+
+typedef struct {
+	const char *name;
+	double timestep;
+	int substeps;
+	int maxSubsteps;
+} config_t;
+
+typedef struct {
+	double fitness;
+	long steps;
+	double seconds;
+} result_t;
+
+static result_t runCreature( json_t *genome, const config_t *config, double duration );
+
+
+int main( int argc, char *argv[] ) {
+	int numRandom = 20;
+	int limbs = 6;
+	double duration = 30.0;
+
+	int numFiles = 0;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-n", 2 ) == 0 && i+1 < argc ) {
+			numRandom = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-l", 2 ) == 0 && i+1 < argc ) {
+			limbs = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-s", 2 ) == 0 && i+1 < argc ) {
+			duration = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-f", 2 ) == 0 && i+1 < argc ) {
+			numFiles++;
+		}
+	}
+
+	json_t **genomes = malloc( sizeof( json_t * ) * ( numFiles + numRandom ) );
+	assert( genomes != NULL );
+	int numGenomes = 0;
+
+	for ( int i = 0; i < argc; ++i ) {
+		if ( strncmp( argv[i], "-f", 2 ) == 0 && i+1 < argc ) {
+			json_error_t error;
+			json_t *json = json_load_file( argv[i+1], &error );
+
+			if ( !json ) {
+				fprintf( stderr, "Error parsing humperdink on line %d:\n", error.line );
+				fprintf( stderr, "\t%s\n\n", error.text );
+				exit( 1 );
+			}
+			genomes[numGenomes++] = json;
+		}
+	}
+	for ( int i = 0; i < numRandom; ++i ) {
+		genomes[numGenomes++] = createRandomGenome( limbs, i + 1 );
+	}
+
+	cpInitChipmunk( );
+
+	const config_t configs[] = {
+		{ "1/60",            0.0,        1, 0 },
+		// smaller steps, shows how much of the error is just the creatures being chaotic
+		{ "1/120",           1.0/60.0,   2, 0 },
+		{ "1/30",            1.0/30.0,   1, 0 },
+		{ "1/20",            1.0/20.0,   1, 0 },
+		{ "1/15",            1.0/15.0,   1, 0 },
+		{ "1/30 adaptive 2", 1.0/30.0,   1, 2 },
+		{ "1/15 adaptive 4", 1.0/15.0,   1, 4 },
+		{ "1/10 adaptive 8", 1.0/10.0,   1, 8 },
+	};
+	int numConfigs = sizeof( configs ) / sizeof( configs[0] );
+
+	printf( "%d creatures, %.1f simulated seconds each\n\n", numGenomes, duration );
+	printf( "%-16s %10s %9s %12s %12s %12s %9s\n",
+		"timestep", "steps/s", "speedup", "mean error", "max error", "rel. error", "blown up" );
+
+	result_t baseline[numGenomes];
+	double baselineSeconds = 0.0;
+	double meanFitness = 0.0;
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		baseline[i] = runCreature( genomes[i], &configs[0], duration );
+		baselineSeconds += baseline[i].seconds;
+		meanFitness += fabs( baseline[i].fitness ) / numGenomes;
+	}
+
+	for ( int c = 0; c < numConfigs; ++c ) {
+		double seconds = 0.0;
+		double meanError = 0.0;
+		double maxError = 0.0;
+		long steps = 0;
+		int blownUp = 0;
+
+		for ( int i = 0; i < numGenomes; ++i ) {
+			result_t result = ( c == 0 ) ? baseline[i] : runCreature( genomes[i], &configs[c], duration );
+
+			seconds += result.seconds;
+			steps += result.steps;
+
+			if ( !isFiniteValue( result.fitness ) || fabs( result.fitness ) > MAX_DISTANCE ) {
+				blownUp++;
+				continue;
+			}
+
+			double error = fabs( result.fitness - baseline[i].fitness );
+			meanError += error / numGenomes;
+			maxError = fmax( maxError, error );
+		}
+
+		printf( "%-16s %10.1f %9.2f %12.3f %12.3f %12.3f %9d\n",
+			configs[c].name,
+			steps / ( duration * numGenomes ),
+			baselineSeconds / seconds,
+			meanError, maxError,
+			( meanFitness > 0.0 ) ? meanError / meanFitness : 0.0,
+			blownUp
+		);
+	}
+
+	printf( "\n(errors are in distance travelled, relative to the mean distance of the 1/60 runs)\n" );
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		json_decref( genomes[i] );
+	}
+	free( genomes );
+
+	return 0;
+}
+
+static result_t runCreature( json_t *genome, const config_t *config, double duration ) {
+	Environment env = createEnvironment( 800, 600 );
+
+	// leave the default untouched so the baseline is the simulator's usual stepping
+	double timestep = 1.0/60.0;
+	if ( config->timestep > 0.0 ) {
+		timestep = config->timestep;
+		setEnvironmentTimestep( env, timestep );
+	}
+	setEnvironmentSubsteps( env, config->substeps );
+	setEnvironmentAdaptiveSubsteps( env, config->maxSubsteps );
+
+	Creature creature = createCreature( genome, getEnvironmentSpace( env ) );
+	double startX = getCreatureX( creature );
+
+	int updates = (int)( duration / timestep + 0.5 );
+
+	result_t result;
+	double start = benchTime( );
+	for ( int i = 0; i < updates; ++i ) {
+		updateEnvironment( env );
+	}
+	result.seconds = benchTime( ) - start;
+	result.fitness = getCreatureX( creature ) - startX;
+	result.steps = getEnvironmentStepCount( env );
+
+	destroyCreature( creature );
+	destroyEnvironment( env );
+
+	return result;
+}
@@ -0,0 +1,299 @@
+#include "binaryGenome.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct binaryGenome {
+	// the whole file: mapped, or read into memory if it can't be mapped
+	void *data;
+	size_t size;
+	int mapped;
+
+	parameters_t *parameters;
+	int numLimbs;
+};
+
+/*
+ * Private helper function prototypes
+ */
+static void setError( json_error_t *error, const char *format, const char *path, const char *reason );
+static const char *checkHeader( binaryGenomeHeader_t *header, size_t size );
+static int isTree( parameters_t *parameters, int numLimbs );
+static void setParents( parameters_t *parameters, int *parents, int numLimbs );
+static json_t *createLimbJSON( parameters_t *parameters, int *index );
+
+
+BinaryGenome openBinaryGenome( const char *path, json_error_t *error ) {
+	int file = open( path, O_RDONLY );
+	if ( file < 0 ) {
+		setError( error, "unable to open %s: %s", path, strerror( errno ) );
+		return NULL;
+	}
+
+	struct stat status;
+	if ( fstat( file, &status ) != 0 || status.st_size < sizeof( binaryGenomeHeader_t ) ) {
+		close( file );
+		setError( error, "%s is not a binary genome: %s", path, "too short" );
+		return NULL;
+	}
+
+	BinaryGenome genome = malloc( sizeof( struct binaryGenome ) );
+	assert( genome != NULL );
+	genome->size = status.st_size;
+	genome->mapped = 1;
+	genome->data = mmap( NULL, genome->size, PROT_READ, MAP_PRIVATE, file, 0 );
+
+	if ( genome->data == MAP_FAILED ) {
+		// read it instead
+		genome->mapped = 0;
+		genome->data = malloc( genome->size );
+		assert( genome->data != NULL );
+		if ( read( file, genome->data, genome->size ) != (ssize_t)genome->size ) {
+			close( file );
+			closeBinaryGenome( genome );
+			setError( error, "unable to read %s: %s", path, strerror( errno ) );
+			return NULL;
+		}
+	}
+	close( file );
+
+	binaryGenomeHeader_t *header = genome->data;
+	const char *reason = checkHeader( header, genome->size );
+	if ( reason == NULL ) {
+		genome->parameters = (parameters_t *)( header + 1 );
+		genome->numLimbs = header->numLimbs;
+		if ( !isTree( genome->parameters, genome->numLimbs ) ) {
+			reason = "limbs don't make a tree";
+		}
+	}
+
+	if ( reason != NULL ) {
+		closeBinaryGenome( genome );
+		setError( error, "%s is not a binary genome: %s", path, reason );
+		return NULL;
+	}
+
+	return genome;
+}
+
+int loadBinaryGenomeData( const void *data, size_t size, genome_t *genome, json_error_t *error ) {
+	if ( size < sizeof( binaryGenomeHeader_t ) ) {
+		setError( error, "%s is not a binary genome: %s", "data", "too short" );
+		return 0;
+	}
+
+	// copied out, as the data might not be aligned for the header or the records
+	binaryGenomeHeader_t header;
+	memcpy( &header, data, sizeof( header ) );
+	const char *reason = checkHeader( &header, size );
+	if ( reason == NULL ) {
+		if ( genome->capacity < (int)header.numLimbs ) {
+			genome->capacity = header.numLimbs;
+			genome->parameters = realloc( genome->parameters, sizeof( parameters_t ) * genome->capacity );
+			genome->parents = realloc( genome->parents, sizeof( int ) * genome->capacity );
+			assert( genome->parameters != NULL && genome->parents != NULL );
+		}
+		memcpy( genome->parameters, (const char *)data + sizeof( header ), sizeof( parameters_t ) * header.numLimbs );
+		genome->numLimbs = header.numLimbs;
+
+		if ( !isTree( genome->parameters, genome->numLimbs ) ) {
+			genome->numLimbs = 0;
+			reason = "limbs don't make a tree";
+		}
+	}
+
+	if ( reason != NULL ) {
+		setError( error, "%s is not a binary genome: %s", "data", reason );
+		return 0;
+	}
+
+	setParents( genome->parameters, genome->parents, genome->numLimbs );
+	return 1;
+}
+
+int loadBinaryGenomePath( const char *path, genome_t *genome, json_error_t *error ) {
+	BinaryGenome binaryGenome = openBinaryGenome( path, error );
+	if ( binaryGenome == NULL ) {
+		return 0;
+	}
+
+	int loaded = loadBinaryGenomeData( binaryGenome->data, binaryGenome->size, genome, error );
+	closeBinaryGenome( binaryGenome );
+	return loaded;
+}
+
+void closeBinaryGenome( BinaryGenome genome ) {
+	if ( genome->mapped ) {
+		munmap( genome->data, genome->size );
+	} else {
+		free( genome->data );
+	}
+	free( genome );
+}
+
+parameters_t *getBinaryGenomeLimbs( BinaryGenome genome ) {
+	return genome->parameters;
+}
+
+int getBinaryGenomeNumLimbs( BinaryGenome genome ) {
+	return genome->numLimbs;
+}
+
+int isBinaryGenomeFile( const char *path ) {
+	char magic[4];
+
+	FILE *file = fopen( path, "rb" );
+	if ( file == NULL ) {
+		return 0;
+	}
+	int isBinary = ( fread( magic, 1, sizeof( magic ), file ) == sizeof( magic ) && memcmp( magic, BINARY_GENOME_MAGIC, sizeof( magic ) ) == 0 );
+	fclose( file );
+
+	return isBinary;
+}
+
+int writeBinaryGenome( FILE *output, parameters_t *parameters, int numLimbs ) {
+	binaryGenomeHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, BINARY_GENOME_MAGIC, sizeof( header.magic ) );
+	header.version = BINARY_GENOME_VERSION;
+	header.byteOrder = BINARY_GENOME_BYTE_ORDER;
+	header.recordSize = sizeof( parameters_t );
+	header.numLimbs = numLimbs;
+
+	if ( fwrite( &header, sizeof( header ), 1, output ) != 1 ) {
+		return 0;
+	}
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		// copied field by field, so the padding is written as 0
+		parameters_t record;
+		memset( &record, 0, sizeof( record ) );
+		record.numConnections = parameters[i].numConnections;
+		record.angle = parameters[i].angle;
+		record.length = parameters[i].length;
+		record.frequency = parameters[i].frequency;
+		record.amplitude = parameters[i].amplitude;
+		record.phase = parameters[i].phase;
+
+		if ( fwrite( &record, sizeof( record ), 1, output ) != 1 ) {
+			return 0;
+		}
+	}
+
+	return fflush( output ) == 0;
+}
+
+json_t *createGenomeJSON( parameters_t *parameters, int numLimbs ) {
+	int index = 0;
+	json_t *json = createLimbJSON( parameters, &index );
+	assert( index == numLimbs );
+	return json;
+}
+
+int writeBinaryGenomeFromJSON( FILE *output, json_t *json ) {
+	int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( json, parameters, parents, numLimbs );
+
+	return writeBinaryGenome( output, parameters, numLimbs );
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+static void setError( json_error_t *error, const char *format, const char *path, const char *reason ) {
+	if ( error != NULL ) {
+		error->line = -1;
+		snprintf( error->text, JSON_ERROR_TEXT_LENGTH, format, path, reason );
+	}
+}
+
+static const char *checkHeader( binaryGenomeHeader_t *header, size_t size ) {
+	if ( memcmp( header->magic, BINARY_GENOME_MAGIC, sizeof( header->magic ) ) != 0 ) {
+		return "no magic number";
+	} else if ( header->version != BINARY_GENOME_VERSION ) {
+		return "unknown version";
+	} else if ( header->byteOrder != BINARY_GENOME_BYTE_ORDER ) {
+		return "written with the other byte order";
+	} else if ( header->recordSize != sizeof( parameters_t ) ) {
+		return "written with a different record size";
+	} else if ( header->numLimbs == 0 || header->numLimbs > INT_MAX
+		|| size != sizeof( binaryGenomeHeader_t ) + (size_t)header->numLimbs * sizeof( parameters_t ) ) {
+		return "wrong size for its number of limbs";
+	}
+
+	return NULL;
+}
+
+// every limb is some limb's child, except the root, and none is left over
+static int isTree( parameters_t *parameters, int numLimbs ) {
+	// limbs still to come, for the connections of the limbs so far
+	long pending = 1;
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		if ( pending == 0 || parameters[i].numConnections < 0 ) {
+			return 0;
+		}
+		pending += parameters[i].numConnections - 1;
+	}
+
+	return pending == 0;
+}
+
+// of a tree (see isTree): each limb's parent is the last limb before it still short of children
+static void setParents( parameters_t *parameters, int *parents, int numLimbs ) {
+	// limbs short of children, innermost last, and how many each is still short
+	int *open = malloc( sizeof( int ) * numLimbs * 2 );
+	assert( open != NULL );
+	int *missing = open + numLimbs;
+	int depth = 0;
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		while ( depth > 0 && missing[depth - 1] == 0 ) {
+			depth--;
+		}
+		if ( depth == 0 ) {
+			parents[i] = -1;
+		} else {
+			parents[i] = open[depth - 1];
+			missing[depth - 1]--;
+		}
+
+		open[depth] = i;
+		missing[depth] = parameters[i].numConnections;
+		depth++;
+	}
+
+	free( open );
+}
+
+static json_t *createLimbJSON( parameters_t *parameters, int *index ) {
+	parameters_t *limb = &parameters[*index];
+	(*index)++;
+
+	json_t *json = json_object( );
+	json_object_set_new( json, "angle", json_real( limb->angle ) );
+	json_object_set_new( json, "length", json_real( limb->length ) );
+	json_object_set_new( json, "frequency", json_real( limb->frequency ) );
+	json_object_set_new( json, "amplitude", json_real( limb->amplitude ) );
+	json_object_set_new( json, "phase", json_real( limb->phase ) );
+
+	json_t *connections = json_array( );
+	for ( int i = 0; i < limb->numConnections; ++i ) {
+		json_array_append_new( connections, createLimbJSON( parameters, index ) );
+	}
+	json_object_set_new( json, "connections", connections );
+
+	return json;
+}
@@ -0,0 +1,91 @@
+/*
+ * BinaryGenome ADT:
+ *  A genome in a compact binary file, for genomes written and read by
+ *  programs by the million rather than by hand. Opening one maps the file
+ *  into memory and uses its limbs where they are, without parsing or
+ *  copying them.
+ *
+ * The file is a header followed by one record per limb, depth-first in
+ * the order of getGenomeLimbs:
+ *  - header (24 bytes): the magic "HDKB", then as 32-bit integers the
+ *    format version (BINARY_GENOME_VERSION), BINARY_GENOME_BYTE_ORDER as
+ *    the writer stored it, the size of a record, the number of limbs, and 0
+ *  - records: parameters_t as the writer laid it out (its numConnections,
+ *    the number of children, then angle, length, frequency, amplitude and
+ *    phase as doubles; padding is 0)
+ * A file is only read on machines that agree on the byte order and the
+ * record size, and only if the limbs' numbers of children make one tree.
+ */
+#ifndef BINARYGENOME_H
+#define BINARYGENOME_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <jansson.h>
+#include "creature.h"
+#include "genomeLoader.h"
+
+#define BINARY_GENOME_MAGIC "HDKB"
+#define BINARY_GENOME_VERSION 1
+#define BINARY_GENOME_BYTE_ORDER 0x01020304u
+
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t recordSize;
+	uint32_t numLimbs;
+	uint32_t reserved;
+} binaryGenomeHeader_t;
+
+typedef struct binaryGenome *BinaryGenome;
+
+/*
+ * Constructor: Opens (maps) a binary genome file, checking it. Returns
+ *  NULL if it can't be read or isn't a valid binary genome, with the
+ *  reason in 'error' (line -1), as loadGenomePath reports its errors.
+ * Deconstructor: Unmaps the file
+ */
+BinaryGenome openBinaryGenome( const char *path, json_error_t *error );
+void closeBinaryGenome( BinaryGenome genome );
+
+/*
+ * Loads a whole binary genome file that is already in memory, 'size'
+ * bytes at 'data' (aligned or not), into 'genome', copying its limbs.
+ * Returns 1 on success, or 0 with the reason in 'error' as
+ * openBinaryGenome reports it.
+ */
+int loadBinaryGenomeData( const void *data, size_t size, genome_t *genome, json_error_t *error );
+
+/*
+ * The same from a file, as openBinaryGenome reports its errors
+ */
+int loadBinaryGenomePath( const char *path, genome_t *genome, json_error_t *error );
+
+/*
+ * The genome's limbs, as createCreatureFromLimbs takes them:
+ * valid until the genome is closed
+ */
+parameters_t *getBinaryGenomeLimbs( BinaryGenome genome );
+int getBinaryGenomeNumLimbs( BinaryGenome genome );
+
+/*
+ * True if the file starts with the binary genome magic
+ * (so is not JSON, which can't start with 'H')
+ */
+int isBinaryGenomeFile( const char *path );
+
+/*
+ * Writes limbs (in the order of getGenomeLimbs) as a binary genome,
+ * returns 1 on success
+ */
+int writeBinaryGenome( FILE *output, parameters_t *parameters, int numLimbs );
+
+/*
+ * Converters from limbs to the JSON schema of the .hdk files (readme.txt),
+ * and to a binary genome from JSON (returns 1 on success)
+ */
+json_t *createGenomeJSON( parameters_t *parameters, int numLimbs );
+int writeBinaryGenomeFromJSON( FILE *output, json_t *json );
+
+#endif
@@ -1,4 +1,6 @@
 #include "creature.h"
+#include "articulation.h"
+#include "finite.h"
 #include <string.h>
 #include <assert.h>
 #include <math.h>
@@ -7,14 +9,9 @@
 
 // physics simulation
 #include "chipmunk.h"
+#include "chipmunk_unsafe.h"
 
 
-// thickness of creature limbs
-#define SHAPE_RADIUS 4.0f
-
-// mass per 1 unit of limb length
-#define MASS_PER_LENGTH 0.25f
-
 static int groupCount = 1;
 
 /*
@@ -31,6 +28,11 @@ struct creatureNode {
 	int treeSize;
 	
 	cpBody *body;
+	cpShape *shape;
+	
+	// joint and motor connecting this limb to its parent (NULL for the root, or if articulated)
+	cpConstraint *joint;
+	cpConstraint *motor;
 	
 	// end of limb, where new limbs connect
 	cpVect endPoint;
@@ -48,18 +50,52 @@ struct creatureNode {
 struct creature {
 	CreatureNode root;
 	json_t *json;
+	
+	// reduced-coordinate simulation of the limbs, if articulated
+	Articulation articulation;
 };
 
 /*
  * Private helper function prototypes
  */
 static void destroyCreatureNodeTree( CreatureNode node );
-static CreatureNode createNodesFromJSON( json_t *jsonObject, CreatureNode parent, cpSpace *space );
+static CreatureNode createNodesFromLimbs( parameters_t *parameters, int *index, CreatureNode parent, cpSpace *space, int joints );
+static parameters_t readParameters( json_t *jsonObject );
+static void readLimbs( json_t *jsonObject, int parent, parameters_t *parameters, int *parents, int *numLimbs, int maxLimbs );
+static CreatureNode createLimbNode( parameters_t parameters, CreatureNode parent, cpSpace *space );
+static void collectLimbs( CreatureNode node, int parent, CreatureNode *nodes, int *parents, int *numLimbs );
+static cpVect poseLimbNode( CreatureNode node, CreatureNode parent, cpVect *position );
+static int sameNodeTopology( CreatureNode node, parameters_t *parameters, int numLimbs, int *index );
+static void resetNodes( CreatureNode node, parameters_t *parameters, int *index );
+static void stateNodes( CreatureNode node, creatureState_t *state, int *finite );
+static void tagNodes( CreatureNode node, Creature creature );
 
 
 
 
-static CreatureNode createNodesFromJSON( json_t *jsonObject, CreatureNode parent, cpSpace *space ) {
+static CreatureNode createNodesFromLimbs( parameters_t *parameters, int *index, CreatureNode parent, cpSpace *space, int joints ) {
+	parameters_t limb = parameters[*index];
+	(*index)++;
+	
+	CreatureNode node;
+	if ( joints ) {
+		node = createCreatureNode( limb, parent, space );
+	} else {
+		node = createLimbNode( limb, parent, space );
+	}
+	node->treeSize = 1;
+	
+	// the children follow depth-first
+	for ( int i = 0; i < limb.numConnections; ++i ) {
+		node->connections[i] = createNodesFromLimbs( parameters, index, node, space, joints );
+		node->treeSize += node->connections[i]->treeSize;
+	}
+	
+	return node;
+}
+
+
+static parameters_t readParameters( json_t *jsonObject ) {
 	assert( json_is_object( jsonObject ) );
 	
 	// Borrowed references, no need for memory collection
@@ -81,17 +117,27 @@ static CreatureNode createNodesFromJSON( json_t *jsonObject, CreatureNode parent
 	parameters.amplitude      = json_real_value( jsonAmplitude );
 	parameters.phase          = json_real_value( jsonPhase );
 	
-	CreatureNode node = createCreatureNode( parameters, parent, space );
-	node->treeSize = 1;
-	
-	for ( int i = 0; i < parameters.numConnections; ++i ) {
-		json_t *jsonChildObject = json_array_get( jsonConnections, i );
-		
-		node->connections[i] = createNodesFromJSON( jsonChildObject, node, space );
-		node->treeSize += node->connections[i]->treeSize;
+	return parameters;
+}
+
+/*
+ * Lists the parameters of a genome's limbs depth-first, in the same order
+ * the limbs are created in, with the index of each limb's parent
+ */
+static void readLimbs( json_t *jsonObject, int parent, parameters_t *parameters, int *parents, int *numLimbs, int maxLimbs ) {
+	int index = *numLimbs;
+	(*numLimbs)++;
+	
+	parameters_t limb = readParameters( jsonObject );
+	if ( index < maxLimbs ) {
+		parameters[index] = limb;
+		parents[index] = parent;
 	}
 	
-	return node;
+	json_t *jsonConnections = json_object_get( jsonObject, "connections" );
+	for ( int i = 0; i < limb.numConnections; ++i ) {
+		readLimbs( json_array_get( jsonConnections, i ), index, parameters, parents, numLimbs, maxLimbs );
+	}
 }
 
 
@@ -99,82 +145,60 @@ static CreatureNode createNodesFromJSON( json_t *jsonObject, CreatureNode parent
  * ADT implementation
  */
 
-CreatureNode createCreatureNode( parameters_t parameters, CreatureNode parent, cpSpace *space ) {
-	// create memory for node
-	CreatureNode node = malloc( sizeof( struct creatureNode ) );
-	assert( node != NULL );
-	
-	// copy parameters into the node
-	node->parameters = parameters;
-	
-	// find how many connections this node has
-	node->numConnections = node->parameters.numConnections;
-	
-	// create memory (array) for references to the connecting nodes
-	node->connections = malloc( sizeof( CreatureNode ) * node->numConnections );
-	assert( node->connections != NULL );
-	
-	
-	// create physics objects
-	
-	node->parent = parent;
-	
-	cpVect position;
-	cpFloat baseAngle;
+int getGenomeLimbs( json_t *json, parameters_t *parameters, int *parents, int maxLimbs ) {
+	int numLimbs = 0;
+	readLimbs( json, -1, parameters, parents, &numLimbs, maxLimbs );
+	return numLimbs;
+}
+
+unsigned int getGenomeTopologyKey( json_t *json ) {
+	// FNV-1a over the number of connections of each limb, depth-first
+	unsigned int key = 2166136261u;
+	json_t *connections = json_object_get( json, "connections" );
+	int numConnections = json_array_size( connections );
 	
-	if ( parent == NULL ) {
-		position = cpvzero;
-		baseAngle = M_PI/2.0;
-	} else {
-		position = parent->endPoint;
-		baseAngle = parent->angle;
+	key = ( key ^ numConnections ) * 16777619u;
+	for ( int i = 0; i < numConnections; ++i ) {
+		key = ( key ^ getGenomeTopologyKey( json_array_get( connections, i ) ) ) * 16777619u;
 	}
-
-
-	// angle (create unit vector)
-	node->angle = baseAngle + node->parameters.angle;
-	cpVect limbVec = cpvforangle( node->angle );
-
-	// limb vector (multiply unit vector by length)
-	node->length = node->parameters.length;
-	limbVec = cpvmult( limbVec, node->length );
-
-	// endpoint (add limb vector to starting position)
-	node->endPoint = cpvadd( limbVec, position );
 	
-	cpFloat mass = node->parameters.length * MASS_PER_LENGTH;
+	return key;
+}
 
-	node->body = cpSpaceAddBody( 
-		space, 
-		cpBodyNew( mass, cpMomentForSegment( mass, cpvzero, limbVec ) )
-	);
+int sameGenomeTopology( json_t *a, json_t *b ) {
+	json_t *connectionsA = json_object_get( a, "connections" );
+	json_t *connectionsB = json_object_get( b, "connections" );
+	int numConnections = json_array_size( connectionsA );
 	
-	// move 
-	node->body->p = position;
-
-	// shape (starting position to endpoint, relative to body)
-	cpShape *shape = cpSegmentShapeNew( node->body, cpvzero, limbVec, SHAPE_RADIUS );
-	shape->group = groupCount++;
-	shape->u = FRICTION;
+	if ( numConnections != json_array_size( connectionsB ) ) {
+		return 0;
+	}
 	
-	cpSpaceAddShape(
-		space, 
-		shape
-	);
+	for ( int i = 0; i < numConnections; ++i ) {
+		if ( !sameGenomeTopology( json_array_get( connectionsA, i ), json_array_get( connectionsB, i ) ) ) {
+			return 0;
+		}
+	}
 	
+	return 1;
+}
+
+CreatureNode createCreatureNode( parameters_t parameters, CreatureNode parent, cpSpace *space ) {
+	CreatureNode node = createLimbNode( parameters, parent, space );
+	cpVect position = node->body->p;
 	
 	if ( parent != NULL ) {
 		//printf( "  connecting to parent\n" );
 		// joint (connect this limb to its parent)
-		cpSpaceAddConstraint(
+		node->joint = cpSpaceAddConstraint(
 			space, 
 			cpPivotJointNew( node->body, parent->body, position )
 		);
 	
 	
-		cpFloat amplitude = node->parameters.amplitude;
-		cpFloat frequency = node->parameters.frequency;
-		cpFloat phaseShift = node->parameters.phase;
+		cpFloat amplitude = (cpFloat)node->parameters.amplitude;
+		cpFloat frequency = (cpFloat)node->parameters.frequency;
+		cpFloat phaseShift = (cpFloat)node->parameters.phase;
 	
 		cpConstraint *motor = cpSpaceAddConstraint( 
 			space,
@@ -182,6 +206,7 @@ CreatureNode createCreatureNode( parameters_t parameters, CreatureNode parent, c
 		);
 		
 		motor->maxForce = MAX_FORCE;
+		node->motor = motor;
 	}
 	
 	return node;
@@ -194,12 +219,34 @@ void destroyCreatureNode( CreatureNode node ) {
 }
 
 Creature createCreature( json_t *json, cpSpace *space ) {
+	int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( json, parameters, parents, numLimbs );
+	
+	return createCreatureFromLimbs( parameters, numLimbs, space );
+}
+
+Creature createArticulatedCreature( json_t *json, cpSpace *space ) {
+	int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( json, parameters, parents, numLimbs );
+	
+	return createArticulatedCreatureFromLimbs( parameters, numLimbs, space );
+}
+
+Creature createCreatureFromLimbs( parameters_t *parameters, int numLimbs, cpSpace *space ) {
 	// allocate memory for the creature
 	Creature creature = malloc( sizeof( struct creature ) );
 	assert( creature != NULL );
 	
 	// recursively create nodes
-	creature->root = createNodesFromJSON( json, NULL, space );
+	int index = 0;
+	creature->root = createNodesFromLimbs( parameters, &index, NULL, space, 1 );
+	assert( index == numLimbs );
+	creature->articulation = NULL;
+	tagNodes( creature->root, creature );
 	
 	//printf( "Creature Size: %d\n", creature->root->treeSize );
 	//printf( "Position: (%lf, %lf)\n", creature->root->body->p.x, creature->root->body->p.y );
@@ -207,7 +254,45 @@ Creature createCreature( json_t *json, cpSpace *space ) {
 	return creature;
 }
 
+Creature createArticulatedCreatureFromLimbs( parameters_t *parameters, int numLimbs, cpSpace *space ) {
+	Creature creature = malloc( sizeof( struct creature ) );
+	assert( creature != NULL );
+	
+	// create the limbs without joints, the articulation connects them
+	int index = 0;
+	creature->root = createNodesFromLimbs( parameters, &index, NULL, space, 0 );
+	assert( index == numLimbs );
+	tagNodes( creature->root, creature );
+	
+	int parents[numLimbs];
+	CreatureNode nodes[numLimbs];
+	cpBody *bodies[numLimbs];
+	numLimbs = 0;
+	collectLimbs( creature->root, -1, nodes, parents, &numLimbs );
+	
+	for ( int i = 0; i < numLimbs; ++i ) {
+		bodies[i] = nodes[i]->body;
+	}
+	
+	creature->articulation = createArticulation( space, bodies, parents, numLimbs );
+	
+	for ( int i = 1; i < numLimbs; ++i ) {
+		parameters_t parameters = nodes[i]->parameters;
+		setArticulationMotor(
+			creature->articulation, i,
+			(cpFloat)parameters.frequency, (cpFloat)parameters.amplitude, (cpFloat)parameters.phase,
+			MAX_FORCE
+		);
+	}
+	
+	return creature;
+}
+
 void destroyCreature( Creature creature ) {
+	if ( creature->articulation != NULL ) {
+		destroyArticulation( creature->articulation );
+	}
+	
 	// remove all nodes recursively from the root
 	destroyCreatureNodeTree( creature->root );
 	
@@ -227,24 +312,105 @@ cpVect getCreaturePosition( Creature creature ) {
 	return creature->root->body->p;
 }
 
+void getCreatureState( Creature creature, creatureState_t *state ) {
+	cpBody *root = creature->root->body;
+	state->rootTurn = atan2( root->rot.y, root->rot.x );
+	state->maxSpeed = 0.0;
+	state->lowestY = INFINITY;
+	state->maxSeparation = 0.0;
+	
+	int finite = 1;
+	stateNodes( creature->root, state, &finite );
+	state->blownUp = !finite;
+}
+
+int isCreatureTouching( Creature creature, cpSpace *space ) {
+	if ( creature->articulation != NULL && getArticulationNumContacts( creature->articulation ) > 0 ) {
+		return 1;
+	}
+	
+	// arbiters of the last step, found by the shapes tagged in tagNodes
+	cpArray *arbiters = space->arbiters;
+	for ( int i = 0; i < arbiters->num; ++i ) {
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		if ( arb->a->data == creature || arb->b->data == creature ) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+double getCreatureEnergy( Creature creature ) {
+	int numLimbs = creature->root->treeSize;
+	double energies[numLimbs];
+	getCreatureLimbEnergies( creature, energies );
+	
+	double energy = 0.0;
+	for ( int i = 0; i < numLimbs; ++i ) {
+		energy += energies[i];
+	}
+	return energy;
+}
+
+void getCreatureLimbEnergies( Creature creature, double *energies ) {
+	int numLimbs = 0;
+	int parents[creature->root->treeSize];
+	CreatureNode nodes[creature->root->treeSize];
+	collectLimbs( creature->root, -1, nodes, parents, &numLimbs );
+	
+	for ( int i = 0; i < numLimbs; ++i ) {
+		if ( creature->articulation != NULL ) {
+			energies[i] = getArticulationMotorWork( creature->articulation, i );
+		} else if ( nodes[i]->motor != NULL ) {
+			energies[i] = cpOscillatingMotorGetWork( nodes[i]->motor );
+		} else {
+			energies[i] = 0.0;
+		}
+	}
+}
+
 void printCreatureDebug( Creature creature ) {
 	fprintf( stderr, "Creature Debug:\n" );
 	fprintf( stderr, "--------------\n" );
-	fprintf( stderr, "  Root Position: (%lf,%lf)\n", creature->root->body->p.x, creature->root->body->p.y );
-	fprintf( stderr, "  Root Velocity: (%lf,%lf)\n", creature->root->body->v.x, creature->root->body->v.y );
-	fprintf( stderr, "  Root rotational Velocity: %lf\n", creature->root->body->w );
+	fprintf( stderr, "  Root Position: (%lf,%lf)\n", (double)creature->root->body->p.x, (double)creature->root->body->p.y );
+	fprintf( stderr, "  Root Velocity: (%lf,%lf)\n", (double)creature->root->body->v.x, (double)creature->root->body->v.y );
+	fprintf( stderr, "  Root rotational Velocity: %lf\n", (double)creature->root->body->w );
 	fprintf( stderr, "  Total Limbs: %d\n", creature->root->treeSize );
 	fprintf( stderr, "  Limb Positions:\n");
 	
 	cpVect *limbPositions = getCreatureLimbPositions( creature );
 	for ( int i = 0; i < creature->root->treeSize; ++i ) {
-		fprintf( stderr, "   %d: (%lf,%lf)\n", i, limbPositions[i].x, limbPositions[i].y );
+		fprintf( stderr, "   %d: (%lf,%lf)\n", i, (double)limbPositions[i].x, (double)limbPositions[i].y );
 	}
 	free( limbPositions );
 	
 	fprintf( stderr, "--------------\n\n" );
 }
 
+int sameCreatureTopology( Creature creature, parameters_t *parameters, int numLimbs ) {
+	int index = 0;
+	return sameNodeTopology( creature->root, parameters, numLimbs, &index ) && index == numLimbs;
+}
+
+void setCreatureParameters( Creature creature, parameters_t *parameters, int numLimbs ) {
+	// the articulation keeps its own copy of the tree's state
+	assert( creature->articulation == NULL );
+	// the caller's to check: the creature's templates already have (see sameCreatureTopology)
+	assert( sameCreatureTopology( creature, parameters, numLimbs ) );
+	
+	int index = 0;
+	resetNodes( creature->root, parameters, &index );
+}
+
+void setCreatureGenome( Creature creature, json_t *json ) {
+	int numLimbs = getGenomeLimbs( json, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( json, parameters, parents, numLimbs );
+	
+	setCreatureParameters( creature, parameters, numLimbs );
+}
+
 int getCreatureNumLimbs( Creature creature ) {
 	return creature->root->treeSize;
 }
@@ -279,6 +445,214 @@ cpVect *getCreatureLimbPositions( Creature creature ) {
 /*
  * Private helper function implementation
  */
+
+/*
+ * Creates the body and shape of a limb, without connecting it to its parent
+ */
+static CreatureNode createLimbNode( parameters_t parameters, CreatureNode parent, cpSpace *space ) {
+	// create memory for node
+	CreatureNode node = malloc( sizeof( struct creatureNode ) );
+	assert( node != NULL );
+	
+	// copy parameters into the node
+	node->parameters = parameters;
+	
+	// find how many connections this node has
+	node->numConnections = node->parameters.numConnections;
+	
+	// create memory (array) for references to the connecting nodes
+	node->connections = malloc( sizeof( CreatureNode ) * node->numConnections );
+	assert( node->connections != NULL );
+	
+	
+	// create physics objects
+	
+	node->parent = parent;
+	node->joint = NULL;
+	node->motor = NULL;
+	
+	cpVect position;
+	cpVect limbVec = poseLimbNode( node, parent, &position );
+	
+	cpFloat mass = node->length * MASS_PER_LENGTH;
+
+	node->body = cpSpaceAddBody( 
+		space, 
+		cpBodyNew( mass, cpMomentForSegment( mass, cpvzero, limbVec ) )
+	);
+	
+	// move 
+	node->body->p = position;
+
+	// shape (starting position to endpoint, relative to body)
+	cpShape *shape = cpSegmentShapeNew( node->body, cpvzero, limbVec, SHAPE_RADIUS );
+	// creatures may be built on several threads at once
+	shape->group = __atomic_fetch_add( &groupCount, 1, __ATOMIC_RELAXED );
+	shape->u = FRICTION;
+	
+	node->shape = cpSpaceAddShape(
+		space, 
+		shape
+	);
+	
+	return node;
+}
+
+/*
+ * Works out a limb's construction pose from its parameters and its parent's
+ * pose: sets its angle, length and end point, and returns its starting
+ * position and limb vector
+ */
+static cpVect poseLimbNode( CreatureNode node, CreatureNode parent, cpVect *position ) {
+	cpFloat baseAngle;
+	
+	if ( parent == NULL ) {
+		*position = cpvzero;
+		baseAngle = (cpFloat)( M_PI/2.0 );
+	} else {
+		*position = parent->endPoint;
+		baseAngle = parent->angle;
+	}
+
+
+	// angle (create unit vector)
+	node->angle = (cpFloat)( baseAngle + node->parameters.angle );
+	cpVect limbVec = cpvforangle( node->angle );
+
+	// limb vector (multiply unit vector by length)
+	node->length = (cpFloat)node->parameters.length;
+	limbVec = cpvmult( limbVec, node->length );
+
+	// endpoint (add limb vector to starting position)
+	node->endPoint = cpvadd( limbVec, *position );
+	
+	return limbVec;
+}
+
+/*
+ * True if the limbs from 'index' on, in depth-first order,
+ * connect up as this limb's sub-tree does
+ */
+static int sameNodeTopology( CreatureNode node, parameters_t *parameters, int numLimbs, int *index ) {
+	if ( *index >= numLimbs || parameters[*index].numConnections != node->numConnections ) {
+		return 0;
+	}
+	(*index)++;
+	
+	for ( int i = 0; i < node->numConnections; ++i ) {
+		if ( !sameNodeTopology( node->connections[i], parameters, numLimbs, index ) ) {
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+/*
+ * Puts a limb (and its sub-tree) back into its construction pose,
+ * with the next parameters in depth-first order
+ */
+static void resetNodes( CreatureNode node, parameters_t *parameters, int *index ) {
+	// only the parameters may change, not the tree
+	assert( parameters[*index].numConnections == node->numConnections );
+	node->parameters = parameters[*index];
+	(*index)++;
+	
+	CreatureNode parent = node->parent;
+	cpVect position;
+	cpVect limbVec = poseLimbNode( node, parent, &position );
+	
+	cpFloat mass = node->length * MASS_PER_LENGTH;
+	
+	cpBody *body = node->body;
+	cpBodySetMass( body, mass );
+	cpBodySetMoment( body, cpMomentForSegment( mass, cpvzero, limbVec ) );
+	body->p = position;
+	body->v = cpvzero;
+	body->f = cpvzero;
+	cpBodySetAngle( body, 0.0f );
+	body->w = 0.0f;
+	body->t = 0.0f;
+	body->v_bias = cpvzero;
+	body->w_bias = 0.0f;
+	
+	cpSegmentShapeSetEndpoints( node->shape, cpvzero, limbVec );
+	
+	if ( node->joint != NULL ) {
+		cpPivotJoint *joint = (cpPivotJoint *)node->joint;
+		joint->anchr1 = cpBodyWorld2Local( body, position );
+		joint->anchr2 = cpBodyWorld2Local( parent->body, position );
+		joint->jAcc = cpvzero;
+		
+		cpOscillatingMotor *motor = (cpOscillatingMotor *)node->motor;
+		motor->frequency = (cpFloat)node->parameters.frequency;
+		motor->amplitude = (cpFloat)node->parameters.amplitude;
+		motor->phaseShift = (cpFloat)node->parameters.phase;
+		motor->t = 0.0f;
+		motor->jAcc = 0.0f;
+		motor->work = 0.0f;
+	}
+	
+	for ( int i = 0; i < node->numConnections; ++i ) {
+		resetNodes( node->connections[i], parameters, index );
+	}
+}
+
+/*
+ * Adds a limb (and its sub-tree) to a creature state: the speed bound is
+ * the speed of the limb's start plus its spin times its length
+ */
+static void stateNodes( CreatureNode node, creatureState_t *state, int *finite ) {
+	cpBody *body = node->body;
+	cpSegmentShape *segment = (cpSegmentShape *)node->shape;
+	
+	cpVect a = cpBodyLocal2World( body, segment->a );
+	cpVect b = cpBodyLocal2World( body, segment->b );
+	cpFloat speed = cpvlength( body->v ) + cpfabs( body->w ) * node->length;
+	
+	*finite = *finite && isFiniteValue( a.x ) && isFiniteValue( a.y ) && isFiniteValue( b.x ) && isFiniteValue( b.y ) && isFiniteValue( speed );
+	
+	state->maxSpeed = fmax( state->maxSpeed, (double)speed );
+	state->lowestY = fmin( state->lowestY, (double)( cpfmin( a.y, b.y ) - segment->r ) );
+	
+	if ( node->parent != NULL ) {
+		cpSegmentShape *parentSegment = (cpSegmentShape *)node->parent->shape;
+		cpVect parentEnd = cpBodyLocal2World( node->parent->body, parentSegment->b );
+		state->maxSeparation = fmax( state->maxSeparation, (double)cpvdist( a, parentEnd ) );
+	}
+	
+	for ( int i = 0; i < node->numConnections; ++i ) {
+		stateNodes( node->connections[i], state, finite );
+	}
+}
+
+/*
+ * Marks the shapes of a limb (and its sub-tree) as the creature's
+ */
+static void tagNodes( CreatureNode node, Creature creature ) {
+	node->shape->data = creature;
+	
+	for ( int i = 0; i < node->numConnections; ++i ) {
+		tagNodes( node->connections[i], creature );
+	}
+}
+
+/*
+ * Lists the limbs of a tree depth-first (parents before children)
+ * with the index of each limb's parent
+ */
+static void collectLimbs( CreatureNode node, int parent, CreatureNode *nodes, int *parents, int *numLimbs ) {
+	int index = *numLimbs;
+	
+	nodes[index] = node;
+	parents[index] = parent;
+	(*numLimbs)++;
+	
+	for ( int i = 0; i < node->numConnections; ++i ) {
+		collectLimbs( node->connections[i], index, nodes, parents, numLimbs );
+	}
+}
+
 static void destroyCreatureNodeTree( CreatureNode node ) {
 	assert( node != NULL );
 	
@@ -3,6 +3,8 @@
  *  For converting genome array to a tree structure
  *  and creating physics simulation objects
  */
+#ifndef CREATURE_H
+#define CREATURE_H
 
 
 #include <stdint.h>
@@ -26,6 +28,12 @@ typedef struct creatureNode *CreatureNode;
 #define MAX_FORCE 100000
 #define FRICTION 0.2f
 
+// thickness of creature limbs
+#define SHAPE_RADIUS 4.0f
+
+// mass per 1 unit of limb length
+#define MASS_PER_LENGTH 0.25f
+
 /*
  *  - number of branches that connect to this node
  *  - length of this node's parent-connecting branch
@@ -60,11 +68,107 @@ void destroyCreatureNode( CreatureNode node );
 Creature createCreature( json_t *json, cpSpace *space );
 void destroyCreature( Creature creature );
 
+/*
+ * Constructor: Creates a creature whose limbs are simulated in joint
+ *  coordinates (see articulation.h) instead of with pivot joints and motors.
+ *  Not compatible with the graph coloring solver.
+ */
+Creature createArticulatedCreature( json_t *json, cpSpace *space );
+
+/*
+ * Constructors from a genome's limbs instead of its JSON: one set of
+ * parameters per limb, in the order of getGenomeLimbs (see genomeLoader.h
+ * for reading them straight from a file)
+ */
+Creature createCreatureFromLimbs( parameters_t *parameters, int numLimbs, cpSpace *space );
+Creature createArticulatedCreatureFromLimbs( parameters_t *parameters, int numLimbs, cpSpace *space );
+
+/*
+ * Reads a genome's limbs without building a creature: fills in (up to
+ * maxLimbs of) each limb's parameters and the index of its parent (-1 for
+ * the root), parents before their children, in the order createCreature
+ * creates the limbs. Returns the number of limbs in the genome.
+ */
+int getGenomeLimbs( json_t *json, parameters_t *parameters, int *parents, int maxLimbs );
+
+/*
+ * True if two genomes have the same tree of limbs,
+ * differing at most in the limbs' parameters
+ */
+int sameGenomeTopology( json_t *a, json_t *b );
+
+/*
+ * Hash of a genome's tree of limbs (genomes with the same topology have
+ * the same key), for looking up a creature to reuse with setCreatureGenome
+ */
+unsigned int getGenomeTopologyKey( json_t *json );
+
+/*
+ * Creature templates: turns a creature (made with createCreature) into the
+ * creature of another genome with the same topology, in place and without
+ * allocating. Every limb goes back to its construction pose with the new
+ * angle, length (and so mass and moment), frequency, amplitude and phase.
+ * The space should be reset too (see resetEnvironment).
+ * setCreatureParameters takes one set of parameters per limb, in the
+ * order of getGenomeLimbs. The genome's tree of limbs must be the
+ * creature's, which the caller checks (with sameGenomeTopology or
+ * sameCreatureTopology) when it looks the creature up: neither checks it
+ * again. Not for articulated creatures.
+ */
+void setCreatureGenome( Creature creature, json_t *json );
+void setCreatureParameters( Creature creature, parameters_t *parameters, int numLimbs );
+
+/*
+ * True if a creature has the tree of limbs of 'numLimbs' limbs' parameters
+ * (in the order of getGenomeLimbs), the test setCreatureParameters makes
+ */
+int sameCreatureTopology( Creature creature, parameters_t *parameters, int numLimbs );
+
 double getCreatureX( Creature creature );
 double getCreatureY( Creature creature );
 cpVect getCreaturePosition( Creature creature );
 
+/*
+ * A summary of the creature's limbs, for deciding whether it is worth
+ * simulating any further (see termination.h):
+ *  - whether any limb's position or velocity has become NaN or infinite
+ *  - an upper bound on the speed of any point of any limb
+ *  - the lowest point of any limb, including its thickness
+ *  - how far the root limb has turned from its construction pose (-pi..pi)
+ *  - the furthest any limb's start is from its parent's end (how far the
+ *    joints have come apart, 0 for articulated creatures)
+ */
+typedef struct {
+	int blownUp;
+	double maxSpeed;
+	double lowestY;
+	double rootTurn;
+	double maxSeparation;
+} creatureState_t;
+
+void getCreatureState( Creature creature, creatureState_t *state );
+
+/*
+ * True if any of the creature's limbs was touching anything
+ * (the ground, or another creature) in the space's last step
+ */
+int isCreatureTouching( Creature creature, cpSpace *space );
+
+/*
+ * Energy used by the creature's motors since it was created (or last given
+ * a genome with setCreatureGenome), accumulated by the physics solver
+ * once per step (so up to the step before the last), from each motor's
+ * impulse over the step and the speed it leaves the joint turning at
+ * (approximate, not the exact work). In total, and per limb: one value for
+ * each of getCreatureNumLimbs limbs, in the order of getGenomeLimbs
+ * (the root, with no motor, is always 0).
+ */
+double getCreatureEnergy( Creature creature );
+void getCreatureLimbEnergies( Creature creature, double *energies );
+
 void printCreatureDebug( Creature creature );
 
 int getCreatureNumLimbs( Creature creature );
-cpVect *getCreatureLimbPositions( Creature creature );
\ No newline at end of file
+cpVect *getCreatureLimbPositions( Creature creature );
+
+#endif
@@ -10,6 +10,24 @@
 
 #define GROUND_LENGTH 100000
 
+// cells in the static spatial hash (see createEnvironment)
+#define STATIC_CELLS 1000
+
+// how far the ground reaches below its surface: a limb that gets more than half
+// way through it in one step is pushed out of the bottom, so long steps need it deep
+#define GROUND_DEPTH 1000.0f
+
+// default length of time simulated by each update
+#define DEFAULT_TIMESTEP ( 1.0f/60.0f )
+
+// adaptive stepping limits: how far any point of a body may move in one step
+// (a few limb thicknesses, further and limbs start to pass through each other)
+// and how deep shapes may overlap before the step is shortened
+#define MAX_STEP_TRAVEL 16.0f
+#define MAX_STEP_PENETRATION 4.0f
+// an update is calm (and the next one may use longer steps) if it stayed under these fractions of the limits
+#define CALM_FRACTION 0.5f
+
 typedef struct creatureListNode *creatureListNode_t;
 
 struct creatureListNode {
@@ -25,8 +43,23 @@ struct environment {
 	int height;
 	
 	cpFloat groundHeight;
+	
+	// time per update, split into 'substeps' physics steps
+	cpFloat timestep;
+	int substeps;
+	// adaptive stepping if more than 1, the most substeps an update may take
+	int maxSubsteps;
+	
+	long stepCount;
 };
 
+/*
+ * Private helper function prototypes
+ */
+static void stepEnvironment( Environment env, cpFloat dt );
+static void updateAdaptive( Environment env );
+static void shapeSpeed( cpShape *shape, cpFloat *maxSpeed );
+
 
 Environment createEnvironment( int width, int height ) {
 	Environment env = malloc( sizeof( struct environment ) );
@@ -38,12 +71,16 @@ Environment createEnvironment( int width, int height ) {
 	env->width = width;
 	env->height = height;
 	
+	env->timestep = DEFAULT_TIMESTEP;
+	env->substeps = 1;
+	env->maxSubsteps = 0;
+	env->stepCount = 0;
+	
 	/*
 	 * Create the Space
 	 */
 	env->space = cpSpaceNew( );
 	env->space->iterations = 10; // physics accuracy
-	cpSpaceResizeStaticHash( env->space, 30.0f, 1000 );
 	cpSpaceResizeActiveHash( env->space, 30.0f, 1000 );
 	env->space->gravity = cpv( 0, -200 );
 	
@@ -63,6 +100,10 @@ Environment createEnvironment( int width, int height ) {
 	// height of ground
 	env->groundHeight = 10.0f;
 	
+	// the ground is the only static shape: one cell per slot of the static hash,
+	// rather than millions of limb-sized cells, each of which adding it visits
+	cpSpaceResizeStaticHash( env->space, 2.0f * halfWidth / STATIC_CELLS, STATIC_CELLS );
+	
 	
 	/*
 	printf( "%f, %f\n", halfWidth,-halfHeight );
@@ -72,8 +113,8 @@ Environment createEnvironment( int width, int height ) {
 	*/
 	// polygon for ground shape
 	cpVect groundPoly[] = {
-		cpv( halfWidth, -halfHeight ),
-		cpv( -halfWidth, -halfHeight  ),
+		cpv( halfWidth, -halfHeight+env->groundHeight-GROUND_DEPTH ),
+		cpv( -halfWidth, -halfHeight+env->groundHeight-GROUND_DEPTH ),
 		cpv( -halfWidth, -halfHeight+env->groundHeight ),
 		cpv( halfWidth, -halfHeight+env->groundHeight )
 	};
@@ -91,7 +132,73 @@ Environment createEnvironment( int width, int height ) {
 }
 
 void updateEnvironment( Environment env ) {
-	cpSpaceStep( env->space, 1.0f/60.0f );
+	if ( env->maxSubsteps > 1 ) {
+		updateAdaptive( env );
+	} else {
+		for ( int i = 0; i < env->substeps; ++i ) {
+			stepEnvironment( env, env->timestep / env->substeps );
+		}
+	}
+}
+
+void resetEnvironment( Environment env ) {
+	cpSpaceResetContacts( env->space );
+	env->stepCount = 0;
+	
+	// adaptive stepping starts over with whole updates
+	if ( env->maxSubsteps > 1 ) {
+		env->substeps = 1;
+	}
+}
+
+void setEnvironmentTimestep( Environment env, double timestep ) {
+	assert( timestep > 0.0 );
+	env->timestep = (cpFloat)timestep;
+}
+
+double getEnvironmentTimestep( Environment env ) {
+	return env->timestep;
+}
+
+void setEnvironmentSubsteps( Environment env, int substeps ) {
+	// an update of no steps would never move anything
+	env->substeps = ( substeps > 0 ) ? substeps : 1;
+}
+
+void setEnvironmentAdaptiveSubsteps( Environment env, int maxSubsteps ) {
+	env->maxSubsteps = maxSubsteps;
+	if ( maxSubsteps > 1 ) {
+		env->substeps = 1;
+	}
+}
+
+long getEnvironmentStepCount( Environment env ) {
+	return env->stepCount;
+}
+
+void setEnvironmentThreads( Environment env, int threads ) {
+	env->space->threads = threads;
+}
+
+void setEnvironmentGraphColoring( Environment env, int enabled ) {
+	env->space->graphColoring = enabled;
+}
+
+void setEnvironmentIterations( Environment env, int iterations ) {
+	env->space->iterations = iterations;
+}
+
+void setEnvironmentIterationTolerance( Environment env, double tolerance, int minIterations ) {
+	env->space->iterationTolerance = (cpFloat)tolerance;
+	env->space->minIterations = minIterations;
+}
+
+int getEnvironmentStepIterations( Environment env ) {
+	return env->space->stepStats.iterations;
+}
+
+double getEnvironmentGroundY( Environment env ) {
+	return -env->height/2.0 + env->groundHeight;
 }
 
 void destroyEnvironment( Environment env ) {
@@ -173,3 +280,62 @@ void displayEnvironment( Environment env, char *message, cpVect center ) {
 	glutSwapBuffers();
 	#endif
 }
+
+
+/*
+ * Private helper function implementation
+ */
+
+static void stepEnvironment( Environment env, cpFloat dt ) {
+	cpSpaceStep( env->space, dt );
+	env->stepCount++;
+}
+
+/*
+ * One update in power of two sub-steps: the sub-step is halved as soon as
+ * a step moves too far or overlaps too deeply (finishing the update with
+ * the shorter steps), and doubled for the next update after a calm one
+ */
+static void updateAdaptive( Environment env ) {
+	int substeps = env->substeps;
+	int taken = 0;
+	int calm = 1;
+	
+	while ( taken < substeps ) {
+		cpFloat dt = env->timestep / substeps;
+		stepEnvironment( env, dt );
+		taken++;
+		
+		cpFloat maxSpeed = 0.0f;
+		cpSpaceHashEach( env->space->activeShapes, (cpSpaceHashIterator)shapeSpeed, &maxSpeed );
+		
+		cpFloat travel = maxSpeed * dt;
+		cpFloat penetration = env->space->stepStats.penetration;
+		
+		if ( travel > MAX_STEP_TRAVEL * CALM_FRACTION || penetration > MAX_STEP_PENETRATION * CALM_FRACTION ) {
+			calm = 0;
+		}
+		
+		if ( ( travel > MAX_STEP_TRAVEL || penetration > MAX_STEP_PENETRATION ) && substeps * 2 <= env->maxSubsteps ) {
+			substeps *= 2;
+			taken *= 2;
+		}
+	}
+	
+	if ( calm && substeps > 1 ) {
+		substeps /= 2;
+	}
+	env->substeps = substeps;
+}
+
+// fastest any point of a shape's bounding box moves with its body
+static void shapeSpeed( cpShape *shape, cpFloat *maxSpeed ) {
+	cpBody *body = shape->body;
+	cpBB bb = shape->bb;
+	
+	cpFloat dx = cpfmax( cpfabs( bb.l - body->p.x ), cpfabs( bb.r - body->p.x ) );
+	cpFloat dy = cpfmax( cpfabs( bb.b - body->p.y ), cpfabs( bb.t - body->p.y ) );
+	cpFloat speed = cpvlength( body->v ) + cpfabs( body->w ) * cpfsqrt( dx*dx + dy*dy );
+	
+	*maxSpeed = cpfmax( *maxSpeed, speed );
+}
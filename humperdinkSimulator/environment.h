@@ -1,3 +1,6 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
 #ifndef NOGRAPHICS
 #include "display.h"
 #endif
@@ -10,8 +13,74 @@ Environment createEnvironment( int width, int height );
 
 void updateEnvironment( Environment env );
 
+/*
+ * Forgets all contacts and the step count, so the creatures in it can be
+ * moved back to their construction pose (see setCreatureGenome) and
+ * simulated again as if the environment had just been created
+ */
+void resetEnvironment( Environment env );
+
+/*
+ * Length of time simulated by each update (default 1/60 s),
+ * and the number of equal physics steps it is split into (default 1,
+ * and at least 1)
+ */
+void setEnvironmentTimestep( Environment env, double timestep );
+void setEnvironmentSubsteps( Environment env, int substeps );
+double getEnvironmentTimestep( Environment env );
+
+/*
+ * Adaptive stepping: each update starts with as many sub-steps as the last
+ * one ended with, halves the sub-step as soon as a limb moves too far in one
+ * step or shapes overlap too deeply (around impacts), and doubles it again
+ * after a calm update. At most maxSubsteps (a power of two) per update,
+ * 0 turns it off.
+ */
+void setEnvironmentAdaptiveSubsteps( Environment env, int maxSubsteps );
+
+/*
+ * Number of physics steps taken since the environment was created
+ */
+long getEnvironmentStepCount( Environment env );
+
+/*
+ * Number of threads the physics solver may use.
+ * Creatures that aren't touching each other are solved in parallel,
+ * the result is the same as with a single thread.
+ */
+void setEnvironmentThreads( Environment env, int threads );
+
+/*
+ * Solve with graph coloring: spreads the limbs of a single large creature
+ * over the solver threads. Changes the solver order, so results differ
+ * slightly from the default solver (but not between thread counts).
+ */
+void setEnvironmentGraphColoring( Environment env, int enabled );
+
+/*
+ * Number of passes the physics solver makes each step (default 10):
+ * fewer is faster, and less accurate
+ */
+void setEnvironmentIterations( Environment env, int iterations );
+
+/*
+ * Lets the physics solver stop early each step, once no contact or joint
+ * impulse changes by more than 'tolerance' in a pass (0 turns this off).
+ * Runs between minIterations and the space's iterations passes.
+ * getEnvironmentStepIterations gives the passes used by the last update.
+ */
+void setEnvironmentIterationTolerance( Environment env, double tolerance, int minIterations );
+int getEnvironmentStepIterations( Environment env );
+
+/*
+ * Height of the top of the ground, which creatures stand on
+ */
+double getEnvironmentGroundY( Environment env );
+
 void destroyEnvironment( Environment env );
 
 void displayEnvironment( Environment env, char *message, cpVect center );
 
-cpSpace *getEnvironmentSpace( Environment env );
\ No newline at end of file
+cpSpace *getEnvironmentSpace( Environment env );
+
+#endif
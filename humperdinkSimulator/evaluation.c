@@ -0,0 +1,270 @@
+#include "evaluation.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+// environments and creatures each thread keeps for reuse
+#define NUM_TEMPLATES 8
+
+// a creature to turn into the next genome with its tree of limbs (see setCreatureParameters),
+// alone in an environment set up by 'settings'
+typedef struct {
+	Environment env;
+	Creature creature;
+	evaluationSettings_t settings;
+	long lastUsed;
+} template_t;
+
+typedef struct {
+	template_t templates[NUM_TEMPLATES];
+	int numTemplates;
+	long uses;
+} templates_t;
+
+static pthread_key_t templatesKey;
+static pthread_once_t templatesKeyCreated = PTHREAD_ONCE_INIT;
+
+/*
+ * Private helper function prototypes
+ */
+static template_t *getTemplate( parameters_t *parameters, int numLimbs, evaluationSettings_t *settings );
+static Environment createSettingsEnvironment( evaluationSettings_t *settings );
+static int sameEnvironmentSettings( evaluationSettings_t *a, evaluationSettings_t *b );
+static void createTemplatesKey( void );
+static void destroyTemplates( void *templates );
+static uint64_t hashText( uint64_t key, const char *format, ... );
+
+
+evaluationSettings_t defaultEvaluationSettings( int updates ) {
+	evaluationSettings_t settings;
+
+	settings.updates = updates;
+	settings.timestep = 0.0;
+	settings.substeps = 1;
+	settings.maxSubsteps = 0;
+	settings.iterations = 0;
+	settings.tolerance = 0.0;
+	settings.articulated = 0;
+	settings.graphColoring = 0;
+	settings.terminate = 0;
+	settings.rules = defaultTerminationRules( );
+
+	return settings;
+}
+
+void evaluateGenome( json_t *genome, evaluationSettings_t *settings, metrics_t *result ) {
+	int numLimbs = getGenomeLimbs( genome, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( genome, parameters, parents, numLimbs );
+
+	evaluateLimbs( parameters, numLimbs, settings, result );
+}
+
+void evaluateLimbs( parameters_t *parameters, int numLimbs, evaluationSettings_t *settings, metrics_t *result ) {
+	Environment env;
+	Creature creature;
+	template_t *template = NULL;
+
+	if ( settings->articulated ) {
+		// articulated creatures can't be reused
+		env = createSettingsEnvironment( settings );
+		creature = createArticulatedCreatureFromLimbs( parameters, numLimbs, getEnvironmentSpace( env ) );
+	} else {
+		template = getTemplate( parameters, numLimbs, settings );
+		env = template->env;
+		creature = template->creature;
+	}
+
+	Metrics metrics = createMetrics( creature, env );
+	Termination termination = NULL;
+	if ( settings->terminate ) {
+		termination = createTermination( creature, env, settings->rules );
+	}
+
+	for ( int i = 0; i < settings->updates; ++i ) {
+		updateEnvironment( env );
+		updateMetrics( metrics );
+
+		if ( termination != NULL && checkTermination( termination ) != TERMINATION_NONE ) {
+			break;
+		}
+	}
+	getMetrics( metrics, result );
+
+	if ( termination != NULL ) {
+		destroyTermination( termination );
+	}
+	destroyMetrics( metrics );
+	if ( template == NULL ) {
+		destroyCreature( creature );
+		destroyEnvironment( env );
+	}
+}
+
+void releaseEvaluationTemplates( void ) {
+	pthread_once( &templatesKeyCreated, createTemplatesKey );
+
+	templates_t *templates = pthread_getspecific( templatesKey );
+	if ( templates != NULL ) {
+		destroyTemplates( templates );
+		pthread_setspecific( templatesKey, NULL );
+	}
+}
+
+uint64_t getEvaluationKey( json_t *genome, evaluationSettings_t *settings ) {
+	// the limbs as read by createCreature
+	int numLimbs = getGenomeLimbs( genome, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( genome, parameters, parents, numLimbs );
+
+	return getLimbsEvaluationKey( parameters, parents, numLimbs, settings );
+}
+
+uint64_t getLimbsEvaluationKey( parameters_t *parameters, int *parents, int numLimbs, evaluationSettings_t *settings ) {
+	uint64_t key = FNV_OFFSET;
+
+	// numbers as %.17g (which round-trips)
+	for ( int i = 0; i < numLimbs; ++i ) {
+		parameters_t *limb = &parameters[i];
+		key = hashText( key, "%d %d %.17g %.17g %.17g %.17g %.17g;",
+			parents[i], limb->numConnections,
+			limb->angle, limb->length, limb->frequency, limb->amplitude, limb->phase
+		);
+	}
+
+	terminationRules_t *rules = &settings->rules;
+	key = hashText( key, "|%d %.17g %d %d %.17g %d %d %d",
+		settings->updates, settings->timestep, settings->substeps, settings->maxSubsteps,
+		settings->tolerance, settings->articulated, settings->graphColoring, settings->terminate
+	);
+	if ( settings->terminate ) {
+		key = hashText( key, " %.17g %.17g %.17g %.17g %.17g",
+			rules->progressWindow, rules->minProgress, rules->invertedTime, rules->maxSpeed, rules->maxDepth
+		);
+		// "moved": progress counts movement both ways (net progress was the only rule before, so it has no marker)
+		if ( !rules->netProgress ) {
+			key = hashText( key, " moved" );
+		}
+	}
+	// only when set, so cache files from before it was a setting still match
+	if ( settings->iterations > 0 ) {
+		key = hashText( key, " iterations%d", settings->iterations );
+	}
+	key = hashText( key, " cpFloat%d", (int)sizeof( cpFloat ) );
+
+	return key;
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+// this thread's creature with the limbs' tree in an environment with the settings, reset and
+// turned into the limbs, or else a new one (in place of the one used longest ago if there's no room)
+static template_t *getTemplate( parameters_t *parameters, int numLimbs, evaluationSettings_t *settings ) {
+	pthread_once( &templatesKeyCreated, createTemplatesKey );
+
+	templates_t *templates = pthread_getspecific( templatesKey );
+	if ( templates == NULL ) {
+		templates = malloc( sizeof( templates_t ) );
+		assert( templates != NULL );
+		templates->numTemplates = 0;
+		templates->uses = 0;
+		pthread_setspecific( templatesKey, templates );
+	}
+	templates->uses++;
+
+	for ( int i = 0; i < templates->numTemplates; ++i ) {
+		template_t *template = &templates->templates[i];
+		if ( sameEnvironmentSettings( &template->settings, settings )
+			&& sameCreatureTopology( template->creature, parameters, numLimbs ) ) {
+			resetEnvironment( template->env );
+			setCreatureParameters( template->creature, parameters, numLimbs );
+			template->lastUsed = templates->uses;
+			return template;
+		}
+	}
+
+	template_t *template;
+	if ( templates->numTemplates < NUM_TEMPLATES ) {
+		template = &templates->templates[templates->numTemplates++];
+	} else {
+		template = &templates->templates[0];
+		for ( int i = 1; i < NUM_TEMPLATES; ++i ) {
+			if ( templates->templates[i].lastUsed < template->lastUsed ) {
+				template = &templates->templates[i];
+			}
+		}
+		destroyCreature( template->creature );
+		destroyEnvironment( template->env );
+	}
+
+	template->env = createSettingsEnvironment( settings );
+	template->creature = createCreatureFromLimbs( parameters, numLimbs, getEnvironmentSpace( template->env ) );
+	template->settings = *settings;
+	template->lastUsed = templates->uses;
+	return template;
+}
+
+static Environment createSettingsEnvironment( evaluationSettings_t *settings ) {
+	Environment env = createEnvironment( 800, 600 );
+	setEnvironmentGraphColoring( env, settings->graphColoring );
+	if ( settings->iterations > 0 ) {
+		setEnvironmentIterations( env, settings->iterations );
+	}
+	setEnvironmentIterationTolerance( env, settings->tolerance, 2 );
+	if ( settings->timestep > 0.0 ) {
+		setEnvironmentTimestep( env, settings->timestep );
+	}
+	setEnvironmentSubsteps( env, settings->substeps );
+	setEnvironmentAdaptiveSubsteps( env, settings->maxSubsteps );
+
+	return env;
+}
+
+// true if environments created with either settings are set up the same
+static int sameEnvironmentSettings( evaluationSettings_t *a, evaluationSettings_t *b ) {
+	return a->timestep == b->timestep && a->substeps == b->substeps && a->maxSubsteps == b->maxSubsteps
+		&& a->iterations == b->iterations && a->tolerance == b->tolerance && a->graphColoring == b->graphColoring;
+}
+
+// a thread's templates are destroyed when it exits
+static void createTemplatesKey( void ) {
+	int created = pthread_key_create( &templatesKey, destroyTemplates );
+	assert( created == 0 );
+	(void)created;
+}
+
+static void destroyTemplates( void *templates ) {
+	templates_t *kept = templates;
+	for ( int i = 0; i < kept->numTemplates; ++i ) {
+		destroyCreature( kept->templates[i].creature );
+		destroyEnvironment( kept->templates[i].env );
+	}
+	free( kept );
+}
+
+// continues an FNV-1a hash over some formatted text
+static uint64_t hashText( uint64_t key, const char *format, ... ) {
+	char text[256];
+
+	va_list args;
+	va_start( args, format );
+	int length = vsnprintf( text, sizeof( text ), format, args );
+	va_end( args );
+	assert( length >= 0 && length < sizeof( text ) );
+
+	for ( int i = 0; i < length; ++i ) {
+		key = ( key ^ (unsigned char)text[i] ) * FNV_PRIME;
+	}
+	return key;
+}
@@ -0,0 +1,77 @@
+/*
+ * Evaluation:
+ *  Simulates a genome alone in an environment for a fixed number of
+ *  updates and measures it (see metrics.h), with every setting that
+ *  changes the result in one place, so results can be cached by genome
+ *  and settings (see fitnessCache.h).
+ */
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <stdint.h>
+#include <jansson.h>
+#include "metrics.h"
+#include "termination.h"
+
+/*
+ * How a genome is simulated, as the runtime flags in readme.txt:
+ *  - updates: number of updates of the environment (-i)
+ *  - timestep, substeps, maxSubsteps: time per update and its physics steps
+ *    (-d, -u and -v, timestep 0 for the environment's default)
+ *  - iterations: solver passes per physics step (0 for the environment's
+ *    default, no flag: see screening.h)
+ *  - tolerance: solver iteration tolerance (-e, 0 for off)
+ *  - articulated: simulate in joint coordinates (-a)
+ *  - graphColoring: use the graph coloring solver (-c)
+ *  - terminate, rules: stop early by these rules (-x)
+ */
+typedef struct {
+	int updates;
+	double timestep;
+	int substeps;
+	int maxSubsteps;
+	int iterations;
+	double tolerance;
+	int articulated;
+	int graphColoring;
+	int terminate;
+	terminationRules_t rules;
+} evaluationSettings_t;
+
+/*
+ * The simulator's defaults, for 'updates' updates
+ */
+evaluationSettings_t defaultEvaluationSettings( int updates );
+
+/*
+ * Simulates a genome with the settings, and measures it into 'result'
+ */
+void evaluateGenome( json_t *genome, evaluationSettings_t *settings, metrics_t *result );
+
+/*
+ * The same from a genome's limbs, in the order of getGenomeLimbs
+ * (the same limbs give the same result as evaluateGenome).
+ * Each thread keeps the environments and creatures of the last few trees
+ * of limbs and settings it simulated, and reuses them for genomes with
+ * the same (see setCreatureParameters), giving the same results as new
+ * ones would. They are removed when the thread exits, or by
+ * releaseEvaluationTemplates for the calling thread.
+ */
+void evaluateLimbs( parameters_t *parameters, int numLimbs, evaluationSettings_t *settings, metrics_t *result );
+void releaseEvaluationTemplates( void );
+
+/*
+ * A 64-bit hash identifying an evaluation: the genome's limbs (their
+ * parameters and connections, depth-first, with the numbers normalised so
+ * the way they are written in the JSON doesn't matter), every setting,
+ * and the precision of the physics build. Equal keys give equal results.
+ */
+uint64_t getEvaluationKey( json_t *genome, evaluationSettings_t *settings );
+
+/*
+ * The same from a genome's limbs and their parents, in the order of
+ * getGenomeLimbs (the same limbs give the same key as getEvaluationKey)
+ */
+uint64_t getLimbsEvaluationKey( parameters_t *parameters, int *parents, int numLimbs, evaluationSettings_t *settings );
+
+#endif
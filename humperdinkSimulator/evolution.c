@@ -0,0 +1,706 @@
+#include "evolution.h"
+#include "finite.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <ctype.h>
+#include <errno.h>
+#include <assert.h>
+
+// the range of each parameter, for random limbs and the size of mutations
+#define MIN_ANGLE -M_PI
+#define MAX_ANGLE M_PI
+#define MIN_LENGTH 5.0
+#define MAX_LENGTH 60.0
+#define MIN_FREQUENCY 0.0
+#define MAX_FREQUENCY 10.0
+#define MIN_AMPLITUDE 0.0
+#define MAX_AMPLITUDE M_PI
+#define MIN_PHASE 0.0
+#define MAX_PHASE ( 2.0*M_PI )
+
+struct evolution {
+	evolutionSettings_t settings;
+	evaluationSettings_t evaluation;
+
+	// the current generation, and room for the next one
+	evolutionMember_t *members;
+	evolutionMember_t *offspring;
+
+	// evaluates the generations
+	Screening screening;
+
+	int generation;
+	long evaluations;
+	unsigned int seed;
+};
+
+/*
+ * Private helper function prototypes
+ */
+static int compareFitness( const void *a, const void *b );
+static double getFitness( evolutionMember_t *member );
+static evolutionMember_t *selectParent( Evolution evolution );
+static int mutateGenome( Evolution evolution, genome_t *genome );
+static int mutateParameter( Evolution evolution, double *value, double min, double max, int wraps );
+static void randomizeLimb( parameters_t *limb, unsigned int *seed );
+static void growLimb( genome_t *genome, int parent, unsigned int *seed );
+static void pruneLimb( genome_t *genome, int index );
+static Evolution newEvolution( evolutionSettings_t *settings, evaluationSettings_t *evaluation );
+static void reserveLimbs( genome_t *genome, int numLimbs );
+static void writeLimbs( json_writer_t *writer, genome_t *genome, int *index, evolutionMember_t *member, Evolution run );
+static void writeMeasure( json_writer_t *writer, double value );
+static int readMetrics( json_t *array, metrics_t *metrics );
+static json_t *loadFirstLine( FILE *input );
+static int isBlank( const char *line );
+static int chance( unsigned int *seed, double probability );
+static double randomRange( unsigned int *seed, double min, double max );
+static double randomNormal( unsigned int *seed );
+
+
+evolutionSettings_t defaultEvolutionSettings( void ) {
+	evolutionSettings_t settings;
+
+	settings.populationSize = 100;
+	settings.generations = 50;
+	settings.elites = 4;
+	settings.tournament = 3;
+	settings.mutationRate = 0.1;
+	settings.mutationScale = 0.1;
+	settings.growChance = 0.05;
+	settings.pruneChance = 0.05;
+	settings.minLimbs = 2;
+	settings.maxLimbs = 16;
+	settings.randomLimbs = 6;
+	settings.seed = 1;
+	settings.threads = 1;
+
+	return settings;
+}
+
+int parseEvolutionSettings( const char *list, evolutionSettings_t *settings ) {
+	const char *c = list;
+
+	while ( *c != '\0' ) {
+		char name[16];
+		double value;
+		int length;
+
+		if ( sscanf( c, "%15[a-z]=%lf%n", name, &value, &length ) != 2 || value < 0.0 ) {
+			return 0;
+		}
+
+		if ( strcmp( name, "size" ) == 0 && value >= 1.0 ) {
+			settings->populationSize = (int)value;
+		} else if ( strcmp( name, "generations" ) == 0 ) {
+			settings->generations = (int)value;
+		} else if ( strcmp( name, "elites" ) == 0 ) {
+			settings->elites = (int)value;
+		} else if ( strcmp( name, "tournament" ) == 0 && value >= 1.0 ) {
+			settings->tournament = (int)value;
+		} else if ( strcmp( name, "rate" ) == 0 && value <= 1.0 ) {
+			settings->mutationRate = value;
+		} else if ( strcmp( name, "scale" ) == 0 ) {
+			settings->mutationScale = value;
+		} else if ( strcmp( name, "grow" ) == 0 && value <= 1.0 ) {
+			settings->growChance = value;
+		} else if ( strcmp( name, "prune" ) == 0 && value <= 1.0 ) {
+			settings->pruneChance = value;
+		} else if ( strcmp( name, "min" ) == 0 && value >= 1.0 ) {
+			settings->minLimbs = (int)value;
+		} else if ( strcmp( name, "max" ) == 0 && value >= 1.0 ) {
+			settings->maxLimbs = (int)value;
+		} else if ( strcmp( name, "limbs" ) == 0 && value >= 1.0 ) {
+			settings->randomLimbs = (int)value;
+		} else if ( strcmp( name, "seed" ) == 0 ) {
+			settings->seed = (unsigned int)value;
+		} else {
+			return 0;
+		}
+
+		c += length;
+		if ( *c == ',' ) {
+			c++;
+		} else if ( *c != '\0' ) {
+			return 0;
+		}
+	}
+
+	return settings->minLimbs <= settings->maxLimbs;
+}
+
+Evolution createEvolution( evolutionSettings_t *settings, evaluationSettings_t *evaluation, genome_t *seeds, int numSeeds ) {
+	Evolution evolution = newEvolution( settings, evaluation );
+
+	for ( int i = 0; i < settings->populationSize; ++i ) {
+		evolutionMember_t *member = &evolution->members[i];
+
+		if ( numSeeds > 0 ) {
+			// the seeds, then mutations of them
+			copyGenome( &member->genome, &seeds[i % numSeeds] );
+			if ( i >= numSeeds ) {
+				mutateGenome( evolution, &member->genome );
+			}
+		} else {
+			// a random root, grown a limb at a time
+			reserveLimbs( &member->genome, 1 );
+			randomizeLimb( &member->genome.parameters[0], &evolution->seed );
+			member->genome.parameters[0].numConnections = 0;
+			member->genome.parents[0] = -1;
+			member->genome.numLimbs = 1;
+			while ( member->genome.numLimbs < settings->randomLimbs ) {
+				int parent = rand_r( &evolution->seed ) % member->genome.numLimbs;
+				growLimb( &member->genome, parent, &evolution->seed );
+			}
+		}
+	}
+
+	return evolution;
+}
+
+Evolution loadEvolutionCheckpoint( evolutionSettings_t *settings, evaluationSettings_t *evaluation, const char *path, json_error_t *error ) {
+	FILE *input = fopen( path, "r" );
+	if ( input == NULL ) {
+		error->line = -1;
+		snprintf( error->text, JSON_ERROR_TEXT_LENGTH, "unable to open %s: %s", path, strerror( errno ) );
+		return NULL;
+	}
+
+	Evolution evolution = newEvolution( settings, evaluation );
+	int size = settings->populationSize;
+	int count = 0;
+	int loaded = 1;
+
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t length;
+	int lineNumber = 0;
+	while ( loaded && ( length = getline( &line, &capacity, input ) ) >= 0 ) {
+		lineNumber++;
+		if ( isBlank( line ) ) {
+			continue;
+		}
+
+		if ( count == size ) {
+			error->line = lineNumber;
+			snprintf( error->text, JSON_ERROR_TEXT_LENGTH, "more than the %d genomes of a generation", size );
+			loaded = 0;
+			break;
+		}
+
+		// the limbs as any genome's, then the results and the run's state alongside the root's parameters
+		evolutionMember_t *member = &evolution->members[count];
+		json_t *root = NULL;
+		if ( !loadGenomeText( line, length, &member->genome, error ) || ( root = json_loads( line, error ) ) == NULL ) {
+			error->line = lineNumber;
+			loaded = 0;
+			break;
+		}
+
+		member->evaluated = readMetrics( json_object_get( root, "metrics" ), &member->metrics );
+		member->screened = 0;
+
+		if ( count == 0 ) {
+			json_t *run = json_object_get( root, "evolution" );
+			json_t *generation = json_object_get( run, "generation" );
+			json_t *evaluations = json_object_get( run, "evaluations" );
+			json_t *random = json_object_get( run, "random" );
+			if ( !json_is_integer( generation ) || !json_is_number( evaluations ) || !json_is_number( random ) ) {
+				error->line = lineNumber;
+				snprintf( error->text, JSON_ERROR_TEXT_LENGTH, "not a checkpoint: no \"evolution\" state" );
+				loaded = 0;
+			} else {
+				evolution->generation = json_integer_value( generation );
+				evolution->evaluations = (long)json_number_value( evaluations );
+				evolution->seed = (unsigned int)json_number_value( random );
+			}
+		}
+
+		json_decref( root );
+		count++;
+	}
+	free( line );
+	fclose( input );
+
+	if ( loaded && count < size ) {
+		error->line = -1;
+		snprintf( error->text, JSON_ERROR_TEXT_LENGTH, "%d genomes, not the %d of a generation", count, size );
+		loaded = 0;
+	}
+
+	if ( !loaded ) {
+		destroyEvolution( evolution );
+		return NULL;
+	}
+	return evolution;
+}
+
+int isEvolutionCheckpoint( const char *path ) {
+	FILE *input = fopen( path, "r" );
+	if ( input == NULL ) {
+		return 0;
+	}
+
+	json_t *root = loadFirstLine( input );
+	fclose( input );
+
+	int checkpoint = json_is_object( json_object_get( root, "evolution" ) );
+	if ( root != NULL ) {
+		json_decref( root );
+	}
+	return checkpoint;
+}
+
+void destroyEvolution( Evolution evolution ) {
+	for ( int i = 0; i < evolution->settings.populationSize; ++i ) {
+		freeGenome( &evolution->members[i].genome );
+		freeGenome( &evolution->offspring[i].genome );
+	}
+	free( evolution->members );
+	free( evolution->offspring );
+	destroyScreening( evolution->screening );
+	free( evolution );
+}
+
+void evaluateGeneration( Evolution evolution ) {
+	int size = evolution->settings.populationSize;
+
+	// the members without results
+	genome_t *genomes[size];
+	int indices[size];
+	int count = 0;
+	for ( int i = 0; i < size; ++i ) {
+		if ( !evolution->members[i].evaluated ) {
+			genomes[count] = &evolution->members[i].genome;
+			indices[count] = i;
+			count++;
+		}
+	}
+
+	metrics_t results[count > 0 ? count : 1];
+	int tiers[count > 0 ? count : 1];
+	screenGenomes( evolution->screening, genomes, count, results, tiers );
+
+	int full = getScreeningTiers( evolution->screening ) - 1;
+	for ( int i = 0; i < count; ++i ) {
+		evolutionMember_t *member = &evolution->members[indices[i]];
+		member->metrics = results[i];
+		member->evaluated = 1;
+		member->screened = ( tiers[i] < full );
+	}
+	evolution->evaluations += count;
+
+	qsort( evolution->members, size, sizeof( evolutionMember_t ), compareFitness );
+}
+
+void nextGeneration( Evolution evolution ) {
+	int size = evolution->settings.populationSize;
+
+	for ( int i = 0; i < size; ++i ) {
+		evolutionMember_t *child = &evolution->offspring[i];
+		evolutionMember_t *parent;
+
+		// results from screening alone aren't kept: the genome is screened again
+		if ( i < evolution->settings.elites ) {
+			parent = &evolution->members[i];
+			copyGenome( &child->genome, &parent->genome );
+			child->evaluated = parent->evaluated && !parent->screened;
+		} else {
+			parent = selectParent( evolution );
+			copyGenome( &child->genome, &parent->genome );
+			// an unchanged copy keeps its parent's results
+			int changed = mutateGenome( evolution, &child->genome );
+			child->evaluated = parent->evaluated && !parent->screened && !changed;
+		}
+		child->metrics = parent->metrics;
+		child->screened = 0;
+	}
+
+	evolutionMember_t *members = evolution->members;
+	evolution->members = evolution->offspring;
+	evolution->offspring = members;
+	evolution->generation++;
+}
+
+int getEvolutionGeneration( Evolution evolution ) {
+	return evolution->generation;
+}
+
+int getEvolutionSize( Evolution evolution ) {
+	return evolution->settings.populationSize;
+}
+
+evolutionMember_t *getEvolutionMember( Evolution evolution, int index ) {
+	assert( index >= 0 && index < evolution->settings.populationSize );
+	return &evolution->members[index];
+}
+
+long getEvolutionEvaluations( Evolution evolution ) {
+	return evolution->evaluations;
+}
+
+Screening getEvolutionScreening( Evolution evolution ) {
+	return evolution->screening;
+}
+
+int writeEvolution( Evolution evolution, FILE *output ) {
+	json_writer_t *writer = json_writer_new( output, JSON_COMPACT );
+	if ( writer == NULL ) {
+		return 0;
+	}
+
+	int written = 1;
+	for ( int i = 0; i < evolution->settings.populationSize && written; ++i ) {
+		evolutionMember_t *member = &evolution->members[i];
+		int index = 0;
+
+		json_writer_reset( writer, output, JSON_COMPACT );
+		writeLimbs( writer, &member->genome, &index, member, ( i == 0 ) ? evolution : NULL );
+		written = ( json_writer_flush( writer ) == 0 && fputc( '\n', output ) != EOF );
+	}
+
+	json_writer_free( writer );
+	return written;
+}
+
+int writeEvolutionCheckpoint( Evolution evolution, const char *path ) {
+	char temporary[strlen( path ) + 5];
+	snprintf( temporary, sizeof( temporary ), "%s.tmp", path );
+
+	FILE *output = fopen( temporary, "w" );
+	if ( output == NULL ) {
+		return 0;
+	}
+
+	int written = writeEvolution( evolution, output );
+	written = ( fclose( output ) == 0 ) && written;
+	if ( !written || rename( temporary, path ) != 0 ) {
+		remove( temporary );
+		return 0;
+	}
+
+	return 1;
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+// fittest first, with the members that were only screened after the rest
+static int compareFitness( const void *a, const void *b ) {
+	evolutionMember_t *x = (evolutionMember_t *)a;
+	evolutionMember_t *y = (evolutionMember_t *)b;
+	if ( x->screened != y->screened ) {
+		return x->screened - y->screened;
+	}
+	return ( getFitness( x ) < getFitness( y ) ) - ( getFitness( x ) > getFitness( y ) );
+}
+
+// the distance, with creatures that blew up (NaN) last
+static double getFitness( evolutionMember_t *member ) {
+	double distance = member->metrics.distance;
+	return isFiniteValue( distance ) ? distance : -DBL_MAX;
+}
+
+// the fittest of a tournament: members are ranked, so the lowest index wins
+static evolutionMember_t *selectParent( Evolution evolution ) {
+	int winner = evolution->settings.populationSize;
+	for ( int i = 0; i < evolution->settings.tournament; ++i ) {
+		int entrant = rand_r( &evolution->seed ) % evolution->settings.populationSize;
+		if ( entrant < winner ) {
+			winner = entrant;
+		}
+	}
+	return &evolution->members[winner];
+}
+
+// true if anything changed
+static int mutateGenome( Evolution evolution, genome_t *genome ) {
+	evolutionSettings_t *settings = &evolution->settings;
+	unsigned int *seed = &evolution->seed;
+	int changed = 0;
+
+	for ( int i = 0; i < genome->numLimbs; ++i ) {
+		parameters_t *limb = &genome->parameters[i];
+		changed |= mutateParameter( evolution, &limb->angle, MIN_ANGLE, MAX_ANGLE, 1 );
+		changed |= mutateParameter( evolution, &limb->length, MIN_LENGTH, MAX_LENGTH, 0 );
+		changed |= mutateParameter( evolution, &limb->frequency, MIN_FREQUENCY, MAX_FREQUENCY, 0 );
+		changed |= mutateParameter( evolution, &limb->amplitude, MIN_AMPLITUDE, MAX_AMPLITUDE, 0 );
+		changed |= mutateParameter( evolution, &limb->phase, MIN_PHASE, MAX_PHASE, 1 );
+	}
+
+	if ( chance( seed, settings->growChance ) && genome->numLimbs < settings->maxLimbs ) {
+		growLimb( genome, rand_r( seed ) % genome->numLimbs, seed );
+		changed = 1;
+	}
+
+	if ( chance( seed, settings->pruneChance ) && genome->numLimbs > settings->minLimbs ) {
+		// the n'th leaf, not counting the root
+		int leaves = 0;
+		for ( int i = 1; i < genome->numLimbs; ++i ) {
+			leaves += ( genome->parameters[i].numConnections == 0 );
+		}
+		if ( leaves > 0 ) {
+			int leaf = rand_r( seed ) % leaves;
+			for ( int i = 1; i < genome->numLimbs; ++i ) {
+				if ( genome->parameters[i].numConnections == 0 && leaf-- == 0 ) {
+					pruneLimb( genome, i );
+					changed = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	return changed;
+}
+
+static int mutateParameter( Evolution evolution, double *value, double min, double max, int wraps ) {
+	if ( !chance( &evolution->seed, evolution->settings.mutationRate ) ) {
+		return 0;
+	}
+
+	double range = max - min;
+	double mutated = *value + randomNormal( &evolution->seed ) * evolution->settings.mutationScale * range;
+
+	if ( wraps ) {
+		mutated = min + fmod( mutated - min, range );
+		if ( mutated < min ) {
+			mutated += range;
+		}
+	} else if ( mutated < min ) {
+		mutated = min;
+	} else if ( mutated > max ) {
+		mutated = max;
+	}
+
+	int changed = ( mutated != *value );
+	*value = mutated;
+	return changed;
+}
+
+static void randomizeLimb( parameters_t *limb, unsigned int *seed ) {
+	limb->angle = randomRange( seed, MIN_ANGLE, MAX_ANGLE );
+	limb->length = randomRange( seed, MIN_LENGTH, MAX_LENGTH );
+	limb->frequency = randomRange( seed, MIN_FREQUENCY, MAX_FREQUENCY );
+	limb->amplitude = randomRange( seed, MIN_AMPLITUDE, MAX_AMPLITUDE );
+	limb->phase = randomRange( seed, MIN_PHASE, MAX_PHASE );
+}
+
+// adds a random leaf as the last child of 'parent', keeping the limbs depth-first
+static void growLimb( genome_t *genome, int parent, unsigned int *seed ) {
+	// the parent's subtree ends at the first limb after it whose parent comes before it
+	int index = parent + 1;
+	while ( index < genome->numLimbs && genome->parents[index] >= parent ) {
+		index++;
+	}
+
+	reserveLimbs( genome, genome->numLimbs + 1 );
+	int moved = genome->numLimbs - index;
+	memmove( &genome->parameters[index + 1], &genome->parameters[index], sizeof( parameters_t ) * moved );
+	memmove( &genome->parents[index + 1], &genome->parents[index], sizeof( int ) * moved );
+	genome->numLimbs++;
+
+	for ( int i = index + 1; i < genome->numLimbs; ++i ) {
+		if ( genome->parents[i] >= index ) {
+			genome->parents[i]++;
+		}
+	}
+
+	randomizeLimb( &genome->parameters[index], seed );
+	genome->parameters[index].numConnections = 0;
+	genome->parents[index] = parent;
+	genome->parameters[parent].numConnections++;
+}
+
+// removes a leaf limb
+static void pruneLimb( genome_t *genome, int index ) {
+	assert( index > 0 && genome->parameters[index].numConnections == 0 );
+	genome->parameters[genome->parents[index]].numConnections--;
+
+	int moved = genome->numLimbs - index - 1;
+	memmove( &genome->parameters[index], &genome->parameters[index + 1], sizeof( parameters_t ) * moved );
+	memmove( &genome->parents[index], &genome->parents[index + 1], sizeof( int ) * moved );
+	genome->numLimbs--;
+
+	for ( int i = index; i < genome->numLimbs; ++i ) {
+		if ( genome->parents[i] > index ) {
+			genome->parents[i]--;
+		}
+	}
+}
+
+// the run's settings and screening, with members that have no genomes yet
+static Evolution newEvolution( evolutionSettings_t *settings, evaluationSettings_t *evaluation ) {
+	Evolution evolution = malloc( sizeof( struct evolution ) );
+	assert( evolution != NULL );
+
+	evolution->settings = *settings;
+	evolution->evaluation = *evaluation;
+	evolution->generation = 0;
+	evolution->evaluations = 0;
+	evolution->seed = settings->seed;
+	evolution->screening = createScreening( evaluation, settings->threads );
+
+	int size = settings->populationSize;
+	if ( evolution->settings.elites > size ) {
+		evolution->settings.elites = size;
+	}
+
+	evolution->members = malloc( sizeof( evolutionMember_t ) * size );
+	evolution->offspring = malloc( sizeof( evolutionMember_t ) * size );
+	assert( evolution->members != NULL && evolution->offspring != NULL );
+
+	for ( int i = 0; i < size; ++i ) {
+		initGenome( &evolution->members[i].genome );
+		initGenome( &evolution->offspring[i].genome );
+		evolution->members[i].evaluated = 0;
+		evolution->members[i].screened = 0;
+	}
+
+	return evolution;
+}
+
+static void reserveLimbs( genome_t *genome, int numLimbs ) {
+	if ( genome->capacity < numLimbs ) {
+		genome->capacity = ( numLimbs < 16 ) ? 16 : numLimbs * 2;
+		genome->parameters = realloc( genome->parameters, sizeof( parameters_t ) * genome->capacity );
+		assert( genome->parameters != NULL );
+		genome->parents = realloc( genome->parents, sizeof( int ) * genome->capacity );
+		assert( genome->parents != NULL );
+	}
+}
+
+// a limb and its connections, in the .hdk schema (with the member's results on the root,
+// and the run's state on the first member's)
+static void writeLimbs( json_writer_t *writer, genome_t *genome, int *index, evolutionMember_t *member, Evolution run ) {
+	parameters_t *limb = &genome->parameters[( *index )++];
+
+	json_write_begin_object( writer );
+	json_write_key( writer, "angle" );
+	json_write_real( writer, limb->angle );
+	json_write_key( writer, "length" );
+	json_write_real( writer, limb->length );
+	json_write_key( writer, "frequency" );
+	json_write_real( writer, limb->frequency );
+	json_write_key( writer, "amplitude" );
+	json_write_real( writer, limb->amplitude );
+	json_write_key( writer, "phase" );
+	json_write_real( writer, limb->phase );
+
+	if ( member != NULL ) {
+		json_write_key( writer, "fitness" );
+		if ( member->evaluated && !member->screened && isFiniteValue( member->metrics.distance ) ) {
+			json_write_real( writer, member->metrics.distance );
+		} else {
+			json_write_null( writer );
+		}
+
+		// screened results aren't kept (see nextGeneration)
+		if ( member->evaluated && !member->screened ) {
+			metrics_t *metrics = &member->metrics;
+			json_write_key( writer, "metrics" );
+			json_write_begin_array( writer );
+			writeMeasure( writer, metrics->seconds );
+			writeMeasure( writer, metrics->distance );
+			writeMeasure( writer, metrics->averageSpeed );
+			writeMeasure( writer, metrics->maxDisplacement );
+			writeMeasure( writer, metrics->straightness );
+			writeMeasure( writer, metrics->airborneTime );
+			writeMeasure( writer, metrics->energy );
+			json_write_end_array( writer );
+		}
+	}
+
+	if ( run != NULL ) {
+		// reals, which hold any evaluation count or random state exactly
+		json_write_key( writer, "evolution" );
+		json_write_begin_object( writer );
+		json_write_key( writer, "generation" );
+		json_write_integer( writer, run->generation );
+		json_write_key( writer, "evaluations" );
+		json_write_real( writer, run->evaluations );
+		json_write_key( writer, "random" );
+		json_write_real( writer, run->seed );
+		json_write_end_object( writer );
+	}
+
+	json_write_key( writer, "connections" );
+	json_write_begin_array( writer );
+	for ( int i = 0; i < limb->numConnections; ++i ) {
+		writeLimbs( writer, genome, index, NULL, NULL );
+	}
+	json_write_end_array( writer );
+	json_write_end_object( writer );
+}
+
+// a measure, null if it isn't a number
+static void writeMeasure( json_writer_t *writer, double value ) {
+	if ( isFiniteValue( value ) ) {
+		json_write_real( writer, value );
+	} else {
+		json_write_null( writer );
+	}
+}
+
+// the measures writeLimbs wrote (nulls back to NaNs), returns 0 if there aren't any
+static int readMetrics( json_t *array, metrics_t *metrics ) {
+	double *measures[] = {
+		&metrics->seconds, &metrics->distance, &metrics->averageSpeed, &metrics->maxDisplacement,
+		&metrics->straightness, &metrics->airborneTime, &metrics->energy
+	};
+	int numMeasures = sizeof( measures ) / sizeof( measures[0] );
+
+	if ( !json_is_array( array ) || json_array_size( array ) != numMeasures ) {
+		return 0;
+	}
+	for ( int i = 0; i < numMeasures; ++i ) {
+		json_t *value = json_array_get( array, i );
+		*measures[i] = json_is_number( value ) ? json_number_value( value ) : NAN;
+	}
+	return 1;
+}
+
+// the first line that isn't blank, parsed (NULL at the end of the file or if it doesn't parse)
+static json_t *loadFirstLine( FILE *input ) {
+	char *text = NULL;
+	size_t capacity = 0;
+	json_t *root = NULL;
+	json_error_t error;
+
+	while ( getline( &text, &capacity, input ) >= 0 ) {
+		if ( !isBlank( text ) ) {
+			root = json_loads( text, &error );
+			break;
+		}
+	}
+
+	free( text );
+	return root;
+}
+
+static int isBlank( const char *line ) {
+	while ( isspace( (unsigned char)*line ) ) {
+		line++;
+	}
+	return *line == '\0';
+}
+
+static int chance( unsigned int *seed, double probability ) {
+	return rand_r( seed ) < probability * RAND_MAX;
+}
+
+static double randomRange( unsigned int *seed, double min, double max ) {
+	return min + ( max - min ) * ( rand_r( seed ) / (double)RAND_MAX );
+}
+
+// standard normal (Box-Muller)
+static double randomNormal( unsigned int *seed ) {
+	double u = ( rand_r( seed ) + 1.0 ) / ( RAND_MAX + 2.0 );
+	double v = rand_r( seed ) / ( RAND_MAX + 1.0 );
+	return sqrt( -2.0 * log( u ) ) * cos( 2.0 * M_PI * v );
+}
@@ -0,0 +1,153 @@
+/*
+ * Evolution ADT:
+ *  A generational genetic algorithm run entirely in-process: a population
+ *  of genomes (as genomeLoader.h's limbs, never JSON) is evaluated (see
+ *  evaluation.h) on several threads, ranked by the distance each creature
+ *  moved, and replaced by the next generation:
+ *  - the fittest 'elites' survive unchanged, keeping their results
+ *  - the rest are offspring of tournament winners (the fittest of
+ *    'tournament' members picked at random), mutated:
+ *     - each limb's angle, length, frequency, amplitude and phase, each
+ *       with chance 'mutationRate', by a normally distributed change of
+ *       'mutationScale' times the parameter's range (angles and phases
+ *       wrap around, the rest are clamped to their ranges)
+ *     - with chance 'growChance', a new random limb on a random limb
+ *     - with chance 'pruneChance', a random leaf limb (not the root) removed
+ *    keeping between minLimbs and maxLimbs limbs. An offspring that came
+ *    out the same as its parent keeps its parent's results.
+ *
+ * Generations are evaluated by a screening (see screening.h), which
+ * simulates every genome in full unless cheap tiers are added to it
+ * (getEvolutionScreening). Members that were only screened rank after the
+ * rest, and are screened again if they make it into the next generation.
+ * With a fitness cache on the screening (setScreeningCache), genomes it
+ * already has results for aren't simulated again.
+ *
+ * Evaluation is deterministic and all the random choices are made on one
+ * thread from 'seed', so a run gives the same generations with any number
+ * of threads.
+ */
+#ifndef EVOLUTION_H
+#define EVOLUTION_H
+
+#include <stdio.h>
+#include "evaluation.h"
+#include "genomeLoader.h"
+#include "screening.h"
+
+typedef struct evolution *Evolution;
+
+/*
+ * generations is how many a run goes on for (createEvolution's caller
+ * runs the generations, see main.c's -p)
+ */
+typedef struct {
+	int populationSize;
+	int generations;
+	int elites;
+	int tournament;
+	double mutationRate;
+	double mutationScale;
+	double growChance;
+	double pruneChance;
+	int minLimbs;
+	int maxLimbs;
+	int randomLimbs;
+	unsigned int seed;
+	int threads;
+} evolutionSettings_t;
+
+/*
+ * A member of the population: its genome, and its results once evaluated
+ * (from a cheap tier of the screening if 'screened')
+ */
+typedef struct {
+	genome_t genome;
+	int evaluated;
+	int screened;
+	metrics_t metrics;
+} evolutionMember_t;
+
+/*
+ * Settings for 50 generations of 100 with 4 elites, tournaments of 3,
+ * one parameter in ten mutated by a tenth of its range, one limb grown or
+ * pruned in every twenty offspring, 2 to 16 limbs (6 in random genomes),
+ * seed 1, and one thread (threads isn't in parseEvolutionSettings' lists:
+ * it doesn't change the results)
+ */
+evolutionSettings_t defaultEvolutionSettings( void );
+
+/*
+ * Reads settings from a list like "size=100,generations=50,elites=4,
+ * tournament=3,rate=0.1,scale=0.1,grow=0.05,prune=0.05,min=2,max=16,limbs=6,
+ * seed=1" into 'settings', leaving those not in the list as they were.
+ * Returns 0 if the list can't be read.
+ */
+int parseEvolutionSettings( const char *list, evolutionSettings_t *settings );
+
+/*
+ * Constructor: Creates the first generation: mutations of the 'numSeeds'
+ *  seed genomes (the seeds themselves first, as many as fit), or random
+ *  genomes of randomLimbs limbs if there are none. The settings are copied.
+ * Deconstructor: Removes memory allocated for the population
+ */
+Evolution createEvolution( evolutionSettings_t *settings, evaluationSettings_t *evaluation, genome_t *seeds, int numSeeds );
+void destroyEvolution( Evolution evolution );
+
+/*
+ * Evaluates the members of the current generation that don't have results
+ * yet, on the settings' threads, and ranks the generation fittest first
+ */
+void evaluateGeneration( Evolution evolution );
+
+/*
+ * Replaces the (evaluated) generation with the next one
+ */
+void nextGeneration( Evolution evolution );
+
+/*
+ * The current generation (0 for the first), its members (fittest first
+ * once evaluated), and the number of genomes evaluated so far (simulated,
+ * or found in the screening's cache)
+ */
+int getEvolutionGeneration( Evolution evolution );
+int getEvolutionSize( Evolution evolution );
+evolutionMember_t *getEvolutionMember( Evolution evolution, int index );
+long getEvolutionEvaluations( Evolution evolution );
+
+/*
+ * The screening that evaluates the generations, for adding tiers to and
+ * for its report
+ */
+Screening getEvolutionScreening( Evolution evolution );
+
+/*
+ * Writes the generation as JSON lines, one genome per line in the order
+ * of the members, each with its "fitness" (the distance, null if it
+ * wasn't a number or the genome was only screened) and, if it was
+ * simulated in full, its "metrics" (an array in the order of metrics_t,
+ * nulls for NaNs) alongside the root limb's parameters, and the first
+ * with the run's "evolution" state (its generation, evaluations and the
+ * state of its random numbers): a population file that population.h (or
+ * -f) reads back. writeEvolutionCheckpoint writes to 'path' by way of a
+ * temporary file, so an interrupted run never leaves a partial
+ * checkpoint. Return 1 on success.
+ */
+int writeEvolution( Evolution evolution, FILE *output );
+int writeEvolutionCheckpoint( Evolution evolution, const char *path );
+
+/*
+ * Constructor: Carries on the run that wrote the checkpoint at 'path',
+ *  given the same settings: the generation, its members in order with
+ *  their results, the number of evaluations and the random state are as
+ *  they were written, so nextGeneration goes on exactly as that run's
+ *  would have. Returns NULL, with the reason in 'error', if the file can't
+ *  be read, isn't a checkpoint or doesn't hold populationSize genomes.
+ *  (Removed by destroyEvolution.)
+ * isEvolutionCheckpoint is true if the first genome in the file has the
+ * run's state (so the file isn't just a population to seed a run with)
+ */
+Evolution loadEvolutionCheckpoint( evolutionSettings_t *settings, evaluationSettings_t *evaluation, const char *path, json_error_t *error );
+int isEvolutionCheckpoint( const char *path );
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * Finite values:
+ *  isfinite() by the bits. The simulator is built with -ffast-math, which
+ *  lets the compiler assume every value is finite, so isfinite() and
+ *  isnan() become constants and x != x is always false. Results of
+ *  creatures that blew up are NaN or infinite all the same, and this is
+ *  how to tell.
+ *
+ * Header only (so the benchmarks that link no objects can use it too).
+ */
+#ifndef FINITE_H
+#define FINITE_H
+
+#include <stdint.h>
+#include <string.h>
+
+static inline int isFiniteValue( double value ) {
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	return ( bits & 0x7ff0000000000000ull ) != 0x7ff0000000000000ull;
+}
+
+#endif
@@ -0,0 +1,428 @@
+#include "fitnessCache.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define FILE_HEADER "# humperdink fitness cache 1\n"
+
+#define MAX_LINE 512
+
+// no entry
+#define NONE -1
+
+/*
+ * A result in memory, in a hash chain and in the most recently used list
+ */
+typedef struct {
+	uint64_t key;
+	metrics_t result;
+
+	int next;
+	int newer, older;
+} entry_t;
+
+/*
+ * Where a result is in the file, in a hash chain
+ */
+typedef struct {
+	uint64_t key;
+	long offset;
+
+	int next;
+} fileEntry_t;
+
+struct fitnessCache {
+	// memory tier: 'capacity' entries, chained from 'buckets'
+	entry_t *entries;
+	int *buckets;
+	int numBuckets;
+	int capacity;
+	int numEntries;
+	int newest, oldest;
+
+	// file tier: the offset of every result read or written so far
+	FILE *file;
+	fileEntry_t *fileEntries;
+	int *fileBuckets;
+	int numFileBuckets;
+	int numFileEntries;
+	// everything before this has been indexed
+	long scanned;
+
+	long hits;
+	long misses;
+
+	// held by lookups and stores, so threads can share the cache
+	pthread_mutex_t lock;
+};
+
+/*
+ * Private helper function prototypes
+ */
+static int bucketOf( uint64_t key, int numBuckets );
+static int findEntry( FitnessCache cache, uint64_t key );
+static void touchEntry( FitnessCache cache, int index );
+static void unlinkEntry( FitnessCache cache, int index );
+static void insertEntry( FitnessCache cache, uint64_t key, metrics_t *result );
+static long findFileEntry( FitnessCache cache, uint64_t key );
+static void indexFileEntry( FitnessCache cache, uint64_t key, long offset );
+static void scanFile( FitnessCache cache );
+static int readRecord( const char *line, uint64_t *key, metrics_t *result );
+
+
+FitnessCache createFitnessCache( int capacity, const char *filename ) {
+	assert( capacity > 0 );
+
+	FitnessCache cache = malloc( sizeof( struct fitnessCache ) );
+	assert( cache != NULL );
+
+	cache->capacity = capacity;
+	cache->numEntries = 0;
+	cache->newest = NONE;
+	cache->oldest = NONE;
+	cache->entries = malloc( sizeof( entry_t ) * capacity );
+	assert( cache->entries != NULL );
+
+	cache->numBuckets = 1;
+	while ( cache->numBuckets < capacity ) {
+		cache->numBuckets *= 2;
+	}
+	cache->buckets = malloc( sizeof( int ) * cache->numBuckets );
+	assert( cache->buckets != NULL );
+	for ( int i = 0; i < cache->numBuckets; ++i ) {
+		cache->buckets[i] = NONE;
+	}
+
+	cache->file = NULL;
+	cache->fileEntries = NULL;
+	cache->fileBuckets = NULL;
+	cache->numFileBuckets = 0;
+	cache->numFileEntries = 0;
+	cache->scanned = 0;
+
+	cache->hits = 0;
+	cache->misses = 0;
+
+	pthread_mutex_init( &cache->lock, NULL );
+
+	if ( filename != NULL ) {
+		cache->file = fopen( filename, "a+" );
+		if ( cache->file == NULL ) {
+			destroyFitnessCache( cache );
+			return NULL;
+		}
+
+		// a new file gets the header, an old one must start with it
+		fseek( cache->file, 0, SEEK_END );
+		if ( ftell( cache->file ) == 0 ) {
+			fputs( FILE_HEADER, cache->file );
+			fflush( cache->file );
+		} else {
+			char line[MAX_LINE];
+			fseek( cache->file, 0, SEEK_SET );
+			if ( fgets( line, sizeof( line ), cache->file ) == NULL || strcmp( line, FILE_HEADER ) != 0 ) {
+				destroyFitnessCache( cache );
+				return NULL;
+			}
+		}
+		cache->scanned = strlen( FILE_HEADER );
+
+		scanFile( cache );
+	}
+
+	return cache;
+}
+
+void destroyFitnessCache( FitnessCache cache ) {
+	if ( cache->file != NULL ) {
+		fclose( cache->file );
+	}
+	free( cache->fileEntries );
+	free( cache->fileBuckets );
+	free( cache->entries );
+	free( cache->buckets );
+	pthread_mutex_destroy( &cache->lock );
+	free( cache );
+}
+
+int lookupFitnessCache( FitnessCache cache, uint64_t key, metrics_t *result ) {
+	pthread_mutex_lock( &cache->lock );
+
+	int index = findEntry( cache, key );
+	if ( index != NONE ) {
+		touchEntry( cache, index );
+		*result = cache->entries[index].result;
+		cache->hits++;
+		pthread_mutex_unlock( &cache->lock );
+		return 1;
+	}
+
+	if ( cache->file != NULL ) {
+		long offset = findFileEntry( cache, key );
+		if ( offset < 0 ) {
+			// another run may have added it since
+			scanFile( cache );
+			offset = findFileEntry( cache, key );
+		}
+
+		char line[MAX_LINE];
+		uint64_t lineKey;
+		if ( offset >= 0 && fseek( cache->file, offset, SEEK_SET ) == 0
+		  && fgets( line, sizeof( line ), cache->file ) != NULL
+		  && readRecord( line, &lineKey, result ) && lineKey == key ) {
+			insertEntry( cache, key, result );
+			cache->hits++;
+			pthread_mutex_unlock( &cache->lock );
+			return 1;
+		}
+	}
+
+	cache->misses++;
+	pthread_mutex_unlock( &cache->lock );
+	return 0;
+}
+
+void storeFitnessCache( FitnessCache cache, uint64_t key, metrics_t *result ) {
+	pthread_mutex_lock( &cache->lock );
+
+	int index = findEntry( cache, key );
+	if ( index != NONE ) {
+		cache->entries[index].result = *result;
+		touchEntry( cache, index );
+	} else {
+		insertEntry( cache, key, result );
+	}
+
+	if ( cache->file != NULL ) {
+		// pick up other runs' results first, so this one's offset is known
+		scanFile( cache );
+
+		fseek( cache->file, 0, SEEK_END );
+		fprintf( cache->file, "%016" PRIx64 " %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n", key,
+			result->seconds, result->distance, result->averageSpeed, result->maxDisplacement,
+			result->straightness, result->airborneTime, result->energy
+		);
+		fflush( cache->file );
+
+		scanFile( cache );
+	}
+
+	pthread_mutex_unlock( &cache->lock );
+}
+
+int evaluateGenomeCached( FitnessCache cache, json_t *genome, evaluationSettings_t *settings, metrics_t *result ) {
+	int numLimbs = getGenomeLimbs( genome, NULL, NULL, 0 );
+	parameters_t parameters[numLimbs];
+	int parents[numLimbs];
+	getGenomeLimbs( genome, parameters, parents, numLimbs );
+
+	return evaluateLimbsCached( cache, parameters, parents, numLimbs, settings, result );
+}
+
+int evaluateLimbsCached( FitnessCache cache, parameters_t *parameters, int *parents, int numLimbs, evaluationSettings_t *settings, metrics_t *result ) {
+	uint64_t key = getLimbsEvaluationKey( parameters, parents, numLimbs, settings );
+
+	if ( lookupFitnessCache( cache, key, result ) ) {
+		return 1;
+	}
+
+	evaluateLimbs( parameters, numLimbs, settings, result );
+	storeFitnessCache( cache, key, result );
+	return 0;
+}
+
+long getFitnessCacheHits( FitnessCache cache ) {
+	pthread_mutex_lock( &cache->lock );
+	long hits = cache->hits;
+	pthread_mutex_unlock( &cache->lock );
+	return hits;
+}
+
+long getFitnessCacheMisses( FitnessCache cache ) {
+	pthread_mutex_lock( &cache->lock );
+	long misses = cache->misses;
+	pthread_mutex_unlock( &cache->lock );
+	return misses;
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+static int bucketOf( uint64_t key, int numBuckets ) {
+	// the keys are already hashes, fold the high bits in anyway
+	return (int)( ( key ^ ( key >> 32 ) ) & (uint64_t)( numBuckets - 1 ) );
+}
+
+static int findEntry( FitnessCache cache, uint64_t key ) {
+	int index = cache->buckets[bucketOf( key, cache->numBuckets )];
+	while ( index != NONE && cache->entries[index].key != key ) {
+		index = cache->entries[index].next;
+	}
+	return index;
+}
+
+// makes an entry the most recently used
+static void touchEntry( FitnessCache cache, int index ) {
+	if ( cache->newest == index ) {
+		return;
+	}
+	unlinkEntry( cache, index );
+
+	entry_t *entry = &cache->entries[index];
+	entry->newer = NONE;
+	entry->older = cache->newest;
+	if ( cache->newest != NONE ) {
+		cache->entries[cache->newest].newer = index;
+	}
+	cache->newest = index;
+	if ( cache->oldest == NONE ) {
+		cache->oldest = index;
+	}
+}
+
+// takes an entry out of the most recently used list
+static void unlinkEntry( FitnessCache cache, int index ) {
+	entry_t *entry = &cache->entries[index];
+
+	if ( entry->newer != NONE ) {
+		cache->entries[entry->newer].older = entry->older;
+	} else if ( cache->newest == index ) {
+		cache->newest = entry->older;
+	}
+
+	if ( entry->older != NONE ) {
+		cache->entries[entry->older].newer = entry->newer;
+	} else if ( cache->oldest == index ) {
+		cache->oldest = entry->newer;
+	}
+
+	entry->newer = NONE;
+	entry->older = NONE;
+}
+
+// adds a result to memory, replacing the least recently used one when full
+static void insertEntry( FitnessCache cache, uint64_t key, metrics_t *result ) {
+	int index;
+
+	if ( cache->numEntries < cache->capacity ) {
+		index = cache->numEntries++;
+	} else {
+		index = cache->oldest;
+		unlinkEntry( cache, index );
+
+		// out of its hash chain
+		int *link = &cache->buckets[bucketOf( cache->entries[index].key, cache->numBuckets )];
+		while ( *link != index ) {
+			link = &cache->entries[*link].next;
+		}
+		*link = cache->entries[index].next;
+	}
+
+	entry_t *entry = &cache->entries[index];
+	entry->key = key;
+	entry->result = *result;
+	entry->newer = NONE;
+	entry->older = NONE;
+
+	int bucket = bucketOf( key, cache->numBuckets );
+	entry->next = cache->buckets[bucket];
+	cache->buckets[bucket] = index;
+
+	touchEntry( cache, index );
+}
+
+static long findFileEntry( FitnessCache cache, uint64_t key ) {
+	if ( cache->numFileBuckets == 0 ) {
+		return -1;
+	}
+
+	int index = cache->fileBuckets[bucketOf( key, cache->numFileBuckets )];
+	while ( index != NONE && cache->fileEntries[index].key != key ) {
+		index = cache->fileEntries[index].next;
+	}
+	return ( index == NONE ) ? -1 : cache->fileEntries[index].offset;
+}
+
+// the latest line for a key wins, so later results replace earlier ones
+static void indexFileEntry( FitnessCache cache, uint64_t key, long offset ) {
+	int index = NONE;
+	if ( cache->numFileBuckets > 0 ) {
+		index = cache->fileBuckets[bucketOf( key, cache->numFileBuckets )];
+		while ( index != NONE && cache->fileEntries[index].key != key ) {
+			index = cache->fileEntries[index].next;
+		}
+	}
+	if ( index != NONE ) {
+		cache->fileEntries[index].offset = offset;
+		return;
+	}
+
+	// grow (doubling) and rehash when every bucket is used once on average
+	if ( cache->numFileEntries == cache->numFileBuckets ) {
+		int numBuckets = ( cache->numFileBuckets == 0 ) ? 1024 : cache->numFileBuckets * 2;
+
+		cache->fileEntries = realloc( cache->fileEntries, sizeof( fileEntry_t ) * numBuckets );
+		assert( cache->fileEntries != NULL );
+		cache->fileBuckets = realloc( cache->fileBuckets, sizeof( int ) * numBuckets );
+		assert( cache->fileBuckets != NULL );
+
+		cache->numFileBuckets = numBuckets;
+		for ( int i = 0; i < numBuckets; ++i ) {
+			cache->fileBuckets[i] = NONE;
+		}
+		for ( int i = 0; i < cache->numFileEntries; ++i ) {
+			int bucket = bucketOf( cache->fileEntries[i].key, numBuckets );
+			cache->fileEntries[i].next = cache->fileBuckets[bucket];
+			cache->fileBuckets[bucket] = i;
+		}
+	}
+
+	index = cache->numFileEntries++;
+	int bucket = bucketOf( key, cache->numFileBuckets );
+	cache->fileEntries[index].key = key;
+	cache->fileEntries[index].offset = offset;
+	cache->fileEntries[index].next = cache->fileBuckets[bucket];
+	cache->fileBuckets[bucket] = index;
+}
+
+// indexes the complete lines added to the file since it was last scanned
+static void scanFile( FitnessCache cache ) {
+	char line[MAX_LINE];
+
+	fflush( cache->file );
+	if ( fseek( cache->file, cache->scanned, SEEK_SET ) != 0 ) {
+		return;
+	}
+
+	long offset = cache->scanned;
+	while ( fgets( line, sizeof( line ), cache->file ) != NULL ) {
+		size_t length = strlen( line );
+		if ( line[length - 1] != '\n' ) {
+			// still being written
+			break;
+		}
+
+		uint64_t key;
+		metrics_t result;
+		if ( readRecord( line, &key, &result ) ) {
+			indexFileEntry( cache, key, offset );
+		}
+
+		offset += length;
+		cache->scanned = offset;
+	}
+	clearerr( cache->file );
+}
+
+static int readRecord( const char *line, uint64_t *key, metrics_t *result ) {
+	return sscanf( line, "%" SCNx64 " %lf %lf %lf %lf %lf %lf %lf", key,
+		&result->seconds, &result->distance, &result->averageSpeed, &result->maxDisplacement,
+		&result->straightness, &result->airborneTime, &result->energy
+	) == 8;
+}
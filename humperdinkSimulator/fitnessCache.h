@@ -0,0 +1,60 @@
+/*
+ * FitnessCache ADT:
+ *  Remembers the results of evaluations (see evaluation.h) by their key,
+ *  so genomes that come up again (elites, duplicate offspring, restarts)
+ *  don't have to be simulated again.
+ *
+ * Two tiers:
+ *  - in memory, the most recently used results, up to a fixed number
+ *  - optionally a file, which every result is appended to and which can be
+ *    shared by several runs (and processes): results other runs have added
+ *    are picked up when a key is missing. Lines are
+ *      <key, 16 hex digits> <seconds> <distance> <averageSpeed> <maxDisplacement> <straightness> <airborneTime> <energy>
+ *    after a first line naming the format.
+ *
+ * Lookups and stores can come from several threads at once.
+ */
+#ifndef FITNESSCACHE_H
+#define FITNESSCACHE_H
+
+#include <stdint.h>
+#include "evaluation.h"
+
+typedef struct fitnessCache *FitnessCache;
+
+/*
+ * Constructor: Creates a cache of up to 'capacity' results in memory,
+ *  backed by the file 'filename' (created if needed) unless it's NULL.
+ *  Returns NULL if the file can't be opened or isn't a cache.
+ * Deconstructor: Closes the file and removes memory allocated for the cache
+ */
+FitnessCache createFitnessCache( int capacity, const char *filename );
+void destroyFitnessCache( FitnessCache cache );
+
+/*
+ * Looks up a result, returns 1 and fills in 'result' if it's there
+ */
+int lookupFitnessCache( FitnessCache cache, uint64_t key, metrics_t *result );
+
+/*
+ * Adds a result (to the file too, if there is one)
+ */
+void storeFitnessCache( FitnessCache cache, uint64_t key, metrics_t *result );
+
+/*
+ * evaluateGenome, through the cache: returns 1 if the result was cached
+ */
+int evaluateGenomeCached( FitnessCache cache, json_t *genome, evaluationSettings_t *settings, metrics_t *result );
+
+/*
+ * evaluateLimbs, through the cache, keyed by getLimbsEvaluationKey
+ */
+int evaluateLimbsCached( FitnessCache cache, parameters_t *parameters, int *parents, int numLimbs, evaluationSettings_t *settings, metrics_t *result );
+
+/*
+ * Lookups so far that found a result (in memory or in the file), and that didn't
+ */
+long getFitnessCacheHits( FitnessCache cache );
+long getFitnessCacheMisses( FitnessCache cache );
+
+#endif
@@ -0,0 +1,358 @@
+#include "genomeLoader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+// nested limbs that fit here need no memory from the heap
+#define FRAME_SPACE 32
+
+/*
+ * The keys of a limb object
+ */
+typedef enum {
+	KEY_OTHER,
+	KEY_CONNECTIONS,
+	KEY_ANGLE,
+	KEY_LENGTH,
+	KEY_FREQUENCY,
+	KEY_AMPLITUDE,
+	KEY_PHASE
+} limbKey_t;
+
+/*
+ * An object or array being read: a limb (and the key whose value comes
+ * next), or a limb's connections array, whose values are its child limbs
+ */
+typedef enum {
+	FRAME_LIMB,
+	FRAME_CONNECTIONS
+} frameType_t;
+
+typedef struct {
+	frameType_t type;
+	int index;
+	limbKey_t key;
+} frame_t;
+
+/*
+ * The limbs read so far from jansson's events (see json_sax_t), with the
+ * objects and arrays they are in
+ */
+typedef struct {
+	genome_t *genome;
+
+	frame_t *frames;
+	int numFrames;
+	int capacity;
+	frame_t frameSpace[FRAME_SPACE];
+
+	// the depth inside a value that isn't kept (0 if there's none)
+	int skipped;
+} loader_t;
+
+// the text a genome is decoded from
+typedef struct {
+	const char *text;
+	size_t length;
+} text_t;
+
+// decodes a genome's text, file or path ('source') into events
+typedef int ( *decoder_t )( const json_sax_t *sax, void *data, json_error_t *error, const void *source );
+
+/*
+ * Private helper function prototypes
+ */
+static int load( genome_t *genome, json_error_t *error, decoder_t decode, const void *source );
+static int decodeText( const json_sax_t *sax, void *data, json_error_t *error, const void *source );
+static int decodeFile( const json_sax_t *sax, void *data, json_error_t *error, const void *source );
+static int decodePath( const json_sax_t *sax, void *data, json_error_t *error, const void *source );
+static int startObject( void *data );
+static int startArray( void *data );
+static int endValue( void *data );
+static int readKey( void *data, const char *key );
+static int readReal( void *data, double value );
+static int readOther( void *data );
+static int readString( void *data, const char *value );
+static int readInteger( void *data, int value );
+static int readBoolean( void *data, int value );
+static int valueLimb( loader_t *loader );
+static void setParameter( genome_t *genome, int index, limbKey_t key, double real );
+static void pushFrame( loader_t *loader, frameType_t type, int index );
+static int addLimb( genome_t *genome, int parent );
+static limbKey_t keyOf( const char *key );
+
+// the events the genome is read from
+static const json_sax_t LIMB_EVENTS = {
+	startObject,
+	readKey,
+	endValue,
+	startArray,
+	endValue,
+	readString,
+	readInteger,
+	readReal,
+	readBoolean,
+	readOther
+};
+
+
+void initGenome( genome_t *genome ) {
+	genome->parameters = NULL;
+	genome->parents = NULL;
+	genome->numLimbs = 0;
+	genome->capacity = 0;
+}
+
+void freeGenome( genome_t *genome ) {
+	free( genome->parameters );
+	free( genome->parents );
+	initGenome( genome );
+}
+
+void copyGenome( genome_t *genome, genome_t *source ) {
+	if ( genome->capacity < source->numLimbs ) {
+		genome->capacity = source->numLimbs;
+		genome->parameters = realloc( genome->parameters, sizeof( parameters_t ) * genome->capacity );
+		assert( genome->parameters != NULL );
+		genome->parents = realloc( genome->parents, sizeof( int ) * genome->capacity );
+		assert( genome->parents != NULL );
+	}
+
+	memcpy( genome->parameters, source->parameters, sizeof( parameters_t ) * source->numLimbs );
+	memcpy( genome->parents, source->parents, sizeof( int ) * source->numLimbs );
+	genome->numLimbs = source->numLimbs;
+}
+
+int loadGenomeText( const char *text, size_t length, genome_t *genome, json_error_t *error ) {
+	text_t source = { text, length };
+	return load( genome, error, decodeText, &source );
+}
+
+int loadGenomeFile( FILE *input, genome_t *genome, json_error_t *error ) {
+	return load( genome, error, decodeFile, input );
+}
+
+int loadGenomePath( const char *path, genome_t *genome, json_error_t *error ) {
+	return load( genome, error, decodePath, path );
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+// reads a genome from the events of one of the decoders below
+static int load( genome_t *genome, json_error_t *error, decoder_t decode, const void *source ) {
+	json_error_t ignored;
+	if ( error == NULL ) {
+		error = &ignored;
+	}
+
+	loader_t loader;
+	loader.genome = genome;
+	loader.frames = loader.frameSpace;
+	loader.numFrames = 0;
+	loader.capacity = FRAME_SPACE;
+	loader.skipped = 0;
+	genome->numLimbs = 0;
+
+	int loaded = ( decode( &LIMB_EVENTS, &loader, error, source ) == 0 );
+
+	if ( loader.frames != loader.frameSpace ) {
+		free( loader.frames );
+	}
+	if ( !loaded ) {
+		genome->numLimbs = 0;
+	}
+	return loaded;
+}
+
+static int decodeText( const json_sax_t *sax, void *data, json_error_t *error, const void *source ) {
+	const text_t *text = source;
+	return json_sax_loadb( text->text, text->length, sax, data, error );
+}
+
+static int decodeFile( const json_sax_t *sax, void *data, json_error_t *error, const void *source ) {
+	return json_sax_loadf( (FILE *)source, sax, data, error );
+}
+
+static int decodePath( const json_sax_t *sax, void *data, json_error_t *error, const void *source ) {
+	return json_sax_load_file( source, sax, data, error );
+}
+
+static int startObject( void *data ) {
+	loader_t *loader = data;
+	if ( loader->skipped > 0 ) {
+		loader->skipped++;
+		return 0;
+	}
+
+	int limb = valueLimb( loader );
+	if ( limb >= 0 ) {
+		pushFrame( loader, FRAME_LIMB, limb );
+		return 0;
+	}
+
+	// a limb's key's value: a parameter that isn't a real, or connections that aren't an array
+	frame_t *frame = &loader->frames[loader->numFrames - 1];
+	setParameter( loader->genome, frame->index, frame->key, 0.0 );
+	loader->skipped = 1;
+	return 0;
+}
+
+static int startArray( void *data ) {
+	loader_t *loader = data;
+	if ( loader->skipped > 0 ) {
+		loader->skipped++;
+		return 0;
+	}
+
+	// a limb that isn't an object has no connections
+	if ( valueLimb( loader ) >= 0 ) {
+		loader->skipped = 1;
+		return 0;
+	}
+
+	frame_t *frame = &loader->frames[loader->numFrames - 1];
+	setParameter( loader->genome, frame->index, frame->key, 0.0 );
+	if ( frame->key == KEY_CONNECTIONS ) {
+		pushFrame( loader, FRAME_CONNECTIONS, frame->index );
+	} else {
+		loader->skipped = 1;
+	}
+	return 0;
+}
+
+static int endValue( void *data ) {
+	loader_t *loader = data;
+	if ( loader->skipped > 0 ) {
+		loader->skipped--;
+	} else {
+		loader->numFrames--;
+	}
+	return 0;
+}
+
+static int readKey( void *data, const char *key ) {
+	loader_t *loader = data;
+	if ( loader->skipped == 0 ) {
+		loader->frames[loader->numFrames - 1].key = keyOf( key );
+	}
+	return 0;
+}
+
+// a number or other value that isn't an object or array: a limb with nothing in it, or a limb's key's value
+static int readReal( void *data, double value ) {
+	loader_t *loader = data;
+	if ( loader->skipped == 0 && valueLimb( loader ) < 0 ) {
+		frame_t *frame = &loader->frames[loader->numFrames - 1];
+		setParameter( loader->genome, frame->index, frame->key, value );
+	}
+	return 0;
+}
+
+// parameters are only read from reals, so anything else reads as 0
+static int readOther( void *data ) {
+	return readReal( data, 0.0 );
+}
+
+static int readString( void *data, const char *value ) {
+	return readOther( data );
+}
+
+static int readInteger( void *data, int value ) {
+	return readOther( data );
+}
+
+static int readBoolean( void *data, int value ) {
+	return readOther( data );
+}
+
+// if a value starting now is a limb (the root, or in a connections array), adds it and returns
+// its index, otherwise (it's a limb's key's value) returns -1
+static int valueLimb( loader_t *loader ) {
+	if ( loader->numFrames == 0 ) {
+		return addLimb( loader->genome, -1 );
+	}
+
+	frame_t *frame = &loader->frames[loader->numFrames - 1];
+	if ( frame->type == FRAME_CONNECTIONS ) {
+		loader->genome->parameters[frame->index].numConnections++;
+		return addLimb( loader->genome, frame->index );
+	}
+	return -1;
+}
+
+// a key's value for a limb, with 0 for anything but a real (a repeated key replaces the earlier one)
+static void setParameter( genome_t *genome, int index, limbKey_t key, double real ) {
+	parameters_t *parameters = &genome->parameters[index];
+
+	switch ( key ) {
+		case KEY_ANGLE:     parameters->angle = real;     break;
+		case KEY_LENGTH:    parameters->length = real;    break;
+		case KEY_FREQUENCY: parameters->frequency = real; break;
+		case KEY_AMPLITUDE: parameters->amplitude = real; break;
+		case KEY_PHASE:     parameters->phase = real;     break;
+		case KEY_CONNECTIONS:
+			// replaces any earlier connections, which are the last limbs added
+			genome->numLimbs = index + 1;
+			parameters->numConnections = 0;
+			break;
+		case KEY_OTHER:
+			break;
+	}
+}
+
+static void pushFrame( loader_t *loader, frameType_t type, int index ) {
+	if ( loader->numFrames == loader->capacity ) {
+		loader->capacity *= 2;
+		if ( loader->frames == loader->frameSpace ) {
+			loader->frames = malloc( sizeof( frame_t ) * loader->capacity );
+			assert( loader->frames != NULL );
+			memcpy( loader->frames, loader->frameSpace, sizeof( loader->frameSpace ) );
+		} else {
+			loader->frames = realloc( loader->frames, sizeof( frame_t ) * loader->capacity );
+			assert( loader->frames != NULL );
+		}
+	}
+
+	frame_t *frame = &loader->frames[loader->numFrames++];
+	frame->type = type;
+	frame->index = index;
+	frame->key = KEY_OTHER;
+}
+
+// a limb with no connections and every parameter 0, returns its index
+static int addLimb( genome_t *genome, int parent ) {
+	if ( genome->numLimbs == genome->capacity ) {
+		genome->capacity = ( genome->capacity == 0 ) ? 16 : genome->capacity * 2;
+		genome->parameters = realloc( genome->parameters, sizeof( parameters_t ) * genome->capacity );
+		assert( genome->parameters != NULL );
+		genome->parents = realloc( genome->parents, sizeof( int ) * genome->capacity );
+		assert( genome->parents != NULL );
+	}
+
+	int index = genome->numLimbs++;
+	memset( &genome->parameters[index], 0, sizeof( parameters_t ) );
+	genome->parents[index] = parent;
+	return index;
+}
+
+static limbKey_t keyOf( const char *key ) {
+	if ( strcmp( key, "connections" ) == 0 ) {
+		return KEY_CONNECTIONS;
+	} else if ( strcmp( key, "angle" ) == 0 ) {
+		return KEY_ANGLE;
+	} else if ( strcmp( key, "length" ) == 0 ) {
+		return KEY_LENGTH;
+	} else if ( strcmp( key, "frequency" ) == 0 ) {
+		return KEY_FREQUENCY;
+	} else if ( strcmp( key, "amplitude" ) == 0 ) {
+		return KEY_AMPLITUDE;
+	} else if ( strcmp( key, "phase" ) == 0 ) {
+		return KEY_PHASE;
+	}
+	return KEY_OTHER;
+}
@@ -0,0 +1,55 @@
+/*
+ * Genome loader:
+ *  Reads a humperdink genome straight from its JSON text into the limb
+ *  list createCreatureFromLimbs builds from, without building a jansson
+ *  document (no json_t per limb, per parameter, or per connections array).
+ *
+ * The text is decoded by jansson's own parser, as events (json_sax_loadb
+ * and the like, see jansson-1.2/doc/apiref.rst), so a genome that
+ * json_loadf rejects is rejected with the same error text and line, and
+ * one it accepts gives the same limbs as getGenomeLimbs on the document:
+ *  - a limb's angle, length, frequency, amplitude and phase are read from
+ *    real numbers only (anything else, or a missing key, reads as 0)
+ *  - a repeated key replaces the earlier one
+ *  - a limb that isn't an object, or whose "connections" isn't an array,
+ *    has no connections
+ */
+#ifndef GENOMELOADER_H
+#define GENOMELOADER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <jansson.h>
+#include "creature.h"
+
+/*
+ * A genome's limbs, in the order of getGenomeLimbs: each limb's parameters
+ * and the index of its parent (-1 for the root), parents first.
+ * Reusable: loading into a genome keeps its memory for the next load.
+ */
+typedef struct {
+	parameters_t *parameters;
+	int *parents;
+	int numLimbs;
+	int capacity;
+} genome_t;
+
+void initGenome( genome_t *genome );
+void freeGenome( genome_t *genome );
+
+/*
+ * Makes 'genome' a copy of 'source' (keeping its memory if there's room)
+ */
+void copyGenome( genome_t *genome, genome_t *source );
+
+/*
+ * Loads a genome from 'length' bytes of text, an open file (read to its
+ * end, a chunk at a time), or the file at 'path'. Return 1 on success, or
+ * 0 with 'error' set as json_loadb / json_loadf / json_load_file would
+ * set it.
+ */
+int loadGenomeText( const char *text, size_t length, genome_t *genome, json_error_t *error );
+int loadGenomeFile( FILE *input, genome_t *genome, json_error_t *error );
+int loadGenomePath( const char *path, genome_t *genome, json_error_t *error );
+
+#endif
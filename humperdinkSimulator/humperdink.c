@@ -0,0 +1,410 @@
+#include "humperdink.h"
+
+#include "chipmunk.h"
+#include "evaluation.h"
+#include "genomeLoader.h"
+#include "binaryGenome.h"
+#include "screening.h"
+#include "fitnessCache.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <assert.h>
+
+// updates each genome is simulated for, until the settings say otherwise
+#define DEFAULT_UPDATES 1200
+
+// results a cache keeps in memory (a file keeps them all)
+#define CACHE_CAPACITY 65536
+
+#define ERROR_LENGTH ( JSON_ERROR_TEXT_LENGTH + 64 )
+
+struct humperdink {
+	evaluationSettings_t settings;
+	int threads;
+
+	// the screening tiers' lists, read when the batch is run
+	char **tiers;
+	int numTiers;
+
+	// NULL for none
+	FitnessCache cache;
+
+	// built by the first run and kept, with its threads and their creatures,
+	// until the settings or tiers change: NULL until then
+	Screening screening;
+
+	// the batch: its genomes keep their memory when it's emptied
+	genome_t *genomes;
+	int numGenomes;
+	int capacity;
+
+	// the last run's results, for every genome in the batch if 'run'
+	metrics_t *results;
+	int *resultTiers;
+	int run;
+
+	char error[ERROR_LENGTH];
+};
+
+// a measure's offset in metrics_t, by the name getHumperdinkResults takes
+typedef struct {
+	const char *name;
+	size_t offset;
+} measure_t;
+
+static const measure_t MEASURES[] = {
+	{ "seconds", offsetof( metrics_t, seconds ) },
+	{ "distance", offsetof( metrics_t, distance ) },
+	{ "averageSpeed", offsetof( metrics_t, averageSpeed ) },
+	{ "maxDisplacement", offsetof( metrics_t, maxDisplacement ) },
+	{ "straightness", offsetof( metrics_t, straightness ) },
+	{ "airborneTime", offsetof( metrics_t, airborneTime ) },
+	{ "energy", offsetof( metrics_t, energy ) }
+};
+
+#define NUM_MEASURES ( sizeof( MEASURES ) / sizeof( MEASURES[0] ) )
+
+/*
+ * Private helper function prototypes
+ */
+static int parseSettings( const char *list, evaluationSettings_t *settings, int *threads );
+static genome_t *nextGenome( Humperdink humperdink );
+static int checkResults( Humperdink humperdink, int count );
+static void dropScreening( Humperdink humperdink );
+static int fail( Humperdink humperdink, const char *format, ... );
+
+
+int getHumperdinkVersion( void ) {
+	return HUMPERDINK_VERSION;
+}
+
+Humperdink createHumperdink( void ) {
+	// once, even with contexts created on several threads
+	static pthread_once_t initialised = PTHREAD_ONCE_INIT;
+	pthread_once( &initialised, cpInitChipmunk );
+
+	Humperdink humperdink = malloc( sizeof( struct humperdink ) );
+	assert( humperdink != NULL );
+
+	humperdink->settings = defaultEvaluationSettings( DEFAULT_UPDATES );
+	humperdink->threads = 1;
+
+	humperdink->tiers = NULL;
+	humperdink->numTiers = 0;
+
+	humperdink->cache = NULL;
+	humperdink->screening = NULL;
+
+	humperdink->genomes = NULL;
+	humperdink->numGenomes = 0;
+	humperdink->capacity = 0;
+
+	humperdink->results = NULL;
+	humperdink->resultTiers = NULL;
+	humperdink->run = 0;
+
+	humperdink->error[0] = '\0';
+
+	return humperdink;
+}
+
+void destroyHumperdink( Humperdink humperdink ) {
+	clearHumperdinkTiers( humperdink );
+	setHumperdinkCache( humperdink, NULL );
+	dropScreening( humperdink );
+
+	for ( int i = 0; i < humperdink->capacity; ++i ) {
+		freeGenome( &humperdink->genomes[i] );
+	}
+	free( humperdink->genomes );
+	free( humperdink->results );
+	free( humperdink->resultTiers );
+
+	// the creatures kept by this thread's runs
+	releaseEvaluationTemplates( );
+
+	free( humperdink );
+}
+
+const char *getHumperdinkError( Humperdink humperdink ) {
+	return humperdink->error;
+}
+
+int setHumperdinkSettings( Humperdink humperdink, const char *list ) {
+	evaluationSettings_t settings = humperdink->settings;
+	int threads = humperdink->threads;
+
+	if ( !parseSettings( list, &settings, &threads ) ) {
+		return fail( humperdink, "can't read the settings \"%s\"", list );
+	}
+	if ( settings.articulated && settings.graphColoring ) {
+		return fail( humperdink, "the graph coloring solver can't be used with articulated creatures" );
+	}
+
+	humperdink->settings = settings;
+	humperdink->threads = threads;
+	dropScreening( humperdink );
+	return 1;
+}
+
+int setHumperdinkTermination( Humperdink humperdink, const char *rules ) {
+	if ( rules == NULL ) {
+		humperdink->settings.terminate = 0;
+		dropScreening( humperdink );
+		return 1;
+	}
+
+	terminationRules_t parsed = defaultTerminationRules( );
+	if ( !parseTerminationRules( rules, &parsed ) ) {
+		return fail( humperdink, "can't read the termination rules \"%s\"", rules );
+	}
+
+	humperdink->settings.terminate = 1;
+	humperdink->settings.rules = parsed;
+	dropScreening( humperdink );
+	return 1;
+}
+
+int addHumperdinkTier( Humperdink humperdink, const char *list ) {
+	// read now only to check it: the settings it changes may change before the run
+	evaluationSettings_t settings = humperdink->settings;
+	double keep;
+	if ( !parseScreeningTier( list, &settings, &keep ) ) {
+		return fail( humperdink, "can't read the screening tier \"%s\"", list );
+	}
+
+	humperdink->tiers = realloc( humperdink->tiers, sizeof( char * ) * ( humperdink->numTiers + 1 ) );
+	assert( humperdink->tiers != NULL );
+	humperdink->tiers[humperdink->numTiers] = strdup( list );
+	assert( humperdink->tiers[humperdink->numTiers] != NULL );
+	humperdink->numTiers++;
+	dropScreening( humperdink );
+
+	return 1;
+}
+
+void clearHumperdinkTiers( Humperdink humperdink ) {
+	for ( int i = 0; i < humperdink->numTiers; ++i ) {
+		free( humperdink->tiers[i] );
+	}
+	free( humperdink->tiers );
+	humperdink->tiers = NULL;
+	humperdink->numTiers = 0;
+	dropScreening( humperdink );
+}
+
+int setHumperdinkCache( Humperdink humperdink, const char *path ) {
+	FitnessCache cache = NULL;
+	if ( path != NULL ) {
+		cache = createFitnessCache( CACHE_CAPACITY, ( path[0] != '\0' ) ? path : NULL );
+		if ( cache == NULL ) {
+			// the old cache stays
+			return fail( humperdink, "can't open the fitness cache \"%s\"", path );
+		}
+	}
+
+	if ( humperdink->cache != NULL ) {
+		destroyFitnessCache( humperdink->cache );
+	}
+	humperdink->cache = cache;
+	return 1;
+}
+
+int addHumperdinkGenome( Humperdink humperdink, const char *json ) {
+	json_error_t error;
+	genome_t *genome = nextGenome( humperdink );
+
+	if ( !loadGenomeText( json, strlen( json ), genome, &error ) ) {
+		return fail( humperdink, "genome %d: line %d: %s", humperdink->numGenomes, error.line, error.text );
+	}
+
+	humperdink->numGenomes++;
+	humperdink->run = 0;
+	return 1;
+}
+
+int addHumperdinkBinaryGenome( Humperdink humperdink, const void *data, size_t size ) {
+	json_error_t error;
+	genome_t *genome = nextGenome( humperdink );
+
+	if ( !loadBinaryGenomeData( data, size, genome, &error ) ) {
+		return fail( humperdink, "genome %d: %s", humperdink->numGenomes, error.text );
+	}
+
+	humperdink->numGenomes++;
+	humperdink->run = 0;
+	return 1;
+}
+
+int getHumperdinkBatchSize( Humperdink humperdink ) {
+	return humperdink->numGenomes;
+}
+
+void clearHumperdinkBatch( Humperdink humperdink ) {
+	humperdink->numGenomes = 0;
+	humperdink->run = 0;
+}
+
+int runHumperdink( Humperdink humperdink ) {
+	if ( humperdink->numGenomes == 0 ) {
+		return fail( humperdink, "the batch is empty" );
+	}
+
+	if ( humperdink->screening == NULL ) {
+		humperdink->screening = createScreening( &humperdink->settings, humperdink->threads );
+		for ( int i = 0; i < humperdink->numTiers; ++i ) {
+			evaluationSettings_t settings = humperdink->settings;
+			double keep;
+			int parsed = parseScreeningTier( humperdink->tiers[i], &settings, &keep );
+			assert( parsed );
+			(void)parsed;
+			addScreeningTier( humperdink->screening, &settings, keep );
+		}
+	}
+	Screening screening = humperdink->screening;
+	setScreeningCache( screening, humperdink->cache );
+
+	genome_t **batch = malloc( sizeof( genome_t * ) * humperdink->numGenomes );
+	assert( batch != NULL );
+	for ( int i = 0; i < humperdink->numGenomes; ++i ) {
+		batch[i] = &humperdink->genomes[i];
+	}
+	screenGenomes( screening, batch, humperdink->numGenomes, humperdink->results, humperdink->resultTiers );
+	free( batch );
+
+	humperdink->run = 1;
+	return 1;
+}
+
+int getHumperdinkResults( Humperdink humperdink, const char *measure, double *values, int count ) {
+	if ( !checkResults( humperdink, count ) ) {
+		return 0;
+	}
+
+	for ( int m = 0; m < NUM_MEASURES; ++m ) {
+		if ( strcmp( measure, MEASURES[m].name ) == 0 ) {
+			for ( int i = 0; i < count; ++i ) {
+				values[i] = *(double *)( (char *)&humperdink->results[i] + MEASURES[m].offset );
+			}
+			return 1;
+		}
+	}
+
+	return fail( humperdink, "no measure \"%s\"", measure );
+}
+
+int getHumperdinkResultTiers( Humperdink humperdink, int *tiers, int count ) {
+	if ( !checkResults( humperdink, count ) ) {
+		return 0;
+	}
+
+	memcpy( tiers, humperdink->resultTiers, sizeof( int ) * count );
+	return 1;
+}
+
+int getHumperdinkTiers( Humperdink humperdink ) {
+	return humperdink->numTiers + 1;
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+// reads the list setHumperdinkSettings takes, as parseTerminationRules reads its list
+static int parseSettings( const char *list, evaluationSettings_t *settings, int *threads ) {
+	const char *c = list;
+
+	while ( *c != '\0' ) {
+		char name[16];
+		double value;
+		int length;
+
+		if ( sscanf( c, "%15[a-z]=%lf%n", name, &value, &length ) != 2 || value < 0.0 ) {
+			return 0;
+		}
+
+		if ( strcmp( name, "updates" ) == 0 && value >= 1.0 ) {
+			settings->updates = (int)value;
+		} else if ( strcmp( name, "timestep" ) == 0 ) {
+			settings->timestep = value;
+		} else if ( strcmp( name, "substeps" ) == 0 && value >= 1.0 ) {
+			settings->substeps = (int)value;
+		} else if ( strcmp( name, "maxsubsteps" ) == 0 ) {
+			settings->maxSubsteps = (int)value;
+		} else if ( strcmp( name, "passes" ) == 0 ) {
+			settings->iterations = (int)value;
+		} else if ( strcmp( name, "tolerance" ) == 0 ) {
+			settings->tolerance = value;
+		} else if ( strcmp( name, "articulated" ) == 0 ) {
+			settings->articulated = ( value != 0.0 );
+		} else if ( strcmp( name, "coloring" ) == 0 ) {
+			settings->graphColoring = ( value != 0.0 );
+		} else if ( strcmp( name, "threads" ) == 0 && value >= 1.0 ) {
+			*threads = (int)value;
+		} else {
+			return 0;
+		}
+
+		c += length;
+		if ( *c == ',' ) {
+			c++;
+		} else if ( *c != '\0' ) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// the genome after the last in the batch, with room for the results of a batch that includes it
+static genome_t *nextGenome( Humperdink humperdink ) {
+	if ( humperdink->numGenomes == humperdink->capacity ) {
+		int capacity = ( humperdink->capacity > 0 ) ? humperdink->capacity * 2 : 16;
+		humperdink->genomes = realloc( humperdink->genomes, sizeof( genome_t ) * capacity );
+		humperdink->results = realloc( humperdink->results, sizeof( metrics_t ) * capacity );
+		humperdink->resultTiers = realloc( humperdink->resultTiers, sizeof( int ) * capacity );
+		assert( humperdink->genomes != NULL && humperdink->results != NULL && humperdink->resultTiers != NULL );
+
+		for ( int i = humperdink->capacity; i < capacity; ++i ) {
+			initGenome( &humperdink->genomes[i] );
+		}
+		humperdink->capacity = capacity;
+	}
+
+	return &humperdink->genomes[humperdink->numGenomes];
+}
+
+static int checkResults( Humperdink humperdink, int count ) {
+	if ( !humperdink->run ) {
+		return fail( humperdink, "the batch hasn't been run" );
+	}
+	if ( count < 0 || count > humperdink->numGenomes ) {
+		return fail( humperdink, "%d results asked for, from a batch of %d", count, humperdink->numGenomes );
+	}
+
+	return 1;
+}
+
+// stops the screening's threads, removing the creatures they kept, for the next run to build a new one
+static void dropScreening( Humperdink humperdink ) {
+	if ( humperdink->screening != NULL ) {
+		destroyScreening( humperdink->screening );
+		humperdink->screening = NULL;
+	}
+}
+
+// sets the error, and returns 0 for the caller to return
+static int fail( Humperdink humperdink, const char *format, ... ) {
+	va_list arguments;
+	va_start( arguments, format );
+	vsnprintf( humperdink->error, ERROR_LENGTH, format, arguments );
+	va_end( arguments );
+
+	return 0;
+}
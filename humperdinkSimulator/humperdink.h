@@ -0,0 +1,124 @@
+/*
+ * Humperdink library (libhumperdink):
+ *  Evaluates batches of genomes in the caller's process, for optimizers
+ *  (in C, or in any language that can call C, such as Python through
+ *  ctypes) that would otherwise write each genome to a file and run the
+ *  simulator on it. A context holds the settings and a batch: genomes are
+ *  added to the batch as .hdk JSON text or as binary genomes in memory
+ *  (see binaryGenome.h), the batch is run on the context's threads (and
+ *  screened first if tiers were added, see screening.h), and the results
+ *  are copied into arrays the caller owns.
+ *
+ * This header is the whole interface of the library: it includes no other
+ * header of the simulator's, and its functions only take and return ints,
+ * doubles, strings, buffers and contexts. The functions that can fail
+ * return 1 on success, or 0 with the reason in getHumperdinkError.
+ * A context is used by one thread at a time.
+ *
+ * make lib builds libhumperdink.a and libhumperdink.so
+ */
+#ifndef HUMPERDINK_H
+#define HUMPERDINK_H
+
+#include <stddef.h>
+
+// changes whenever a function here does
+#define HUMPERDINK_VERSION 2
+
+// the library only exports these functions
+#define HUMPERDINK_API __attribute__(( visibility( "default" ) ))
+
+typedef struct humperdink *Humperdink;
+
+/*
+ * The HUMPERDINK_VERSION the library was built with
+ */
+HUMPERDINK_API int getHumperdinkVersion( void );
+
+/*
+ * Constructor: Creates a context with an empty batch, the simulator's
+ *  defaults for 1200 updates (20 seconds), no screening, and one thread
+ * Deconstructor: Removes memory allocated for the context and its batch
+ */
+HUMPERDINK_API Humperdink createHumperdink( void );
+HUMPERDINK_API void destroyHumperdink( Humperdink humperdink );
+
+/*
+ * Why the last function that failed did (empty if none has)
+ */
+HUMPERDINK_API const char *getHumperdinkError( Humperdink humperdink );
+
+/*
+ * Changes settings from a list like "updates=1200,timestep=0.0167,
+ * substeps=1,maxsubsteps=0,passes=10,tolerance=0,articulated=0,coloring=0,
+ * threads=4" (the runtime flags -i, -d, -u, -v, -e, -a, -c and -t in
+ * readme.txt, and the solver passes per step), leaving the rest as they
+ * were. Nothing changes if the list can't be read.
+ */
+HUMPERDINK_API int setHumperdinkSettings( Humperdink humperdink, const char *list );
+
+/*
+ * Stops simulations early (like -x) by the default termination rules
+ * changed by a list like "window=3,progress=5" (or "" for the defaults),
+ * or never if 'rules' is NULL
+ */
+HUMPERDINK_API int setHumperdinkTermination( Humperdink humperdink, const char *rules );
+
+/*
+ * Adds a screening tier (like -q) from a list like "updates=300,passes=4,
+ * keep=0.25", after the tiers already added. The tiers change the
+ * settings as they are when the batch is run. clearHumperdinkTiers
+ * removes them all, so every genome is simulated in full.
+ */
+HUMPERDINK_API int addHumperdinkTier( Humperdink humperdink, const char *list );
+HUMPERDINK_API void clearHumperdinkTiers( Humperdink humperdink );
+
+/*
+ * Looks every genome up in a fitness cache before simulating it, and adds
+ * the results of the ones that weren't there: kept in the file at 'path'
+ * (created if needed, and shared with later runs, other contexts and -k),
+ * only in memory if 'path' is "", or no cache at all if it's NULL (the
+ * default). A genome is found with the same settings, by each tier's own.
+ */
+HUMPERDINK_API int setHumperdinkCache( Humperdink humperdink, const char *path );
+
+/*
+ * Adds a genome to the end of the batch, from its JSON text (up to a
+ * '\0') or the 'size' bytes of a binary genome file
+ */
+HUMPERDINK_API int addHumperdinkGenome( Humperdink humperdink, const char *json );
+HUMPERDINK_API int addHumperdinkBinaryGenome( Humperdink humperdink, const void *data, size_t size );
+
+/*
+ * The number of genomes in the batch, and emptying it
+ * (keeping its memory for the next batch)
+ */
+HUMPERDINK_API int getHumperdinkBatchSize( Humperdink humperdink );
+HUMPERDINK_API void clearHumperdinkBatch( Humperdink humperdink );
+
+/*
+ * Simulates every genome in the batch. The results stay until the batch
+ * changes. The threads (and the creatures they keep for reuse) are started
+ * by the first run and kept for the next, until the settings, termination
+ * or tiers change or the context is destroyed.
+ */
+HUMPERDINK_API int runHumperdink( Humperdink humperdink );
+
+/*
+ * Copies a measure of each of the first 'count' genomes of the run batch
+ * (at most its size) into 'values': "seconds", "distance", "averageSpeed",
+ * "maxDisplacement", "straightness", "airborneTime" or "energy" (see
+ * metrics.h). With screening, each genome's measures are from the last
+ * tier that simulated it, whose index (0 for the first tier added,
+ * getHumperdinkTiers - 1 for the full settings) getHumperdinkResultTiers
+ * copies into 'tiers'.
+ */
+HUMPERDINK_API int getHumperdinkResults( Humperdink humperdink, const char *measure, double *values, int count );
+HUMPERDINK_API int getHumperdinkResultTiers( Humperdink humperdink, int *tiers, int count );
+
+/*
+ * The number of tiers, counting the full settings (the last)
+ */
+HUMPERDINK_API int getHumperdinkTiers( Humperdink humperdink );
+
+#endif
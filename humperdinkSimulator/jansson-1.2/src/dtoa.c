@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2009 Petri Lehtinen <petri@digip.org>
+ *
+ * Jansson is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+/*
+ * Shortest round-trip formatting of doubles, with the Grisu2 algorithm
+ * (Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers", PLDI 2010). The digits always read back
+ * as the same double, and are the fewest that do for all but a small
+ * fraction of a percent of doubles (for which there is one digit more).
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <jansson.h>
+
+/* a double as an unsigned significand and a binary exponent */
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+#define DP_SIGNIFICAND_SIZE  52
+#define DP_EXPONENT_BIAS     (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_MIN_EXPONENT      (-DP_EXPONENT_BIAS)
+#define DP_EXPONENT_MASK     0x7FF0000000000000ULL
+#define DP_SIGNIFICAND_MASK  0x000FFFFFFFFFFFFFULL
+#define DP_HIDDEN_BIT        0x0010000000000000ULL
+
+/* the largest decimal exponent still written without an exponent, as
+   printf's "%.17g" would */
+#define MAX_FIXED_EXPONENT   17
+
+/* normalized 64-bit significands and binary exponents of the powers
+   of ten 10^-348, 10^-340, ..., 10^340 */
+static const uint64_t cached_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+static const int16_t cached_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint64_t pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+static diy_fp_t diy_fp_from_double(double value)
+{
+    diy_fp_t fp;
+    uint64_t bits;
+    int biased_e;
+
+    memcpy(&bits, &value, sizeof(bits));
+    biased_e = (int)((bits & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+
+    if(biased_e != 0) {
+        fp.f = (bits & DP_SIGNIFICAND_MASK) + DP_HIDDEN_BIT;
+        fp.e = biased_e - DP_EXPONENT_BIAS;
+    }
+    else {
+        fp.f = bits & DP_SIGNIFICAND_MASK;
+        fp.e = DP_MIN_EXPONENT + 1;
+    }
+
+    return fp;
+}
+
+/* the upper 64 bits of the product, rounded */
+static diy_fp_t diy_fp_multiply(diy_fp_t x, diy_fp_t y)
+{
+    const uint64_t mask = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & mask;
+    uint64_t c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask) + (bc & mask);
+    diy_fp_t product;
+
+    tmp += 1ULL << 31;
+    product.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    product.e = x.e + y.e + 64;
+
+    return product;
+}
+
+static diy_fp_t diy_fp_normalize(diy_fp_t fp)
+{
+    while(!(fp.f & 0x8000000000000000ULL)) {
+        fp.f <<= 1;
+        fp.e--;
+    }
+    return fp;
+}
+
+/* the normalized boundaries halfway to the neighbouring doubles */
+static void normalized_boundaries(diy_fp_t fp, diy_fp_t *minus,
+                                  diy_fp_t *plus)
+{
+    diy_fp_t pl, mi;
+
+    pl.f = (fp.f << 1) + 1;
+    pl.e = fp.e - 1;
+    pl = diy_fp_normalize(pl);
+
+    /* the gap below a power of two is half the gap above it */
+    if(fp.f == DP_HIDDEN_BIT) {
+        mi.f = (fp.f << 2) - 1;
+        mi.e = fp.e - 2;
+    }
+    else {
+        mi.f = (fp.f << 1) - 1;
+        mi.e = fp.e - 1;
+    }
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+
+    *minus = mi;
+    *plus = pl;
+}
+
+/* a power of ten c = 10^-k such that e + c.e + 64 is in [-60, -32] */
+static diy_fp_t cached_power(int e, int *k)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int index = (int)dk;
+    diy_fp_t c;
+
+    if(dk - index > 0.0)
+        index++;
+    index = (index >> 3) + 1;
+
+    *k = -(-348 + index * 8);
+    c.f = cached_f[index];
+    c.e = cached_e[index];
+
+    return c;
+}
+
+static void grisu_round(char *digits, int length, uint64_t delta,
+                        uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    /* step the last digit down while that moves closer to the value */
+    while(rest < wp_w && delta - rest >= ten_kappa &&
+          (rest + ten_kappa < wp_w ||
+           wp_w - rest > rest + ten_kappa - wp_w))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int count_digits(uint32_t n)
+{
+    int count = 1;
+    while(n >= 10) {
+        n /= 10;
+        count++;
+    }
+    return count;
+}
+
+/* the digits of w, as few as keep it within delta of mp */
+static int digit_gen(diy_fp_t w, diy_fp_t mp, uint64_t delta,
+                     char *digits, int *k)
+{
+    diy_fp_t one;
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa, length = 0;
+
+    one.f = 1ULL << -mp.e;
+    one.e = mp.e;
+
+    p1 = (uint32_t)(mp.f >> -one.e);
+    p2 = mp.f & (one.f - 1);
+    kappa = count_digits(p1);
+
+    while(kappa > 0) {
+        uint32_t d = p1 / (uint32_t)pow10[kappa - 1];
+        uint64_t rest;
+
+        p1 %= (uint32_t)pow10[kappa - 1];
+        if(d || length)
+            digits[length++] = (char)('0' + d);
+        kappa--;
+
+        rest = ((uint64_t)p1 << -one.e) + p2;
+        if(rest <= delta) {
+            *k += kappa;
+            grisu_round(digits, length, delta, rest,
+                        pow10[kappa] << -one.e, wp_w);
+            return length;
+        }
+    }
+
+    while(1) {
+        char d;
+
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if(d || length)
+            digits[length++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+
+        if(p2 < delta) {
+            *k += kappa;
+            grisu_round(digits, length, delta, p2, one.f,
+                        -kappa < 20 ? wp_w * pow10[-kappa] : 0);
+            return length;
+        }
+    }
+}
+
+/* the digits of a positive, finite value, which is digits * 10^k */
+static int grisu2(double value, char *digits, int *k)
+{
+    diy_fp_t v = diy_fp_from_double(value);
+    diy_fp_t w_m, w_p, c_mk, w;
+
+    normalized_boundaries(v, &w_m, &w_p);
+    c_mk = cached_power(w_p.e, k);
+
+    w = diy_fp_multiply(diy_fp_normalize(v), c_mk);
+    w_p = diy_fp_multiply(w_p, c_mk);
+    w_m = diy_fp_multiply(w_m, c_mk);
+    w_m.f++;
+    w_p.f--;
+
+    return digit_gen(w, w_p, w_p.f - w_m.f, digits, k);
+}
+
+static char *write_exponent(char *buffer, int exponent)
+{
+    *buffer++ = 'e';
+    if(exponent < 0) {
+        *buffer++ = '-';
+        exponent = -exponent;
+    }
+    else
+        *buffer++ = '+';
+
+    if(exponent >= 100) {
+        *buffer++ = (char)('0' + exponent / 100);
+        exponent %= 100;
+    }
+    *buffer++ = (char)('0' + exponent / 10);
+    *buffer++ = (char)('0' + exponent % 10);
+
+    return buffer;
+}
+
+int json_real_str(double value, char *buffer)
+{
+    char digits[24];
+    char *start = buffer;
+    int length, k, point;
+
+    if(isnan(value)) {
+        strcpy(buffer, signbit(value) ? "-nan" : "nan");
+        return (int)strlen(buffer);
+    }
+
+    if(signbit(value)) {
+        *buffer++ = '-';
+        value = -value;
+    }
+
+    if(isinf(value)) {
+        strcpy(buffer, "inf");
+        return (int)(buffer - start) + 3;
+    }
+
+    if(value == 0.0) {
+        *buffer++ = '0';
+        *buffer = '\0';
+        return (int)(buffer - start);
+    }
+
+    length = grisu2(value, digits, &k);
+
+    /* the value is 0.digits * 10^point; written as printf's "%.17g"
+       writes the same digits */
+    point = length + k;
+
+    if(point > MAX_FIXED_EXPONENT || point < -3) {
+        /* d.ddde+xx */
+        *buffer++ = digits[0];
+        if(length > 1) {
+            *buffer++ = '.';
+            memcpy(buffer, digits + 1, length - 1);
+            buffer += length - 1;
+        }
+        buffer = write_exponent(buffer, point - 1);
+    }
+    else if(point >= length) {
+        /* ddd000 */
+        memcpy(buffer, digits, length);
+        memset(buffer + length, '0', point - length);
+        buffer += point;
+    }
+    else if(point > 0) {
+        /* dd.dd */
+        memcpy(buffer, digits, point);
+        buffer[point] = '.';
+        memcpy(buffer + point + 1, digits + point, length - point);
+        buffer += length + 1;
+    }
+    else {
+        /* 0.000ddd */
+        *buffer++ = '0';
+        *buffer++ = '.';
+        memset(buffer, '0', -point);
+        buffer += -point;
+        memcpy(buffer, digits, length);
+        buffer += length;
+    }
+
+    *buffer = '\0';
+    return (int)(buffer - start);
+}
@@ -18,7 +18,13 @@
 #include "utf.h"
 
 #define MAX_INTEGER_STR_LENGTH  100
-#define MAX_REAL_STR_LENGTH     100
+#define MAX_REAL_STR_LENGTH     JSON_REAL_STR_LENGTH
+
+/* size of a writer's buffer, written out when it's full */
+#define WRITE_SIZE  65536
+
+/* containers a writer's stack has room for at first */
+#define WRITER_DEPTH  16
 
 typedef int (*dump_func)(const char *buffer, int size, void *data);
 
@@ -34,14 +40,6 @@ static int dump_to_strbuffer(const char *buffer, int size, void *data)
     return strbuffer_append_bytes((strbuffer_t *)data, buffer, size);
 }
 
-static int dump_to_file(const char *buffer, int size, void *data)
-{
-    FILE *dest = (FILE *)data;
-    if(fwrite(buffer, size, 1, dest) != 1)
-        return -1;
-    return 0;
-}
-
 /* 256 spaces (the maximum indentation size) */
 static char whitespace[] = "                                                                                                                                                                                                                                                                ";
 
@@ -154,6 +152,42 @@ static int dump_string(const char *str, int ascii, dump_func dump, void *data)
     return dump("\"", 1, data);
 }
 
+static int dump_integer(int value, dump_func dump, void *data)
+{
+    char buffer[MAX_INTEGER_STR_LENGTH];
+    int size;
+
+    size = snprintf(buffer, MAX_INTEGER_STR_LENGTH, "%d", value);
+    if(size >= MAX_INTEGER_STR_LENGTH)
+        return -1;
+
+    return dump(buffer, size, data);
+}
+
+static int dump_real(double value, dump_func dump, void *data)
+{
+    char buffer[MAX_REAL_STR_LENGTH];
+    int size;
+
+    size = json_real_str(value, buffer);
+
+    /* Make sure there's a dot or 'e' in the output. Otherwise
+       a real is converted to an integer when decoding */
+    if(strchr(buffer, '.') == NULL &&
+       strchr(buffer, 'e') == NULL)
+    {
+        if(size + 2 >= MAX_REAL_STR_LENGTH) {
+            /* No space to append ".0" */
+            return -1;
+        }
+        buffer[size] = '.';
+        buffer[size + 1] = '0';
+        size += 2;
+    }
+
+    return dump(buffer, size, data);
+}
+
 static int object_key_cmp(const void *key1, const void *key2)
 {
     return strcmp(*(const char **)key1, *(const char **)key2);
@@ -175,43 +209,10 @@ static int do_dump(const json_t *json, unsigned long flags, int depth,
             return dump("false", 5, data);
 
         case JSON_INTEGER:
-        {
-            char buffer[MAX_INTEGER_STR_LENGTH];
-            int size;
-
-            size = snprintf(buffer, MAX_INTEGER_STR_LENGTH, "%d", json_integer_value(json));
-            if(size >= MAX_INTEGER_STR_LENGTH)
-                return -1;
-
-            return dump(buffer, size, data);
-        }
+            return dump_integer(json_integer_value(json), dump, data);
 
         case JSON_REAL:
-        {
-            char buffer[MAX_REAL_STR_LENGTH];
-            int size;
-
-            size = snprintf(buffer, MAX_REAL_STR_LENGTH, "%.17g",
-                            json_real_value(json));
-            if(size >= MAX_REAL_STR_LENGTH)
-                return -1;
-
-            /* Make sure there's a dot or 'e' in the output. Otherwise
-               a real is converted to an integer when decoding */
-            if(strchr(buffer, '.') == NULL &&
-               strchr(buffer, 'e') == NULL)
-            {
-                if(size + 2 >= MAX_REAL_STR_LENGTH) {
-                    /* No space to append ".0" */
-                    return -1;
-                }
-                buffer[size] = '.';
-                buffer[size + 1] = '0';
-                size += 2;
-            }
-
-            return dump(buffer, size, data);
-        }
+            return dump_real(json_real_value(json), dump, data);
 
         case JSON_STRING:
             return dump_string(json_string_value(json), ascii, dump, data);
@@ -232,8 +233,10 @@ static int do_dump(const json_t *json, unsigned long flags, int depth,
 
             if(dump("[", 1, data))
                 return -1;
-            if(n == 0)
+            if(n == 0) {
+                array->visited = 0;
                 return dump("]", 1, data);
+            }
             if(dump_indent(flags, depth + 1, 0, dump, data))
                 return -1;
 
@@ -285,8 +288,10 @@ static int do_dump(const json_t *json, unsigned long flags, int depth,
 
             if(dump("{", 1, data))
                 return -1;
-            if(!iter)
+            if(!iter) {
+                object->visited = 0;
                 return dump("}", 1, data);
+            }
             if(dump_indent(flags, depth + 1, 0, dump, data))
                 return -1;
 
@@ -417,10 +422,22 @@ char *json_dumps(const json_t *json, unsigned long flags)
 
 int json_dumpf(const json_t *json, FILE *output, unsigned long flags)
 {
+    json_writer_t *writer;
+    int result;
+
     if(!json_is_array(json) && !json_is_object(json))
         return -1;
 
-    return do_dump(json, flags, 0, dump_to_file, (void *)output);
+    /* through a writer's buffer, rather than a write for every token */
+    writer = json_writer_new(output, flags);
+    if(!writer)
+        return -1;
+
+    result = json_write_value(writer, json);
+    if(json_writer_free(writer))
+        result = -1;
+
+    return result;
 }
 
 int json_dump_file(const json_t *json, const char *path, unsigned long flags)
@@ -436,3 +453,309 @@ int json_dump_file(const json_t *json, const char *path, unsigned long flags)
     fclose(output);
     return result;
 }
+
+
+/*** streaming writer ***/
+
+struct json_writer {
+    FILE *output;
+    unsigned long flags;
+    char *buffer;
+    int length;
+    /* the open arrays and objects, '[' or '{', outermost first */
+    char *stack;
+    int depth;
+    int stack_size;
+    /* nothing written in the innermost one yet */
+    int first;
+    /* an object's key written, its value next */
+    int keyed;
+    /* the document's outermost array or object closed */
+    int done;
+    /* once anything fails, so does everything after it */
+    int error;
+};
+
+static int writer_flush(json_writer_t *writer)
+{
+    if(writer->length > 0 &&
+       fwrite(writer->buffer, writer->length, 1, writer->output) != 1)
+        return -1;
+
+    writer->length = 0;
+    return 0;
+}
+
+static int dump_to_writer(const char *buffer, int size, void *data)
+{
+    json_writer_t *writer = (json_writer_t *)data;
+
+    if(writer->length + size > WRITE_SIZE) {
+        if(writer_flush(writer))
+            return -1;
+
+        /* too big for the buffer: straight out */
+        if(size > WRITE_SIZE)
+            return fwrite(buffer, size, 1, writer->output) == 1 ? 0 : -1;
+    }
+
+    memcpy(writer->buffer + writer->length, buffer, size);
+    writer->length += size;
+    return 0;
+}
+
+static int writer_failed(json_writer_t *writer)
+{
+    writer->error = 1;
+    return -1;
+}
+
+/* what comes before a value (or key, in an object): a separator from
+   the one before it, and where it's indented to, as do_dump writes */
+static int writer_element(json_writer_t *writer, int key)
+{
+    char container;
+
+    if(writer->error)
+        return -1;
+
+    if(writer->depth == 0) {
+        /* the document is a single array or object */
+        return writer->done ? writer_failed(writer) : 0;
+    }
+
+    container = writer->stack[writer->depth - 1];
+
+    if(container == '{' && writer->keyed) {
+        /* the value of the key just written */
+        if(key)
+            return writer_failed(writer);
+        writer->keyed = 0;
+        return 0;
+    }
+
+    if(container == '{' && !key)
+        return writer_failed(writer);
+    if(container == '[' && key)
+        return writer_failed(writer);
+
+    if(writer->first) {
+        writer->first = 0;
+        if(dump_indent(writer->flags, writer->depth, 0, dump_to_writer, writer))
+            return writer_failed(writer);
+    }
+    else {
+        if(dump_to_writer(",", 1, writer) ||
+           dump_indent(writer->flags, writer->depth, 1, dump_to_writer, writer))
+            return writer_failed(writer);
+    }
+
+    return 0;
+}
+
+/* a value (not an array or object) in the current array or object */
+static int writer_scalar(json_writer_t *writer)
+{
+    /* the document's outermost value must be an array or object */
+    if(writer->depth == 0)
+        return writer_failed(writer);
+
+    return writer_element(writer, 0);
+}
+
+static int writer_begin(json_writer_t *writer, char container)
+{
+    if(writer_element(writer, 0))
+        return -1;
+
+    if(writer->depth == writer->stack_size) {
+        char *stack = realloc(writer->stack, writer->stack_size * 2);
+        if(!stack)
+            return writer_failed(writer);
+        writer->stack = stack;
+        writer->stack_size *= 2;
+    }
+
+    if(dump_to_writer(container == '{' ? "{" : "[", 1, writer))
+        return writer_failed(writer);
+
+    writer->stack[writer->depth++] = container;
+    writer->first = 1;
+    return 0;
+}
+
+static int writer_end(json_writer_t *writer, char container)
+{
+    if(writer->error)
+        return -1;
+
+    if(writer->depth == 0 || writer->stack[writer->depth - 1] != container ||
+       writer->keyed)
+        return writer_failed(writer);
+
+    writer->depth--;
+
+    /* an empty one is closed straight after it's opened */
+    if(!writer->first &&
+       dump_indent(writer->flags, writer->depth, 0, dump_to_writer, writer))
+        return writer_failed(writer);
+
+    if(dump_to_writer(container == '{' ? "}" : "]", 1, writer))
+        return writer_failed(writer);
+
+    writer->first = 0;
+    if(writer->depth == 0)
+        writer->done = 1;
+    return 0;
+}
+
+json_writer_t *json_writer_new(FILE *output, unsigned long flags)
+{
+    json_writer_t *writer = malloc(sizeof(json_writer_t));
+    if(!writer)
+        return NULL;
+
+    writer->buffer = malloc(WRITE_SIZE);
+    writer->stack = malloc(WRITER_DEPTH);
+    if(!writer->buffer || !writer->stack) {
+        free(writer->buffer);
+        free(writer->stack);
+        free(writer);
+        return NULL;
+    }
+
+    writer->stack_size = WRITER_DEPTH;
+    json_writer_reset(writer, output, flags);
+    return writer;
+}
+
+void json_writer_reset(json_writer_t *writer, FILE *output, unsigned long flags)
+{
+    writer->output = output;
+    writer->flags = flags;
+    writer->length = 0;
+    writer->depth = 0;
+    writer->first = 0;
+    writer->keyed = 0;
+    writer->done = 0;
+    writer->error = 0;
+}
+
+int json_writer_flush(json_writer_t *writer)
+{
+    if(writer->error || writer_flush(writer))
+        return writer_failed(writer);
+    return 0;
+}
+
+int json_writer_free(json_writer_t *writer)
+{
+    int result = 0;
+
+    if(!writer)
+        return -1;
+
+    if(json_writer_flush(writer) || !writer->done)
+        result = -1;
+
+    free(writer->buffer);
+    free(writer->stack);
+    free(writer);
+    return result;
+}
+
+int json_write_begin_object(json_writer_t *writer)
+{
+    return writer_begin(writer, '{');
+}
+
+int json_write_end_object(json_writer_t *writer)
+{
+    return writer_end(writer, '{');
+}
+
+int json_write_begin_array(json_writer_t *writer)
+{
+    return writer_begin(writer, '[');
+}
+
+int json_write_end_array(json_writer_t *writer)
+{
+    return writer_end(writer, '[');
+}
+
+int json_write_key(json_writer_t *writer, const char *key)
+{
+    int ascii = writer->flags & JSON_ENSURE_ASCII ? 1 : 0;
+    const char *separator = (writer->flags & JSON_COMPACT) ? ":" : ": ";
+
+    if(writer_element(writer, 1))
+        return -1;
+
+    if(dump_string(key, ascii, dump_to_writer, writer) ||
+       dump_to_writer(separator, strlen(separator), writer))
+        return writer_failed(writer);
+
+    writer->keyed = 1;
+    return 0;
+}
+
+int json_write_string(json_writer_t *writer, const char *value)
+{
+    int ascii = writer->flags & JSON_ENSURE_ASCII ? 1 : 0;
+
+    if(writer_scalar(writer) ||
+       dump_string(value, ascii, dump_to_writer, writer))
+        return writer_failed(writer);
+    return 0;
+}
+
+int json_write_integer(json_writer_t *writer, int value)
+{
+    if(writer_scalar(writer) || dump_integer(value, dump_to_writer, writer))
+        return writer_failed(writer);
+    return 0;
+}
+
+int json_write_real(json_writer_t *writer, double value)
+{
+    if(writer_scalar(writer) || dump_real(value, dump_to_writer, writer))
+        return writer_failed(writer);
+    return 0;
+}
+
+int json_write_boolean(json_writer_t *writer, int value)
+{
+    if(writer_scalar(writer) ||
+       (value ? dump_to_writer("true", 4, writer)
+              : dump_to_writer("false", 5, writer)))
+        return writer_failed(writer);
+    return 0;
+}
+
+int json_write_null(json_writer_t *writer)
+{
+    if(writer_scalar(writer) || dump_to_writer("null", 4, writer))
+        return writer_failed(writer);
+    return 0;
+}
+
+int json_write_value(json_writer_t *writer, const json_t *json)
+{
+    if(!json)
+        return writer_failed(writer);
+
+    if(json_is_array(json) || json_is_object(json)) {
+        if(writer_element(writer, 0))
+            return -1;
+    }
+    else if(writer_scalar(writer))
+        return -1;
+
+    if(do_dump(json, writer->flags, writer->depth, dump_to_writer, writer))
+        return writer_failed(writer);
+
+    if(writer->depth == 0)
+        writer->done = 1;
+    return 0;
+}
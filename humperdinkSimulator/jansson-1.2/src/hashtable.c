@@ -70,6 +70,19 @@ static inline unsigned int num_buckets(hashtable_t *hashtable)
     return primes[hashtable->num_buckets];
 }
 
+static inline void *table_alloc(hashtable_t *hashtable, size_t size)
+{
+    if(hashtable->alloc)
+        return hashtable->alloc(hashtable->alloc_data, size);
+    return malloc(size);
+}
+
+static inline void table_free(hashtable_t *hashtable, void *ptr)
+{
+    if(!hashtable->alloc)
+        free(ptr);
+}
+
 
 static pair_t *hashtable_find_pair(hashtable_t *hashtable, bucket_t *bucket,
                                    const void *key, unsigned int hash)
@@ -127,7 +140,7 @@ static int hashtable_do_del(hashtable_t *hashtable,
     if(hashtable->free_value)
         hashtable->free_value(pair->value);
 
-    free(pair);
+    table_free(hashtable, pair);
     hashtable->size--;
 
     return 0;
@@ -146,7 +159,7 @@ static void hashtable_do_clear(hashtable_t *hashtable)
             hashtable->free_key(pair->key);
         if(hashtable->free_value)
             hashtable->free_value(pair->value);
-        free(pair);
+        table_free(hashtable, pair);
     }
 }
 
@@ -156,12 +169,12 @@ static int hashtable_do_rehash(hashtable_t *hashtable)
     pair_t *pair;
     unsigned int i, index, new_size;
 
-    free(hashtable->buckets);
+    table_free(hashtable, hashtable->buckets);
 
     hashtable->num_buckets++;
     new_size = num_buckets(hashtable);
 
-    hashtable->buckets = malloc(new_size * sizeof(bucket_t));
+    hashtable->buckets = table_alloc(hashtable, new_size * sizeof(bucket_t));
     if(!hashtable->buckets)
         return -1;
 
@@ -210,12 +223,24 @@ void hashtable_destroy(hashtable_t *hashtable)
 int hashtable_init(hashtable_t *hashtable,
                    key_hash_fn hash_key, key_cmp_fn cmp_keys,
                    free_fn free_key, free_fn free_value)
+{
+    return hashtable_init_alloc(hashtable, hash_key, cmp_keys,
+                                free_key, free_value, NULL, NULL);
+}
+
+int hashtable_init_alloc(hashtable_t *hashtable,
+                         key_hash_fn hash_key, key_cmp_fn cmp_keys,
+                         free_fn free_key, free_fn free_value,
+                         alloc_fn alloc, void *alloc_data)
 {
     unsigned int i;
 
     hashtable->size = 0;
     hashtable->num_buckets = 0;  /* index to primes[] */
-    hashtable->buckets = malloc(num_buckets(hashtable) * sizeof(bucket_t));
+    hashtable->alloc = alloc;
+    hashtable->alloc_data = alloc_data;
+    hashtable->buckets = table_alloc(hashtable,
+                                     num_buckets(hashtable) * sizeof(bucket_t));
     if(!hashtable->buckets)
         return -1;
 
@@ -238,7 +263,7 @@ int hashtable_init(hashtable_t *hashtable,
 void hashtable_close(hashtable_t *hashtable)
 {
     hashtable_do_clear(hashtable);
-    free(hashtable->buckets);
+    table_free(hashtable, hashtable->buckets);
 }
 
 int hashtable_set(hashtable_t *hashtable, void *key, void *value)
@@ -257,7 +282,7 @@ int hashtable_set(hashtable_t *hashtable, void *key, void *value)
         if(hashtable_do_rehash(hashtable))
             return -1;
 
-    pair = malloc(sizeof(pair_t));
+    pair = table_alloc(hashtable, sizeof(pair_t));
     if(!pair)
         return -1;
 
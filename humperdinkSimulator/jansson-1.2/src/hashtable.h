@@ -8,9 +8,12 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 
+#include <stddef.h>
+
 typedef unsigned int (*key_hash_fn)(const void *key);
 typedef int (*key_cmp_fn)(const void *key1, const void *key2);
 typedef void (*free_fn)(void *key);
+typedef void *(*alloc_fn)(void *data, size_t size);
 
 struct hashtable_list {
     struct hashtable_list *prev;
@@ -39,6 +42,11 @@ typedef struct hashtable {
     key_cmp_fn cmp_keys;  /* returns non-zero for equal keys */
     free_fn free_key;
     free_fn free_value;
+
+    /* if non-NULL, pairs and buckets come from alloc and are never
+       freed one by one (the allocator frees them all at once) */
+    alloc_fn alloc;
+    void *alloc_data;
 } hashtable_t;
 
 /**
@@ -85,6 +93,22 @@ int hashtable_init(hashtable_t *hashtable,
                    key_hash_fn hash_key, key_cmp_fn cmp_keys,
                    free_fn free_key, free_fn free_value);
 
+/**
+ * hashtable_init_alloc - Initialize a hashtable object with an allocator
+ *
+ * @hashtable: The (statically allocated) hashtable object
+ * @hash_key, @cmp_keys, @free_key, @free_value: As for hashtable_init()
+ * @alloc: Called with @alloc_data to allocate the hashtable's pairs and
+ *     buckets, which are never passed to free(), or NULL for malloc()
+ * @alloc_data: Passed to @alloc
+ *
+ * Returns 0 on success, -1 on error (out of memory).
+ */
+int hashtable_init_alloc(hashtable_t *hashtable,
+                         key_hash_fn hash_key, key_cmp_fn cmp_keys,
+                         free_fn free_key, free_fn free_value,
+                         alloc_fn alloc, void *alloc_data);
+
 /**
  * hashtable_close - Release all resources used by a hashtable object
  *
@@ -73,6 +73,15 @@ static inline void json_decref(json_t *json)
 }
 
 
+/* arena allocation */
+
+typedef struct json_arena json_arena_t;
+
+json_arena_t *json_arena_new(void);
+void json_arena_clear(json_arena_t *arena);
+void json_arena_free(json_arena_t *arena);
+
+
 /* getters, setters, manipulation */
 
 unsigned int json_object_size(const json_t *object);
@@ -158,18 +167,78 @@ typedef struct {
 } json_error_t;
 
 json_t *json_loads(const char *input, json_error_t *error);
+json_t *json_loadb(const char *buffer, size_t buflen, json_error_t *error);
 json_t *json_loadf(FILE *input, json_error_t *error);
 json_t *json_load_file(const char *path, json_error_t *error);
 
+json_t *json_arena_loads(json_arena_t *arena, const char *input, json_error_t *error);
+json_t *json_arena_loadb(json_arena_t *arena, const char *buffer, size_t buflen, json_error_t *error);
+json_t *json_arena_loadf(json_arena_t *arena, FILE *input, json_error_t *error);
+json_t *json_arena_load_file(json_arena_t *arena, const char *path, json_error_t *error);
+
+/* events of a document as it's decoded, without building values: each
+   callback (any of them can be NULL) returns 0 to go on, or non-zero to
+   stop decoding. Strings are only valid during the call */
+
+typedef struct {
+    int (*start_object)(void *data);
+    int (*key)(void *data, const char *key);
+    int (*end_object)(void *data);
+    int (*start_array)(void *data);
+    int (*end_array)(void *data);
+    int (*string)(void *data, const char *value);
+    int (*integer)(void *data, int value);
+    int (*real)(void *data, double value);
+    int (*boolean)(void *data, int value);
+    int (*null)(void *data);
+} json_sax_t;
+
+int json_sax_loads(const char *input, const json_sax_t *sax, void *data, json_error_t *error);
+int json_sax_loadb(const char *buffer, size_t buflen, const json_sax_t *sax, void *data, json_error_t *error);
+int json_sax_loadf(FILE *input, const json_sax_t *sax, void *data, json_error_t *error);
+int json_sax_load_file(const char *path, const json_sax_t *sax, void *data, json_error_t *error);
+
+/* the double the text of a JSON number stands for, as strtod reads it
+   (with errno ERANGE if it overflows or underflows) */
+double json_real_parse(const char *text);
+
 #define JSON_INDENT(n)      (n & 0xFF)
 #define JSON_COMPACT        0x100
 #define JSON_ENSURE_ASCII   0x200
 #define JSON_SORT_KEYS      0x400
 
+/* the longest text json_real_str writes, with the terminator */
+#define JSON_REAL_STR_LENGTH  32
+
+int json_real_str(double value, char *buffer);
+
 char *json_dumps(const json_t *json, unsigned long flags);
 int json_dumpf(const json_t *json, FILE *output, unsigned long flags);
 int json_dump_file(const json_t *json, const char *path, unsigned long flags);
 
+/* writing a document a value at a time, without building it first:
+   into a buffer, written to output whenever it fills up, formatted as
+   json_dumpf formats it with the same flags */
+
+typedef struct json_writer json_writer_t;
+
+json_writer_t *json_writer_new(FILE *output, unsigned long flags);
+void json_writer_reset(json_writer_t *writer, FILE *output, unsigned long flags);
+int json_writer_flush(json_writer_t *writer);
+int json_writer_free(json_writer_t *writer);
+
+int json_write_begin_object(json_writer_t *writer);
+int json_write_end_object(json_writer_t *writer);
+int json_write_begin_array(json_writer_t *writer);
+int json_write_end_array(json_writer_t *writer);
+int json_write_key(json_writer_t *writer, const char *key);
+int json_write_string(json_writer_t *writer, const char *value);
+int json_write_integer(json_writer_t *writer, int value);
+int json_write_real(json_writer_t *writer, double value);
+int json_write_boolean(json_writer_t *writer, int value);
+int json_write_null(json_writer_t *writer);
+int json_write_value(json_writer_t *writer, const json_t *json);
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,9 +14,23 @@
 #define container_of(ptr_, type_, member_)  \
     ((type_ *)((char *)ptr_ - (size_t)&((type_ *)0)->member_))
 
+/* objects with up to this many keys keep them in a small array */
+#define OBJECT_SMALL_SIZE  8
+
+typedef struct {
+    char *key;
+    json_t *value;
+} object_pair_t;
+
 typedef struct {
     json_t json;
+    /* the pairs of a small object, in the order they were set, searched
+       linearly; once it outgrows small, the pairs are in hashtable */
+    int hashed;
+    unsigned int small_size;
+    object_pair_t small[OBJECT_SMALL_SIZE];
     hashtable_t hashtable;
+    json_arena_t *arena;
     int visited;
 } json_object_t;
 
@@ -25,6 +39,7 @@ typedef struct {
     unsigned int size;
     unsigned int entries;
     json_t **table;
+    json_arena_t *arena;
     int visited;
 } json_array_t;
 
@@ -49,4 +64,22 @@ typedef struct {
 #define json_to_real(json_)   container_of(json_, json_real_t, json)
 #define json_to_integer(json_) container_of(json_, json_integer_t, json)
 
+/* values in an arena have the refcount json_incref and json_decref
+   leave alone; objects, arrays and strings in an arena are read-only */
+#define ARENA_REFCOUNT          ((unsigned int)-1)
+#define json_in_arena(json_)    ((json_)->refcount == ARENA_REFCOUNT)
+
+void *jsonp_arena_alloc(json_arena_t *arena, size_t size);
+
+/* constructors and setters for the parser: values are allocated in
+   arena, or on the heap like json_object() etc. if it is NULL, and the
+   setters steal the reference to value (without the read-only check) */
+json_t *jsonp_object(json_arena_t *arena);
+json_t *jsonp_array(json_arena_t *arena);
+json_t *jsonp_string_nocheck(json_arena_t *arena, const char *value);
+json_t *jsonp_integer(json_arena_t *arena, int value);
+json_t *jsonp_real(json_arena_t *arena, double value);
+int jsonp_object_set_new_nocheck(json_t *object, const char *key, json_t *value);
+int jsonp_array_append_new(json_t *array, json_t *value);
+
 #endif
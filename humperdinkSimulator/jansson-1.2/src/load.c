@@ -21,6 +21,18 @@
 #include "strbuffer.h"
 #include "utf.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#define USE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#endif
+
+/* chunk size for reading a stream into memory */
+#define READ_SIZE 65536
+
 #define TOKEN_INVALID         -1
 #define TOKEN_EOF              0
 #define TOKEN_STRING         256
@@ -40,6 +52,14 @@ typedef struct {
     get_func get;
     eof_func eof;
     void *data;
+    /* input already in memory: read directly, without get and eof */
+    const char *input;
+    size_t input_length;
+    size_t input_pos;
+    int input_eof;
+    /* or read from file, a chunk at a time, into input */
+    FILE *file;
+    char *chunk;
     int stream_pos;
     char buffer[5];
     int buffer_pos;
@@ -49,6 +69,7 @@ typedef struct {
 typedef struct {
     stream_t stream;
     strbuffer_t saved_text;
+    json_arena_t *arena;  /* where values are allocated, or NULL */
     int token;
     int line, column;
     union {
@@ -119,18 +140,69 @@ void stream_init(stream_t *stream, get_func get, eof_func eof, void *data)
     stream->get = get;
     stream->eof = eof;
     stream->data = data;
+    stream->input = NULL;
+    stream->file = NULL;
+    stream->chunk = NULL;
     stream->stream_pos = 0;
     stream->buffer[0] = '\0';
     stream->buffer_pos = 0;
 }
 
+static void stream_init_input(stream_t *stream, const char *input, size_t length)
+{
+    stream_init(stream, NULL, NULL, NULL);
+    stream->input = input;
+    stream->input_length = length;
+    stream->input_pos = 0;
+    stream->input_eof = 0;
+}
+
+static void stream_init_file(stream_t *stream, FILE *file, char *chunk)
+{
+    stream_init_input(stream, chunk, 0);
+    stream->file = file;
+    stream->chunk = chunk;
+}
+
+/* the next chunk of a file: 0 if there isn't one */
+static int stream_refill(stream_t *stream)
+{
+    if(!stream->file)
+        return 0;
+
+    stream->input_length = fread(stream->chunk, 1, READ_SIZE, stream->file);
+    stream->input_pos = 0;
+    return stream->input_length > 0;
+}
+
+/* one byte as fgetc returns it, EOF at the end */
+static int stream_read(stream_t *stream)
+{
+    if(!stream->input)
+        return stream->get(stream->data);
+
+    if(stream->input_pos >= stream->input_length && !stream_refill(stream)) {
+        stream->input_eof = 1;
+        return EOF;
+    }
+    return (unsigned char)stream->input[stream->input_pos++];
+}
+
+static int stream_eof(stream_t *stream)
+{
+    if(!stream->input)
+        return stream->eof(stream->data);
+
+    return stream->input_eof;
+}
+
 static char stream_get(stream_t *stream, json_error_t *error)
 {
     char c;
 
     if(!stream->buffer[stream->buffer_pos])
     {
-        stream->buffer[0] = stream->get(stream->data);
+        stream->buffer[0] = stream_read(stream);
         stream->buffer_pos = 0;
 
         c = stream->buffer[0];
@@ -147,7 +219,7 @@ static char stream_get(stream_t *stream, json_error_t *error)
             assert(count >= 2);
 
             for(i = 1; i < count; i++)
-                stream->buffer[i] = stream->get(stream->data);
+                stream->buffer[i] = stream_read(stream);
 
             if(!utf8_check_full(stream->buffer, count, NULL))
                 goto out;
@@ -189,7 +261,7 @@ static int lex_get(lex_t *lex, json_error_t *error)
 
 static int lex_eof(lex_t *lex)
 {
-    return lex->stream.eof(lex->stream.data);
+    return stream_eof(&lex->stream);
 }
 
 static void lex_save(lex_t *lex, char c)
@@ -401,14 +473,137 @@ out:
     free(lex->value.string);
 }
 
-static int lex_scan_number(lex_t *lex, char c, json_error_t *error)
+/* the length of the number at text (its first character), or 0 if
+   there isn't a valid one before end */
+static size_t number_length(const char *text, const char *end, int *real)
+{
+    const char *p = text;
+
+    *real = 0;
+
+    if(p < end && *p == '-')
+        p++;
+
+    if(p < end && *p == '0') {
+        p++;
+        if(p < end && isdigit(*p))
+            return 0;
+    }
+    else if(p < end && isdigit(*p)) {
+        while(p < end && isdigit(*p))
+            p++;
+    }
+    else
+        return 0;
+
+    if(p < end && *p == '.') {
+        p++;
+        if(p == end || !isdigit(*p))
+            return 0;
+        while(p < end && isdigit(*p))
+            p++;
+        *real = 1;
+    }
+
+    if(p < end && (*p == 'E' || *p == 'e')) {
+        p++;
+        if(p < end && (*p == '+' || *p == '-'))
+            p++;
+        if(p == end || !isdigit(*p))
+            return 0;
+        while(p < end && isdigit(*p))
+            p++;
+        *real = 1;
+    }
+
+    return p - text;
+}
+
+/* a number from input in memory, its first character already read:
+   saves the rest of it and takes it from the input all at once.
+   Returns 0 if there isn't a valid one, to be scanned byte by byte */
+static size_t lex_take_number(lex_t *lex, int *real)
+{
+    stream_t *stream = &lex->stream;
+    const char *text;
+    size_t length;
+
+    if(!stream->input || stream->buffer[stream->buffer_pos] != '\0')
+        return 0;
+
+    text = stream->input + stream->input_pos - 1;
+    length = number_length(text, stream->input + stream->input_length, real);
+    if(length == 0)
+        return 0;
+
+    /* it may go on in the file's next chunk */
+    if(stream->file && text + length == stream->input + stream->input_length)
+        return 0;
+
+    strbuffer_append_bytes(&lex->saved_text, text + 1, length - 1);
+    stream->input_pos += length - 1;
+    stream->stream_pos += length - 1;
+    return length;
+}
+
+static int lex_number_integer(lex_t *lex, json_error_t *error)
 {
-    const char *saved_text;
+    const char *saved_text = strbuffer_value(&lex->saved_text);
     char *end;
+    long value;
+
+    errno = 0;
+    value = strtol(saved_text, &end, 10);
+    assert(end == saved_text + lex->saved_text.length);
+
+    if((value == LONG_MAX && errno == ERANGE) || value > INT_MAX) {
+        error_set(error, lex, "too big integer");
+        return -1;
+    }
+    else if((value == LONG_MIN && errno == ERANGE) || value < INT_MIN) {
+        error_set(error, lex, "too big negative integer");
+        return -1;
+    }
+
+    lex->token = TOKEN_INTEGER;
+    lex->value.integer = (int)value;
+    return 0;
+}
+
+static int lex_number_real(lex_t *lex, json_error_t *error)
+{
     double value;
 
+    errno = 0;
+    value = json_real_parse(strbuffer_value(&lex->saved_text));
+
+    if(value == 0 && errno == ERANGE) {
+        error_set(error, lex, "real number underflow");
+        return -1;
+    }
+
+    /* Cannot test for +/-HUGE_VAL because the HUGE_VAL constant is
+       only defined in C99 mode. So let's trust in sole errno. */
+    else if(errno == ERANGE) {
+        error_set(error, lex, "real number overflow");
+        return -1;
+    }
+
+    lex->token = TOKEN_REAL;
+    lex->value.real = value;
+    return 0;
+}
+
+static int lex_scan_number(lex_t *lex, char c, json_error_t *error)
+{
+    int real;
+
     lex->token = TOKEN_INVALID;
 
+    if(lex_take_number(lex, &real))
+        return real ? lex_number_real(lex, error)
+                    : lex_number_integer(lex, error);
+
     if(c == '-')
         c = lex_get_save(lex, error);
 
@@ -430,26 +625,8 @@ static int lex_scan_number(lex_t *lex, char c, json_error_t *error)
     }
 
     if(c != '.' && c != 'E' && c != 'e') {
-        long value;
-
         lex_unget_unsave(lex, c);
-
-        saved_text = strbuffer_value(&lex->saved_text);
-        value = strtol(saved_text, &end, 10);
-        assert(end == saved_text + lex->saved_text.length);
-
-        if((value == LONG_MAX && errno == ERANGE) || value > INT_MAX) {
-            error_set(error, lex, "too big integer");
-            goto out;
-        }
-        else if((value == LONG_MIN && errno == ERANGE) || value < INT_MIN) {
-            error_set(error, lex, "too big negative integer");
-            goto out;
-        }
-
-        lex->token = TOKEN_INTEGER;
-        lex->value.integer = (int)value;
-        return 0;
+        return lex_number_integer(lex, error);
     }
 
     if(c == '.') {
@@ -479,26 +656,7 @@ static int lex_scan_number(lex_t *lex, char c, json_error_t *error)
     }
 
     lex_unget_unsave(lex, c);
-
-    saved_text = strbuffer_value(&lex->saved_text);
-    value = strtod(saved_text, &end);
-    assert(end == saved_text + lex->saved_text.length);
-
-    if(value == 0 && errno == ERANGE) {
-        error_set(error, lex, "real number underflow");
-        goto out;
-    }
-
-    /* Cannot test for +/-HUGE_VAL because the HUGE_VAL constant is
-       only defined in C99 mode. So let's trust in sole errno. */
-    else if(errno == ERANGE) {
-        error_set(error, lex, "real number overflow");
-        goto out;
-    }
-
-    lex->token = TOKEN_REAL;
-    lex->value.real = value;
-    return 0;
+    return lex_number_real(lex, error);
 
 out:
     return -1;
@@ -594,6 +752,33 @@ static int lex_init(lex_t *lex, get_func get, eof_func eof, void *data)
     if(strbuffer_init(&lex->saved_text))
         return -1;
 
+    lex->arena = NULL;
+    lex->token = TOKEN_INVALID;
+    lex->line = 1;
+
+    return 0;
+}
+
+static int lex_init_input(lex_t *lex, const char *input, size_t length)
+{
+    stream_init_input(&lex->stream, input, length);
+    if(strbuffer_init(&lex->saved_text))
+        return -1;
+
+    lex->arena = NULL;
+    lex->token = TOKEN_INVALID;
+    lex->line = 1;
+
+    return 0;
+}
+
+static int lex_init_file(lex_t *lex, FILE *file, char *chunk)
+{
+    stream_init_file(&lex->stream, file, chunk);
+    if(strbuffer_init(&lex->saved_text))
+        return -1;
+
+    lex->arena = NULL;
     lex->token = TOKEN_INVALID;
     lex->line = 1;
 
@@ -614,7 +799,7 @@ static json_t *parse_value(lex_t *lex, json_error_t *error);
 
 static json_t *parse_object(lex_t *lex, json_error_t *error)
 {
-    json_t *object = json_object();
+    json_t *object = jsonp_object(lex->arena);
     if(!object)
         return NULL;
 
@@ -649,13 +834,11 @@ static json_t *parse_object(lex_t *lex, json_error_t *error)
             goto error;
         }
 
-        if(json_object_set_nocheck(object, key, value)) {
+        if(jsonp_object_set_new_nocheck(object, key, value)) {
             free(key);
-            json_decref(value);
             goto error;
         }
 
-        json_decref(value);
         free(key);
 
         lex_scan(lex, error);
@@ -679,7 +862,7 @@ error:
 
 static json_t *parse_array(lex_t *lex, json_error_t *error)
 {
-    json_t *array = json_array();
+    json_t *array = jsonp_array(lex->arena);
     if(!array)
         return NULL;
 
@@ -692,11 +875,8 @@ static json_t *parse_array(lex_t *lex, json_error_t *error)
         if(!elem)
             goto error;
 
-        if(json_array_append(array, elem)) {
-            json_decref(elem);
+        if(jsonp_array_append_new(array, elem))
             goto error;
-        }
-        json_decref(elem);
 
         lex_scan(lex, error);
         if(lex->token != ',')
@@ -723,17 +903,17 @@ static json_t *parse_value(lex_t *lex, json_error_t *error)
 
     switch(lex->token) {
         case TOKEN_STRING: {
-            json = json_string_nocheck(lex->value.string);
+            json = jsonp_string_nocheck(lex->arena, lex->value.string);
             break;
         }
 
         case TOKEN_INTEGER: {
-            json = json_integer(lex->value.integer);
+            json = jsonp_integer(lex->arena, lex->value.integer);
             break;
         }
 
         case TOKEN_REAL: {
-            json = json_real(lex->value.real);
+            json = jsonp_real(lex->arena, lex->value.real);
             break;
         }
 
@@ -785,6 +965,164 @@ static json_t *parse_json(lex_t *lex, json_error_t *error)
     return parse_value(lex, error);
 }
 
+
+/*** event parser ***/
+
+/* a callback, if there is one: 1 if it stops the parse, otherwise 0 */
+#define sax_event(sax, event, ...) \
+    ((sax)->event && (sax)->event(__VA_ARGS__) ? 1 : 0)
+
+/* the parsers below return 0, -1 on error, or 1 if a callback stopped
+   them */
+
+static int sax_parse_value(lex_t *lex, const json_sax_t *sax, void *data,
+                           json_error_t *error);
+
+static int sax_parse_object(lex_t *lex, const json_sax_t *sax, void *data,
+                            json_error_t *error)
+{
+    int result;
+
+    if(sax_event(sax, start_object, data))
+        return 1;
+
+    lex_scan(lex, error);
+    if(lex->token == '}')
+        return sax_event(sax, end_object, data);
+
+    while(1) {
+        if(lex->token != TOKEN_STRING) {
+            error_set(error, lex, "string or '}' expected");
+            return -1;
+        }
+
+        if(sax_event(sax, key, data, lex->value.string))
+            return 1;
+
+        lex_scan(lex, error);
+        if(lex->token != ':') {
+            error_set(error, lex, "':' expected");
+            return -1;
+        }
+
+        lex_scan(lex, error);
+        result = sax_parse_value(lex, sax, data, error);
+        if(result)
+            return result;
+
+        lex_scan(lex, error);
+        if(lex->token != ',')
+            break;
+
+        lex_scan(lex, error);
+    }
+
+    if(lex->token != '}') {
+        error_set(error, lex, "'}' expected");
+        return -1;
+    }
+
+    return sax_event(sax, end_object, data);
+}
+
+static int sax_parse_array(lex_t *lex, const json_sax_t *sax, void *data,
+                           json_error_t *error)
+{
+    int result;
+
+    if(sax_event(sax, start_array, data))
+        return 1;
+
+    lex_scan(lex, error);
+    if(lex->token == ']')
+        return sax_event(sax, end_array, data);
+
+    while(lex->token) {
+        result = sax_parse_value(lex, sax, data, error);
+        if(result)
+            return result;
+
+        lex_scan(lex, error);
+        if(lex->token != ',')
+            break;
+
+        lex_scan(lex, error);
+    }
+
+    if(lex->token != ']') {
+        error_set(error, lex, "']' expected");
+        return -1;
+    }
+
+    return sax_event(sax, end_array, data);
+}
+
+static int sax_parse_value(lex_t *lex, const json_sax_t *sax, void *data,
+                           json_error_t *error)
+{
+    switch(lex->token) {
+        case TOKEN_STRING:
+            return sax_event(sax, string, data, lex->value.string);
+
+        case TOKEN_INTEGER:
+            return sax_event(sax, integer, data, lex->value.integer);
+
+        case TOKEN_REAL:
+            return sax_event(sax, real, data, lex->value.real);
+
+        case TOKEN_TRUE:
+            return sax_event(sax, boolean, data, 1);
+
+        case TOKEN_FALSE:
+            return sax_event(sax, boolean, data, 0);
+
+        case TOKEN_NULL:
+            return sax_event(sax, null, data);
+
+        case '{':
+            return sax_parse_object(lex, sax, data, error);
+
+        case '[':
+            return sax_parse_array(lex, sax, data, error);
+
+        case TOKEN_INVALID:
+            error_set(error, lex, "invalid token");
+            return -1;
+
+        default:
+            error_set(error, lex, "unexpected token");
+            return -1;
+    }
+}
+
+/* a whole JSON text, as parse_json and the end of file check after it */
+static int sax_parse_json(lex_t *lex, const json_sax_t *sax, void *data,
+                          json_error_t *error)
+{
+    int result;
+
+    error_init(error);
+
+    lex_scan(lex, error);
+    if(lex->token != '[' && lex->token != '{') {
+        error_set(error, lex, "'[' or '{' expected");
+        return -1;
+    }
+
+    result = sax_parse_value(lex, sax, data, error);
+    if(result)
+        return result;
+
+    lex_scan(lex, error);
+    if(lex->token != TOKEN_EOF) {
+        error_set(error, lex, "end of file expected");
+        return -1;
+    }
+
+    return 0;
+}
+
+
 typedef struct
 {
     const char *data;
@@ -812,6 +1150,29 @@ static int string_eof(void *data)
 }
 
 json_t *json_loads(const char *string, json_error_t *error)
+{
+    return json_arena_loads(NULL, string, error);
+}
+
+json_t *json_loadb(const char *buffer, size_t buflen, json_error_t *error)
+{
+    return json_arena_loadb(NULL, buffer, buflen, error);
+}
+
+json_t *json_loadf(FILE *input, json_error_t *error)
+{
+    return json_arena_loadf(NULL, input, error);
+}
+
+json_t *json_load_file(const char *path, json_error_t *error)
+{
+    return json_arena_load_file(NULL, path, error);
+}
+
+/* the same, with the values allocated in arena (if it isn't NULL) */
+
+json_t *json_arena_loads(json_arena_t *arena, const char *string,
+                         json_error_t *error)
 {
     lex_t lex;
     json_t *result;
@@ -823,6 +1184,7 @@ json_t *json_loads(const char *string, json_error_t *error)
 
     if(lex_init(&lex, string_get, string_eof, (void *)&stream_data))
         return NULL;
+    lex.arena = arena;
 
     result = parse_json(&lex, error);
     if(!result)
@@ -840,13 +1202,15 @@ out:
     return result;
 }
 
-json_t *json_loadf(FILE *input, json_error_t *error)
+json_t *json_arena_loadb(json_arena_t *arena, const char *buffer,
+                         size_t buflen, json_error_t *error)
 {
     lex_t lex;
     json_t *result;
 
-    if(lex_init(&lex, (get_func)fgetc, (eof_func)feof, input))
+    if(lex_init_input(&lex, buffer, buflen))
         return NULL;
+    lex.arena = arena;
 
     result = parse_json(&lex, error);
     if(!result)
@@ -864,7 +1228,40 @@ out:
     return result;
 }
 
-json_t *json_load_file(const char *path, json_error_t *error)
+json_t *json_arena_loadf(json_arena_t *arena, FILE *input,
+                         json_error_t *error)
+{
+    json_t *result;
+    char *buffer;
+    size_t length = 0, size = READ_SIZE, count;
+
+    /* read the rest of the stream in bulk (parsing reads to its end
+       anyway) instead of a byte at a time */
+    buffer = malloc(size);
+    if(!buffer)
+        return NULL;
+
+    while((count = fread(buffer + length, 1, size - length, input)) > 0) {
+        length += count;
+        if(length == size) {
+            char *bigger = realloc(buffer, size * 2);
+            if(!bigger) {
+                free(buffer);
+                return NULL;
+            }
+            buffer = bigger;
+            size *= 2;
+        }
+    }
+
+    result = json_arena_loadb(arena, buffer, length, error);
+
+    free(buffer);
+    return result;
+}
+
+json_t *json_arena_load_file(json_arena_t *arena, const char *path,
+                             json_error_t *error)
 {
     json_t *result;
     FILE *fp;
@@ -879,7 +1276,96 @@ json_t *json_load_file(const char *path, json_error_t *error)
         return NULL;
     }
 
-    result = json_loadf(fp, error);
+#ifdef USE_MMAP
+    {
+        /* map regular files instead of reading them */
+        struct stat st;
+        if(fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) &&
+           st.st_size > 0)
+        {
+            void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                             fileno(fp), 0);
+            if(map != MAP_FAILED)
+            {
+                result = json_arena_loadb(arena, map, st.st_size, error);
+                munmap(map, st.st_size);
+                fclose(fp);
+                return result;
+            }
+        }
+    }
+#endif
+
+    result = json_arena_loadf(arena, fp, error);
+
+    fclose(fp);
+    return result;
+}
+
+/* the same, as events, without building values */
+
+int json_sax_loads(const char *string, const json_sax_t *sax, void *data,
+                   json_error_t *error)
+{
+    return json_sax_loadb(string, strlen(string), sax, data, error);
+}
+
+int json_sax_loadb(const char *buffer, size_t buflen, const json_sax_t *sax,
+                   void *data, json_error_t *error)
+{
+    lex_t lex;
+    int result;
+
+    if(lex_init_input(&lex, buffer, buflen))
+        return -1;
+
+    result = sax_parse_json(&lex, sax, data, error);
+
+    lex_close(&lex);
+    return result;
+}
+
+int json_sax_loadf(FILE *input, const json_sax_t *sax, void *data,
+                   json_error_t *error)
+{
+    lex_t lex;
+    int result;
+
+    /* the stream is read a chunk at a time, so however long it is,
+       only a chunk and the current token are in memory */
+    char *chunk = malloc(READ_SIZE);
+    if(!chunk)
+        return -1;
+
+    if(lex_init_file(&lex, input, chunk)) {
+        free(chunk);
+        return -1;
+    }
+
+    result = sax_parse_json(&lex, sax, data, error);
+
+    lex_close(&lex);
+    free(chunk);
+    return result;
+}
+
+int json_sax_load_file(const char *path, const json_sax_t *sax, void *data,
+                       json_error_t *error)
+{
+    int result;
+    FILE *fp;
+
+    error_init(error);
+
+    fp = fopen(path, "r");
+    if(!fp)
+    {
+        error_set(error, NULL, "unable to open %s: %s",
+                  path, strerror(errno));
+        return -1;
+    }
+
+    result = json_sax_loadf(fp, sax, data, error);
 
     fclose(fp);
     return result;
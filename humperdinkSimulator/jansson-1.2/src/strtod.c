@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2009 Petri Lehtinen <petri@digip.org>
+ *
+ * Jansson is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+/*
+ * Decimal to double conversion of JSON numbers. Most reals in JSON
+ * texts are short decimals like 3.14 or 0.4, whose digits fit in a
+ * double's significand and whose power of ten is exactly a double too:
+ * one multiplication or division then rounds correctly, with no need
+ * for strtod (William D. Clinger, "How to Read Floating Point Numbers
+ * Accurately", PLDI 1990). Everything else is left to strtod.
+ */
+
+#include <float.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <jansson.h>
+
+/* the largest integer whose neighbours are all doubles, 2^53 */
+#define MAX_EXACT_INTEGER  9007199254740992ULL
+
+/* the most digits accumulated, so the significand can't overflow */
+#define MAX_DIGITS  19
+
+/* 10^22 is the largest power of ten that is exactly a double */
+#define MAX_EXACT_POWER  22
+
+/* exponents are accumulated up to here, far beyond any double's */
+#define MAX_EXPONENT  100000
+
+static const double exact_powers[MAX_EXACT_POWER + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+double json_real_parse(const char *text)
+{
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    const char *p = text;
+    uint64_t significand = 0;
+    int digits = 0;
+    int exponent = 0;
+    int negative = 0;
+    double value;
+
+    if(*p == '-') {
+        negative = 1;
+        p++;
+    }
+
+    /* leading zeros aren't counted as digits */
+    for(; *p >= '0' && *p <= '9'; p++) {
+        if(digits == MAX_DIGITS)
+            return strtod(text, NULL);
+        significand = significand * 10 + (*p - '0');
+        digits += (significand != 0);
+    }
+
+    if(*p == '.') {
+        for(p++; *p >= '0' && *p <= '9'; p++) {
+            if(digits == MAX_DIGITS)
+                return strtod(text, NULL);
+            significand = significand * 10 + (*p - '0');
+            digits += (significand != 0);
+            exponent--;
+        }
+    }
+
+    if(*p == 'e' || *p == 'E') {
+        int explicit = 0;
+        int exponent_negative = 0;
+
+        p++;
+        if(*p == '+' || *p == '-')
+            exponent_negative = (*p++ == '-');
+
+        for(; *p >= '0' && *p <= '9'; p++) {
+            if(explicit < MAX_EXPONENT)
+                explicit = explicit * 10 + (*p - '0');
+        }
+
+        exponent += exponent_negative ? -explicit : explicit;
+    }
+
+    /* not a whole JSON number: as strtod would read it */
+    if(*p != '\0')
+        return strtod(text, NULL);
+
+    if(significand == 0)
+        return negative ? -0.0 : 0.0;
+
+    if(significand > MAX_EXACT_INTEGER ||
+       exponent < -MAX_EXACT_POWER || exponent > MAX_EXACT_POWER)
+        return strtod(text, NULL);
+
+    /* both exact, so one correctly rounded operation */
+    value = (double)significand;
+    if(exponent < 0)
+        value /= exact_powers[-exponent];
+    else
+        value *= exact_powers[exponent];
+
+    return negative ? -value : value;
+#else
+    /* with excess precision, the operation above would round twice */
+    return strtod(text, NULL);
+#endif
+}
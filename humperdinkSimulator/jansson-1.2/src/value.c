@@ -16,10 +16,145 @@
 #include "util.h"
 
 
-static inline void json_init(json_t *json, json_type type)
+static inline void json_init(json_t *json, json_type type,
+                             json_arena_t *arena)
 {
     json->type = type;
-    json->refcount = 1;
+    json->refcount = arena ? ARENA_REFCOUNT : 1;
+}
+
+static inline void *json_malloc(json_arena_t *arena, size_t size)
+{
+    return arena ? jsonp_arena_alloc(arena, size) : malloc(size);
+}
+
+static inline void json_free(json_arena_t *arena, void *ptr)
+{
+    if(!arena)
+        free(ptr);
+}
+
+
+/*** arena ***/
+
+/* the first block's size: each block after it is twice as large as the
+   one before (or as large as the allocation that needed it) */
+#define ARENA_BLOCK_SIZE  4096
+#define ARENA_ALIGN       8
+
+#define arena_round(size_)  \
+    (((size_) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;
+} arena_block_t;
+
+struct json_arena {
+    arena_block_t *block;  /* the newest block, allocated from */
+    size_t used;           /* bytes used in block */
+};
+
+#define block_data(block_)  \
+    ((char *)(block_) + arena_round(sizeof(arena_block_t)))
+
+json_arena_t *json_arena_new(void)
+{
+    json_arena_t *arena = malloc(sizeof(json_arena_t));
+    if(!arena)
+        return NULL;
+
+    arena->block = NULL;
+    arena->used = 0;
+
+    return arena;
+}
+
+void json_arena_clear(json_arena_t *arena)
+{
+    arena_block_t *block, *next;
+    size_t total = 0;
+
+    if(!arena)
+        return;
+
+    /* replace several blocks with one that holds as much, so the next
+       document of the same size needs no more allocations */
+    if(arena->block && arena->block->next)
+    {
+        for(block = arena->block; block; block = next) {
+            next = block->next;
+            total += block->size;
+            free(block);
+        }
+
+        arena->block = malloc(arena_round(sizeof(arena_block_t)) + total);
+        if(arena->block) {
+            arena->block->next = NULL;
+            arena->block->size = total;
+        }
+    }
+
+    arena->used = 0;
+}
+
+void json_arena_free(json_arena_t *arena)
+{
+    arena_block_t *block, *next;
+
+    if(!arena)
+        return;
+
+    for(block = arena->block; block; block = next) {
+        next = block->next;
+        free(block);
+    }
+    free(arena);
+}
+
+void *jsonp_arena_alloc(json_arena_t *arena, size_t size)
+{
+    void *ptr;
+
+    size = arena_round(size);
+
+    if(!arena->block || arena->used + size > arena->block->size)
+    {
+        arena_block_t *block;
+        size_t block_size = arena->block ? arena->block->size * 2
+                                         : ARENA_BLOCK_SIZE;
+        if(block_size < size)
+            block_size = size;
+
+        block = malloc(arena_round(sizeof(arena_block_t)) + block_size);
+        if(!block)
+            return NULL;
+
+        block->next = arena->block;
+        block->size = block_size;
+        arena->block = block;
+        arena->used = 0;
+    }
+
+    ptr = block_data(arena->block) + arena->used;
+    arena->used += size;
+
+    return ptr;
+}
+
+/* for the hashtables of objects in an arena */
+static void *arena_alloc(void *arena, size_t size)
+{
+    return jsonp_arena_alloc((json_arena_t *)arena, size);
+}
+
+static char *arena_strdup(json_arena_t *arena, const char *value)
+{
+    size_t length = strlen(value) + 1;
+    char *copy = jsonp_arena_alloc(arena, length);
+    if(copy)
+        memcpy(copy, value, length);
+    return copy;
 }
 
 
@@ -50,28 +185,98 @@ static void value_decref(void *value)
     json_decref((json_t *)value);
 }
 
-json_t *json_object(void)
+/* iterators of small objects point to their pairs, with the lowest bit
+   set to tell them from the iterators of hashtables */
+#define small_iter(pair_)       ((void *)((char *)(pair_) + 1))
+#define is_small_iter(iter_)    (((size_t)(iter_) & 1) != 0)
+#define small_iter_pair(iter_)  ((object_pair_t *)((char *)(iter_) - 1))
+
+json_t *jsonp_object(json_arena_t *arena)
 {
-    json_object_t *object = malloc(sizeof(json_object_t));
+    json_object_t *object = json_malloc(arena, sizeof(json_object_t));
     if(!object)
         return NULL;
-    json_init(&object->json, JSON_OBJECT);
+    json_init(&object->json, JSON_OBJECT, arena);
 
-    if(hashtable_init(&object->hashtable, hash_string, string_equal,
-                      free, value_decref))
-    {
-        free(object);
-        return NULL;
-    }
+    /* the hashtable is only set up when the object outgrows small */
+    object->hashed = 0;
+    object->small_size = 0;
 
+    object->arena = arena;
     object->visited = 0;
 
     return &object->json;
 }
 
+json_t *json_object(void)
+{
+    return jsonp_object(NULL);
+}
+
+static void object_clear_small(json_object_t *object)
+{
+    unsigned int i;
+
+    for(i = 0; i < object->small_size; i++) {
+        json_free(object->arena, object->small[i].key);
+        json_decref(object->small[i].value);
+    }
+    object->small_size = 0;
+}
+
+/* moves the pairs of a full small object into its hashtable */
+static int object_to_hashtable(json_object_t *object)
+{
+    json_arena_t *arena = object->arena;
+    unsigned int i;
+
+    /* in an arena, keys and values are freed with it */
+    if(hashtable_init_alloc(&object->hashtable, hash_string, string_equal,
+                            arena ? NULL : free,
+                            arena ? NULL : value_decref,
+                            arena ? arena_alloc : NULL, arena))
+        return -1;
+
+    for(i = 0; i < object->small_size; i++) {
+        if(hashtable_set(&object->hashtable, object->small[i].key,
+                         object->small[i].value))
+        {
+            /* the pairs are still in small: close without freeing them */
+            object->hashtable.free_key = NULL;
+            object->hashtable.free_value = NULL;
+            hashtable_close(&object->hashtable);
+            return -1;
+        }
+    }
+
+    object->small_size = 0;
+    object->hashed = 1;
+
+    return 0;
+}
+
+static object_pair_t *object_find_small(json_object_t *object,
+                                        const char *key)
+{
+    unsigned int i;
+
+    /* most keys differ in their first character */
+    for(i = 0; i < object->small_size; i++) {
+        const char *small_key = object->small[i].key;
+        if(small_key[0] == key[0] && strcmp(small_key, key) == 0)
+            return &object->small[i];
+    }
+
+    return NULL;
+}
+
 static void json_delete_object(json_object_t *object)
 {
-    hashtable_close(&object->hashtable);
+    if(object->hashed)
+        hashtable_close(&object->hashtable);
+    else
+        object_clear_small(object);
+
     free(object);
 }
 
@@ -83,23 +288,30 @@ unsigned int json_object_size(const json_t *json)
         return -1;
 
     object = json_to_object(json);
-    return object->hashtable.size;
+    return object->hashed ? object->hashtable.size : object->small_size;
 }
 
 json_t *json_object_get(const json_t *json, const char *key)
 {
     json_object_t *object;
+    object_pair_t *pair;
 
     if(!json_is_object(json))
         return NULL;
 
     object = json_to_object(json);
-    return hashtable_get(&object->hashtable, key);
+    if(object->hashed)
+        return hashtable_get(&object->hashtable, key);
+
+    pair = object_find_small(object, key);
+    return pair ? pair->value : NULL;
 }
 
-int json_object_set_new_nocheck(json_t *json, const char *key, json_t *value)
+int jsonp_object_set_new_nocheck(json_t *json, const char *key, json_t *value)
 {
     json_object_t *object;
+    object_pair_t *pair;
+    char *copy;
 
     if(!key || !value)
         return -1;
@@ -111,15 +323,60 @@ int json_object_set_new_nocheck(json_t *json, const char *key, json_t *value)
     }
     object = json_to_object(json);
 
-    if(hashtable_set(&object->hashtable, strdup(key), value))
+    if(!object->hashed)
+    {
+        /* an existing key keeps its place */
+        pair = object_find_small(object, key);
+        if(pair) {
+            json_decref(pair->value);
+            pair->value = value;
+            return 0;
+        }
+
+        if(object->small_size == OBJECT_SMALL_SIZE &&
+           object_to_hashtable(object))
+        {
+            json_decref(value);
+            return -1;
+        }
+    }
+
+    copy = object->arena ? arena_strdup(object->arena, key) : strdup(key);
+    if(!copy)
     {
         json_decref(value);
         return -1;
     }
 
+    if(!object->hashed)
+    {
+        pair = &object->small[object->small_size++];
+        pair->key = copy;
+        pair->value = value;
+        return 0;
+    }
+
+    if(hashtable_set(&object->hashtable, copy, value))
+    {
+        json_free(object->arena, copy);
+        json_decref(value);
+        return -1;
+    }
+
     return 0;
 }
 
+int json_object_set_new_nocheck(json_t *json, const char *key, json_t *value)
+{
+    if(json && json_in_arena(json))
+    {
+        json_decref(value);
+        return -1;
+    }
+
+    return jsonp_object_set_new_nocheck(json, key, value);
+}
+
 int json_object_set_new(json_t *json, const char *key, json_t *value)
 {
     if(!key || !utf8_check_string(key, -1))
@@ -134,23 +391,44 @@ int json_object_set_new(json_t *json, const char *key, json_t *value)
 int json_object_del(json_t *json, const char *key)
 {
     json_object_t *object;
+    object_pair_t *pair;
+    unsigned int index;
 
-    if(!json_is_object(json))
+    if(!json_is_object(json) || json_in_arena(json))
         return -1;
 
     object = json_to_object(json);
-    return hashtable_del(&object->hashtable, key);
+    if(object->hashed)
+        return hashtable_del(&object->hashtable, key);
+
+    pair = object_find_small(object, key);
+    if(!pair)
+        return -1;
+
+    free(pair->key);
+    json_decref(pair->value);
+
+    /* the rest keep their order */
+    index = pair - object->small;
+    memmove(pair, pair + 1,
+            (object->small_size - index - 1) * sizeof(object_pair_t));
+    object->small_size--;
+
+    return 0;
 }
 
 int json_object_clear(json_t *json)
 {
     json_object_t *object;
 
-    if(!json_is_object(json))
+    if(!json_is_object(json) || json_in_arena(json))
         return -1;
 
     object = json_to_object(json);
-    hashtable_clear(&object->hashtable);
+    if(object->hashed)
+        hashtable_clear(&object->hashtable);
+    else
+        object_clear_small(object);
 
     return 0;
 }
@@ -187,18 +465,29 @@ void *json_object_iter(json_t *json)
         return NULL;
 
     object = json_to_object(json);
-    return hashtable_iter(&object->hashtable);
+    if(object->hashed)
+        return hashtable_iter(&object->hashtable);
+
+    return object->small_size ? small_iter(&object->small[0]) : NULL;
 }
 
 void *json_object_iter_next(json_t *json, void *iter)
 {
     json_object_t *object;
+    object_pair_t *next;
 
     if(!json_is_object(json) || iter == NULL)
         return NULL;
 
     object = json_to_object(json);
-    return hashtable_iter_next(&object->hashtable, iter);
+    if(!is_small_iter(iter))
+        return hashtable_iter_next(&object->hashtable, iter);
+
+    next = small_iter_pair(iter) + 1;
+    if(next >= &object->small[object->small_size])
+        return NULL;
+
+    return small_iter(next);
 }
 
 const char *json_object_iter_key(void *iter)
@@ -206,6 +495,9 @@ const char *json_object_iter_key(void *iter)
     if(!iter)
         return NULL;
 
+    if(is_small_iter(iter))
+        return small_iter_pair(iter)->key;
+
     return (const char *)hashtable_iter_key(iter);
 }
 
@@ -214,6 +506,9 @@ json_t *json_object_iter_value(void *iter)
     if(!iter)
         return NULL;
 
+    if(is_small_iter(iter))
+        return small_iter_pair(iter)->value;
+
     return (json_t *)hashtable_iter_value(iter);
 }
 
@@ -296,27 +591,33 @@ static json_t *json_object_deep_copy(json_t *object)
 
 /*** array ***/
 
-json_t *json_array(void)
+json_t *jsonp_array(json_arena_t *arena)
 {
-    json_array_t *array = malloc(sizeof(json_array_t));
+    json_array_t *array = json_malloc(arena, sizeof(json_array_t));
     if(!array)
         return NULL;
-    json_init(&array->json, JSON_ARRAY);
+    json_init(&array->json, JSON_ARRAY, arena);
 
     array->entries = 0;
     array->size = 8;
 
-    array->table = malloc(array->size * sizeof(json_t *));
+    array->table = json_malloc(arena, array->size * sizeof(json_t *));
     if(!array->table) {
-        free(array);
+        json_free(arena, array);
         return NULL;
     }
 
+    array->arena = arena;
     array->visited = 0;
 
     return &array->json;
 }
 
+json_t *json_array(void)
+{
+    return jsonp_array(NULL);
+}
+
 static void json_delete_array(json_array_t *array)
 {
     unsigned int i;
@@ -356,7 +657,7 @@ int json_array_set_new(json_t *json, unsigned int index, json_t *value)
     if(!value)
         return -1;
 
-    if(!json_is_array(json) || json == value)
+    if(!json_is_array(json) || json == value || json_in_arena(json))
     {
         json_decref(value);
         return -1;
@@ -401,7 +702,7 @@ static json_t **json_array_grow(json_array_t *array,
     old_table = array->table;
 
     new_size = max(array->size + amount, array->size * 2);
-    new_table = malloc(new_size * sizeof(json_t *));
+    new_table = json_malloc(array->arena, new_size * sizeof(json_t *));
     if(!new_table)
         return NULL;
 
@@ -410,14 +711,14 @@ static json_t **json_array_grow(json_array_t *array,
 
     if(copy) {
         array_copy(array->table, 0, old_table, 0, array->entries);
-        free(old_table);
+        json_free(array->arena, old_table);
         return array->table;
     }
 
     return old_table;
 }
 
-int json_array_append_new(json_t *json, json_t *value)
+int jsonp_array_append_new(json_t *json, json_t *value)
 {
     json_array_t *array;
 
@@ -442,6 +743,17 @@ int json_array_append_new(json_t *json, json_t *value)
     return 0;
 }
 
+int json_array_append_new(json_t *json, json_t *value)
+{
+    if(json && json_in_arena(json))
+    {
+        json_decref(value);
+        return -1;
+    }
+
+    return jsonp_array_append_new(json, value);
+}
+
 int json_array_insert_new(json_t *json, unsigned int index, json_t *value)
 {
     json_array_t *array;
@@ -450,7 +762,7 @@ int json_array_insert_new(json_t *json, unsigned int index, json_t *value)
     if(!value)
         return -1;
 
-    if(!json_is_array(json) || json == value) {
+    if(!json_is_array(json) || json == value || json_in_arena(json)) {
         json_decref(value);
         return -1;
     }
@@ -471,7 +783,7 @@ int json_array_insert_new(json_t *json, unsigned int index, json_t *value)
         array_copy(array->table, 0, old_table, 0, index);
         array_copy(array->table, index + 1, old_table, index,
                    array->entries - index);
-        free(old_table);
+        json_free(array->arena, old_table);
     }
     else
         array_move(array, index + 1, index, array->entries - index);
@@ -486,7 +798,7 @@ int json_array_remove(json_t *json, unsigned int index)
 {
     json_array_t *array;
 
-    if(!json_is_array(json))
+    if(!json_is_array(json) || json_in_arena(json))
         return -1;
     array = json_to_array(json);
 
@@ -506,7 +818,7 @@ int json_array_clear(json_t *json)
     json_array_t *array;
     unsigned int i;
 
-    if(!json_is_array(json))
+    if(!json_is_array(json) || json_in_arena(json))
         return -1;
     array = json_to_array(json);
 
@@ -522,7 +834,8 @@ int json_array_extend(json_t *json, json_t *other_json)
     json_array_t *array, *other;
     unsigned int i;
 
-    if(!json_is_array(json) || !json_is_array(other_json))
+    if(!json_is_array(json) || !json_is_array(other_json) ||
+       json_in_arena(json))
         return -1;
     array = json_to_array(json);
     other = json_to_array(other_json);
@@ -593,17 +906,32 @@ static json_t *json_array_deep_copy(json_t *array)
 
 /*** string ***/
 
-json_t *json_string_nocheck(const char *value)
+json_t *jsonp_string_nocheck(json_arena_t *arena, const char *value)
 {
     json_string_t *string;
+    size_t length;
 
     if(!value)
         return NULL;
 
+    if(arena) {
+        /* the value right after the string */
+        length = strlen(value) + 1;
+        string = jsonp_arena_alloc(arena, sizeof(json_string_t) + length);
+        if(!string)
+            return NULL;
+        json_init(&string->json, JSON_STRING, arena);
+
+        string->value = (char *)(string + 1);
+        memcpy(string->value, value, length);
+
+        return &string->json;
+    }
+
     string = malloc(sizeof(json_string_t));
     if(!string)
         return NULL;
-    json_init(&string->json, JSON_STRING);
+    json_init(&string->json, JSON_STRING, NULL);
 
     string->value = strdup(value);
     if(!string->value) {
@@ -614,6 +942,11 @@ json_t *json_string_nocheck(const char *value)
     return &string->json;
 }
 
+json_t *json_string_nocheck(const char *value)
+{
+    return jsonp_string_nocheck(NULL, value);
+}
+
 json_t *json_string(const char *value)
 {
     if(!value || !utf8_check_string(value, -1))
@@ -635,6 +968,9 @@ int json_string_set_nocheck(json_t *json, const char *value)
     char *dup;
     json_string_t *string;
 
+    if(!json_is_string(json) || json_in_arena(json))
+        return -1;
+
     dup = strdup(value);
     if(!dup)
         return -1;
@@ -673,17 +1009,22 @@ static json_t *json_string_copy(json_t *string)
 
 /*** integer ***/
 
-json_t *json_integer(int value)
+json_t *jsonp_integer(json_arena_t *arena, int value)
 {
-    json_integer_t *integer = malloc(sizeof(json_integer_t));
+    json_integer_t *integer = json_malloc(arena, sizeof(json_integer_t));
     if(!integer)
         return NULL;
-    json_init(&integer->json, JSON_INTEGER);
+    json_init(&integer->json, JSON_INTEGER, arena);
 
     integer->value = value;
     return &integer->json;
 }
 
+json_t *json_integer(int value)
+{
+    return jsonp_integer(NULL, value);
+}
+
 int json_integer_value(const json_t *json)
 {
     if(!json_is_integer(json))
@@ -720,17 +1061,22 @@ static json_t *json_integer_copy(json_t *integer)
 
 /*** real ***/
 
-json_t *json_real(double value)
+json_t *jsonp_real(json_arena_t *arena, double value)
 {
-    json_real_t *real = malloc(sizeof(json_real_t));
+    json_real_t *real = json_malloc(arena, sizeof(json_real_t));
     if(!real)
         return NULL;
-    json_init(&real->json, JSON_REAL);
+    json_init(&real->json, JSON_REAL, arena);
 
     real->value = value;
     return &real->json;
 }
 
+json_t *json_real(double value)
+{
+    return jsonp_real(NULL, value);
+}
+
 double json_real_value(const json_t *json)
 {
     if(!json_is_real(json))
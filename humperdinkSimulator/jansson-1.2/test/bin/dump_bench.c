@@ -0,0 +1,182 @@
+/*
+ * Encoding benchmark: writes a trajectory (an array of samples, each an
+ * object of a time and a position) to a file by building it as values
+ * and encoding it with json_dumpf, and with a writer (json_writer_new),
+ * a sample at a time, and checks that both files are the same. Building
+ * the values is timed separately from encoding them.
+ *
+ * usage: dump_bench [samples [rounds]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <jansson.h>
+
+#define DUMPF_FILE  "dump_bench_dumpf.json"
+#define WRITER_FILE "dump_bench_writer.json"
+
+#define NUM_FLAGS 2
+
+static const unsigned long flag_values[NUM_FLAGS] = {JSON_COMPACT, JSON_INDENT(2)};
+static const char *flag_names[NUM_FLAGS] = {"JSON_COMPACT", "JSON_INDENT(2)"};
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* a position along a wobbling path */
+static void sample(int i, double *t, double *x, double *y)
+{
+    *t = i / 60.0;
+    *x = 0.37 * i + 5.0 * (i % 17) / 17.0;
+    *y = 20.0 + (i % 23) / 7.0;
+}
+
+static json_t *build(int samples)
+{
+    json_t *array = json_array();
+    int i;
+
+    for(i = 0; i < samples; i++) {
+        json_t *object = json_object();
+        double t, x, y;
+
+        sample(i, &t, &x, &y);
+        json_object_set_new(object, "t", json_real(t));
+        json_object_set_new(object, "x", json_real(x));
+        json_object_set_new(object, "y", json_real(y));
+        json_array_append_new(array, object);
+    }
+
+    return array;
+}
+
+static int write_samples(FILE *output, int samples, unsigned long flags)
+{
+    json_writer_t *writer = json_writer_new(output, flags);
+    int i;
+
+    if(!writer)
+        return -1;
+
+    json_write_begin_array(writer);
+    for(i = 0; i < samples; i++) {
+        double t, x, y;
+
+        sample(i, &t, &x, &y);
+        json_write_begin_object(writer);
+        json_write_key(writer, "t");
+        json_write_real(writer, t);
+        json_write_key(writer, "x");
+        json_write_real(writer, x);
+        json_write_key(writer, "y");
+        json_write_real(writer, y);
+        json_write_end_object(writer);
+    }
+    json_write_end_array(writer);
+
+    return json_writer_free(writer);
+}
+
+/* non-zero if the files differ */
+static int compare_files(const char *path1, const char *path2, long *length)
+{
+    FILE *file1 = fopen(path1, "rb"), *file2 = fopen(path2, "rb");
+    int c1, c2, different = 0;
+
+    *length = 0;
+    if(!file1 || !file2)
+        different = 1;
+
+    while(!different) {
+        c1 = getc(file1);
+        c2 = getc(file2);
+        if(c1 != c2)
+            different = 1;
+        else if(c1 == EOF)
+            break;
+        (*length)++;
+    }
+
+    if(file1)
+        fclose(file1);
+    if(file2)
+        fclose(file2);
+    return different;
+}
+
+int main(int argc, char *argv[])
+{
+    int samples = 1000000, rounds = 3, f, r;
+    int different = 0;
+
+    if(argc > 1)
+        samples = atoi(argv[1]);
+    if(argc > 2)
+        rounds = atoi(argv[2]);
+    if(samples <= 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [samples [rounds]]\n", argv[0]);
+        return 2;
+    }
+
+    printf("%d samples, %d rounds\n\n", samples, rounds);
+    printf("%-16s %10s %10s %10s %10s %10s %8s\n", "flags", "building",
+           "dumpf", "freeing", "writer", "MB/s", "speedup");
+
+    for(f = 0; f < NUM_FLAGS; f++) {
+        double build_seconds = 0, dump_seconds = 0, free_seconds = 0;
+        double writer_seconds = 0;
+        long length;
+
+        for(r = 0; r < rounds; r++) {
+            FILE *output;
+            json_t *json;
+            double start = now();
+
+            json = build(samples);
+            build_seconds += now() - start;
+
+            output = fopen(DUMPF_FILE, "w");
+            start = now();
+            if(!output || json_dumpf(json, output, flag_values[f])) {
+                fprintf(stderr, "unable to write %s\n", DUMPF_FILE);
+                return 1;
+            }
+            fclose(output);
+            dump_seconds += now() - start;
+
+            start = now();
+            json_decref(json);
+            free_seconds += now() - start;
+
+            output = fopen(WRITER_FILE, "w");
+            start = now();
+            if(!output || write_samples(output, samples, flag_values[f])) {
+                fprintf(stderr, "unable to write %s\n", WRITER_FILE);
+                return 1;
+            }
+            fclose(output);
+            writer_seconds += now() - start;
+        }
+
+        if(compare_files(DUMPF_FILE, WRITER_FILE, &length)) {
+            fprintf(stderr, "%s: the files differ\n", flag_names[f]);
+            different++;
+        }
+
+        printf("%-16s %10.3f %10.3f %10.3f %10.3f %10.1f %8.2f\n",
+               flag_names[f], build_seconds, dump_seconds, free_seconds,
+               writer_seconds, rounds * length / 1e6 / writer_seconds,
+               (build_seconds + dump_seconds + free_seconds) / writer_seconds);
+    }
+
+    remove(DUMPF_FILE);
+    remove(WRITER_FILE);
+
+    return different ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Parse throughput benchmark: decodes the same document through the
+ * per-character callback path (json_loads) and the in-memory paths
+ * (json_loadb, json_loadf and json_load_file), and into an arena
+ * (json_arena_loadb), and checks that they all decode it the same way.
+ * Freeing the document (json_decref, or json_arena_clear) is timed
+ * separately. It's also read as events (json_sax_loadb and
+ * json_sax_load_file), counting the reals, without building values.
+ *
+ * usage: load_bench [objects [rounds]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <jansson.h>
+
+#define TEMP_FILE "load_bench.json"
+
+#define NUM_PATHS 7
+#define FIRST_SAX_PATH 5
+
+static int count_real(void *data, double value)
+{
+    (*(int *)data)++;
+    return 0;
+}
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* an array of objects much like a population of genomes */
+static json_t *create_document(int objects)
+{
+    json_t *array = json_array();
+    unsigned int seed = 1;
+    int i, j;
+
+    for(i = 0; i < objects; i++) {
+        json_t *object = json_object();
+        json_t *children = json_array();
+
+        json_object_set_new(object, "angle", json_real(rand_r(&seed) / (double)RAND_MAX));
+        json_object_set_new(object, "length", json_real(10.0 + rand_r(&seed) % 300 / 10.0));
+        json_object_set_new(object, "name", json_string("limb \"\\u00e9\" \xc3\xa9"));
+        for(j = 0; j < 4; j++)
+            json_array_append_new(children, json_integer(rand_r(&seed) % 1000));
+        json_object_set_new(object, "connections", children);
+
+        json_array_append_new(array, object);
+    }
+
+    return array;
+}
+
+int main(int argc, char *argv[])
+{
+    int objects = 20000, rounds = 5, i, r;
+    const char *names[NUM_PATHS] = {"json_loads", "json_loadb", "json_loadf",
+                                    "json_load_file", "json_arena_loadb",
+                                    "json_sax_loadb", "json_sax_load_file"};
+    double seconds[NUM_PATHS] = {0};
+    double free_seconds[NUM_PATHS] = {0};
+    json_sax_t sax = {NULL};
+    int reals;
+    json_arena_t *arena = json_arena_new();
+    int different = 0;
+    json_t *document, *loaded;
+    json_error_t error;
+    char *text;
+    size_t length;
+    FILE *file;
+
+    if(argc > 1)
+        objects = atoi(argv[1]);
+    if(argc > 2)
+        rounds = atoi(argv[2]);
+    if(objects <= 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [objects [rounds]]\n", argv[0]);
+        return 2;
+    }
+
+    document = create_document(objects);
+    text = json_dumps(document, JSON_INDENT(2));
+    length = strlen(text);
+
+    file = fopen(TEMP_FILE, "w");
+    if(!file || fwrite(text, 1, length, file) != length) {
+        fprintf(stderr, "unable to write %s\n", TEMP_FILE);
+        return 1;
+    }
+    fclose(file);
+
+    sax.real = count_real;
+
+    for(r = 0; r < rounds; r++) {
+        for(i = 0; i < NUM_PATHS; i++) {
+            double start = now();
+
+            if(i >= FIRST_SAX_PATH) {
+                int result;
+
+                reals = 0;
+                if(i == FIRST_SAX_PATH)
+                    result = json_sax_loadb(text, length, &sax, &reals, &error);
+                else
+                    result = json_sax_load_file(TEMP_FILE, &sax, &reals, &error);
+                seconds[i] += now() - start;
+
+                /* each object has an angle and a length */
+                if(result != 0 || reals != 2 * objects) {
+                    fprintf(stderr, "%s: %s\n", names[i],
+                            result ? error.text : "wrong number of reals");
+                    different++;
+                }
+                continue;
+            }
+
+            switch(i) {
+                case 0:
+                    loaded = json_loads(text, &error);
+                    break;
+                case 1:
+                    loaded = json_loadb(text, length, &error);
+                    break;
+                case 2:
+                    file = fopen(TEMP_FILE, "r");
+                    loaded = json_loadf(file, &error);
+                    fclose(file);
+                    break;
+                case 3:
+                    loaded = json_load_file(TEMP_FILE, &error);
+                    break;
+                default:
+                    loaded = json_arena_loadb(arena, text, length, &error);
+                    break;
+            }
+
+            seconds[i] += now() - start;
+
+            if(!loaded || !json_equal(loaded, document)) {
+                fprintf(stderr, "%s: %s\n", names[i],
+                        loaded ? "decoded differently" : error.text);
+                different++;
+            }
+
+            start = now();
+            if(i == 4)
+                json_arena_clear(arena);
+            else
+                json_decref(loaded);
+            free_seconds[i] += now() - start;
+        }
+    }
+
+    remove(TEMP_FILE);
+
+    printf("%d objects, %lu bytes, %d rounds\n\n", objects,
+           (unsigned long)length, rounds);
+    printf("%-18s %10s %10s %10s\n", "path", "seconds", "MB/s", "freeing");
+    for(i = 0; i < NUM_PATHS; i++)
+        printf("%-18s %10.3f %10.1f %10.3f\n", names[i], seconds[i],
+               rounds * length / 1e6 / seconds[i], free_seconds[i]);
+
+    json_arena_free(arena);
+    free(text);
+    json_decref(document);
+
+    return different ? 1 : 0;
+}
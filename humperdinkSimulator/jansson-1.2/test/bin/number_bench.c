@@ -0,0 +1,154 @@
+/*
+ * Number parsing benchmark: decodes documents that are nearly all
+ * numbers with json_loadb -- short decimals like a genome's parameters,
+ * reals written in full (shortest round-trip) precision, and integers --
+ * and converts the same numbers one at a time with strtod and with
+ * json_real_parse. Every real decoded is checked against strtod.
+ *
+ * usage: number_bench [numbers [rounds]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <jansson.h>
+
+#define NUM_KINDS 3
+
+static const char *kind_names[NUM_KINDS] = {"short", "full", "integer"};
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* the text of a random number of a kind */
+static void write_number(int kind, unsigned int *seed, char *buffer)
+{
+    double value;
+
+    switch(kind) {
+        case 0:
+            snprintf(buffer, JSON_REAL_STR_LENGTH, "%s%d.%02d",
+                     rand_r(seed) % 2 ? "-" : "", rand_r(seed) % 100,
+                     rand_r(seed) % 100);
+            break;
+        case 1:
+            value = (rand_r(seed) / (double)RAND_MAX - 0.5) * 1000.0;
+            json_real_str(value, buffer);
+            break;
+        default:
+            snprintf(buffer, JSON_REAL_STR_LENGTH, "%d", rand_r(seed) % 100000);
+            break;
+    }
+}
+
+/* numbers, each terminated, in one block, and as a JSON array */
+static char *create_numbers(int kind, int count, char **document)
+{
+    char *numbers = malloc(count * JSON_REAL_STR_LENGTH);
+    char *text = malloc(count * (JSON_REAL_STR_LENGTH + 1) + 3);
+    char *end = text;
+    unsigned int seed = 1;
+    int i;
+
+    *end++ = '[';
+    for(i = 0; i < count; i++) {
+        char *number = numbers + i * JSON_REAL_STR_LENGTH;
+        size_t length;
+
+        write_number(kind, &seed, number);
+        length = strlen(number);
+        memcpy(end, number, length);
+        end += length;
+        *end++ = (i + 1 < count) ? ',' : ']';
+    }
+    *end = '\0';
+
+    *document = text;
+    return numbers;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 200000, rounds = 5, kind, i, r;
+    json_arena_t *arena = json_arena_new();
+    int different = 0;
+
+    if(argc > 1)
+        count = atoi(argv[1]);
+    if(argc > 2)
+        rounds = atoi(argv[2]);
+    if(count <= 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [numbers [rounds]]\n", argv[0]);
+        return 2;
+    }
+
+    printf("%d numbers per document, %d rounds\n\n", count, rounds);
+    printf("%-8s %10s %10s %12s %12s %8s\n", "numbers", "loadb MB/s",
+           "arena MB/s", "strtod /s", "parse /s", "speedup");
+
+    for(kind = 0; kind < NUM_KINDS; kind++) {
+        double load_seconds = 0, arena_seconds = 0;
+        double strtod_seconds = 0, parse_seconds = 0;
+        volatile double sink = 0;
+        char *document;
+        char *numbers = create_numbers(kind, count, &document);
+        size_t length = strlen(document);
+        json_error_t error;
+        json_t *loaded;
+
+        for(r = 0; r < rounds; r++) {
+            double start = now();
+            loaded = json_loadb(document, length, &error);
+            load_seconds += now() - start;
+
+            if(!loaded || (int)json_array_size(loaded) != count) {
+                fprintf(stderr, "%s: %s\n", kind_names[kind],
+                        loaded ? "wrong size" : error.text);
+                return 1;
+            }
+            if(r == 0) {
+                for(i = 0; i < count; i++) {
+                    json_t *value = json_array_get(loaded, i);
+                    if(json_number_value(value) !=
+                       strtod(numbers + i * JSON_REAL_STR_LENGTH, NULL))
+                        different++;
+                }
+            }
+            json_decref(loaded);
+
+            start = now();
+            loaded = json_arena_loadb(arena, document, length, &error);
+            arena_seconds += now() - start;
+            json_arena_clear(arena);
+
+            start = now();
+            for(i = 0; i < count; i++)
+                sink += strtod(numbers + i * JSON_REAL_STR_LENGTH, NULL);
+            strtod_seconds += now() - start;
+
+            start = now();
+            for(i = 0; i < count; i++)
+                sink += json_real_parse(numbers + i * JSON_REAL_STR_LENGTH);
+            parse_seconds += now() - start;
+        }
+
+        printf("%-8s %10.1f %10.1f %12.0f %12.0f %8.2f\n", kind_names[kind],
+               rounds * length / 1e6 / load_seconds,
+               rounds * length / 1e6 / arena_seconds,
+               rounds * count / strtod_seconds, rounds * count / parse_seconds,
+               strtod_seconds / parse_seconds);
+
+        free(numbers);
+        free(document);
+    }
+
+    printf("\nnumbers decoded differently from strtod: %d\n", different);
+
+    json_arena_free(arena);
+    return different ? 1 : 0;
+}
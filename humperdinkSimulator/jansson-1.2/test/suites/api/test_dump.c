@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2009 Petri Lehtinen <petri@digip.org>
+ *
+ * Jansson is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+#include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util.h"
+
+static FILE *open_temporary(void)
+{
+    FILE *file = tmpfile();
+    if(!file)
+        fail("unable to create a temporary file");
+    return file;
+}
+
+/* everything written to file, which is then closed */
+static char *contents(FILE *file)
+{
+    long length = ftell(file);
+    char *text = malloc(length + 1);
+
+    if(!text)
+        fail("unable to allocate the file's contents");
+
+    rewind(file);
+    if(fread(text, 1, length, file) != (size_t)length)
+        fail("unable to read the file's contents");
+    text[length] = '\0';
+
+    fclose(file);
+    return text;
+}
+
+/* a decoded document's events, written straight back out */
+static int on_start_object(void *data) { return json_write_begin_object(data); }
+static int on_key(void *data, const char *key) { return json_write_key(data, key); }
+static int on_end_object(void *data) { return json_write_end_object(data); }
+static int on_start_array(void *data) { return json_write_begin_array(data); }
+static int on_end_array(void *data) { return json_write_end_array(data); }
+static int on_string(void *data, const char *value) { return json_write_string(data, value); }
+static int on_integer(void *data, int value) { return json_write_integer(data, value); }
+static int on_real(void *data, double value) { return json_write_real(data, value); }
+static int on_boolean(void *data, int value) { return json_write_boolean(data, value); }
+static int on_null(void *data) { return json_write_null(data); }
+
+static void test_same_as_dumps(void)
+{
+    const char *texts[] = {
+        "[]", "{}", "[[], {}, [[]]]",
+        "[1, -2, 3.5, 1e22, 0.1, true, false, null, \"a\\\"b\\n\\u00e9\"]",
+        "{\"angle\": 0.5, \"connections\": [{\"length\": 40.0, "
+        "\"connections\": []}, {\"x\": [1, [2, {\"y\": {}}]]}]}",
+        "[\"\\ud834\\udd1e\", {\"\\u00e9\": \"\\u0001\"}]"
+    };
+    unsigned long flags[] = {0, JSON_COMPACT, JSON_INDENT(2),
+                             JSON_INDENT(3) | JSON_COMPACT, JSON_ENSURE_ASCII,
+                             JSON_INDENT(1) | JSON_ENSURE_ASCII};
+    json_sax_t sax = {on_start_object, on_key, on_end_object, on_start_array,
+                      on_end_array, on_string, on_integer, on_real,
+                      on_boolean, on_null};
+    json_writer_t *writer;
+    json_error_t error;
+    FILE *file;
+    unsigned int i, j;
+
+    for(i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        json_t *json = json_loads(texts[i], &error);
+        if(!json)
+            fail("unable to decode a test document");
+
+        for(j = 0; j < sizeof(flags) / sizeof(flags[0]); j++) {
+            char *expected = json_dumps(json, flags[j]);
+            char *written;
+
+            /* a value at a time */
+            file = open_temporary();
+            writer = json_writer_new(file, flags[j]);
+            if(!writer)
+                fail("json_writer_new failed");
+            if(json_sax_loads(texts[i], &sax, writer, &error) != 0)
+                fail("the writer failed to write a document");
+            if(json_writer_free(writer))
+                fail("json_writer_free failed on a finished document");
+
+            written = contents(file);
+            if(strcmp(written, expected) != 0)
+                fail("the writer wrote differently from json_dumps");
+            free(written);
+
+            /* a whole value */
+            file = open_temporary();
+            writer = json_writer_new(file, flags[j]);
+            if(json_write_value(writer, json) || json_writer_free(writer))
+                fail("json_write_value failed");
+
+            written = contents(file);
+            if(strcmp(written, expected) != 0)
+                fail("json_write_value wrote differently from json_dumps");
+            free(written);
+
+            free(expected);
+        }
+
+        json_decref(json);
+    }
+}
+
+static void test_long(void)
+{
+    json_t *json = json_array();
+    json_writer_t *writer;
+    char *expected, *written;
+    FILE *file;
+    int i;
+
+    file = open_temporary();
+
+    /* several buffers' worth, and a value bigger than a buffer */
+    writer = json_writer_new(file, JSON_INDENT(2));
+    json_write_begin_array(writer);
+    for(i = 0; i < 20000; i++) {
+        json_array_append_new(json, json_real(i / 7.0));
+        json_write_real(writer, i / 7.0);
+    }
+    {
+        char *big = malloc(100000);
+        memset(big, 'x', 99999);
+        big[99999] = '\0';
+        json_array_append_new(json, json_string(big));
+        json_write_string(writer, big);
+        free(big);
+    }
+    json_write_end_array(writer);
+    if(json_writer_free(writer))
+        fail("the writer failed to write a long document");
+
+    expected = json_dumps(json, JSON_INDENT(2));
+    written = contents(file);
+    if(strcmp(written, expected) != 0)
+        fail("the writer wrote a long document differently from json_dumps");
+
+    free(expected);
+    free(written);
+    json_decref(json);
+}
+
+static void test_misuse(void)
+{
+    json_writer_t *writer;
+    FILE *file;
+
+    file = open_temporary();
+    writer = json_writer_new(file, 0);
+
+    /* the document must be an array or object */
+    if(json_write_integer(writer, 1) != -1)
+        fail("the writer wrote a number outside an array or object");
+
+    /* and once something fails, so does everything after it */
+    if(json_write_begin_array(writer) != -1)
+        fail("the writer went on after an error");
+
+    json_writer_reset(writer, file, 0);
+    json_write_begin_object(writer);
+    if(json_write_integer(writer, 1) != -1)
+        fail("the writer wrote an object's value without a key");
+
+    json_writer_reset(writer, file, 0);
+    json_write_begin_array(writer);
+    if(json_write_key(writer, "a") != -1)
+        fail("the writer wrote a key in an array");
+
+    json_writer_reset(writer, file, 0);
+    json_write_begin_object(writer);
+    json_write_key(writer, "a");
+    if(json_write_key(writer, "b") != -1)
+        fail("the writer wrote a key without a value");
+
+    json_writer_reset(writer, file, 0);
+    json_write_begin_object(writer);
+    json_write_key(writer, "a");
+    if(json_write_end_object(writer) != -1)
+        fail("the writer ended an object with a key and no value");
+
+    json_writer_reset(writer, file, 0);
+    json_write_begin_array(writer);
+    if(json_write_end_object(writer) != -1)
+        fail("the writer ended an array as an object");
+
+    json_writer_reset(writer, file, 0);
+    json_write_begin_array(writer);
+    json_write_end_array(writer);
+    if(json_write_begin_array(writer) != -1)
+        fail("the writer wrote a second document");
+
+    /* a document that isn't finished */
+    json_writer_reset(writer, file, 0);
+    json_write_begin_array(writer);
+    if(json_writer_free(writer) != -1)
+        fail("json_writer_free succeeded on an unfinished document");
+
+    fclose(file);
+}
+
+int main()
+{
+    test_same_as_dumps();
+    test_long();
+    test_misuse();
+
+    return 0;
+}
@@ -6,9 +6,210 @@
  */
 
 #include <jansson.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 #include "util.h"
 
+static void test_arena(void)
+{
+    const char *text = "{\"angle\": 0.5, \"name\": \"limb\", "
+                       "\"connections\": [1, {\"a\": [true, null]}, \"x\"]}";
+    json_arena_t *arena;
+    json_t *json, *heap, *copy, *big;
+    json_error_t error;
+    char *dumped;
+    int i;
+
+    arena = json_arena_new();
+    if(!arena)
+        fail("json_arena_new failed");
+
+    json = json_arena_loads(arena, text, &error);
+    heap = json_loads(text, &error);
+    if(!json || !heap || !json_equal(json, heap))
+        fail("json_arena_loads decoded differently from json_loads");
+
+    /* references are not counted, and values can't be changed */
+    json_incref(json);
+    json_decref(json);
+    json_decref(json);
+    if(json_object_size(json) != 3)
+        fail("json_decref freed an arena value");
+
+    if(json_object_set_new(json, "length", json_real(1.0)) != -1)
+        fail("json_object_set_new changed an arena object");
+    if(json_object_del(json, "angle") != -1)
+        fail("json_object_del changed an arena object");
+    if(json_array_append_new(json_object_get(json, "connections"),
+                             json_integer(2)) != -1)
+        fail("json_array_append_new changed an arena array");
+    if(json_string_set(json_object_get(json, "name"), "other") != -1)
+        fail("json_string_set changed an arena string");
+    if(!json_equal(json, heap))
+        fail("an arena value was changed");
+
+    /* copies are on the heap, and outlive the arena */
+    copy = json_deep_copy(json);
+    if(json_object_set_new(copy, "length", json_real(1.0)))
+        fail("json_object_set_new failed on a copy of an arena object");
+    json_object_del(copy, "length");
+
+    dumped = json_dumps(json, JSON_COMPACT | JSON_SORT_KEYS);
+    if(!dumped || strcmp(dumped, "{\"angle\":0.5,\"connections\":[1,{\"a\":"
+                         "[true,null]},\"x\"],\"name\":\"limb\"}") != 0)
+        fail("json_dumps printed an arena value differently");
+    free(dumped);
+
+    /* errors are reported as without an arena */
+    json = json_arena_loadb(arena, "{\"a\":\n [1,\n 2 3]}", 17, &error);
+    if(json || error.line != 3 ||
+       strcmp(error.text, "']' expected near '3'") != 0)
+        fail("json_arena_loadb reported a different error");
+
+    /* a document that needs several blocks, then again after clearing */
+    big = json_array();
+    for(i = 0; i < 10000; i++)
+        json_array_append_new(big, json_deep_copy(heap));
+    dumped = json_dumps(big, 0);
+
+    for(i = 0; i < 2; i++) {
+        json_arena_clear(arena);
+        json = json_arena_loads(arena, dumped, &error);
+        if(!json || !json_equal(json, big))
+            fail("json_arena_loads decoded a large document differently");
+    }
+    free(dumped);
+
+    json_arena_free(arena);
+
+    if(!json_equal(copy, heap))
+        fail("a copy of an arena value didn't outlive the arena");
+
+    json_decref(copy);
+    json_decref(big);
+    json_decref(heap);
+
+    /* without an arena, loading is the same as json_loads */
+    json = json_arena_loads(NULL, text, &error);
+    if(!json || json->refcount != 1)
+        fail("json_arena_loads without an arena didn't use the heap");
+    json_decref(json);
+}
+
+/* events, written one after another into a buffer */
+typedef struct {
+    char text[512];
+    int reals;
+    int stop_at;
+} events_t;
+
+static int event(events_t *events, const char *format, ...)
+{
+    size_t length = strlen(events->text);
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(events->text + length, sizeof(events->text) - length, format, ap);
+    va_end(ap);
+    return 0;
+}
+
+static int on_start_object(void *data) { return event(data, "{"); }
+static int on_key(void *data, const char *key) { return event(data, "%s:", key); }
+static int on_end_object(void *data) { return event(data, "}"); }
+static int on_start_array(void *data) { return event(data, "["); }
+static int on_end_array(void *data) { return event(data, "]"); }
+static int on_string(void *data, const char *value) { return event(data, "'%s' ", value); }
+static int on_integer(void *data, int value) { return event(data, "%d ", value); }
+static int on_boolean(void *data, int value) { return event(data, value ? "true " : "false "); }
+static int on_null(void *data) { return event(data, "null "); }
+
+static int on_real(void *data, double value)
+{
+    events_t *events = data;
+    event(events, "%g ", value);
+    return ++events->reals == events->stop_at;
+}
+
+/* the sum of the reals, to compare with a decoded document */
+static int add_real(void *data, double value)
+{
+    *(double *)data += value;
+    return 0;
+}
+
+static void test_sax(void)
+{
+    const char *text = "{\"angle\": 0.5, \"name\": \"limb\", "
+                       "\"connections\": [1, {\"a\": [true, null]}, false, 2.5]}";
+    const char *invalid[] = {"[1, 2", "{\"a\" 1}", "[1, 2]]", "[01]",
+                             "{\"a\": [1,\n 2 3]}", "[\"a\nb\"]", "\"a\""};
+    json_sax_t sax = {on_start_object, on_key, on_end_object, on_start_array,
+                      on_end_array, on_string, on_integer, on_real,
+                      on_boolean, on_null};
+    json_sax_t sum = {NULL};
+    events_t events;
+    json_error_t error, dom_error;
+    json_t *json;
+    double total, expected;
+    FILE *file;
+    unsigned int i;
+
+    memset(&events, 0, sizeof(events));
+    if(json_sax_loads(text, &sax, &events, &error) != 0)
+        fail("json_sax_loads failed on a valid document");
+    if(strcmp(events.text, "{angle:0.5 name:'limb' connections:"
+                           "[1 {a:[true null ]}false 2.5 ]}") != 0)
+        fail("json_sax_loads gave the wrong events");
+
+    /* a callback stops it */
+    memset(&events, 0, sizeof(events));
+    events.stop_at = 1;
+    if(json_sax_loads(text, &sax, &events, &error) != 1)
+        fail("json_sax_loads didn't stop when a callback returned non-zero");
+    if(strcmp(events.text, "{angle:0.5 ") != 0)
+        fail("json_sax_loads went on after a callback stopped it");
+
+    /* the same errors as json_loads */
+    for(i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        json = json_loads(invalid[i], &dom_error);
+        if(json || json_sax_loads(invalid[i], &sum, &total, &error) != -1)
+            fail("json_sax_loads succeeded on an invalid document");
+        if(error.line != dom_error.line || strcmp(error.text, dom_error.text) != 0)
+            fail("json_sax_loads gave a different error from json_loads");
+    }
+
+    if(json_sax_load_file("/path/to/nonexistent/file.json", &sum, &total, &error) != -1 ||
+       error.line != -1)
+        fail("json_sax_load_file opened a nonexistent file");
+
+    /* a file longer than a chunk, with numbers across chunk boundaries */
+    file = tmpfile();
+    if(!file)
+        fail("unable to create a temporary file");
+    fputc('[', file);
+    for(i = 0; i < 20000; i++)
+        fprintf(file, "%s%u.%u", i ? ", " : "", i, i % 97);
+    fputc(']', file);
+
+    rewind(file);
+    json = json_loadf(file, &error);
+    if(!json || json_array_size(json) != 20000)
+        fail("json_loadf failed on a long file");
+    expected = 0.0;
+    for(i = 0; i < json_array_size(json); i++)
+        expected += json_real_value(json_array_get(json, i));
+    json_decref(json);
+
+    sum.real = add_real;
+    total = 0.0;
+    rewind(file);
+    if(json_sax_loadf(file, &sum, &total, &error) != 0 || total != expected)
+        fail("json_sax_loadf read a long file differently from json_loadf");
+    fclose(file);
+}
+
 int main()
 {
     json_t *json;
@@ -20,5 +221,28 @@ int main()
     if(strcmp(error.text, "unable to open /path/to/nonexistent/file.json: No such file or directory") != 0)
         fail("json_load_file returned an invalid error message");
 
+    /* json_loadb reads only buflen bytes, no terminator needed */
+    json = json_loadb("[1, 2]garbage", 6, &error);
+    if(!json || json_array_size(json) != 2)
+        fail("json_loadb failed on a valid buffer");
+    json_decref(json);
+
+    json = json_loadb("{\"a\":\n [1,\n 2 3]}", 17, &error);
+    if(json)
+        fail("json_loadb succeeded on an invalid buffer");
+    if(error.line != 3)
+        fail("json_loadb returned an invalid line number");
+    if(strcmp(error.text, "']' expected near '3'") != 0)
+        fail("json_loadb returned an invalid error message");
+
+    json = json_loadb("[1, 2", 5, &error);
+    if(json)
+        fail("json_loadb succeeded on a truncated buffer");
+    if(strcmp(error.text, "']' expected near end of file") != 0)
+        fail("json_loadb returned an invalid error message at the end");
+
+    test_arena();
+    test_sax();
+
     return 0;
 }
@@ -6,8 +6,122 @@
  */
 
 #include <jansson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include "util.h"
 
+static void test_real_str()
+{
+    static const struct {
+        double value;
+        const char *text;
+    } cases[] = {
+        {0.0, "0"}, {1.0, "1"}, {-2.5, "-2.5"}, {0.1, "0.1"},
+        {100.1, "100.1"}, {1e16, "10000000000000000"}, {1e17, "1e+17"},
+        {1e22, "1e+22"}, {1.23e47, "1.23e+47"}, {0.0001, "0.0001"},
+        {1e-5, "1e-05"}, {5e-324, "5e-324"},
+        {1.7976931348623157e308, "1.7976931348623157e+308"},
+        {-0.000123456789, "-0.000123456789"}
+    };
+    char buffer[JSON_REAL_STR_LENGTH];
+    unsigned int i;
+    unsigned int seed = 1;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int length = json_real_str(cases[i].value, buffer);
+        if(strcmp(buffer, cases[i].text) != 0 ||
+           length != (int)strlen(cases[i].text))
+            fail("json_real_str wrote a real wrongly");
+    }
+
+    /* every double reads back the same */
+    for(i = 0; i < 100000; i++) {
+        unsigned char bytes[sizeof(double)];
+        unsigned int j;
+        double value;
+
+        for(j = 0; j < sizeof(bytes); j++)
+            bytes[j] = rand_r(&seed);
+        memcpy(&value, bytes, sizeof(value));
+        if(value != value || value - value != 0.0)
+            continue;
+
+        json_real_str(value, buffer);
+        if(strtod(buffer, NULL) != value)
+            fail("json_real_str wrote a real that doesn't read back");
+    }
+}
+
+/* the same double, and the same errno, as strtod */
+static int same_as_strtod(const char *text)
+{
+    double expected, value;
+    int expected_errno;
+
+    errno = 0;
+    expected = strtod(text, NULL);
+    expected_errno = errno;
+
+    errno = 0;
+    value = json_real_parse(text);
+
+    return memcmp(&value, &expected, sizeof(value)) == 0 &&
+           errno == expected_errno;
+}
+
+static void test_real_parse()
+{
+    static const char *cases[] = {
+        "0", "-0", "0.0", "-0.0", "0e10", "3.14", "0.4", "-1.57", "40.0",
+        "1e22", "1e23", "1E-22", "1e-23", "0.1e-22", "9007199254740992",
+        "9007199254740993", "9007199254740993.0", "1234567890123456789",
+        "12345678901234567890", "0.000000000000000000001",
+        "1.7976931348623157e308", "1.7976931348623159e308", "1e400",
+        "-1e400", "5e-324", "2e-324", "1e-400", "4.9406564584124654e-324",
+        "2.2250738585072011e-308", "123456.789e-3", "1e+5", "-2.5E+2"
+    };
+    char buffer[JSON_REAL_STR_LENGTH];
+    unsigned int i;
+    unsigned int seed = 1;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if(!same_as_strtod(cases[i]))
+            fail("json_real_parse read a real wrongly");
+    }
+
+    /* short decimals, as genomes have them */
+    for(i = 0; i < 100000; i++) {
+        snprintf(buffer, sizeof(buffer), "%s%d.%0*d",
+                 rand_r(&seed) % 2 ? "-" : "", rand_r(&seed) % 1000,
+                 1 + rand_r(&seed) % 6, rand_r(&seed) % 1000000);
+        if(!same_as_strtod(buffer))
+            fail("json_real_parse read a short decimal wrongly");
+    }
+
+    /* any double, written both ways */
+    for(i = 0; i < 100000; i++) {
+        unsigned char bytes[sizeof(double)];
+        unsigned int j;
+        double value;
+
+        for(j = 0; j < sizeof(bytes); j++)
+            bytes[j] = rand_r(&seed);
+        memcpy(&value, bytes, sizeof(value));
+        if(value != value || value - value != 0.0)
+            continue;
+
+        json_real_str(value, buffer);
+        if(!same_as_strtod(buffer))
+            fail("json_real_parse read a shortest real wrongly");
+
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+        if(!same_as_strtod(buffer))
+            fail("json_real_parse read a real wrongly");
+    }
+}
+
 int main()
 {
     json_t *integer, *real;
@@ -40,5 +154,8 @@ int main()
     json_decref(integer);
     json_decref(real);
 
+    test_real_str();
+    test_real_parse();
+
     return 0;
 }
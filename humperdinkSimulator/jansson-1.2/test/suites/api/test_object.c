@@ -6,6 +6,7 @@
  */
 
 #include <jansson.h>
+#include <stdio.h>
 #include <string.h>
 #include "util.h"
 
@@ -325,6 +326,79 @@ static void test_misc()
     json_decref(object);
 }
 
+static void test_growth()
+{
+    json_t *object;
+    void *iter;
+    char key[16];
+    int i, n, count;
+
+    /* from a few keys (kept in order) to many, and back */
+    for(n = 1; n <= 40; n++)
+    {
+        object = json_object();
+        if(!object)
+            fail("unable to create object");
+
+        for(i = 0; i < n; i++) {
+            sprintf(key, "key%d", i);
+            if(json_object_set_new(object, key, json_integer(i)))
+                fail("unable to set value");
+        }
+
+        /* replacing keeps the size */
+        sprintf(key, "key%d", n / 2);
+        if(json_object_set_new(object, key, json_integer(n / 2)))
+            fail("unable to replace value");
+        if(json_object_size(object) != (unsigned int)n)
+            fail("invalid size");
+
+        for(i = 0; i < n; i++) {
+            sprintf(key, "key%d", i);
+            if(json_integer_value(json_object_get(object, key)) != i)
+                fail("json_object_get returned an invalid value");
+        }
+        if(json_object_get(object, "missing"))
+            fail("json_object_get found a missing key");
+
+        count = 0;
+        iter = json_object_iter(object);
+        while(iter) {
+            const char *iter_key = json_object_iter_key(iter);
+            if(n <= 8) {
+                /* small objects iterate in the order keys were set */
+                sprintf(key, "key%d", count);
+                if(strcmp(iter_key, key) != 0)
+                    fail("small object iterated out of order");
+            }
+            if(json_object_get(object, iter_key) !=
+               json_object_iter_value(iter))
+                fail("iterator value differs from json_object_get");
+            count++;
+            iter = json_object_iter_next(object, iter);
+        }
+        if(count != n)
+            fail("iterated over an invalid number of keys");
+
+        for(i = 0; i < n; i += 2) {
+            sprintf(key, "key%d", i);
+            if(json_object_del(object, key))
+                fail("unable to delete key");
+        }
+        if(json_object_size(object) != (unsigned int)n / 2)
+            fail("invalid size after deleting");
+        for(i = 0; i < n; i++) {
+            sprintf(key, "key%d", i);
+            if((json_object_get(object, key) != NULL) != (i % 2))
+                fail("json_object_get after deleting is invalid");
+        }
+        if(json_object_del(object, "key0") != -1)
+            fail("deleted a missing key");
+
+        json_decref(object);
+    }
+}
+
 int main()
 {
     test_misc();
@@ -332,6 +406,7 @@ int main()
     test_update();
     test_circular();
     test_set_nocheck();
+    test_growth();
 
     return 0;
 }
@@ -0,0 +1,443 @@
+#include "lockstep.h"
+
+#include "creature.h"
+
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+// the physics of createEnvironment( 800, 600 )
+#define TIMESTEP ( 1.0f/60.0f )
+#define ITERATIONS 10
+#define GRAVITY -200.0f
+// top of the ground
+#define GROUND_Y ( -600/2.0f + 10.0f )
+
+typedef cpFloat lane_t[LOCKSTEP_LANES];
+
+/*
+ * One end of a limb against the ground (a chipmunk contact), in every lane.
+ * Lanes that aren't touching have no effective mass, so never apply an impulse.
+ */
+typedef struct {
+	lane_t active;
+	lane_t r1x, r1y;
+	lane_t nMass, tMass;
+	lane_t bias, jBias;
+	lane_t jnAcc, jtAcc;
+} contactLanes_t;
+
+/*
+ * A limb (body, the joint and motor connecting it to its parent,
+ * and its ground contacts) of every creature
+ */
+typedef struct {
+	// body
+	lane_t m_inv, i_inv;
+	lane_t px, py, vx, vy;
+	lane_t angle, w, cosA, sinA;
+	lane_t vbx, vby, wb;
+
+	// limb vector, in body coordinates
+	lane_t lx, ly;
+
+	// pivot joint: anchored on this limb's center of gravity,
+	// and on the parent at anchor (in the parent's body coordinates)
+	lane_t anchorX, anchorY;
+	lane_t r2x, r2y;
+	lane_t k1x, k1y, k2x, k2y;
+	lane_t biasX, biasY;
+	lane_t jAccX, jAccY;
+
+	// oscillating motor
+	lane_t frequency, amplitude, phase;
+	lane_t t, rate, iSum, jAcc;
+
+	// both ends of the limb, and the steps since either last touched the ground
+	contactLanes_t contacts[2];
+	lane_t untouched;
+} limbLanes_t;
+
+struct lockstep {
+	int numCreatures;
+	int numLimbs;
+
+	// parent of each limb, parents before their children
+	int *parents;
+	limbLanes_t *limbs;
+};
+
+/*
+ * Private helper function prototypes
+ */
+static void stepLockstep( Lockstep lockstep, cpFloat dt );
+static void integratePosition( limbLanes_t *restrict limb, cpFloat dt );
+static void integrateVelocity( limbLanes_t *restrict limb, cpFloat dt );
+static void preStepContacts( limbLanes_t *restrict limb, cpFloat dt_inv );
+static void preStepContact( limbLanes_t *restrict limb, contactLanes_t *restrict con,
+                            cpFloat *x, cpFloat *y, cpFloat *dist, cpFloat *keep, cpFloat dt_inv );
+static void preStepJoint( limbLanes_t *restrict a, limbLanes_t *restrict b, cpFloat dt, cpFloat dt_inv );
+static void applyCachedContact( limbLanes_t *restrict limb, contactLanes_t *restrict con );
+static void applyContactImpulse( limbLanes_t *restrict limb, contactLanes_t *restrict con );
+static void applyJointImpulses( limbLanes_t *restrict a, limbLanes_t *restrict b, cpFloat jMax );
+
+
+Lockstep createLockstep( json_t *genomes[], int numGenomes ) {
+	assert( numGenomes > 0 && numGenomes <= LOCKSTEP_LANES );
+
+	Lockstep lockstep = malloc( sizeof( struct lockstep ) );
+	assert( lockstep != NULL );
+
+	int numLimbs = getGenomeLimbs( genomes[0], NULL, NULL, 0 );
+
+	lockstep->numCreatures = numGenomes;
+	lockstep->numLimbs = numLimbs;
+	lockstep->parents = malloc( sizeof( int ) * numLimbs );
+	assert( lockstep->parents != NULL );
+
+	// everything starts at rest, with no cached impulses
+	lockstep->limbs = calloc( numLimbs, sizeof( limbLanes_t ) );
+	assert( lockstep->limbs != NULL );
+
+	parameters_t parameters[numLimbs];
+	cpVect positions[numLimbs];
+	cpVect endPoints[numLimbs];
+	cpFloat angles[numLimbs];
+
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		// unused lanes simulate a copy of the first creature
+		json_t *genome = genomes[( l < numGenomes ) ? l : 0];
+		assert( sameGenomeTopology( genome, genomes[0] ) );
+
+		getGenomeLimbs( genome, parameters, lockstep->parents, numLimbs );
+
+		// the construction pose, worked out the same way as in createCreatureNode
+		for ( int i = 0; i < numLimbs; ++i ) {
+			limbLanes_t *limb = &lockstep->limbs[i];
+			int parent = lockstep->parents[i];
+
+			cpFloat baseAngle;
+			if ( parent == -1 ) {
+				positions[i] = cpvzero;
+				baseAngle = (cpFloat)( M_PI/2.0 );
+			} else {
+				positions[i] = endPoints[parent];
+				baseAngle = angles[parent];
+			}
+
+			angles[i] = (cpFloat)( baseAngle + parameters[i].angle );
+			cpFloat length = (cpFloat)parameters[i].length;
+			cpVect limbVec = cpvmult( cpvforangle( angles[i] ), length );
+			endPoints[i] = cpvadd( limbVec, positions[i] );
+
+			cpFloat mass = length * MASS_PER_LENGTH;
+			limb->m_inv[l] = 1.0f/mass;
+			limb->i_inv[l] = 1.0f/cpMomentForSegment( mass, cpvzero, limbVec );
+
+			// bodies start unrotated, the limb vector is in body coordinates
+			limb->px[l] = positions[i].x;
+			limb->py[l] = positions[i].y;
+			limb->cosA[l] = 1.0f;
+			limb->lx[l] = limbVec.x;
+			limb->ly[l] = limbVec.y;
+
+			if ( parent != -1 ) {
+				cpVect anchor = cpvsub( positions[i], positions[parent] );
+				limb->anchorX[l] = anchor.x;
+				limb->anchorY[l] = anchor.y;
+
+				limb->frequency[l] = (cpFloat)parameters[i].frequency;
+				limb->amplitude[l] = (cpFloat)parameters[i].amplitude;
+				limb->phase[l] = (cpFloat)parameters[i].phase;
+			}
+		}
+	}
+
+	return lockstep;
+}
+
+void destroyLockstep( Lockstep lockstep ) {
+	free( lockstep->limbs );
+	free( lockstep->parents );
+	free( lockstep );
+}
+
+void updateLockstep( Lockstep lockstep ) {
+	stepLockstep( lockstep, TIMESTEP );
+}
+
+double getLockstepX( Lockstep lockstep, int creature ) {
+	assert( creature >= 0 && creature < lockstep->numCreatures );
+	return lockstep->limbs[0].px[creature];
+}
+
+double getLockstepY( Lockstep lockstep, int creature ) {
+	assert( creature >= 0 && creature < lockstep->numCreatures );
+	return lockstep->limbs[0].py[creature];
+}
+
+
+/*
+ * One physics step, in the same order as cpSpaceStep
+ */
+static void stepLockstep( Lockstep lockstep, cpFloat dt ) {
+	cpFloat dt_inv = 1.0f/dt;
+	int numLimbs = lockstep->numLimbs;
+	int *parents = lockstep->parents;
+	limbLanes_t *limbs = lockstep->limbs;
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		integratePosition( &limbs[i], dt );
+	}
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		preStepContacts( &limbs[i], dt_inv );
+	}
+
+	for ( int i = 1; i < numLimbs; ++i ) {
+		preStepJoint( &limbs[i], &limbs[parents[i]], dt, dt_inv );
+	}
+
+	for ( int i = 0; i < numLimbs; ++i ) {
+		integrateVelocity( &limbs[i], dt );
+		applyCachedContact( &limbs[i], &limbs[i].contacts[0] );
+		applyCachedContact( &limbs[i], &limbs[i].contacts[1] );
+	}
+
+	cpFloat jMax = MAX_FORCE * dt;
+	for ( int n = 0; n < ITERATIONS; ++n ) {
+		for ( int i = 0; i < numLimbs; ++i ) {
+			applyContactImpulse( &limbs[i], &limbs[i].contacts[0] );
+			applyContactImpulse( &limbs[i], &limbs[i].contacts[1] );
+		}
+		for ( int i = 1; i < numLimbs; ++i ) {
+			applyJointImpulses( &limbs[i], &limbs[parents[i]], jMax );
+		}
+	}
+}
+
+static void integratePosition( limbLanes_t *restrict limb, cpFloat dt ) {
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		limb->px[l] += ( limb->vx[l] + limb->vbx[l] ) * dt;
+		limb->py[l] += ( limb->vy[l] + limb->vby[l] ) * dt;
+		limb->angle[l] += ( limb->w[l] + limb->wb[l] ) * dt;
+
+		limb->vbx[l] = 0.0f;
+		limb->vby[l] = 0.0f;
+		limb->wb[l] = 0.0f;
+	}
+
+	// in separate loops, or the compiler pairs them into a (scalar) sincos
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		limb->cosA[l] = cpfcos( limb->angle[l] );
+	}
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		limb->sinA[l] = cpfsin( limb->angle[l] );
+	}
+}
+
+static void integrateVelocity( limbLanes_t *restrict limb, cpFloat dt ) {
+	// no damping, and gravity is the only force
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		limb->vy[l] += GRAVITY * dt;
+	}
+}
+
+/*
+ * Collides both ends of each limb with the ground (chipmunk's seg2poly
+ * against a flat top face) and pre-steps the contacts like cpArbiterPreStep.
+ * The contact normal is (0, -1), from the limb into the ground.
+ */
+static void preStepContacts( limbLanes_t *restrict limb, cpFloat dt_inv ) {
+	// the limb's ends, less the radius
+	lane_t x[2], y[2];
+	// both contacts get the depth of the deeper end
+	lane_t dist;
+	// 0 where an end's cached impulses are out of date, 1 elsewhere
+	lane_t keep[2];
+
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		x[0][l] = limb->px[l];
+		y[0][l] = limb->py[l] - SHAPE_RADIUS;
+		x[1][l] = limb->px[l] + limb->lx[l]*limb->cosA[l] - limb->ly[l]*limb->sinA[l];
+		y[1][l] = limb->py[l] + limb->lx[l]*limb->sinA[l] + limb->ly[l]*limb->cosA[l] - SHAPE_RADIUS;
+		dist[l] = cpfmin( y[0][l], y[1][l] ) - GROUND_Y;
+
+		// chipmunk keeps the cached impulses of both ends while the limb is off the ground
+		// for less than cp_contact_persistence steps, or of one end while it stays in contact
+		cpFloat touching = ( dist[l] <= 0.0f );
+		limb->untouched[l] = ( limb->untouched[l] + 1.0f )*( 1.0f - touching );
+		cpFloat expired = ( limb->untouched[l] >= cp_contact_persistence );
+
+		keep[0][l] = ( 1.0f - expired )*( 1.0f - touching*( y[0][l] > GROUND_Y ) );
+		keep[1][l] = ( 1.0f - expired )*( 1.0f - touching*( y[1][l] > GROUND_Y ) );
+	}
+
+	for ( int e = 0; e < 2; ++e ) {
+		preStepContact( limb, &limb->contacts[e], x[e], y[e], dist, keep[e], dt_inv );
+	}
+}
+
+static void preStepContact( limbLanes_t *restrict limb, contactLanes_t *restrict con,
+                            cpFloat *x, cpFloat *y, cpFloat *dist, cpFloat *keep, cpFloat dt_inv ) {
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		cpFloat active = ( y[l] <= GROUND_Y );
+
+		con->jnAcc[l] *= keep[l];
+		con->jtAcc[l] *= keep[l];
+
+		cpFloat r1x = x[l] - limb->px[l];
+		cpFloat r1y = y[l] - limb->py[l];
+		con->r1x[l] = r1x;
+		con->r1y[l] = r1y;
+		con->active[l] = active;
+		con->nMass[l] = active/( limb->m_inv[l] + limb->i_inv[l]*r1x*r1x );
+		con->tMass[l] = active/( limb->m_inv[l] + limb->i_inv[l]*r1y*r1y );
+		con->bias[l] = -cp_bias_coef*dt_inv*cpfmin( 0.0f, dist[l] + cp_collision_slop );
+		con->jBias[l] = 0.0f;
+	}
+}
+
+/*
+ * Pre-steps the pivot joint and motor between limb a and its parent b,
+ * like the cpPivotJoint and cpOscillatingMotor preStep functions,
+ * including applying their accumulated impulses
+ */
+static void preStepJoint( limbLanes_t *restrict a, limbLanes_t *restrict b, cpFloat dt, cpFloat dt_inv ) {
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		// the anchor on a is its center of gravity, so r1 is zero
+		cpFloat r2x = a->anchorX[l]*b->cosA[l] - a->anchorY[l]*b->sinA[l];
+		cpFloat r2y = a->anchorX[l]*b->sinA[l] + a->anchorY[l]*b->cosA[l];
+		a->r2x[l] = r2x;
+		a->r2y[l] = r2y;
+
+		// mass tensor, inverted
+		cpFloat m_sum = a->m_inv[l] + b->m_inv[l];
+		cpFloat k11 = m_sum + r2y*r2y*b->i_inv[l];
+		cpFloat k12 = -r2x*r2y*b->i_inv[l];
+		cpFloat k22 = m_sum + r2x*r2x*b->i_inv[l];
+		cpFloat det_inv = 1.0f/( k11*k22 - k12*k12 );
+		a->k1x[l] =  k22*det_inv;
+		a->k1y[l] = -k12*det_inv;
+		a->k2x[l] = -k12*det_inv;
+		a->k2y[l] =  k11*det_inv;
+
+		a->biasX[l] = ( b->px[l] + r2x - a->px[l] ) * -cp_constraint_bias_coef*dt_inv;
+		a->biasY[l] = ( b->py[l] + r2y - a->py[l] ) * -cp_constraint_bias_coef*dt_inv;
+
+		cpFloat jx = a->jAccX[l];
+		cpFloat jy = a->jAccY[l];
+		a->vx[l] -= jx*a->m_inv[l];
+		a->vy[l] -= jy*a->m_inv[l];
+		b->vx[l] += jx*b->m_inv[l];
+		b->vy[l] += jy*b->m_inv[l];
+		b->w[l] += b->i_inv[l]*( r2x*jy - r2y*jx );
+
+		// motor
+		a->iSum[l] = 1.0f/( a->i_inv[l] + b->i_inv[l] );
+		a->w[l] -= a->jAcc[l]*a->i_inv[l];
+		b->w[l] += a->jAcc[l]*b->i_inv[l];
+
+		cpFloat frequency = a->frequency[l];
+		cpFloat t = a->t[l] + dt;
+		if ( frequency == 0.0f ) {
+			t = 0.0f;
+		} else {
+			cpFloat tLimit = (cpFloat)( 2.0*M_PI )/frequency;
+			if ( t > tLimit ) t -= tLimit;
+		}
+		a->t[l] = t;
+		a->rate[l] = frequency * a->amplitude[l] * cpfcos( frequency * t + a->phase[l] );
+	}
+}
+
+static void applyCachedContact( limbLanes_t *restrict limb, contactLanes_t *restrict con ) {
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		cpFloat jn = con->jnAcc[l] * con->active[l];
+		cpFloat jt = con->jtAcc[l] * con->active[l];
+
+		limb->vx[l] -= jt*limb->m_inv[l];
+		limb->vy[l] += jn*limb->m_inv[l];
+		limb->w[l] += limb->i_inv[l]*( con->r1x[l]*jn + con->r1y[l]*jt );
+	}
+}
+
+/*
+ * cpArbiterApplyImpulse, for one end of a limb against the static ground
+ */
+static void applyContactImpulse( limbLanes_t *restrict limb, contactLanes_t *restrict con ) {
+	cpFloat u = FRICTION;
+
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		cpFloat r1x = con->r1x[l];
+		cpFloat r1y = con->r1y[l];
+		cpFloat m_inv = limb->m_inv[l];
+		cpFloat i_inv = limb->i_inv[l];
+
+		// bias impulse
+		cpFloat vbn = limb->vby[l] + r1x*limb->wb[l];
+		cpFloat jbn = ( con->bias[l] - vbn )*con->nMass[l];
+		cpFloat jbnOld = con->jBias[l];
+		con->jBias[l] = cpfmax( jbnOld + jbn, 0.0f );
+		jbn = con->jBias[l] - jbnOld;
+
+		limb->vby[l] += jbn*m_inv;
+		limb->wb[l] += i_inv*r1x*jbn;
+
+		// normal impulse (the limbs aren't elastic, so there's no bounce)
+		cpFloat vrn = limb->vy[l] + r1x*limb->w[l];
+		cpFloat jn = -vrn*con->nMass[l];
+		cpFloat jnOld = con->jnAcc[l];
+		con->jnAcc[l] = cpfmax( jnOld + jn, 0.0f );
+		jn = con->jnAcc[l] - jnOld;
+
+		// friction impulse
+		cpFloat vrt = r1y*limb->w[l] - limb->vx[l];
+		cpFloat jtMax = u*con->jnAcc[l];
+		cpFloat jt = -vrt*con->tMass[l];
+		cpFloat jtOld = con->jtAcc[l];
+		con->jtAcc[l] = cpfclamp( jtOld + jt, -jtMax, jtMax );
+		jt = con->jtAcc[l] - jtOld;
+
+		limb->vx[l] -= jt*m_inv;
+		limb->vy[l] += jn*m_inv;
+		limb->w[l] += i_inv*( r1x*jn + r1y*jt );
+	}
+}
+
+/*
+ * The pivot joint's and then the motor's applyImpulse,
+ * between limb a and its parent b
+ */
+static void applyJointImpulses( limbLanes_t *restrict a, limbLanes_t *restrict b, cpFloat jMax ) {
+	for ( int l = 0; l < LOCKSTEP_LANES; ++l ) {
+		cpFloat r2x = a->r2x[l];
+		cpFloat r2y = a->r2y[l];
+
+		// pivot
+		cpFloat vrx = b->vx[l] - r2y*b->w[l] - a->vx[l];
+		cpFloat vry = b->vy[l] + r2x*b->w[l] - a->vy[l];
+		cpFloat dx = a->biasX[l] - vrx;
+		cpFloat dy = a->biasY[l] - vry;
+		cpFloat jx = dx*a->k1x[l] + dy*a->k1y[l];
+		cpFloat jy = dx*a->k2x[l] + dy*a->k2y[l];
+		a->jAccX[l] += jx;
+		a->jAccY[l] += jy;
+
+		a->vx[l] -= jx*a->m_inv[l];
+		a->vy[l] -= jy*a->m_inv[l];
+		b->vx[l] += jx*b->m_inv[l];
+		b->vy[l] += jy*b->m_inv[l];
+		b->w[l] += b->i_inv[l]*( r2x*jy - r2y*jx );
+
+		// motor
+		cpFloat wr = b->w[l] - a->w[l] + a->rate[l];
+		cpFloat j = -wr*a->iSum[l];
+		cpFloat jOld = a->jAcc[l];
+		a->jAcc[l] = cpfclamp( jOld + j, -jMax, jMax );
+		j = a->jAcc[l] - jOld;
+
+		a->w[l] -= j*a->i_inv[l];
+		b->w[l] += j*b->i_inv[l];
+	}
+}
@@ -0,0 +1,51 @@
+/*
+ * Lockstep ADT:
+ *  Simulates up to LOCKSTEP_LANES creatures that share a topology
+ *  (the same tree of limbs, see sameGenomeTopology) side by side,
+ *  for screening many mutations of one creature at once.
+ *
+ * Every body, joint, motor and ground contact is stored lane-wise
+ * (one array element per creature), so each step of the solver runs
+ * over all the creatures together and compiles to SIMD code.
+ * The physics is the same as a creature created with createCreature
+ * alone in createEnvironment( 800, 600 ): pivot joints, oscillating
+ * motors, chipmunk's contact and joint solvers, same constants.
+ * Results are not the same as the chipmunk simulation's (the solver
+ * visits the contacts in a different order, and the difference grows
+ * over a run): most creatures go about as far, but some differ by tens
+ * or hundreds of units, so the results are for screening, not ranking
+ * (see bench/lockstepBench).
+ *
+ * Restrictions:
+ *  - the ground is the environment's flat ground and nothing else
+ *  - limbs never collide with each other (they don't in chipmunk either,
+ *    segment to segment collisions aren't supported) or with other creatures
+ *  - default stepping only: 1/60 s per update, 10 solver iterations
+ */
+
+#include <jansson.h>
+#include "chipmunk.h"
+
+// creatures simulated together
+#define LOCKSTEP_LANES 8
+
+typedef struct lockstep *Lockstep;
+
+/*
+ * Constructor: Builds 1..LOCKSTEP_LANES creatures from genomes
+ *  that must all have the same topology as the first.
+ * Deconstructor: Removes memory allocated for the creatures.
+ */
+Lockstep createLockstep( json_t *genomes[], int numGenomes );
+void destroyLockstep( Lockstep lockstep );
+
+/*
+ * Advances every creature by one update (1/60 s)
+ */
+void updateLockstep( Lockstep lockstep );
+
+/*
+ * Position of a creature's root limb, like getCreatureX/Y
+ */
+double getLockstepX( Lockstep lockstep, int creature );
+double getLockstepY( Lockstep lockstep, int creature );
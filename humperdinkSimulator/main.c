@@ -1,5 +1,14 @@
 #include "environment.h"
 #include "creature.h"
+#include "genomeLoader.h"
+#include "binaryGenome.h"
+#include "termination.h"
+#include "metrics.h"
+#include "evaluation.h"
+#include "evolution.h"
+#include "population.h"
+#include "fitnessCache.h"
+#include "finite.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,10 +17,20 @@
 
 #define SLEEP_TICKS 16
 
+// updates each genome is simulated for by -p, without -i
+#define EVOLUTION_UPDATES 1200
+
+// results -k keeps in memory (the file keeps them all)
+#define CACHE_CAPACITY 65536
+
 
 static void timercall( int value );
 static void display( void );
 static void initGL( float width, float height );
+static void printPosition( Creature creature );
+static void evolvePopulation( char *filename, evolutionSettings_t *settings, evaluationSettings_t *evaluation, char *checkpoint,
+	char **tiers, int numTiers, bool audit, char *cacheFile );
+static Evolution seedEvolution( char *filename, evolutionSettings_t *settings, evaluationSettings_t *evaluation );
 
 static Environment simulationEnvironment;
 static Creature simulatedCreature;
@@ -24,8 +43,25 @@ int main( int argc, char *argv[] ) {
 	
 	simulationSpeed = 1;
 	iterations = 0; // infinite
+	int threads = 1;
+	bool graphColoring = false;
+	bool articulated = false;
+	double tolerance = 0.0;
+	double timestep = 0.0; // environment default
+	int substeps = 1;
+	int maxSubsteps = 0;
+	bool terminate = false;
+	bool measure = false;
+	terminationRules_t rules = defaultTerminationRules( );
+	bool evolve = false;
+	evolutionSettings_t evolution = defaultEvolutionSettings( );
 	
 	char *filename = NULL;
+	char *checkpoint = NULL;
+	char *cacheFile = NULL;
+	char *tiers[argc];
+	int numTiers = 0;
+	bool audit = false;
 	
 	bool graphics = true;
 	
@@ -40,11 +76,83 @@ int main( int argc, char *argv[] ) {
 			simulationSpeed = atoi( argv[i+1] );
 		} else if ( strncmp( argv[i], "-i", 2 ) == 0 && i+1 < argc ) {
 			iterations = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-t", 2 ) == 0 && i+1 < argc ) {
+			threads = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-c", 2 ) == 0 ) {
+			graphColoring = true;
+		} else if ( strncmp( argv[i], "-e", 2 ) == 0 && i+1 < argc ) {
+			tolerance = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-d", 2 ) == 0 && i+1 < argc ) {
+			timestep = atof( argv[i+1] );
+		} else if ( strncmp( argv[i], "-u", 2 ) == 0 && i+1 < argc ) {
+			substeps = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-v", 2 ) == 0 && i+1 < argc ) {
+			maxSubsteps = atoi( argv[i+1] );
+		} else if ( strncmp( argv[i], "-a", 2 ) == 0 ) {
+			articulated = true;
+		} else if ( strncmp( argv[i], "-x", 2 ) == 0 ) {
+			terminate = true;
+			// optional list of rules, otherwise the defaults
+			if ( i+1 < argc && argv[i+1][0] != '-' ) {
+				if ( !parseTerminationRules( argv[i+1], &rules ) ) {
+					fprintf( stderr, "Can't read the termination rules \"%s\"\n", argv[i+1] );
+					exit( 0 );
+				}
+			}
+		} else if ( strncmp( argv[i], "-p", 2 ) == 0 ) {
+			evolve = true;
+			// optional list of settings, otherwise the defaults
+			if ( i+1 < argc && argv[i+1][0] != '-' ) {
+				if ( !parseEvolutionSettings( argv[i+1], &evolution ) ) {
+					fprintf( stderr, "Can't read the evolution settings \"%s\"\n", argv[i+1] );
+					exit( 0 );
+				}
+			}
+		} else if ( strncmp( argv[i], "-o", 2 ) == 0 && i+1 < argc ) {
+			checkpoint = argv[i+1];
+		} else if ( strncmp( argv[i], "-q", 2 ) == 0 && i+1 < argc ) {
+			// read once the full tier's settings are known
+			tiers[numTiers++] = argv[i+1];
+		} else if ( strncmp( argv[i], "-k", 2 ) == 0 && i+1 < argc ) {
+			cacheFile = argv[i+1];
+		} else if ( strncmp( argv[i], "-r", 2 ) == 0 ) {
+			audit = true;
+		} else if ( strncmp( argv[i], "-m", 2 ) == 0 ) {
+			measure = true;
 		} else if ( strncmp( argv[i], "-g", 2 ) == 0 ) {
 			graphics = false;
 		}
 	}
 	
+	if ( substeps < 1 ) {
+		fprintf( stderr, "The number of sub-steps per update (-u) must be at least 1\n" );
+		exit( 0 );
+	}
+	
+	if ( articulated && graphColoring ) {
+		fprintf( stderr, "The graph coloring solver (-c) can't be used with articulated creatures (-a)\n" );
+		exit( 0 );
+	}
+	
+	if ( evolve ) {
+		evaluationSettings_t evaluation = defaultEvaluationSettings( ( iterations > 0 ) ? iterations : EVOLUTION_UPDATES );
+		evaluation.timestep = timestep;
+		evaluation.substeps = substeps;
+		evaluation.maxSubsteps = maxSubsteps;
+		evaluation.tolerance = tolerance;
+		evaluation.articulated = articulated;
+		evaluation.graphColoring = graphColoring;
+		evaluation.terminate = terminate;
+		evaluation.rules = rules;
+		
+		// each genome is simulated on one thread, -t of them at once
+		evolution.threads = threads;
+		
+		cpInitChipmunk( );
+		evolvePopulation( filename, &evolution, &evaluation, checkpoint, tiers, numTiers, audit, cacheFile );
+		return 0;
+	}
+	
 	fprintf( stderr, "Simulating with a humperdink from " );
 	if ( filename == NULL ) {
 		fprintf( stderr, "stdin" );
@@ -53,29 +161,58 @@ int main( int argc, char *argv[] ) {
 	}
 	fprintf( stderr, ": %d iterations. Processing %d iterations at once.\n", iterations, simulationSpeed );
 	
-	json_t *json;
+	genome_t genome;
+	BinaryGenome binaryGenome = NULL;
 	json_error_t error;
+	int loaded;
 	
-	
+	initGenome( &genome );
 	if ( filename == NULL ) {
-		json = json_loadf( stdin, &error );
+		loaded = loadGenomeFile( stdin, &genome, &error );
+	} else if ( isBinaryGenomeFile( filename ) ) {
+		binaryGenome = openBinaryGenome( filename, &error );
+		loaded = ( binaryGenome != NULL );
 	} else {
-		json = json_load_file( filename, &error );
+		loaded = loadGenomePath( filename, &genome, &error );
 	}
 	
-	if( !json ) {
+	if( !loaded ) {
 		fprintf( stderr, "Error parsing humperdink on line %d:\n", error.line );
 		fprintf( stderr, "\t%s\n\n", error.text );
 		exit( 0 );
 	}
 	
+	// the limbs, straight from the file if it's binary
+	parameters_t *limbs = genome.parameters;
+	int numLimbs = genome.numLimbs;
+	if ( binaryGenome != NULL ) {
+		limbs = getBinaryGenomeLimbs( binaryGenome );
+		numLimbs = getBinaryGenomeNumLimbs( binaryGenome );
+	}
+	
 	int width = 800;
 	int height = 600;
 	
 	cpInitChipmunk( );
 	
 	simulationEnvironment = createEnvironment( width, height );
-	simulatedCreature = createCreature( json, getEnvironmentSpace( simulationEnvironment ) );
+	setEnvironmentThreads( simulationEnvironment, threads );
+	setEnvironmentGraphColoring( simulationEnvironment, graphColoring );
+	setEnvironmentIterationTolerance( simulationEnvironment, tolerance, 2 );
+	if ( timestep > 0.0 ) {
+		setEnvironmentTimestep( simulationEnvironment, timestep );
+	}
+	setEnvironmentSubsteps( simulationEnvironment, substeps );
+	setEnvironmentAdaptiveSubsteps( simulationEnvironment, maxSubsteps );
+	if ( articulated ) {
+		simulatedCreature = createArticulatedCreatureFromLimbs( limbs, numLimbs, getEnvironmentSpace( simulationEnvironment ) );
+	} else {
+		simulatedCreature = createCreatureFromLimbs( limbs, numLimbs, getEnvironmentSpace( simulationEnvironment ) );
+	}
+	freeGenome( &genome );
+	if ( binaryGenome != NULL ) {
+		closeBinaryGenome( binaryGenome );
+	}
 	
 	if ( graphics ) {
 		
@@ -107,9 +244,53 @@ int main( int argc, char *argv[] ) {
 		#endif
 		
 	} else {
-		for ( int i = 0; i < iterations || iterations == 0; ++i ) {
+		Termination termination = NULL;
+		if ( terminate ) {
+			termination = createTermination( simulatedCreature, simulationEnvironment, rules );
+		}
+		
+		Metrics metrics = NULL;
+		if ( measure ) {
+			metrics = createMetrics( simulatedCreature, simulationEnvironment );
+		}
+		
+		long solverPasses = 0;
+		int i;
+		for ( i = 0; i < iterations || iterations == 0; ++i ) {
 			updateEnvironment( simulationEnvironment );
-			printf( "(%lf, %lf)\n", getCreatureX( simulatedCreature ), getCreatureY( simulatedCreature ) );
+			solverPasses += getEnvironmentStepIterations( simulationEnvironment );
+			printPosition( simulatedCreature );
+			
+			if ( metrics != NULL ) {
+				updateMetrics( metrics );
+			}
+			
+			if ( termination != NULL && checkTermination( termination ) != TERMINATION_NONE ) {
+				i++;
+				break;
+			}
+		}
+		
+		if ( termination != NULL ) {
+			if ( getTerminationReason( termination ) != TERMINATION_NONE ) {
+				fprintf( stderr, "Stopped early at iteration %ld: %s\n",
+					getTerminationUpdates( termination ), terminationReasonName( getTerminationReason( termination ) ) );
+			}
+			destroyTermination( termination );
+		}
+		
+		if ( metrics != NULL ) {
+			metrics_t result;
+			getMetrics( metrics, &result );
+			printMetrics( stderr, &result );
+			destroyMetrics( metrics );
+		}
+		
+		if ( tolerance > 0.0 && i > 0 ) {
+			fprintf( stderr, "Solver passes per step: %.2f\n", (double)solverPasses / i );
+		}
+		if ( maxSubsteps > 1 ) {
+			fprintf( stderr, "Physics steps: %ld\n", getEnvironmentStepCount( simulationEnvironment ) );
 		}
 	}
 	
@@ -127,7 +308,7 @@ static void display( void ) {
 	for ( int i = 0; i < simulationSpeed; ++i ) {
 		//printCreatureDebug( simulatedCreature );
 		updateEnvironment( simulationEnvironment );
-		printf( "(%lf, %lf)\n", getCreatureX( simulatedCreature ), getCreatureY( simulatedCreature ) );	
+		printPosition( simulatedCreature );
 		iterations--;
 	}
 	
@@ -136,6 +317,174 @@ static void display( void ) {
 	}
 }
 
+// "(x, y)", each the shortest text that reads back as the same double
+static void printPosition( Creature creature ) {
+	char line[2 * JSON_REAL_STR_LENGTH + 8];
+	char *end = line;
+
+	*end++ = '(';
+	end += json_real_str( getCreatureX( creature ), end );
+	*end++ = ',';
+	*end++ = ' ';
+	end += json_real_str( getCreatureY( creature ), end );
+	*end++ = ')';
+	*end++ = '\n';
+
+	fwrite( line, 1, end - line, stdout );
+}
+
+// runs the generations of -p, starting from the genome or population in -f (if there is one),
+// or carrying on from the checkpoint in -f, screened by the tiers of -q, through the fitness cache in -k
+static void evolvePopulation( char *filename, evolutionSettings_t *settings, evaluationSettings_t *evaluation, char *checkpoint,
+	char **tiers, int numTiers, bool audit, char *cacheFile ) {
+	Evolution evolution;
+	bool resumed = ( filename != NULL && isEvolutionCheckpoint( filename ) );
+	
+	if ( resumed ) {
+		json_error_t error;
+		evolution = loadEvolutionCheckpoint( settings, evaluation, filename, &error );
+		if ( evolution == NULL ) {
+			fprintf( stderr, "Error reading the checkpoint on line %d:\n", error.line );
+			fprintf( stderr, "\t%s\n\n", error.text );
+			exit( 0 );
+		}
+		fprintf( stderr, "Evolving generations %d to %d of %d humperdinks from the checkpoint %s", getEvolutionGeneration( evolution ) + 1,
+			settings->generations - 1, settings->populationSize, filename );
+		fprintf( stderr, ": %d iterations each, on %d threads.\n", evaluation->updates, settings->threads );
+	} else {
+		evolution = seedEvolution( filename, settings, evaluation );
+	}
+	
+	Screening screening = getEvolutionScreening( evolution );
+	for ( int i = 0; i < numTiers; ++i ) {
+		// each tier is the full tier but for its list
+		evaluationSettings_t tier = *evaluation;
+		double keep;
+		if ( !parseScreeningTier( tiers[i], &tier, &keep ) ) {
+			fprintf( stderr, "Can't read the screening tier \"%s\"\n", tiers[i] );
+			exit( 0 );
+		}
+		addScreeningTier( screening, &tier, keep );
+	}
+	setScreeningAudit( screening, audit );
+	
+	FitnessCache cache = NULL;
+	if ( cacheFile != NULL ) {
+		cache = createFitnessCache( CACHE_CAPACITY, cacheFile );
+		if ( cache == NULL ) {
+			fprintf( stderr, "Can't open the fitness cache %s\n", cacheFile );
+			exit( 0 );
+		}
+		setScreeningCache( screening, cache );
+	}
+	
+	printf( "%10s %12s %12s %6s %12s\n", "generation", "best", "mean", "limbs", "evaluations" );
+	// a checkpoint's generation has been evaluated already
+	int first = getEvolutionGeneration( evolution ) + ( resumed ? 1 : 0 );
+	for ( int g = first; g < settings->generations; ++g ) {
+		if ( g > 0 ) {
+			nextGeneration( evolution );
+		}
+		evaluateGeneration( evolution );
+		
+		// the mean of the creatures simulated in full that didn't blow up
+		double total = 0.0;
+		int counted = 0;
+		for ( int i = 0; i < getEvolutionSize( evolution ); ++i ) {
+			evolutionMember_t *member = getEvolutionMember( evolution, i );
+			double distance = member->metrics.distance;
+			if ( !member->screened && isFiniteValue( distance ) ) {
+				total += distance;
+				counted++;
+			}
+		}
+		
+		evolutionMember_t *best = getEvolutionMember( evolution, 0 );
+		printf( "%10d %12.3f %12.3f %6d %12ld\n", g, best->metrics.distance, ( counted > 0 ) ? total / counted : 0.0,
+			best->genome.numLimbs, getEvolutionEvaluations( evolution ) );
+		fflush( stdout );
+		
+		if ( checkpoint != NULL && !writeEvolutionCheckpoint( evolution, checkpoint ) ) {
+			fprintf( stderr, "Can't write the checkpoint %s\n", checkpoint );
+			exit( 0 );
+		}
+	}
+	
+	if ( numTiers > 0 || audit ) {
+		fprintf( stderr, "\n" );
+		printScreeningReport( stderr, screening );
+	}
+	
+	if ( cache != NULL ) {
+		fprintf( stderr, "Fitness cache: %ld hits, %ld misses\n", getFitnessCacheHits( cache ), getFitnessCacheMisses( cache ) );
+	}
+	
+	destroyEvolution( evolution );
+	if ( cache != NULL ) {
+		destroyFitnessCache( cache );
+	}
+}
+
+// the first generation, from the genome (JSON or binary) or population in 'filename' (random genomes if it's NULL)
+static Evolution seedEvolution( char *filename, evolutionSettings_t *settings, evaluationSettings_t *evaluation ) {
+	genome_t genome;
+	Population population = NULL;
+	json_error_t error;
+	int numSeeds = 0;
+	
+	initGenome( &genome );
+	if ( filename != NULL && isPopulationFile( filename ) ) {
+		population = loadPopulationPath( filename, settings->threads, &error );
+		if ( population == NULL ) {
+			fprintf( stderr, "Error reading the population: %s\n", error.text );
+			exit( 0 );
+		}
+		for ( int i = 0; i < getPopulationSize( population ); ++i ) {
+			populationMember_t *member = getPopulationMember( population, i );
+			if ( !member->loaded ) {
+				fprintf( stderr, "Error parsing humperdink on line %d:\n", member->error.line );
+				fprintf( stderr, "\t%s\n\n", member->error.text );
+				exit( 0 );
+			}
+		}
+		numSeeds = getPopulationSize( population );
+	} else if ( filename != NULL ) {
+		int loaded;
+		if ( isBinaryGenomeFile( filename ) ) {
+			loaded = loadBinaryGenomePath( filename, &genome, &error );
+		} else {
+			loaded = loadGenomePath( filename, &genome, &error );
+		}
+		if ( !loaded ) {
+			fprintf( stderr, "Error parsing humperdink on line %d:\n", error.line );
+			fprintf( stderr, "\t%s\n\n", error.text );
+			exit( 0 );
+		}
+		numSeeds = 1;
+	}
+	
+	genome_t seeds[numSeeds > 0 ? numSeeds : 1];
+	for ( int i = 0; i < numSeeds; ++i ) {
+		seeds[i] = ( population != NULL ) ? getPopulationMember( population, i )->genome : genome;
+	}
+	
+	fprintf( stderr, "Evolving %d generations of %d humperdinks from ", settings->generations, settings->populationSize );
+	if ( numSeeds == 0 ) {
+		fprintf( stderr, "random genomes" );
+	} else {
+		fprintf( stderr, "%s", filename );
+	}
+	fprintf( stderr, ": %d iterations each, on %d threads.\n", evaluation->updates, settings->threads );
+	
+	Evolution evolution = createEvolution( settings, evaluation, seeds, numSeeds );
+	freeGenome( &genome );
+	if ( population != NULL ) {
+		destroyPopulation( population );
+	}
+	
+	return evolution;
+}
+
 static void timercall( int value ) {
 	#ifndef NOGRAPHICS
 	glutTimerFunc( SLEEP_TICKS, timercall, 0 );
@@ -0,0 +1,79 @@
+#include "metrics.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+
+struct metrics {
+	Creature creature;
+	Environment env;
+
+	cpVect start;
+	cpVect last;
+
+	double seconds;
+	double pathLength;
+	double maxDisplacement;
+	double airborneTime;
+	double startEnergy;
+};
+
+
+Metrics createMetrics( Creature creature, Environment env ) {
+	Metrics metrics = malloc( sizeof( struct metrics ) );
+	assert( metrics != NULL );
+
+	metrics->creature = creature;
+	metrics->env = env;
+
+	metrics->start = getCreaturePosition( creature );
+	metrics->last = metrics->start;
+
+	metrics->seconds = 0.0;
+	metrics->pathLength = 0.0;
+	metrics->maxDisplacement = 0.0;
+	metrics->airborneTime = 0.0;
+	metrics->startEnergy = getCreatureEnergy( creature );
+
+	return metrics;
+}
+
+void destroyMetrics( Metrics metrics ) {
+	free( metrics );
+}
+
+void updateMetrics( Metrics metrics ) {
+	cpSpace *space = getEnvironmentSpace( metrics->env );
+	double timestep = getEnvironmentTimestep( metrics->env );
+	cpVect position = getCreaturePosition( metrics->creature );
+
+	metrics->seconds += timestep;
+	metrics->pathLength += fabs( position.x - metrics->last.x );
+	metrics->maxDisplacement = fmax( metrics->maxDisplacement, fabs( position.x - metrics->start.x ) );
+	metrics->last = position;
+
+	if ( !isCreatureTouching( metrics->creature, space ) ) {
+		metrics->airborneTime += timestep;
+	}
+}
+
+void getMetrics( Metrics metrics, metrics_t *result ) {
+	result->seconds = metrics->seconds;
+	result->distance = metrics->last.x - metrics->start.x;
+	result->averageSpeed = ( metrics->seconds > 0.0 ) ? metrics->pathLength / metrics->seconds : 0.0;
+	result->maxDisplacement = metrics->maxDisplacement;
+	result->straightness = ( metrics->pathLength > 0.0 ) ? fabs( result->distance ) / metrics->pathLength : 1.0;
+	result->airborneTime = metrics->airborneTime;
+	result->energy = getCreatureEnergy( metrics->creature ) - metrics->startEnergy;
+}
+
+void printMetrics( FILE *stream, metrics_t *metrics ) {
+	fprintf( stream, "Simulated seconds: %.3f\n", metrics->seconds );
+	fprintf( stream, "Distance: %.3f\n", metrics->distance );
+	fprintf( stream, "Average speed: %.3f\n", metrics->averageSpeed );
+	fprintf( stream, "Max displacement: %.3f\n", metrics->maxDisplacement );
+	fprintf( stream, "Path straightness: %.3f\n", metrics->straightness );
+	fprintf( stream, "Airborne seconds: %.3f\n", metrics->airborneTime );
+	fprintf( stream, "Energy: %.3f\n", metrics->energy );
+}
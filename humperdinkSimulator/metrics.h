@@ -0,0 +1,60 @@
+/*
+ * Metrics ADT:
+ *  Accumulates the measures fitness functions are built from while a
+ *  creature is simulated, in constant memory, so the creature's
+ *  trajectory never has to be stored or post-processed.
+ *
+ * Updated once per update of the environment, from the root limb's
+ * position and the space's contacts. The energy is the creature's own
+ * counter (see getCreatureEnergy).
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include "environment.h"
+#include "creature.h"
+
+typedef struct metrics *Metrics;
+
+/*
+ *  - seconds: time simulated
+ *  - distance: horizontal distance the root limb moved (the usual fitness)
+ *  - averageSpeed: horizontal length of the root limb's path per second
+ *  - maxDisplacement: furthest the root limb got from where it started, horizontally
+ *  - straightness: |distance| over the horizontal length of the path
+ *    (1 for steady progress, towards 0 for shuffling back and forth)
+ *  (horizontally, so the creature's drop onto the ground doesn't count)
+ *  - airborneTime: seconds without any limb touching anything
+ *  - energy: energy used by the motors
+ */
+typedef struct {
+	double seconds;
+	double distance;
+	double averageSpeed;
+	double maxDisplacement;
+	double straightness;
+	double airborneTime;
+	double energy;
+} metrics_t;
+
+/*
+ * Constructor: Starts measuring a creature in an environment from where it is now
+ * Deconstructor: Removes memory allocated for the measurements
+ */
+Metrics createMetrics( Creature creature, Environment env );
+void destroyMetrics( Metrics metrics );
+
+/*
+ * Adds the last update of the environment to the measurements
+ */
+void updateMetrics( Metrics metrics );
+
+/*
+ * The measurements so far
+ */
+void getMetrics( Metrics metrics, metrics_t *result );
+
+void printMetrics( FILE *stream, metrics_t *metrics );
+
+#endif
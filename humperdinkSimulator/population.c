@@ -0,0 +1,260 @@
+#include "population.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <assert.h>
+
+// lines a thread takes at a time
+#define LINES_PER_TASK 16
+
+// size of a file read that doesn't know its length
+#define READ_CHUNK 65536
+
+// population files named this way are never taken for a genome
+#define POPULATION_SUFFIX ".jsonl"
+
+struct population {
+	populationMember_t *members;
+	int size;
+	int errors;
+};
+
+/*
+ * The lines to load, shared by the threads, which take the next
+ * LINES_PER_TASK unclaimed lines until there are none left
+ */
+typedef struct {
+	const char **starts;
+	size_t *lengths;
+	populationMember_t *members;
+	int numLines;
+	int next;
+} job_t;
+
+/*
+ * Private helper function prototypes
+ */
+static int isBlank( const char *line, size_t length );
+static void *loadLines( void *data );
+
+
+Population loadPopulationText( const char *text, size_t length, int threads ) {
+	Population population = malloc( sizeof( struct population ) );
+	assert( population != NULL );
+
+	// split on newlines (serially: it's only a search), skipping blank lines
+	int capacity = 1024;
+	job_t job;
+	job.starts = malloc( sizeof( const char * ) * capacity );
+	job.lengths = malloc( sizeof( size_t ) * capacity );
+	assert( job.starts != NULL && job.lengths != NULL );
+	int *lineNumbers = malloc( sizeof( int ) * capacity );
+	assert( lineNumbers != NULL );
+	job.numLines = 0;
+	job.next = 0;
+
+	const char *end = text + length;
+	int lineNumber = 0;
+	for ( const char *start = text; start < end; ) {
+		const char *newline = memchr( start, '\n', end - start );
+		const char *lineEnd = ( newline != NULL ) ? newline : end;
+		lineNumber++;
+
+		if ( !isBlank( start, lineEnd - start ) ) {
+			if ( job.numLines == capacity ) {
+				capacity *= 2;
+				job.starts = realloc( job.starts, sizeof( const char * ) * capacity );
+				job.lengths = realloc( job.lengths, sizeof( size_t ) * capacity );
+				lineNumbers = realloc( lineNumbers, sizeof( int ) * capacity );
+				assert( job.starts != NULL && job.lengths != NULL && lineNumbers != NULL );
+			}
+			job.starts[job.numLines] = start;
+			job.lengths[job.numLines] = lineEnd - start;
+			lineNumbers[job.numLines] = lineNumber;
+			job.numLines++;
+		}
+
+		start = lineEnd + 1;
+	}
+
+	population->size = job.numLines;
+	population->members = malloc( sizeof( populationMember_t ) * ( job.numLines > 0 ? job.numLines : 1 ) );
+	assert( population->members != NULL );
+	for ( int i = 0; i < job.numLines; ++i ) {
+		population->members[i].line = lineNumbers[i];
+		initGenome( &population->members[i].genome );
+	}
+	free( lineNumbers );
+	job.members = population->members;
+
+	// no more threads than there are tasks
+	int tasks = ( job.numLines + LINES_PER_TASK - 1 ) / LINES_PER_TASK;
+	if ( threads > tasks ) {
+		threads = tasks;
+	}
+	if ( threads < 1 ) {
+		threads = 1;
+	}
+
+	// this thread works too
+	pthread_t workers[threads];
+	int started = 1;
+	for ( ; started < threads; ++started ) {
+		if ( pthread_create( &workers[started], NULL, loadLines, &job ) != 0 ) {
+			// make do with the threads there are
+			break;
+		}
+	}
+	loadLines( &job );
+	for ( int i = 1; i < started; ++i ) {
+		pthread_join( workers[i], NULL );
+	}
+
+	population->errors = 0;
+	for ( int i = 0; i < population->size; ++i ) {
+		population->errors += !population->members[i].loaded;
+	}
+
+	free( job.starts );
+	free( job.lengths );
+
+	return population;
+}
+
+Population loadPopulationPath( const char *path, int threads, json_error_t *error ) {
+	FILE *file = fopen( path, "rb" );
+	if ( file == NULL ) {
+		if ( error != NULL ) {
+			error->line = -1;
+			snprintf( error->text, JSON_ERROR_TEXT_LENGTH, "unable to open %s: %s", path, strerror( errno ) );
+		}
+		return NULL;
+	}
+
+	size_t length = 0;
+	size_t capacity = READ_CHUNK;
+	char *text = malloc( capacity );
+	assert( text != NULL );
+
+	size_t count;
+	while ( ( count = fread( text + length, 1, capacity - length, file ) ) > 0 ) {
+		length += count;
+		if ( length == capacity ) {
+			capacity *= 2;
+			text = realloc( text, capacity );
+			assert( text != NULL );
+		}
+	}
+	fclose( file );
+
+	Population population = loadPopulationText( text, length, threads );
+	free( text );
+	return population;
+}
+
+int isPopulationFile( const char *path ) {
+	size_t length = strlen( path );
+	if ( length >= strlen( POPULATION_SUFFIX ) && strcmp( path + length - strlen( POPULATION_SUFFIX ), POPULATION_SUFFIX ) == 0 ) {
+		return 1;
+	}
+
+	FILE *file = fopen( path, "rb" );
+	if ( file == NULL ) {
+		return 0;
+	}
+
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t read;
+	int lines = 0;
+	int whole = 0;
+	while ( lines < 2 && ( read = getline( &line, &capacity, file ) ) >= 0 ) {
+		if ( read > 0 && line[read - 1] == '\n' ) {
+			line[--read] = '\0';
+		}
+		if ( isBlank( line, read ) ) {
+			continue;
+		}
+
+		if ( lines == 0 ) {
+			// the first and last characters that aren't white space
+			const char *first = line;
+			while ( isspace( (unsigned char)*first ) ) {
+				first++;
+			}
+			const char *last = line + read - 1;
+			while ( isspace( (unsigned char)*last ) ) {
+				last--;
+			}
+			whole = ( *first == '{' && *last == '}' );
+		}
+		lines++;
+	}
+	free( line );
+	fclose( file );
+
+	return whole && lines == 2;
+}
+
+void destroyPopulation( Population population ) {
+	for ( int i = 0; i < population->size; ++i ) {
+		freeGenome( &population->members[i].genome );
+	}
+	free( population->members );
+	free( population );
+}
+
+int getPopulationSize( Population population ) {
+	return population->size;
+}
+
+populationMember_t *getPopulationMember( Population population, int index ) {
+	assert( index >= 0 && index < population->size );
+	return &population->members[index];
+}
+
+int getPopulationErrors( Population population ) {
+	return population->errors;
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+// only JSON whitespace
+static int isBlank( const char *line, size_t length ) {
+	for ( size_t i = 0; i < length; ++i ) {
+		if ( line[i] != ' ' && line[i] != '\t' && line[i] != '\r' ) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// a thread's work: loads tasks of lines until there are none left
+static void *loadLines( void *data ) {
+	job_t *job = data;
+
+	int first;
+	while ( ( first = __atomic_fetch_add( &job->next, LINES_PER_TASK, __ATOMIC_RELAXED ) ) < job->numLines ) {
+		int last = first + LINES_PER_TASK;
+		if ( last > job->numLines ) {
+			last = job->numLines;
+		}
+
+		for ( int i = first; i < last; ++i ) {
+			populationMember_t *member = &job->members[i];
+			member->loaded = loadGenomeText( job->starts[i], job->lengths[i], &member->genome, &member->error );
+			if ( !member->loaded ) {
+				member->error.line = member->line;
+			}
+		}
+	}
+
+	return NULL;
+}
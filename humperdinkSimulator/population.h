@@ -0,0 +1,55 @@
+/*
+ * Population ADT:
+ *  Reads a generation of genomes from JSON lines (one genome per line, in
+ *  the schema of the .hdk files but without newlines; blank lines are
+ *  skipped), with the lines divided among several threads. Each genome is
+ *  read straight into its limbs (see genomeLoader.h), ready for
+ *  createCreatureFromLimbs, and the genomes stay in the order of the input.
+ */
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <stddef.h>
+#include <jansson.h>
+#include "genomeLoader.h"
+
+/*
+ * One line's genome: its limbs if it loaded, otherwise the error, as
+ * loadGenomeText reports it but with error.line the line of the input
+ */
+typedef struct {
+	int line;
+	int loaded;
+	genome_t genome;
+	json_error_t error;
+} populationMember_t;
+
+typedef struct population *Population;
+
+/*
+ * Constructors: Reads a population from 'length' bytes of text, or from the
+ *  file at 'path' (NULL if it can't be read, with the reason in 'error'),
+ *  using up to 'threads' threads
+ * Deconstructor: Removes memory allocated for the population and its genomes
+ */
+Population loadPopulationText( const char *text, size_t length, int threads );
+Population loadPopulationPath( const char *path, int threads, json_error_t *error );
+void destroyPopulation( Population population );
+
+/*
+ * True if the file at 'path' looks like a population rather than one
+ * genome, without parsing it: it's named .jsonl, or its first line that
+ * isn't blank holds a whole object and another line that isn't blank
+ * follows (a genome written over several lines starts with a line that
+ * doesn't close its object)
+ */
+int isPopulationFile( const char *path );
+
+/*
+ * Members in the order of the input, and how many of them failed to load
+ */
+int getPopulationSize( Population population );
+populationMember_t *getPopulationMember( Population population, int index );
+int getPopulationErrors( Population population );
+
+#endif
@@ -0,0 +1,513 @@
+#include "screening.h"
+#include "finite.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+
+// fraction of a tier's genomes it keeps, unless the list says otherwise
+#define DEFAULT_KEEP 0.25
+
+typedef struct {
+	evaluationSettings_t settings;
+	double keep;
+
+	long genomes;
+	long cached;
+	double seconds;
+	double correlationSum;
+	int correlations;
+	double recallSum;
+	int recalls;
+} tier_t;
+
+/*
+ * The genomes a tier simulates, shared by the threads, which each take the
+ * next unclaimed genome until there are none left
+ */
+typedef struct {
+	genome_t **genomes;
+	int *indices;
+	int count;
+	evaluationSettings_t *settings;
+	metrics_t *results;
+	FitnessCache cache;
+	int next;
+	int cached;
+} job_t;
+
+struct screening {
+	// the cheap tiers in order, then the full tier
+	tier_t *tiers;
+	int numTiers;
+	int threads;
+	int audit;
+	FitnessCache cache;
+
+	// the threads that work on each tier's job along with the calling thread, kept for the
+	// screening's life so their creatures are reused (see evaluateLimbs) from tier to tier
+	pthread_t *workers;
+	int numWorkers;
+	pthread_mutex_t lock;
+	// signalled when a job is posted (or the workers should stop), and when the last worker is done with it
+	pthread_cond_t posted;
+	pthread_cond_t finished;
+	job_t *job;
+	long jobsPosted;
+	int working;
+	int stopping;
+};
+
+// a genome's distance, for ranking
+typedef struct {
+	double score;
+	int index;
+} ranked_t;
+
+/*
+ * Private helper function prototypes
+ */
+static void initTier( tier_t *tier, evaluationSettings_t *settings, double keep );
+static void simulateTier( Screening screening, tier_t *tier, genome_t **genomes, int *indices, int count, metrics_t *results );
+static void *runWorker( void *data );
+static void simulateGenomes( job_t *job );
+static void rankGenomes( int *indices, int count, metrics_t *results, ranked_t *ranked );
+static int compareRanked( const void *a, const void *b );
+static double getScore( metrics_t *metrics );
+static double rankCorrelation( int *indices, int count, metrics_t *x, metrics_t *y );
+static void assignRanks( int *indices, int count, metrics_t *results, double *ranks );
+static double getTime( void );
+
+
+Screening createScreening( evaluationSettings_t *full, int threads ) {
+	Screening screening = malloc( sizeof( struct screening ) );
+	assert( screening != NULL );
+
+	screening->tiers = malloc( sizeof( tier_t ) );
+	assert( screening->tiers != NULL );
+	initTier( &screening->tiers[0], full, 1.0 );
+	screening->numTiers = 1;
+	screening->threads = ( threads > 0 ) ? threads : 1;
+	screening->audit = 0;
+	screening->cache = NULL;
+
+	pthread_mutex_init( &screening->lock, NULL );
+	pthread_cond_init( &screening->posted, NULL );
+	pthread_cond_init( &screening->finished, NULL );
+	screening->job = NULL;
+	screening->jobsPosted = 0;
+	screening->working = 0;
+	screening->stopping = 0;
+
+	// the calling thread works too
+	screening->workers = malloc( sizeof( pthread_t ) * screening->threads );
+	assert( screening->workers != NULL );
+	screening->numWorkers = 0;
+	while ( screening->numWorkers < screening->threads - 1 ) {
+		if ( pthread_create( &screening->workers[screening->numWorkers], NULL, runWorker, screening ) != 0 ) {
+			// make do with the threads there are
+			break;
+		}
+		screening->numWorkers++;
+	}
+
+	return screening;
+}
+
+void destroyScreening( Screening screening ) {
+	pthread_mutex_lock( &screening->lock );
+	screening->stopping = 1;
+	pthread_cond_broadcast( &screening->posted );
+	pthread_mutex_unlock( &screening->lock );
+	for ( int i = 0; i < screening->numWorkers; ++i ) {
+		pthread_join( screening->workers[i], NULL );
+	}
+
+	pthread_cond_destroy( &screening->posted );
+	pthread_cond_destroy( &screening->finished );
+	pthread_mutex_destroy( &screening->lock );
+	free( screening->workers );
+	free( screening->tiers );
+	free( screening );
+}
+
+void addScreeningTier( Screening screening, evaluationSettings_t *settings, double keep ) {
+	screening->numTiers++;
+	screening->tiers = realloc( screening->tiers, sizeof( tier_t ) * screening->numTiers );
+	assert( screening->tiers != NULL );
+
+	// the full tier stays last
+	int index = screening->numTiers - 2;
+	screening->tiers[index + 1] = screening->tiers[index];
+	initTier( &screening->tiers[index], settings, keep );
+}
+
+int parseScreeningTier( const char *list, evaluationSettings_t *settings, double *keep ) {
+	const char *c = list;
+	*keep = DEFAULT_KEEP;
+
+	while ( *c != '\0' ) {
+		char name[16];
+		double value;
+		int length;
+
+		if ( sscanf( c, "%15[a-z]=%lf%n", name, &value, &length ) != 2 || value < 0.0 ) {
+			return 0;
+		}
+
+		if ( strcmp( name, "updates" ) == 0 && value >= 1.0 ) {
+			settings->updates = (int)value;
+		} else if ( strcmp( name, "timestep" ) == 0 ) {
+			settings->timestep = value;
+		} else if ( strcmp( name, "passes" ) == 0 && value >= 1.0 ) {
+			settings->iterations = (int)value;
+		} else if ( strcmp( name, "keep" ) == 0 && value > 0.0 && value <= 1.0 ) {
+			*keep = value;
+		} else {
+			return 0;
+		}
+
+		c += length;
+		if ( *c == ',' ) {
+			c++;
+		} else if ( *c != '\0' ) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+void setScreeningAudit( Screening screening, int audit ) {
+	screening->audit = audit;
+}
+
+void setScreeningCache( Screening screening, FitnessCache cache ) {
+	screening->cache = cache;
+}
+
+int getScreeningTiers( Screening screening ) {
+	return screening->numTiers;
+}
+
+void screenGenomes( Screening screening, genome_t **genomes, int numGenomes, metrics_t *results, int *tiers ) {
+	if ( numGenomes == 0 ) {
+		return;
+	}
+
+	// each tier's results, and the last tier's
+	metrics_t *current = malloc( sizeof( metrics_t ) * numGenomes );
+	metrics_t *previous = malloc( sizeof( metrics_t ) * numGenomes );
+	int *active = malloc( sizeof( int ) * numGenomes );
+	int *kept = malloc( sizeof( int ) * numGenomes );
+	int *all = malloc( sizeof( int ) * numGenomes );
+	ranked_t *ranked = malloc( sizeof( ranked_t ) * numGenomes );
+	assert( current != NULL && previous != NULL && active != NULL && kept != NULL && all != NULL && ranked != NULL );
+
+	for ( int i = 0; i < numGenomes; ++i ) {
+		active[i] = i;
+		all[i] = i;
+	}
+	int numActive = numGenomes;
+	int numKept = numGenomes;
+
+	for ( int t = 0; t < screening->numTiers; ++t ) {
+		tier_t *tier = &screening->tiers[t];
+
+		// in an audit every tier simulates every genome
+		int *simulated = screening->audit ? all : active;
+		int numSimulated = screening->audit ? numGenomes : numActive;
+		simulateTier( screening, tier, genomes, simulated, numSimulated, current );
+
+		for ( int i = 0; i < numSimulated; ++i ) {
+			int index = simulated[i];
+			results[index] = current[index];
+			if ( tiers != NULL ) {
+				tiers[index] = t;
+			}
+		}
+
+		// how the last tier compares with this one
+		if ( t > 0 ) {
+			tier_t *last = &screening->tiers[t - 1];
+			double correlation = rankCorrelation( simulated, numSimulated, previous, current );
+			if ( isFiniteValue( correlation ) ) {
+				last->correlationSum += correlation;
+				last->correlations++;
+			}
+
+			if ( screening->audit ) {
+				// the share of this tier's best the last tier kept
+				rankGenomes( all, numGenomes, current, ranked );
+				int found = 0;
+				for ( int i = 0; i < numKept; ++i ) {
+					for ( int j = 0; j < numActive; ++j ) {
+						found += ( active[j] == ranked[i].index );
+					}
+				}
+				last->recallSum += (double)found / numKept;
+				last->recalls++;
+			}
+		}
+
+		if ( t == screening->numTiers - 1 ) {
+			break;
+		}
+
+		// the best of this tier go on to the next
+		rankGenomes( active, numActive, current, ranked );
+		numKept = (int)ceil( tier->keep * numActive );
+		if ( numKept < 1 ) {
+			numKept = 1;
+		}
+		for ( int i = 0; i < numKept; ++i ) {
+			kept[i] = ranked[i].index;
+		}
+		int *swap = active;
+		active = kept;
+		kept = swap;
+		numActive = numKept;
+
+		metrics_t *swapResults = previous;
+		previous = current;
+		current = swapResults;
+	}
+
+	free( current );
+	free( previous );
+	free( active );
+	free( kept );
+	free( all );
+	free( ranked );
+}
+
+void getScreeningReport( Screening screening, int tier, screeningReport_t *report ) {
+	assert( tier >= 0 && tier < screening->numTiers );
+	tier_t *t = &screening->tiers[tier];
+
+	report->genomes = t->genomes;
+	report->cached = t->cached;
+	report->seconds = t->seconds;
+	report->correlation = ( t->correlations > 0 ) ? t->correlationSum / t->correlations : NAN;
+	report->recall = ( t->recalls > 0 ) ? t->recallSum / t->recalls : NAN;
+}
+
+void printScreeningReport( FILE *stream, Screening screening ) {
+	fprintf( stream, "%5s %8s %9s %7s %6s %9s %7s %10s %12s %7s\n",
+		"tier", "updates", "timestep", "passes", "keep", "genomes", "cached", "seconds", "correlation", "recall" );
+
+	for ( int t = 0; t < screening->numTiers; ++t ) {
+		tier_t *tier = &screening->tiers[t];
+		screeningReport_t report;
+		getScreeningReport( screening, t, &report );
+
+		char name[16];
+		if ( t == screening->numTiers - 1 ) {
+			snprintf( name, sizeof( name ), "full" );
+		} else {
+			snprintf( name, sizeof( name ), "%d", t );
+		}
+
+		fprintf( stream, "%5s %8d %9.4f %7d %6.2f %9ld %7ld %10.3f %12.3f %7.2f\n",
+			name, tier->settings.updates,
+			( tier->settings.timestep > 0.0 ) ? tier->settings.timestep : 1.0/60.0,
+			( tier->settings.iterations > 0 ) ? tier->settings.iterations : 10,
+			tier->keep, report.genomes, report.cached, report.seconds, report.correlation, report.recall );
+	}
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+static void initTier( tier_t *tier, evaluationSettings_t *settings, double keep ) {
+	tier->settings = *settings;
+	tier->keep = keep;
+	tier->genomes = 0;
+	tier->cached = 0;
+	tier->seconds = 0.0;
+	tier->correlationSum = 0.0;
+	tier->correlations = 0;
+	tier->recallSum = 0.0;
+	tier->recalls = 0;
+}
+
+// simulates the genomes at 'indices', into the same places of 'results'
+static void simulateTier( Screening screening, tier_t *tier, genome_t **genomes, int *indices, int count, metrics_t *results ) {
+	job_t job;
+	job.genomes = genomes;
+	job.indices = indices;
+	job.count = count;
+	job.settings = &tier->settings;
+	job.results = results;
+	job.cache = screening->cache;
+	job.next = 0;
+	job.cached = 0;
+
+	double start = getTime( );
+
+	// the workers only wake up if there's more than this thread's share
+	int workers = ( count > 1 ) ? screening->numWorkers : 0;
+	if ( workers > 0 ) {
+		pthread_mutex_lock( &screening->lock );
+		screening->job = &job;
+		screening->jobsPosted++;
+		screening->working = workers;
+		pthread_cond_broadcast( &screening->posted );
+		pthread_mutex_unlock( &screening->lock );
+	}
+
+	simulateGenomes( &job );
+
+	if ( workers > 0 ) {
+		pthread_mutex_lock( &screening->lock );
+		while ( screening->working > 0 ) {
+			pthread_cond_wait( &screening->finished, &screening->lock );
+		}
+		screening->job = NULL;
+		pthread_mutex_unlock( &screening->lock );
+	}
+
+	tier->seconds += getTime( ) - start;
+	tier->genomes += count;
+	tier->cached += job.cached;
+}
+
+// a worker: works on each job posted, until the screening is destroyed
+static void *runWorker( void *data ) {
+	Screening screening = data;
+	long jobsSeen = 0;
+
+	pthread_mutex_lock( &screening->lock );
+	while ( 1 ) {
+		while ( screening->jobsPosted == jobsSeen && !screening->stopping ) {
+			pthread_cond_wait( &screening->posted, &screening->lock );
+		}
+		if ( screening->stopping ) {
+			break;
+		}
+		jobsSeen = screening->jobsPosted;
+		job_t *job = screening->job;
+
+		pthread_mutex_unlock( &screening->lock );
+		simulateGenomes( job );
+		pthread_mutex_lock( &screening->lock );
+
+		if ( --screening->working == 0 ) {
+			pthread_cond_signal( &screening->finished );
+		}
+	}
+	pthread_mutex_unlock( &screening->lock );
+
+	return NULL;
+}
+
+static void simulateGenomes( job_t *job ) {
+	int i;
+	while ( ( i = __atomic_fetch_add( &job->next, 1, __ATOMIC_RELAXED ) ) < job->count ) {
+		int index = job->indices[i];
+		genome_t *genome = job->genomes[index];
+		if ( job->cache == NULL ) {
+			evaluateLimbs( genome->parameters, genome->numLimbs, job->settings, &job->results[index] );
+		} else if ( evaluateLimbsCached( job->cache, genome->parameters, genome->parents, genome->numLimbs, job->settings, &job->results[index] ) ) {
+			__atomic_fetch_add( &job->cached, 1, __ATOMIC_RELAXED );
+		}
+	}
+}
+
+// the genomes at 'indices', best first
+static void rankGenomes( int *indices, int count, metrics_t *results, ranked_t *ranked ) {
+	for ( int i = 0; i < count; ++i ) {
+		ranked[i].score = getScore( &results[indices[i]] );
+		ranked[i].index = indices[i];
+	}
+	qsort( ranked, count, sizeof( ranked_t ), compareRanked );
+}
+
+// best first, then in the order of the batch (so the ranking is always the same)
+static int compareRanked( const void *a, const void *b ) {
+	const ranked_t *x = a;
+	const ranked_t *y = b;
+	if ( x->score != y->score ) {
+		return ( x->score < y->score ) ? 1 : -1;
+	}
+	return x->index - y->index;
+}
+
+// the distance, with creatures that blew up (NaN) last
+static double getScore( metrics_t *metrics ) {
+	return isFiniteValue( metrics->distance ) ? metrics->distance : -DBL_MAX;
+}
+
+// Spearman's rank correlation of two tiers' distances for the genomes at 'indices'
+static double rankCorrelation( int *indices, int count, metrics_t *x, metrics_t *y ) {
+	if ( count < 3 ) {
+		return NAN;
+	}
+
+	double *xRanks = malloc( sizeof( double ) * count );
+	double *yRanks = malloc( sizeof( double ) * count );
+	assert( xRanks != NULL && yRanks != NULL );
+	assignRanks( indices, count, x, xRanks );
+	assignRanks( indices, count, y, yRanks );
+
+	// Pearson's correlation of the ranks (which handles ties)
+	double mean = ( count + 1 ) / 2.0;
+	double covariance = 0.0;
+	double xVariance = 0.0;
+	double yVariance = 0.0;
+	for ( int i = 0; i < count; ++i ) {
+		double dx = xRanks[i] - mean;
+		double dy = yRanks[i] - mean;
+		covariance += dx * dy;
+		xVariance += dx * dx;
+		yVariance += dy * dy;
+	}
+
+	free( xRanks );
+	free( yRanks );
+
+	if ( xVariance == 0.0 || yVariance == 0.0 ) {
+		return NAN;
+	}
+	return covariance / sqrt( xVariance * yVariance );
+}
+
+// ranks[i] is the rank (1 for the best, ties sharing their mean rank) of the genome at indices[i]
+static void assignRanks( int *indices, int count, metrics_t *results, double *ranks ) {
+	ranked_t *ranked = malloc( sizeof( ranked_t ) * count );
+	assert( ranked != NULL );
+
+	// rank positions rather than genomes, so the ranks line up with 'indices'
+	for ( int i = 0; i < count; ++i ) {
+		ranked[i].score = getScore( &results[indices[i]] );
+		ranked[i].index = i;
+	}
+	qsort( ranked, count, sizeof( ranked_t ), compareRanked );
+
+	for ( int first = 0; first < count; ) {
+		int last = first;
+		while ( last + 1 < count && ranked[last + 1].score == ranked[first].score ) {
+			last++;
+		}
+		double rank = ( first + last ) / 2.0 + 1.0;
+		for ( int i = first; i <= last; ++i ) {
+			ranks[ranked[i].index] = rank;
+		}
+		first = last + 1;
+	}
+
+	free( ranked );
+}
+
+static double getTime( void ) {
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
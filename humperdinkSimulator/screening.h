@@ -0,0 +1,109 @@
+/*
+ * Screening ADT:
+ *  Evaluates batches of genomes (see evaluation.h) in tiers of increasing
+ *  fidelity: every genome is simulated by the first, cheapest tier (fewer
+ *  solver passes, a larger timestep, fewer updates), only the best
+ *  fraction of them by its distance by the next, and so on up to the full
+ *  tier, the settings the results are meant to have. With no cheap tiers
+ *  every genome is simulated in full. Each tier's genomes are simulated on
+ *  several threads, each genome on one, and the results don't depend on
+ *  the number of threads.
+ *
+ * To tune the tiers, the screening keeps a report of each tier: its cost,
+ * and the Spearman rank correlation of its distances with the next tier's
+ * over the genomes both simulated. Those are only the ones the tier kept,
+ * so in an audit every tier simulates every genome (costing as much as
+ * all the tiers together, and giving every genome full results), which
+ * correlates the whole batch, and counts how many of the next tier's
+ * best the tier would have kept.
+ *
+ * With a fitness cache (see fitnessCache.h), each tier looks its genomes
+ * up by its own settings first, and only simulates (and stores) the ones
+ * that aren't there.
+ */
+#ifndef SCREENING_H
+#define SCREENING_H
+
+#include <stdio.h>
+#include "evaluation.h"
+#include "genomeLoader.h"
+#include "fitnessCache.h"
+
+typedef struct screening *Screening;
+
+/*
+ * A tier's report, over every batch so far:
+ *  - genomes: genomes simulated by the tier
+ *  - cached: of those, the ones whose results were in the cache
+ *  - seconds: time the tier's simulations took
+ *  - correlation: mean, over the batches with at least three genomes
+ *    through both, of the Spearman correlation of the tier's distances
+ *    with the next tier's (NaN for the full tier, or with no such batch)
+ *  - recall: in an audit, the mean fraction of the next tier's best (as
+ *    many as the tier keeps) that the tier kept (NaN otherwise)
+ */
+typedef struct {
+	long genomes;
+	long cached;
+	double seconds;
+	double correlation;
+	double recall;
+} screeningReport_t;
+
+/*
+ * Constructor: Creates a screening with only the full tier, simulating
+ *  genomes with 'full' (copied) on up to 'threads' threads: the calling
+ *  thread, and threads - 1 workers started now and kept until the
+ *  screening is destroyed, so the creatures each thread keeps (see
+ *  evaluateLimbs) are reused by every tier and batch
+ * Deconstructor: Stops the workers and removes memory allocated for the
+ *  screening
+ */
+Screening createScreening( evaluationSettings_t *full, int threads );
+void destroyScreening( Screening screening );
+
+/*
+ * Adds a cheap tier, after the cheap tiers already added (and before the
+ * full tier), which keeps the best 'keep' (0..1) of its genomes, and at
+ * least one, for the next tier
+ */
+void addScreeningTier( Screening screening, evaluationSettings_t *settings, double keep );
+
+/*
+ * Reads a cheap tier from a list like "updates=300,timestep=0.033,
+ * passes=4,keep=0.25" into 'settings' (which should start as a copy of the
+ * full tier's, and is otherwise left as it is) and 'keep' (0.25 unless
+ * it's in the list). Returns 0 if the list can't be read.
+ */
+int parseScreeningTier( const char *list, evaluationSettings_t *settings, double *keep );
+
+/*
+ * In an audit every tier simulates every genome (see above)
+ */
+void setScreeningAudit( Screening screening, int audit );
+
+/*
+ * Looks results up in, and adds them to, 'cache' (NULL for none), which
+ * the screening doesn't own
+ */
+void setScreeningCache( Screening screening, FitnessCache cache );
+
+/*
+ * Number of tiers, counting the full tier (the last)
+ */
+int getScreeningTiers( Screening screening );
+
+/*
+ * Evaluates a batch of genomes: each gets the results of the last tier
+ * that simulated it, and that tier's index in 'tiers' (which can be NULL)
+ */
+void screenGenomes( Screening screening, genome_t **genomes, int numGenomes, metrics_t *results, int *tiers );
+
+void getScreeningReport( Screening screening, int tier, screeningReport_t *report );
+
+/*
+ * A table of the tiers' settings and reports
+ */
+void printScreeningReport( FILE *stream, Screening screening );
+
+#endif
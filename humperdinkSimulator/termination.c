@@ -0,0 +1,231 @@
+#include "termination.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+// a quarter turn, past which the root limb counts as turned over
+#define INVERTED_TURN ( M_PI/2.0 )
+
+// random creatures often go seconds without getting any further, or turned over, and then
+// set off again (see bench/terminationBench): by default only the ones that have stopped
+// moving altogether are stopped, and turning over is allowed
+#define DEFAULT_PROGRESS_WINDOW 5.0
+#define DEFAULT_MIN_PROGRESS 5.0
+#define DEFAULT_INVERTED_TIME 0.0
+#define DEFAULT_MAX_SPEED 10000.0
+#define DEFAULT_MAX_DEPTH 20.0
+#define DEFAULT_NET_PROGRESS 0
+
+struct termination {
+	Creature creature;
+	terminationRules_t rules;
+
+	double groundY;
+
+	// the horizontal distance the root limb has moved (both ways) so far, from its last x,
+	// and over the last windowUpdates updates (a ring buffer, of the root limb's x instead
+	// with netProgress)
+	double moved;
+	double lastX;
+	double *history;
+	int windowUpdates;
+
+	// updates spent turned over so far, and allowed
+	int invertedUpdates;
+	int maxInvertedUpdates;
+
+	long updates;
+	terminationReason_t reason;
+};
+
+/*
+ * Private helper function prototypes
+ */
+static int secondsToUpdates( double seconds, double timestep );
+static terminationReason_t checkRules( Termination termination );
+
+
+terminationRules_t defaultTerminationRules( void ) {
+	terminationRules_t rules = {
+		DEFAULT_PROGRESS_WINDOW,
+		DEFAULT_MIN_PROGRESS,
+		DEFAULT_INVERTED_TIME,
+		DEFAULT_MAX_SPEED,
+		DEFAULT_MAX_DEPTH,
+		DEFAULT_NET_PROGRESS
+	};
+	return rules;
+}
+
+int parseTerminationRules( const char *list, terminationRules_t *rules ) {
+	const char *c = list;
+
+	while ( *c != '\0' ) {
+		char name[16];
+		double value;
+		int length;
+
+		if ( sscanf( c, "%15[a-z]=%lf%n", name, &value, &length ) != 2 || value < 0.0 ) {
+			return 0;
+		}
+
+		if ( strcmp( name, "window" ) == 0 ) {
+			rules->progressWindow = value;
+		} else if ( strcmp( name, "progress" ) == 0 ) {
+			rules->minProgress = value;
+		} else if ( strcmp( name, "inverted" ) == 0 ) {
+			rules->invertedTime = value;
+		} else if ( strcmp( name, "speed" ) == 0 ) {
+			rules->maxSpeed = value;
+		} else if ( strcmp( name, "depth" ) == 0 ) {
+			rules->maxDepth = value;
+		} else if ( strcmp( name, "net" ) == 0 && ( value == 0.0 || value == 1.0 ) ) {
+			rules->netProgress = (int)value;
+		} else {
+			return 0;
+		}
+
+		c += length;
+		if ( *c == ',' ) {
+			c++;
+		} else if ( *c != '\0' ) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+Termination createTermination( Creature creature, Environment env, terminationRules_t rules ) {
+	Termination termination = malloc( sizeof( struct termination ) );
+	assert( termination != NULL );
+
+	double timestep = getEnvironmentTimestep( env );
+
+	termination->creature = creature;
+	termination->rules = rules;
+	termination->groundY = getEnvironmentGroundY( env );
+
+	termination->windowUpdates = 0;
+	termination->history = NULL;
+	if ( rules.progressWindow > 0.0 && rules.minProgress > 0.0 ) {
+		termination->windowUpdates = secondsToUpdates( rules.progressWindow, timestep );
+		termination->history = malloc( sizeof( double ) * termination->windowUpdates );
+		assert( termination->history != NULL );
+	}
+
+	termination->invertedUpdates = 0;
+	termination->maxInvertedUpdates = secondsToUpdates( rules.invertedTime, timestep );
+
+	termination->updates = 0;
+	termination->reason = TERMINATION_NONE;
+
+	// the start is the first one in the window
+	termination->moved = 0.0;
+	termination->lastX = getCreatureX( creature );
+	if ( termination->history != NULL ) {
+		termination->history[0] = rules.netProgress ? termination->lastX : 0.0;
+	}
+
+	return termination;
+}
+
+void destroyTermination( Termination termination ) {
+	free( termination->history );
+	free( termination );
+}
+
+terminationReason_t checkTermination( Termination termination ) {
+	if ( termination->reason == TERMINATION_NONE ) {
+		termination->updates++;
+		termination->reason = checkRules( termination );
+	}
+	return termination->reason;
+}
+
+terminationReason_t getTerminationReason( Termination termination ) {
+	return termination->reason;
+}
+
+long getTerminationUpdates( Termination termination ) {
+	return termination->updates;
+}
+
+const char *terminationReasonName( terminationReason_t reason ) {
+	switch ( reason ) {
+		case TERMINATION_NONE: return "none";
+		case TERMINATION_NOT_MOVING: return "not moving";
+		case TERMINATION_NO_PROGRESS: return "no progress";
+		case TERMINATION_INVERTED: return "inverted";
+		case TERMINATION_BLOWN_UP: return "blown up";
+		case TERMINATION_UNDERGROUND: return "underground";
+	}
+	return "unknown";
+}
+
+
+/*
+ * Private helper function implementation
+ */
+
+static int secondsToUpdates( double seconds, double timestep ) {
+	if ( seconds <= 0.0 ) {
+		return 0;
+	}
+	int updates = (int)ceil( seconds / timestep - 1e-9 );
+	return ( updates < 1 ) ? 1 : updates;
+}
+
+static terminationReason_t checkRules( Termination termination ) {
+	terminationRules_t *rules = &termination->rules;
+
+	creatureState_t state;
+	getCreatureState( termination->creature, &state );
+
+	if ( state.blownUp || ( rules->maxSpeed > 0.0 && state.maxSpeed > rules->maxSpeed ) ) {
+		return TERMINATION_BLOWN_UP;
+	}
+
+	if ( rules->maxDepth > 0.0 && state.lowestY < termination->groundY - rules->maxDepth ) {
+		return TERMINATION_UNDERGROUND;
+	}
+
+	if ( termination->maxInvertedUpdates > 0 ) {
+		if ( fabs( state.rootTurn ) > INVERTED_TURN ) {
+			termination->invertedUpdates++;
+		} else {
+			termination->invertedUpdates = 0;
+		}
+
+		if ( termination->invertedUpdates >= termination->maxInvertedUpdates ) {
+			return TERMINATION_INVERTED;
+		}
+	}
+
+	if ( termination->history != NULL ) {
+		double x = getCreatureX( termination->creature );
+		termination->moved += fabs( x - termination->lastX );
+		termination->lastX = x;
+
+		// the slot for this update holds the distance moved up to (or the x of) a whole window ago
+		int slot = termination->updates % termination->windowUpdates;
+		int windowFull = ( termination->updates >= termination->windowUpdates );
+		double progress;
+		if ( rules->netProgress ) {
+			progress = windowFull ? fabs( x - termination->history[slot] ) : 0.0;
+			termination->history[slot] = x;
+		} else {
+			progress = windowFull ? termination->moved - termination->history[slot] : 0.0;
+			termination->history[slot] = termination->moved;
+		}
+
+		if ( windowFull && progress < rules->minProgress ) {
+			return rules->netProgress ? TERMINATION_NO_PROGRESS : TERMINATION_NOT_MOVING;
+		}
+	}
+
+	return TERMINATION_NONE;
+}
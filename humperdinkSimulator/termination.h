@@ -0,0 +1,91 @@
+/*
+ * Termination ADT:
+ *  Watches a creature while it is simulated and decides when the rest of
+ *  its evaluation isn't worth simulating: it has stopped moving (or,
+ *  by a stricter rule, stopped getting anywhere), fallen on its back,
+ *  blown up, or fallen through the ground.
+ *
+ * Each rule is checked once per update from the creature's state
+ * (see getCreatureState), in constant time.
+ */
+#ifndef TERMINATION_H
+#define TERMINATION_H
+
+#include "environment.h"
+#include "creature.h"
+
+typedef struct termination *Termination;
+
+typedef enum {
+	TERMINATION_NONE = 0,      // still worth simulating
+	TERMINATION_NOT_MOVING,    // moved less than minProgress in the last progressWindow
+	TERMINATION_NO_PROGRESS,   // with netProgress, got less than minProgress further in the last progressWindow
+	TERMINATION_INVERTED,      // root limb turned over for invertedTime
+	TERMINATION_BLOWN_UP,      // NaN, infinite or faster than maxSpeed
+	TERMINATION_UNDERGROUND    // a limb more than maxDepth below the ground
+} terminationReason_t;
+
+/*
+ * The rules, any of them 0 to turn it off
+ * (NaN and infinite values always stop the simulation)
+ *  - progressWindow, minProgress: seconds, and horizontal distance the root
+ *    limb has to move (back and forth both count) in every window of that
+ *    many seconds
+ *  - netProgress: if set, the distance is between where the root limb was
+ *    at the start of the window and where it is at the end instead, so
+ *    moving back and forth on the spot doesn't count (this stops more
+ *    creatures, and sooner, but some of them would have set off again)
+ *  - invertedTime: seconds the root limb may spend turned more than a
+ *    quarter turn from its construction pose
+ *  - maxSpeed: fastest any point of any limb may move
+ *  - maxDepth: how far any limb may sink below the top of the ground
+ */
+typedef struct {
+	double progressWindow;
+	double minProgress;
+	double invertedTime;
+	double maxSpeed;
+	double maxDepth;
+	int netProgress;
+} terminationRules_t;
+
+/*
+ * Rules that only stop creatures that have clearly failed, and so leave
+ * the fittest to run to the end: stopped moving for 5 seconds, blown up,
+ * or underground (turning over is allowed, and progress counts movement
+ * both ways)
+ */
+terminationRules_t defaultTerminationRules( void );
+
+/*
+ * Reads rules from a list like "window=3,progress=5,net=1,inverted=2,speed=10000,depth=20"
+ * into 'rules', leaving the rules not in the list as they were.
+ * Returns 0 if the list can't be read.
+ */
+int parseTerminationRules( const char *list, terminationRules_t *rules );
+
+/*
+ * Constructor: Starts watching a creature in an environment
+ *  (for the environment's timestep and ground)
+ * Deconstructor: Removes memory allocated for the watcher
+ */
+Termination createTermination( Creature creature, Environment env, terminationRules_t rules );
+void destroyTermination( Termination termination );
+
+/*
+ * Checks the rules after an update of the environment, returns the
+ * reason to stop, or TERMINATION_NONE to keep going. Once stopped,
+ * keeps returning the same reason.
+ */
+terminationReason_t checkTermination( Termination termination );
+
+/*
+ * The reason the creature stopped, and the number of updates it
+ * was simulated for (up to and including the one it stopped on)
+ */
+terminationReason_t getTerminationReason( Termination termination );
+long getTerminationUpdates( Termination termination );
+
+const char *terminationReasonName( terminationReason_t reason );
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Genome converter:
+ *  converts a genome between the JSON of the .hdk files (readme.txt) and
+ *  the binary format of binaryGenome.h, whichever way round the input is.
+ *
+ * usage: genomeConvert input output
+ */
+
+#include "../genomeLoader.h"
+#include "../binaryGenome.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+int main( int argc, char *argv[] ) {
+	if ( argc != 3 ) {
+		fprintf( stderr, "usage: %s input output\n", argv[0] );
+		exit( 1 );
+	}
+	char *input = argv[1];
+	char *output = argv[2];
+
+	json_error_t error;
+	int converted;
+
+	if ( isBinaryGenomeFile( input ) ) {
+		BinaryGenome genome = openBinaryGenome( input, &error );
+		if ( genome == NULL ) {
+			fprintf( stderr, "%s\n", error.text );
+			exit( 1 );
+		}
+
+		json_t *json = createGenomeJSON( getBinaryGenomeLimbs( genome ), getBinaryGenomeNumLimbs( genome ) );
+		converted = ( json_dump_file( json, output, JSON_INDENT( 4 ) ) == 0 );
+		json_decref( json );
+		closeBinaryGenome( genome );
+	} else {
+		genome_t genome;
+		initGenome( &genome );
+		if ( !loadGenomePath( input, &genome, &error ) ) {
+			fprintf( stderr, "Error parsing humperdink on line %d:\n\t%s\n", error.line, error.text );
+			exit( 1 );
+		}
+
+		FILE *file = fopen( output, "wb" );
+		converted = ( file != NULL && writeBinaryGenome( file, genome.parameters, genome.numLimbs ) );
+		if ( file != NULL ) {
+			converted = ( fclose( file ) == 0 ) && converted;
+		}
+		freeGenome( &genome );
+	}
+
+	if ( !converted ) {
+		fprintf( stderr, "Can't write %s\n", output );
+		exit( 1 );
+	}
+
+	return 0;
+}